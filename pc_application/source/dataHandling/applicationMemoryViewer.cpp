@@ -3,6 +3,8 @@
 ApplicationMemoryManager::ApplicationMemoryManager(wxString dir, std::shared_ptr<CommunicateWithNetwork> networkImp) {
 	projectDir      = dir;
 	networkInstance = networkImp;
+
+	memoryTrace = std::make_shared<MemoryTrace>(wxFileName::DirName(projectDir));
 }
 
 void ApplicationMemoryManager::addMemoryRegion(uint64_t startByte, uint64_t size) {
@@ -42,13 +44,65 @@ void ApplicationMemoryManager::addMemoryRegion(uint64_t startByte, uint64_t size
 	})
 }
 
-void ApplicationMemoryManager::getData(uint64_t startByte, uint64_t size) {
-	// Set data like a vector
-	// memoryFile[i] = "data";
-	// This is set upon reading the network
-	// This will write the data to the file
-	// memoryFile.sync(errorCode);
-	// Upon being written, the hex editor will read the data on update
+void ApplicationMemoryManager::addMemoryWatch(std::string pointerDefinition, MemoryRegionTypes type, uint8_t isUnsigned, uint64_t dataSize) {
+	// The switch sends numbers at their own size, only strings and byte arrays use dataSize
+	uint32_t valueSize;
+	switch(type) {
+	case MemoryRegionTypes::Bit8:
+		valueSize = sizeof(uint8_t);
+		break;
+	case MemoryRegionTypes::Bit16:
+		valueSize = sizeof(uint16_t);
+		break;
+	case MemoryRegionTypes::Bit32:
+		valueSize = sizeof(uint32_t);
+		break;
+	case MemoryRegionTypes::Bit64:
+		valueSize = sizeof(uint64_t);
+		break;
+	case MemoryRegionTypes::Float:
+		valueSize = sizeof(float);
+		break;
+	case MemoryRegionTypes::Double:
+		valueSize = sizeof(double);
+		break;
+	case MemoryRegionTypes::Bool:
+		valueSize = sizeof(bool);
+		break;
+	default:
+		valueSize = dataSize;
+		break;
+	}
+
+	memoryTrace->addColumn(wxString::FromUTF8(pointerDefinition), type, isUnsigned, valueSize);
+
+	ADD_TO_QUEUE(SendAddMemoryRegion, networkInstance, {
+		data.pointerDefinition = pointerDefinition;
+		data.type              = type;
+		data.clearAllRegions   = false;
+		data.u                 = isUnsigned;
+		data.dataSize          = dataSize;
+	})
+}
+
+void ApplicationMemoryManager::clearMemoryWatches() {
+	memoryTrace->clearColumns();
+
+	ADD_TO_QUEUE(SendAddMemoryRegion, networkInstance, {
+		data.clearAllRegions = true;
+	})
+}
+
+void ApplicationMemoryManager::recordMemoryRegion(const Protocol::Struct_RecieveMemoryRegion& data, FrameNum traceFrame) {
+	memoryTrace->recordValue(data.index, data.branchIndex, traceFrame, data.memory);
+}
+
+bool ApplicationMemoryManager::getData(uint16_t index, BranchNum branch, FrameNum frame, std::vector<uint8_t>& bytes) {
+	std::shared_ptr<MemoryTraceColumn> column = memoryTrace->getColumn(index, branch);
+	if(!column) {
+		return false;
+	}
+	return column->getValue(frame, bytes);
 }
 
 void ApplicationMemoryManager::stopMemoryCollection(uint64_t startByte, uint64_t size) {
@@ -14,6 +14,7 @@
 #include <wx/string.h>
 
 #include "../sharedNetworkCode/networkInterface.hpp"
+#include "memoryTrace.hpp"
 
 struct MemorySection {
 	uint64_t startByte;
@@ -32,6 +33,9 @@ private:
 
 	std::unordered_map<std::string, std::shared_ptr<MemorySection>> memorySections;
 
+	// Values of every watch at every frame they were sent
+	std::shared_ptr<MemoryTrace> memoryTrace;
+
 	std::string getID(uint64_t startByte, uint64_t size) {
 		char buffer[50];
 		int n = sprintf(buffer, "%llu-%llu", startByte, size);
@@ -45,8 +49,19 @@ public:
 	// This creates a file in the project folder that's memory mapped
 	void addMemoryRegion(uint64_t startByte, uint64_t size);
 
-	// Data is automatically sent at every pause, but this gets it manually
-	void getData(uint64_t startByte, uint64_t size);
+	// Adds a watch on the switch, its values are recorded into the memory trace
+	void addMemoryWatch(std::string pointerDefinition, MemoryRegionTypes type, uint8_t isUnsigned, uint64_t dataSize);
+	void clearMemoryWatches();
+
+	// Data is automatically sent at every pause, it's recorded at the frame it was sent for
+	void recordMemoryRegion(const Protocol::Struct_RecieveMemoryRegion& data, FrameNum traceFrame);
+
+	// Reads back the value of a watch at any recorded frame of a branch
+	bool getData(uint16_t index, BranchNum branch, FrameNum frame, std::vector<uint8_t>& bytes);
+
+	std::shared_ptr<MemoryTrace> getMemoryTrace() {
+		return memoryTrace;
+	}
 
 	// Signals the switch to stop sending memory and makes getData invalid
 	// This also deletes the memory mapped file
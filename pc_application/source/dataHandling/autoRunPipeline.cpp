@@ -0,0 +1,43 @@
+#include "autoRunPipeline.hpp"
+
+void AutoRunPipeline::setWindow(uint32_t size) {
+	// Frames already in flight stay that way, only new ones are held back
+	window = size == 0 ? 1 : size > AUTO_RUN_MAX_FRAMES_IN_FLIGHT ? AUTO_RUN_MAX_FRAMES_IN_FLIGHT : size;
+}
+
+bool AutoRunPipeline::recieve(const Protocol::Struct_RecieveGameFramebuffer& data) {
+	if(data.sequence < nextToHandle || data.sequence >= nextSequence) {
+		// Sent before a reset, or never sent at all
+		return false;
+	}
+
+	early[data.sequence] = data;
+	return true;
+}
+
+bool AutoRunPipeline::takeNext(Protocol::Struct_RecieveGameFramebuffer& data) {
+	auto next = early.find(nextToHandle);
+	if(next == early.end()) {
+		return false;
+	}
+
+	data = std::move(next->second);
+	early.erase(next);
+	nextToHandle++;
+	framesHandled++;
+	return true;
+}
+
+void AutoRunPipeline::reset() {
+	nextToHandle = nextSequence;
+	early.clear();
+}
+
+void AutoRunPipeline::startTiming() {
+	timingStart   = std::chrono::steady_clock::now();
+	framesHandled = 0;
+}
+
+double AutoRunPipeline::getSecondsElapsed() const {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - timingStart).count();
+}
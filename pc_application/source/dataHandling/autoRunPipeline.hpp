@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+#include "../sharedNetworkCode/networkingStructures.hpp"
+
+// Most frames auto run can have sent and not heard back from yet
+#define AUTO_RUN_MAX_FRAMES_IN_FLIGHT 16
+
+// Auto run frames sent ahead, so the switch runs the next frame while the PC is still handling the last framebuffer
+// Every frame gets a sequence number, framebuffers are only handled in the order the frames were sent
+// Anything that comes early waits for the ones before it, anything from before a reset is dropped
+class AutoRunPipeline {
+private:
+	// 1 is the old behavior, one frame at a time
+	uint32_t window = 1;
+
+	// Sequence 0 is left for frames that aren't part of auto run
+	uint32_t nextSequence = 1;
+	uint32_t nextToHandle = 1;
+	std::map<uint32_t, Protocol::Struct_RecieveGameFramebuffer> early;
+
+	// For the throughput shown when auto run stops
+	std::chrono::steady_clock::time_point timingStart;
+	uint32_t framesHandled = 0;
+
+public:
+	void setWindow(uint32_t size);
+	uint32_t getWindow() const {
+		return window;
+	}
+
+	uint32_t getNumInFlight() const {
+		return nextSequence - nextToHandle;
+	}
+
+	bool canSend() const {
+		return getNumInFlight() < window;
+	}
+
+	uint32_t takeSequence() {
+		return nextSequence++;
+	}
+
+	// Returns false if this sequence isn't in flight
+	bool recieve(const Protocol::Struct_RecieveGameFramebuffer& data);
+	// The next framebuffer in order, false if it hasn't come yet
+	bool takeNext(Protocol::Struct_RecieveGameFramebuffer& data);
+
+	// Frames still in flight are forgotten, like when the savestate hook changes
+	void reset();
+
+	void startTiming();
+	uint32_t getFramesHandled() const {
+		return framesHandled;
+	}
+	double getSecondsElapsed() const;
+};
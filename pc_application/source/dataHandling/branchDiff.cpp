@@ -0,0 +1,318 @@
+#include "branchDiff.hpp"
+
+// Odd, so every power of it is too
+static const uint64_t chunkHashBase = 0x100000001B3ULL;
+
+static uint64_t hashChunk(const uint64_t* frameHashes) {
+	uint64_t hash = 0;
+	for(int i = 0; i < BRANCH_DIFF_CHUNK_SIZE; i++) {
+		hash = hash * chunkHashBase + frameHashes[i];
+	}
+	return hash;
+}
+
+bool BranchDiff::framesEqual(const std::shared_ptr<ControllerData>& left, const std::shared_ptr<ControllerData>& right) {
+	// Shared by copy on write, most of a forked branch
+	if(left == right) {
+		return true;
+	}
+
+	// Frame state is for the editor, it's not an input
+	const ControllerData& a = *left;
+	const ControllerData& b = *right;
+	return a.buttons == b.buttons && a.LS_X == b.LS_X && a.LS_Y == b.LS_Y && a.RS_X == b.RS_X && a.RS_Y == b.RS_Y && a.ACCEL_X == b.ACCEL_X && a.ACCEL_Y == b.ACCEL_Y && a.ACCEL_Z == b.ACCEL_Z && a.GYRO_1 == b.GYRO_1 && a.GYRO_2 == b.GYRO_2 && a.GYRO_3 == b.GYRO_3;
+}
+
+uint64_t BranchDiff::hashFrame(const ControllerData& data) {
+	// Every input packed into 3 words
+	uint64_t words[3] = {
+		data.buttons | (uint64_t)(uint16_t)data.LS_X << 32 | (uint64_t)(uint16_t)data.LS_Y << 48,
+		(uint64_t)(uint16_t)data.RS_X | (uint64_t)(uint16_t)data.RS_Y << 16 | (uint64_t)(uint16_t)data.ACCEL_X << 32 | (uint64_t)(uint16_t)data.ACCEL_Y << 48,
+		(uint64_t)(uint16_t)data.ACCEL_Z | (uint64_t)(uint16_t)data.GYRO_1 << 16 | (uint64_t)(uint16_t)data.GYRO_2 << 32 | (uint64_t)(uint16_t)data.GYRO_3 << 48,
+	};
+
+	uint64_t hash = 0x9E3779B97F4A7C15ULL;
+	for(uint64_t word : words) {
+		hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+		hash ^= hash >> 32;
+	}
+	return hash;
+}
+
+void BranchDiff::compute(const std::vector<std::shared_ptr<ControllerData>>& otherFrames, const std::vector<std::shared_ptr<ControllerData>>& frames) {
+	clear();
+	numFrames = frames.size();
+
+	FrameNum otherSize = otherFrames.size();
+	FrameNum size      = frames.size();
+
+	FrameNum prefix = 0;
+	while(prefix < otherSize && prefix < size && framesEqual(otherFrames[prefix], frames[prefix])) {
+		prefix++;
+	}
+
+	FrameNum suffix = 0;
+	while(suffix < otherSize - prefix && suffix < size - prefix && framesEqual(otherFrames[otherSize - 1 - suffix], frames[size - 1 - suffix])) {
+		suffix++;
+	}
+
+	framesTrimmed       = prefix + suffix;
+	FrameNum otherCount = otherSize - prefix - suffix;
+	FrameNum count      = size - prefix - suffix;
+	if(otherCount == 0 || count == 0) {
+		if(otherCount != 0 || count != 0) {
+			addHunk(prefix, otherCount, prefix, count);
+		}
+		return;
+	}
+
+	// Only the middle is hashed, frames are compared by hash from here on
+	otherHashes.resize(otherCount);
+	for(FrameNum i = 0; i < otherCount; i++) {
+		otherHashes[i] = hashFrame(*otherFrames[prefix + i]);
+	}
+	hashes.resize(count);
+	for(FrameNum i = 0; i < count; i++) {
+		hashes[i] = hashFrame(*frames[prefix + i]);
+	}
+
+	std::vector<Anchor> anchors;
+	findAnchors(anchors);
+
+	FrameNum otherPos = 0;
+	FrameNum pos      = 0;
+	for(auto const& anchor : anchors) {
+		diffWindow(otherPos, anchor.otherStart, pos, anchor.start, prefix);
+		otherPos = anchor.otherStart + anchor.count;
+		pos      = anchor.start + anchor.count;
+	}
+	diffWindow(otherPos, otherCount, pos, count, prefix);
+
+	// Big branches shouldn't keep this around
+	otherHashes.clear();
+	otherHashes.shrink_to_fit();
+	hashes.clear();
+	hashes.shrink_to_fit();
+	trace.clear();
+	trace.shrink_to_fit();
+}
+
+void BranchDiff::findAnchors(std::vector<Anchor>& anchors) {
+	FrameNum otherSize = otherHashes.size();
+	FrameNum size      = hashes.size();
+	if(otherSize < BRANCH_DIFF_CHUNK_SIZE || size < BRANCH_DIFF_CHUNK_SIZE) {
+		return;
+	}
+
+	// Chunks of the viewed branch on chunk boundaries
+	// Repeated ones (waiting with no input) would line up with the wrong copy, so only unique chunks are used
+	std::unordered_map<uint64_t, FrameNum> chunks;
+	chunks.reserve(size / BRANCH_DIFF_CHUNK_SIZE);
+	for(FrameNum start = 0; start + BRANCH_DIFF_CHUNK_SIZE <= size; start += BRANCH_DIFF_CHUNK_SIZE) {
+		auto inserted = chunks.emplace(hashChunk(&hashes[start]), start);
+		if(!inserted.second) {
+			inserted.first->second = UINT32_MAX;
+		}
+	}
+
+	// To take the oldest frame out of the rolling hash
+	uint64_t power = 1;
+	for(int i = 0; i < BRANCH_DIFF_CHUNK_SIZE - 1; i++) {
+		power *= chunkHashBase;
+	}
+
+	// Every position of the other branch, anchors have to go forward in both
+	FrameNum otherNext = 0;
+	FrameNum next      = 0;
+	FrameNum i         = 0;
+	uint64_t rolling   = hashChunk(&otherHashes[0]);
+	while(true) {
+		auto found = chunks.find(rolling);
+		if(found != chunks.end() && found->second != UINT32_MAX && found->second >= next && std::equal(&otherHashes[i], &otherHashes[i] + BRANCH_DIFF_CHUNK_SIZE, &hashes[found->second])) {
+			Anchor anchor;
+			anchor.otherStart = i;
+			anchor.start      = found->second;
+			anchor.count      = BRANCH_DIFF_CHUNK_SIZE;
+
+			// Grow both ways, but not into the last anchor
+			while(anchor.otherStart > otherNext && anchor.start > next && otherHashes[anchor.otherStart - 1] == hashes[anchor.start - 1]) {
+				anchor.otherStart--;
+				anchor.start--;
+				anchor.count++;
+			}
+			while(anchor.otherStart + anchor.count < otherSize && anchor.start + anchor.count < size && otherHashes[anchor.otherStart + anchor.count] == hashes[anchor.start + anchor.count]) {
+				anchor.count++;
+			}
+
+			anchors.push_back(anchor);
+			framesAnchored += anchor.count;
+
+			otherNext = anchor.otherStart + anchor.count;
+			next      = anchor.start + anchor.count;
+			i         = otherNext;
+			if(i + BRANCH_DIFF_CHUNK_SIZE > otherSize) {
+				break;
+			}
+			rolling = hashChunk(&otherHashes[i]);
+			continue;
+		}
+
+		if(i + BRANCH_DIFF_CHUNK_SIZE >= otherSize) {
+			break;
+		}
+		rolling = (rolling - otherHashes[i] * power) * chunkHashBase + otherHashes[i + BRANCH_DIFF_CHUNK_SIZE];
+		i++;
+	}
+}
+
+void BranchDiff::diffWindow(FrameNum otherStart, FrameNum otherEnd, FrameNum start, FrameNum end, FrameNum offset) {
+	// Anchors only cover chunks, the frames next to them can match too
+	while(otherStart < otherEnd && start < end && otherHashes[otherStart] == hashes[start]) {
+		otherStart++;
+		start++;
+	}
+	while(otherStart < otherEnd && start < end && otherHashes[otherEnd - 1] == hashes[end - 1]) {
+		otherEnd--;
+		end--;
+	}
+
+	int32_t otherCount = otherEnd - otherStart;
+	int32_t count      = end - start;
+	if(otherCount == 0 || count == 0) {
+		if(otherCount != 0 || count != 0) {
+			addHunk(otherStart + offset, otherCount, start + offset, count);
+		}
+		return;
+	}
+
+	numWindows++;
+
+	// Myers, x is in the other branch and y in this one, diagonal k is x - y
+	// The furthest x of every diagonal is kept after each round for backtracking
+	int32_t maxEdits = std::min<int64_t>((int64_t)otherCount + count, BRANCH_DIFF_MAX_EDITS);
+	std::vector<int32_t> furthest(2 * maxEdits + 3, 0);
+	int32_t* v = &furthest[maxEdits + 1];
+
+	const uint64_t* otherWindow = &otherHashes[otherStart];
+	const uint64_t* window      = &hashes[start];
+
+	trace.clear();
+	int32_t numEdits = -1;
+	for(int32_t d = 0; d <= maxEdits && numEdits == -1; d++) {
+		for(int32_t k = -d; k <= d; k += 2) {
+			int32_t x = (k == -d || (k != d && v[k - 1] < v[k + 1])) ? v[k + 1] : v[k - 1] + 1;
+			int32_t y = x - k;
+			while(x < otherCount && y < count && otherWindow[x] == window[y]) {
+				x++;
+				y++;
+			}
+			v[k] = x;
+			if(x >= otherCount && y >= count) {
+				numEdits = d;
+			}
+		}
+		// Round d starts at d^2
+		trace.insert(trace.end(), &v[-d], &v[d] + 1);
+	}
+
+	if(numEdits == -1) {
+		// Too different to line up, good enough for a gutter
+		numGivenUp++;
+		addHunk(otherStart + offset, otherCount, start + offset, count);
+		return;
+	}
+
+	// Walk back from the end, one edit per round, merging neighbouring edits into hunks
+	std::vector<BranchDiffHunk> windowHunks;
+	int32_t x = otherCount;
+	int32_t y = count;
+	for(int32_t d = numEdits; d > 0; d--) {
+		const int32_t* previous = &trace[(d - 1) * (d - 1) + (d - 1)];
+
+		int32_t k         = x - y;
+		bool inserted     = k == -d || (k != d && previous[k - 1] < previous[k + 1]);
+		int32_t previousK = inserted ? k + 1 : k - 1;
+		x                 = previous[previousK];
+		y                 = x - previousK;
+
+		// The edit is at x, y, everything after it up to the last edit was the same
+		FrameNum editOtherCount = inserted ? 0 : 1;
+		FrameNum editCount      = inserted ? 1 : 0;
+		if(!windowHunks.empty() && windowHunks.back().otherStart == x + editOtherCount && windowHunks.back().start == y + editCount) {
+			BranchDiffHunk& hunk = windowHunks.back();
+			hunk.otherStart      = x;
+			hunk.start           = y;
+			hunk.otherCount += editOtherCount;
+			hunk.count += editCount;
+		} else {
+			windowHunks.push_back({ (FrameNum)x, editOtherCount, (FrameNum)y, editCount });
+		}
+	}
+
+	for(auto hunk = windowHunks.rbegin(); hunk != windowHunks.rend(); hunk++) {
+		addHunk(hunk->otherStart + otherStart + offset, hunk->otherCount, hunk->start + start + offset, hunk->count);
+	}
+}
+
+void BranchDiff::addHunk(FrameNum otherStart, FrameNum otherCount, FrameNum start, FrameNum count) {
+	if(!hunks.empty()) {
+		BranchDiffHunk& last = hunks.back();
+		if(last.otherStart + last.otherCount == otherStart && last.start + last.count == start) {
+			last.otherCount += otherCount;
+			last.count += count;
+			return;
+		}
+	}
+	hunks.push_back({ otherStart, otherCount, start, count });
+}
+
+void BranchDiff::clear() {
+	hunks.clear();
+	numFrames      = 0;
+	framesTrimmed  = 0;
+	framesAnchored = 0;
+	numWindows     = 0;
+	numGivenUp     = 0;
+}
+
+uint8_t BranchDiff::getMark(FrameNum frame) const {
+	// Removals are shown on the frame after them, so they take up a frame here
+	auto hunk = std::partition_point(hunks.begin(), hunks.end(), [frame](const BranchDiffHunk& hunk) { return hunk.start + std::max<FrameNum>(hunk.count, 1) <= frame; });
+
+	uint8_t mark = DIFF_NONE;
+	if(hunk != hunks.end() && hunk->start <= frame) {
+		if(hunk->count == 0) {
+			mark = DIFF_REMOVED_ABOVE;
+		} else {
+			mark = hunk->otherCount == 0 ? DIFF_ADDED : DIFF_CHANGED;
+		}
+	}
+
+	// Removed from the very end, there is no frame after it
+	if(frame + 1 == numFrames && !hunks.empty() && hunks.back().count == 0 && hunks.back().start == numFrames) {
+		mark |= DIFF_REMOVED_BELOW;
+	}
+	return mark;
+}
+
+bool BranchDiff::findNextHunk(FrameNum from, FrameNum& frame) const {
+	auto hunk = std::partition_point(hunks.begin(), hunks.end(), [from](const BranchDiffHunk& hunk) { return hunk.start < from; });
+	if(hunk == hunks.end()) {
+		return false;
+	}
+	// Can only be past the end when frames were removed there
+	frame = std::min<FrameNum>(hunk->start, numFrames == 0 ? 0 : numFrames - 1);
+	return true;
+}
+
+FrameNum BranchDiff::getNumDifferentFrames() const {
+	FrameNum count = 0;
+	for(auto const& hunk : hunks) {
+		count += hunk.count;
+	}
+	return count;
+}
+
+void BranchDiff::logStats(int64_t microseconds) const {
+	wxLogDebug("Branch diff of %u frames in %lld us: %zu hunks, %u frames trimmed, %u anchored, %u windows diffed, %u too different", numFrames, (long long)microseconds, hunks.size(), framesTrimmed, framesAnchored, numWindows, numGivenUp);
+}
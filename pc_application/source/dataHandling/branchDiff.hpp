@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <wx/log.h>
+
+#include "../sharedNetworkCode/buttonData.hpp"
+#include "buttonConstants.hpp"
+
+// Frames per chunk when looking for identical regions, smaller finds shorter matches but more false starts
+#define BRANCH_DIFF_CHUNK_SIZE 64
+// Edits tried per window before the whole window is just called changed
+// The trace takes (edits + 1)^2 ints
+#define BRANCH_DIFF_MAX_EDITS 1024
+
+// Marks for the gutter of one frame of the viewed branch
+enum BranchDiffMark : uint8_t {
+	DIFF_NONE = 0,
+	// Different from the frame it lines up with
+	DIFF_CHANGED = 1,
+	// Not in the other branch at all
+	DIFF_ADDED = 2,
+	// The other branch has frames here that this one doesn't
+	DIFF_REMOVED_ABOVE = 4,
+	DIFF_REMOVED_BELOW = 8,
+};
+
+// One region that differs, an insert has no other frames and a removal has no frames
+struct BranchDiffHunk {
+	FrameNum otherStart;
+	FrameNum otherCount;
+	FrameNum start;
+	FrameNum count;
+};
+
+// Lines up two branches of the same savestate hook
+// The common start and end are skipped first, forked branches share frames so that's mostly pointer compares
+// Chunks of frames that only appear once in the viewed branch are found in the other with a rolling hash, those become anchors
+// Only the windows between anchors are diffed frame by frame (Myers), so a mostly identical 1M frame branch is fast
+class BranchDiff {
+private:
+	std::vector<BranchDiffHunk> hunks;
+	FrameNum numFrames = 0;
+
+	// Per window, reused
+	std::vector<uint64_t> otherHashes;
+	std::vector<uint64_t> hashes;
+	std::vector<int32_t> trace;
+
+	// For the log
+	FrameNum framesTrimmed  = 0;
+	FrameNum framesAnchored = 0;
+	uint32_t numWindows     = 0;
+	uint32_t numGivenUp     = 0;
+
+	struct Anchor {
+		FrameNum otherStart;
+		FrameNum start;
+		FrameNum count;
+	};
+
+	static bool framesEqual(const std::shared_ptr<ControllerData>& left, const std::shared_ptr<ControllerData>& right);
+	static uint64_t hashFrame(const ControllerData& data);
+
+	void findAnchors(std::vector<Anchor>& anchors);
+	// Both are relative to the start of the hashes, the hunks are offset
+	void diffWindow(FrameNum otherStart, FrameNum otherEnd, FrameNum start, FrameNum end, FrameNum offset);
+	void addHunk(FrameNum otherStart, FrameNum otherCount, FrameNum start, FrameNum count);
+
+public:
+	// Hunks are sorted and never touch
+	void compute(const std::vector<std::shared_ptr<ControllerData>>& otherFrames, const std::vector<std::shared_ptr<ControllerData>>& frames);
+	void clear();
+
+	const std::vector<BranchDiffHunk>& getHunks() const {
+		return hunks;
+	}
+
+	uint8_t getMark(FrameNum frame) const;
+	// Start of the first hunk after from, returns false if there isn't one
+	bool findNextHunk(FrameNum from, FrameNum& frame) const;
+
+	// Frames in the viewed branch that differ
+	FrameNum getNumDifferentFrames() const;
+	void logStats(int64_t microseconds) const;
+};
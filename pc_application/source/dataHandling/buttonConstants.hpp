@@ -19,6 +19,16 @@ typedef uint32_t FrameNum;
 typedef uint16_t SavestateBlockNum;
 typedef uint16_t BranchNum;
 
+// Branches point at the same frames until one of them edits it, then that branch gets its own copy
+// Anything writing to a frame in a branch has to go through this
+inline ControllerData& getWritableFrame(std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum frame) {
+	std::shared_ptr<ControllerData>& data = frames[frame];
+	if(data.use_count() > 1) {
+		data = std::make_shared<ControllerData>(*data);
+	}
+	return *data;
+}
+
 // Struct containing button info
 struct ButtonInfo {
 	std::string scriptName;
@@ -50,6 +60,8 @@ struct SavestateHook {
 	std::string dHash;
 	wxBitmap* screenshot;
 	SavestateHookBlock inputs;
+	// One per branch, every frame before it has been run, missing ones haven't been run
+	std::vector<FrameNum> runWatermarks;
 };
 
 enum ControllerNumberValues : uint8_t {
@@ -70,160 +70,54 @@ void ButtonData::setupButtonMapping(rapidjson::Document* mainSettings) {
 
 		buttonMapping[chosenButton] = thisButtonInfo;
 	}
-}
-
-FrameNum ButtonData::textToFrames(DataProcessing* dataProcessing, std::string text, FrameNum startLoc, bool insertPaste, bool placePaste) {
-	std::vector<std::string> frameParts = HELPERS::splitString(text, '\n');
-	bool haveSetFirstFrame              = false;
-	FrameNum firstFrame;
-	FrameNum lastReadFrame;
-	for(std::string frame : frameParts) {
-		// Split on whitespace
-		std::vector<std::string> parts = HELPERS::splitString(frame, ' ');
-		// This is to allow a variable number of parts
-		uint8_t currentIndexInParts = 0;
-
-		// This is repeated to break function when it runs out of parts, allows variable
-		// Amounts of data per line
-		if(parts.size() == currentIndexInParts)
-			continue;
-
-		// Has to be decimal number
-		FrameNum frameNum = strtol(parts[currentIndexInParts].c_str(), nullptr, 10);
-
-		if(!haveSetFirstFrame) {
-			// This is the first script frame, it will be put at the startLoc
-			firstFrame = frameNum;
-		}
-
-		// The actual index
-		FrameNum actualIndex = startLoc + (frameNum - firstFrame);
-
-		// Just to keep the app running
-		if(actualIndex % 50 == 0) {
-			wxTheApp->Yield();
-		}
-
-		FrameNum thisDataIndex;
-
-		if(insertPaste || actualIndex >= dataProcessing->getFramesSize()) {
-			if(actualIndex >= dataProcessing->getFramesSize()) {
-				actualIndex--;
-			}
-			// It's a new one
-			// Loop through and add frames to keep the right offset between this frame
-			// And the last one
-			if(haveSetFirstFrame) {
-				// Can use expected indexing
-				for(FrameNum i = lastReadFrame + 1; i < actualIndex; i++) {
-					// Add a blank frame for buffer
-					dataProcessing->addFrame(i - 1);
-				}
-				// Now can easily add the frame later
-			}
-			// Insert it now, it's just a pointer
-			dataProcessing->addFrame(actualIndex);
-			thisDataIndex = actualIndex + 1;
-			// If it's the first frame, no need for padding
-		} else {
-			thisDataIndex = actualIndex;
-		}
-
-		// Now can set the variable
-		haveSetFirstFrame = true;
-		// Have reference, so we can now do this
-		lastReadFrame = actualIndex;
-
-		currentIndexInParts++;
-		if(parts.size() == currentIndexInParts)
-			continue;
 
-		if(!placePaste) {
-			// Clear the buttons if no place paste
-			dataProcessing->clearAllButtons(thisDataIndex);
-		}
-
-		// Deal with buttons
-		// Can be no buttons at all
-		if(parts[currentIndexInParts] != "NONE") {
-			for(std::string buttonName : HELPERS::splitString(parts[currentIndexInParts], ';')) {
-				if(scriptNameToButton.count(buttonName)) {
-					dataProcessing->modifyButton(thisDataIndex, scriptNameToButton[buttonName], true);
-				}
-			}
-		}
+	std::vector<std::pair<std::string, Btn>> scriptNames(scriptNameToButton.begin(), scriptNameToButton.end());
+	scriptParser.setButtonNames(scriptNames);
 
-		currentIndexInParts++;
-		if(parts.size() == currentIndexInParts)
-			continue;
-
-		// Joysticks
-		std::vector<std::string> joystickPartsLeft = HELPERS::splitString(parts[currentIndexInParts], ';');
-		if(joystickPartsLeft.size() == 2) {
-			dataProcessing->setNumberValues(thisDataIndex, ControllerNumberValues::LEFT_X, strtol(joystickPartsLeft[0].c_str(), nullptr, 10));
-			dataProcessing->setNumberValues(thisDataIndex, ControllerNumberValues::LEFT_Y, strtol(joystickPartsLeft[1].c_str(), nullptr, 10));
-		} else {
-			continue;
-		}
+	std::vector<std::string> buttonScriptNames(Btn::BUTTONS_SIZE);
+	for(auto const& button : buttonMapping) {
+		buttonScriptNames[button.first] = button.second->scriptName;
+	}
+	scriptWriter.setButtonNames(buttonScriptNames);
+}
 
-		currentIndexInParts++;
-		if(parts.size() == currentIndexInParts)
-			continue;
+FrameNum ButtonData::textToFrames(DataProcessing* dataProcessing, std::string text, FrameNum startLoc, bool insertPaste, bool placePaste) {
+	auto start = std::chrono::steady_clock::now();
 
-		std::vector<std::string> joystickPartsRight = HELPERS::splitString(parts[currentIndexInParts], ';');
-		if(joystickPartsRight.size() == 2) {
-			dataProcessing->setNumberValues(thisDataIndex, ControllerNumberValues::RIGHT_X, strtol(joystickPartsRight[0].c_str(), nullptr, 10));
-			dataProcessing->setNumberValues(thisDataIndex, ControllerNumberValues::RIGHT_Y, strtol(joystickPartsRight[1].c_str(), nullptr, 10));
-		} else {
-			continue;
-		}
+	std::vector<ScriptFrame> frames;
+	scriptParser.parse(text, frames);
 
-		currentIndexInParts++;
-		if(parts.size() == currentIndexInParts)
-			continue;
+	auto parsed = std::chrono::steady_clock::now();
 
-		// Accelerometer and gyro data
+	FrameNum lastFrame = dataProcessing->pasteFrames(frames, startLoc, insertPaste, placePaste);
 
-		std::vector<std::string> accelParts = HELPERS::splitString(parts[currentIndexInParts], ';');
-		if(accelParts.size() == 3) {
-			dataProcessing->setNumberValues(thisDataIndex, ControllerNumberValues::ACCEL_X, strtol(accelParts[0].c_str(), nullptr, 10));
-			dataProcessing->setNumberValues(thisDataIndex, ControllerNumberValues::ACCEL_Y, strtol(accelParts[1].c_str(), nullptr, 10));
-			dataProcessing->setNumberValues(thisDataIndex, ControllerNumberValues::ACCEL_Z, strtol(accelParts[2].c_str(), nullptr, 10));
-		} else {
-			continue;
-		}
+	auto committed = std::chrono::steady_clock::now();
 
-		currentIndexInParts++;
-		if(parts.size() == currentIndexInParts)
-			continue;
-
-		std::vector<std::string> gyroParts = HELPERS::splitString(parts[currentIndexInParts], ';');
-		if(gyroParts.size() == 3) {
-			dataProcessing->setNumberValues(thisDataIndex, ControllerNumberValues::GYRO_1, strtol(gyroParts[0].c_str(), nullptr, 10));
-			dataProcessing->setNumberValues(thisDataIndex, ControllerNumberValues::GYRO_2, strtol(gyroParts[1].c_str(), nullptr, 10));
-			dataProcessing->setNumberValues(thisDataIndex, ControllerNumberValues::GYRO_3, strtol(gyroParts[2].c_str(), nullptr, 10));
-		} else {
-			continue;
-		}
-	}
+	double parseSeconds = std::chrono::duration<double>(parsed - start).count();
+	double megabytes    = text.size() / 1000000.0;
+	wxLogMessage(wxString::Format("Parsed %zu frames (%.2f MB) at %.1f MB/s, committed in %d ms", frames.size(), megabytes, parseSeconds > 0 ? megabytes / parseSeconds : 0.0,
+		(int)std::chrono::duration_cast<std::chrono::milliseconds>(committed - parsed).count()));
 
-	return lastReadFrame;
+	return lastFrame;
 }
 
-std::string ButtonData::framesToText(DataProcessing* dataProcessing, FrameNum startLoc, FrameNum endLoc, int playerIndex, BranchNum branch) {
+void ButtonData::snapshotFrames(DataProcessing* dataProcessing, FrameNum startLoc, FrameNum endLoc, int playerIndex, BranchNum branch, std::vector<ScriptFrame>& frames) {
 	// If the player index is provided, get every savestate hook in that player
-	std::vector<std::string> textVector;
-	// Loop through each frame and convert it
 	SavestateBlockNum start;
 	SavestateBlockNum end;
+	uint8_t realPlayer;
 	if(playerIndex == -1) {
-		start = dataProcessing->getCurrentSavestateHook();
-		end   = dataProcessing->getCurrentSavestateHook() + 1;
+		start      = dataProcessing->getCurrentSavestateHook();
+		end        = dataProcessing->getCurrentSavestateHook() + 1;
+		realPlayer = dataProcessing->getCurrentPlayer();
 	} else {
-		start = 0;
-		end   = dataProcessing->getNumOfSavestateHooks(playerIndex);
+		start      = 0;
+		end        = dataProcessing->getNumOfSavestateHooks(playerIndex);
+		realPlayer = playerIndex;
 	}
 
+	frames.clear();
+
 	FrameNum indexForAllSavestateHooks = 0;
 	for(SavestateBlockNum j = start; j < end; j++) {
 		if(playerIndex != -1) {
@@ -232,76 +126,50 @@ std::string ButtonData::framesToText(DataProcessing* dataProcessing, FrameNum st
 		}
 
 		for(FrameNum i = startLoc; i <= endLoc; i++) {
-			// Just to keep the app running
-			if(i % 50 == 0) {
-				wxTheApp->Yield();
-			}
+			std::shared_ptr<ControllerData> data = dataProcessing->getControllerData(realPlayer, j, branch, i);
 
 			// Keeping empty ones there clutters things
-			if(!isEmptyControllerData(dataProcessing->getFrame(i))) {
-				std::vector<std::string> parts;
-
-				if(playerIndex == -1) {
-					parts.push_back(std::to_string(i));
-				} else {
-					parts.push_back(std::to_string(indexForAllSavestateHooks));
-				}
-
-				std::vector<std::string> buttonParts;
-				for(uint8_t btn = 0; btn < Btn::BUTTONS_SIZE; btn++) {
-					Btn button = (Btn)btn;
-					uint8_t isSelected;
-					if(playerIndex == -1) {
-						isSelected = dataProcessing->getButton(i, button);
-					} else {
-						isSelected = dataProcessing->getButtonSpecific(i, button, j, branch, playerIndex);
-					}
-					if(isSelected) {
-						// Add to the string
-						buttonParts.push_back(buttonMapping[button]->scriptName);
-					}
-				}
-
-				if(buttonParts.size() == 0) {
-					// Sometimes, it's nothing, so push a constant
-					parts.push_back("NONE");
-				} else {
-					parts.push_back(HELPERS::joinString(buttonParts, ";"));
-				}
-
-				typedef ControllerNumberValues CNV;
-
-				uint8_t realPlayer;
-				if(playerIndex == -1) {
-					realPlayer = dataProcessing->getCurrentPlayer();
-				} else {
-					realPlayer = playerIndex;
-				}
-
-				// clang-format off
-				parts.push_back(std::to_string(dataProcessing->getNumberValuesSpecific(i, CNV::LEFT_X, j, branch, realPlayer)) + \
-					";" + std::to_string(dataProcessing->getNumberValuesSpecific(i, CNV::LEFT_Y, j, branch, realPlayer)));
-
-				parts.push_back(std::to_string(dataProcessing->getNumberValuesSpecific(i, CNV::RIGHT_X, j, branch, realPlayer)) + \
-					";" + std::to_string(dataProcessing->getNumberValuesSpecific(i, CNV::RIGHT_Y, j,branch, realPlayer)));
-
-				parts.push_back(std::to_string(dataProcessing->getNumberValuesSpecific(i, CNV::ACCEL_X, j, branch, realPlayer)) + \
-					";" + std::to_string(dataProcessing->getNumberValuesSpecific(i, CNV::ACCEL_Y, j, branch, realPlayer)) + \
-					";" + std::to_string(dataProcessing->getNumberValuesSpecific(i, CNV::ACCEL_Z, j, branch, realPlayer)));
-
-				parts.push_back(std::to_string(dataProcessing->getNumberValuesSpecific(i, CNV::GYRO_1, j,branch, realPlayer)) + \
-					";" + std::to_string(dataProcessing->getNumberValuesSpecific(i, CNV::GYRO_2, j, branch, realPlayer)) + \
-					";" + std::to_string(dataProcessing->getNumberValuesSpecific(i, CNV::GYRO_3, j, branch, realPlayer)));
-				// clang-format on
-
-				textVector.push_back(HELPERS::joinString(parts, " "));
+			if(!isEmptyControllerData(data)) {
+				ScriptFrame frame = { 0 };
+				frame.offset      = playerIndex == -1 ? i : indexForAllSavestateHooks;
+				frame.lastField   = SCRIPT_GYRO;
+				frame.buttons     = data->buttons;
+				frame.LS_X        = data->LS_X;
+				frame.LS_Y        = data->LS_Y;
+				frame.RS_X        = data->RS_X;
+				frame.RS_Y        = data->RS_Y;
+				frame.ACCEL_X     = data->ACCEL_X;
+				frame.ACCEL_Y     = data->ACCEL_Y;
+				frame.ACCEL_Z     = data->ACCEL_Z;
+				frame.GYRO_1      = data->GYRO_1;
+				frame.GYRO_2      = data->GYRO_2;
+				frame.GYRO_3      = data->GYRO_3;
+				frames.push_back(frame);
 			}
 
 			indexForAllSavestateHooks++;
 		}
 	}
-	// Return with newlines
-	return HELPERS::joinString(textVector, "\n");
+}
+
+std::string ButtonData::framesToText(DataProcessing* dataProcessing, FrameNum startLoc, FrameNum endLoc, int playerIndex, BranchNum branch) {
+	std::vector<ScriptFrame> frames;
+	snapshotFrames(dataProcessing, startLoc, endLoc, playerIndex, branch, frames);
+	return scriptWriter.writeToString(frames);
+}
+
+std::string ButtonData::selectionToText(DataProcessing* dataProcessing, const FrameSelection& selection, BranchNum branch) {
+	std::vector<ScriptFrame> frames;
+	std::vector<ScriptFrame> intervalFrames;
+	for(auto const& interval : selection.getIntervals()) {
+		snapshotFrames(dataProcessing, interval.start, interval.end, -1, branch, intervalFrames);
+		for(auto& frame : intervalFrames) {
+			// Gaps between the intervals stay as gaps
+			frame.offset -= selection.first();
+			frames.push_back(frame);
+		}
+	}
+	return scriptWriter.writeToString(frames);
 }
 
 void ButtonData::transferControllerData(ControllerData src, std::shared_ptr<ControllerData> dest, bool placePaste) {
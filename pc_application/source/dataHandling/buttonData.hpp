@@ -4,6 +4,7 @@
 #define GET_BIT(number, loc) ((number) >> (loc)) & 1U
 
 #include <bitset>
+#include <chrono>
 #include <cstdio>
 #include <map>
 #include <memory>
@@ -19,6 +20,9 @@
 #include "../sharedNetworkCode/buttonData.hpp"
 #include "buttonConstants.hpp"
 #include "dataProcessing.hpp"
+#include "frameSelection.hpp"
+#include "scriptParser.hpp"
+#include "scriptWriter.hpp"
 
 // Forward declare to allow headers to include each other
 class DataProcessing;
@@ -66,10 +70,21 @@ public:
 
 	std::map<Btn, std::shared_ptr<ButtonInfo>> buttonMapping;
 
+	ScriptParser scriptParser;
+	ScriptWriter scriptWriter;
+
 	void setupButtonMapping(rapidjson::Document* mainSettings);
 
+	void parseScript(std::string_view text, std::vector<ScriptFrame>& frames) {
+		scriptParser.parse(text, frames);
+	}
+
 	FrameNum textToFrames(DataProcessing* dataProcessing, std::string text, FrameNum startLoc, bool insertPaste, bool placePaste);
+	// Copies the frames that aren't empty, so they can be written out on another thread
+	void snapshotFrames(DataProcessing* dataProcessing, FrameNum startLoc, FrameNum endLoc, int playerIndex, BranchNum branch, std::vector<ScriptFrame>& frames);
 	std::string framesToText(DataProcessing* dataProcessing, FrameNum startLoc, FrameNum endLoc, int playerIndex, BranchNum branch);
+	// Current player and savestate hook, offsets start at the first selected frame so it can be pasted anywhere
+	std::string selectionToText(DataProcessing* dataProcessing, const FrameSelection& selection, BranchNum branch);
 
 	void transferControllerData(ControllerData src, std::shared_ptr<ControllerData> dest, bool placePaste);
 
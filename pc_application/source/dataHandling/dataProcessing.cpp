@@ -2,55 +2,44 @@
 #include "buttonData.hpp"
 
 DataProcessing::DataProcessing(rapidjson::Document* settings, std::shared_ptr<ButtonData> buttons, std::shared_ptr<CommunicateWithNetwork> communicateWithNetwork, wxWindow* parent)
-	: wxListCtrl(parent, DataProcessing::LIST_CTRL_ID, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_VIRTUAL | wxLC_HRULES) {
+	: InputGrid(parent) {
 
 	// All savestate hook blocks
 	// Start with default, will get cleared later
 	addNewPlayer();
 	addNewSavestateHook("", HELPERS::getDefaultSavestateScreenshot());
 
-	// This can't handle it :(
-	SetDoubleBuffered(false);
 	DragAcceptFiles(true);
-	// Inherit from list control
-	// Use this specific ID in order to do things
 	buttonData      = buttons;
 	mainSettings    = settings;
 	networkInstance = communicateWithNetwork;
 	// Set the mask color via a css string
 	// https://docs.wxwidgets.org/3.0/classwx_colour.html#a08e9f56265647b8b5e1349b76eb728e3
 	maskColor.Set((*mainSettings)["iconTransparent"].GetString());
-	// This is cool, so set it
-	EnableAlternateRowColours(true);
-	// Resize images based on the settings file
-	int imageIconWidth  = (*mainSettings)["inputsList"]["imageWidth"].GetInt();
-	int imageIconHeight = (*mainSettings)["inputsList"]["imageHeight"].GetInt();
-	imageList.Create(imageIconWidth, imageIconHeight);
 
-	InsertColumn(0, "Frame", wxLIST_FORMAT_CENTER, wxLIST_AUTOSIZE);
+	// The icons were already resized based on the settings file
+	// Off icons aren't drawn, so only the on ones go into the grid
+	std::vector<wxString> columnNames;
+	std::vector<wxBitmap*> columnIcons;
 
 	uint8_t i = 1;
 	for(auto const& button : buttonData->buttonMapping) {
-		InsertColumn(i, button.second->normalName, wxLIST_FORMAT_CENTER, wxLIST_AUTOSIZE);
-		// Shouldn't be the exact width, it's a bit too small that way
-		SetColumnWidth(i, (int)(imageIconWidth * 1.5f));
+		columnNames.push_back(button.second->normalName);
+		columnIcons.push_back(button.second->resizedListOnBitmap);
 		buttonToColumn[button.first]               = i;
 		charToButton[button.second->toggleKeybind] = button.first;
 
-		imageList.Add(*const_cast<wxBitmap*>(button.second->resizedListOnBitmap), maskColor);
-		imageList.Add(*const_cast<wxBitmap*>(button.second->resizedListOffBitmap), maskColor);
-
 		i++;
 	}
 
-	SetImageList(&imageList, wxIMAGE_LIST_SMALL);
+	setColumns(columnNames, columnIcons, maskColor);
 
 	// Set item attributes for nice colors
 	setItemAttributes();
 
 	// Create keyboard handlers
 	// Each menu item is added here
-	wxAcceleratorEntry entries[11];
+	wxAcceleratorEntry entries[17];
 
 	pasteInsertID         = wxNewId();
 	pastePlaceID          = wxNewId();
@@ -60,6 +49,18 @@ DataProcessing::DataProcessing(rapidjson::Document* settings, std::shared_ptr<Bu
 	frameAdvanceID        = wxNewId();
 	savestateID           = wxNewId();
 	mergeIntoMainBranchID = wxNewId();
+	clearButtonsID        = wxNewId();
+	shiftFramesID         = wxNewId();
+	forkBranchID          = wxNewId();
+	exportFramebuffersID  = wxNewId();
+	findFramesID          = wxNewId();
+	nextMatchID           = wxNewId();
+	compareBranchID       = wxNewId();
+	nextDifferenceID      = wxNewId();
+	stopComparingID       = wxNewId();
+	runToFrameID          = wxNewId();
+	undoID                = wxID_UNDO;
+	redoID                = wxID_REDO;
 
 	insertPaste = false;
 	placePaste  = false;
@@ -77,9 +78,28 @@ DataProcessing::DataProcessing(rapidjson::Document* settings, std::shared_ptr<Bu
 	entries[9].Set(wxACCEL_CTRL, (int)'H', savestateID, editMenu.Append(savestateID, wxT("Add Savestate\tCtrl+H")));
 	entries[10].Set(wxACCEL_CTRL, (int)'M', mergeIntoMainBranchID, editMenu.Append(mergeIntoMainBranchID, wxT("Merge Frames into Main Branch\tCtrl+M")));
 
-	wxAcceleratorTable accel(11, entries);
+	entries[11].Set(wxACCEL_CTRL, (int)'Z', undoID, editMenu.Append(undoID, wxT("Undo\tCtrl+Z")));
+	entries[12].Set(wxACCEL_CTRL, (int)'Y', redoID, editMenu.Append(redoID, wxT("Redo\tCtrl+Y")));
+
+	entries[13].Set(wxACCEL_CTRL, (int)'F', findFramesID, editMenu.Append(findFramesID, wxT("Find Frames...\tCtrl+F")));
+	entries[14].Set(wxACCEL_NORMAL, WXK_F3, nextMatchID, editMenu.Append(nextMatchID, wxT("Next Match\tF3")));
+
+	// Ctrl+D already toggles the debug menu
+	entries[15].Set(wxACCEL_CTRL | wxACCEL_SHIFT, (int)'D', nextDifferenceID, editMenu.Append(nextDifferenceID, wxT("Next Difference\tCtrl+Shift+D")));
+
+	entries[16].Set(wxACCEL_CTRL | wxACCEL_SHIFT, WXK_RIGHT, runToFrameID, editMenu.Append(runToFrameID, wxT("Run To Here...\tCtrl+Shift+Right")));
+
+	wxAcceleratorTable accel(17, entries);
 	SetAcceleratorTable(accel);
 
+	// No shortcuts for these
+	editMenu.Append(clearButtonsID, wxT("Clear Buttons"));
+	editMenu.Append(shiftFramesID, wxT("Shift Frames..."));
+	editMenu.Append(forkBranchID, wxT("Fork Branch"));
+	editMenu.Append(exportFramebuffersID, wxT("Export Framebuffers..."));
+	editMenu.Append(compareBranchID, wxT("Compare With Branch..."));
+	editMenu.Append(stopComparingID, wxT("Stop Comparing"));
+
 	// Bind each to a handler, both menu and button events
 	Bind(wxEVT_MENU, &DataProcessing::onCopy, this, wxID_COPY);
 	Bind(wxEVT_MENU, &DataProcessing::onCut, this, wxID_CUT);
@@ -90,18 +110,25 @@ DataProcessing::DataProcessing(rapidjson::Document* settings, std::shared_ptr<Bu
 	Bind(wxEVT_MENU, &DataProcessing::onAdd10Frames, this, add10FramesID);
 	Bind(wxEVT_MENU, &DataProcessing::onRemoveFrame, this, removeFrameID);
 	Bind(wxEVT_MENU, &DataProcessing::onFrameAdvance, this, frameAdvanceID);
+	Bind(wxEVT_MENU, &DataProcessing::onRunToFrame, this, runToFrameID);
 	Bind(wxEVT_MENU, &DataProcessing::onAddSavestate, this, savestateID);
 	Bind(wxEVT_MENU, &DataProcessing::onMergeIntoMainBranch, this, mergeIntoMainBranchID);
+	Bind(wxEVT_MENU, &DataProcessing::onClearButtons, this, clearButtonsID);
+	Bind(wxEVT_MENU, &DataProcessing::onShiftFrames, this, shiftFramesID);
+	Bind(wxEVT_MENU, &DataProcessing::onForkBranch, this, forkBranchID);
+	Bind(wxEVT_MENU, &DataProcessing::onExportFramebuffers, this, exportFramebuffersID);
+	Bind(wxEVT_MENU, &DataProcessing::onFindFrames, this, findFramesID);
+	Bind(wxEVT_MENU, &DataProcessing::onNextMatch, this, nextMatchID);
+	Bind(wxEVT_MENU, &DataProcessing::onCompareBranch, this, compareBranchID);
+	Bind(wxEVT_MENU, &DataProcessing::onNextDifference, this, nextDifferenceID);
+	Bind(wxEVT_MENU, &DataProcessing::onStopComparing, this, stopComparingID);
+	Bind(wxEVT_MENU, &DataProcessing::onUndo, this, undoID);
+	Bind(wxEVT_MENU, &DataProcessing::onRedo, this, redoID);
 }
 
 // clang-format off
-BEGIN_EVENT_TABLE(DataProcessing, wxListCtrl)
-	EVT_LIST_CACHE_HINT(DataProcessing::LIST_CTRL_ID, DataProcessing::onCacheHint)
-	EVT_LIST_ITEM_SELECTED(DataProcessing::LIST_CTRL_ID, DataProcessing::onSelect)
-	// This is activated via double click
-	EVT_LIST_ITEM_ACTIVATED(DataProcessing::LIST_CTRL_ID, DataProcessing::onActivate)
+BEGIN_EVENT_TABLE(DataProcessing, InputGrid)
 	EVT_CONTEXT_MENU(DataProcessing::onRightClick)
-	EVT_ERASE_BACKGROUND(DataProcessing::OnEraseBackground)
 	EVT_DROP_FILES(DataProcessing::onDropFiles)
 END_EVENT_TABLE()
 // clang-format on
@@ -114,6 +141,10 @@ void DataProcessing::setSelectedFrameCallbackVideoViewer(std::function<void(int)
 	selectedFrameCallbackVideoViewer = callback;
 }
 
+void DataProcessing::setTimelineCallback(std::function<void()> callback) {
+	timelineCallback = callback;
+}
+
 void DataProcessing::setViewableInputsCallback(std::function<void(FrameNum, FrameNum)> callback) {
 	viewableInputsCallback = callback;
 }
@@ -137,36 +168,44 @@ void DataProcessing::triggerCurrentFrameChanges() {
 }
 
 void DataProcessing::sendAutoAdvance(uint8_t includeFramebuffer) {
+	// None of the frames in flight have been added yet
+	FrameNum inFlight = autoRunPipeline.getNumInFlight();
+	FrameNum runFrame = currentRunFrame + inFlight;
+	uint32_t sequence = autoRunPipeline.takeSequence();
+
 	for(uint8_t playerIndex = 0; playerIndex < allPlayers.size(); playerIndex++) {
 		// Set inputs of all other players correctly but not the current one
-		if(playerIndex != viewingPlayerIndex) {
-			std::shared_ptr<ControllerData> controllerDatas = getControllerData(playerIndex, currentSavestateHook, viewingBranchIndex, currentRunFrame);
+		auto& playerInputs = *allPlayers[playerIndex]->at(currentSavestateHook)->inputs[viewingBranchIndex];
+		if(playerIndex != viewingPlayerIndex && runFrame < playerInputs.size()) {
+			std::shared_ptr<ControllerData> controllerDatas = playerInputs[runFrame];
 
 			ADD_TO_QUEUE(SendFrameData, networkInstance, {
 				data.controllerData     = *controllerDatas;
-				data.frame              = currentRunFrame;
+				data.frame              = runFrame;
 				data.savestateHookNum   = currentSavestateHook;
 				data.branchIndex        = viewingBranchIndex;
 				data.playerIndex        = playerIndex;
 				data.incrementFrame     = false;
 				data.includeFramebuffer = includeFramebuffer;
 				data.isAutoRun          = false;
+				data.sequence           = 0;
 			})
 		}
 	}
 
 	ADD_TO_QUEUE(SendFrameData, networkInstance, {
-		data.frame              = currentFrame + 1;
+		data.frame              = currentFrame + 1 + inFlight;
 		data.savestateHookNum   = currentSavestateHook;
 		data.branchIndex        = viewingBranchIndex;
 		data.playerIndex        = viewingPlayerIndex;
 		data.incrementFrame     = false;
 		data.includeFramebuffer = includeFramebuffer;
 		data.isAutoRun          = true;
+		data.sequence           = sequence;
 	})
 }
 
-std::string DataProcessing::getExportedCurrentPlayer() {
+std::vector<ScriptFrame> DataProcessing::getExportSnapshotCurrentPlayer() {
 	/*
 	wxFile file(exportTarget.GetFullPath(), wxFile::write);
 
@@ -177,9 +216,11 @@ std::string DataProcessing::getExportedCurrentPlayer() {
 	}
 	*/
 
-	// This blocks for a long time
+	// Only copies the frames, writing them out happens elsewhere
 	// Always export the main branch, MAY CHANGE
-	return buttonData->framesToText(this, 0, 0, viewingPlayerIndex, 0);
+	std::vector<ScriptFrame> frames;
+	buttonData->snapshotFrames(this, 0, 0, viewingPlayerIndex, 0, frames);
+	return frames;
 }
 
 void DataProcessing::importFromFile(wxFileName importTarget) {
@@ -192,9 +233,12 @@ void DataProcessing::importFromFile(wxFileName importTarget) {
 
 		if(successful) {
 			Freeze();
+			// The whole import is undone at once
+			editHistory.beginGroup();
 			FrameNum lastFrame = buttonData->textToFrames(this, fileContents.ToStdString(), 0, false, false);
 			// Remove all frames after the data
 			removeFrames(lastFrame + 1, allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs[viewingBranchIndex]->size() - 1);
+			editHistory.endGroup();
 			Thaw();
 			setCurrentFrame(0);
 			Refresh();
@@ -213,46 +257,65 @@ void DataProcessing::onDropFiles(wxDropFilesEvent& event) {
 	}
 }
 
-int DataProcessing::OnGetItemColumnImage(long row, long column) const {
-	if(column == 0) {
-		// This is the frame num
-		return -1;
-	} else {
-		// Returns index in the imagelist
-		// Need to account for the frame being first
-		Btn button = (Btn)(column - 1);
-		bool on    = getButton(row, button);
-		int res;
-		if(on) {
-			// Return index of on image
-			// Interleaved means it looks like this
-			res = button * 2;
-		} else {
-			// I'm trying something, don't return an image if off
-			// res = button * 2 + 1;
-			res = -1;
-		}
+uint32_t DataProcessing::getRowButtons(FrameNum row) const {
+	if(isRowCached(row)) {
+		return cachedButtons[row - rowCacheStart];
+	}
+	return getInputsList()->at(row)->buttons;
+}
 
-		return res;
+const wxItemAttr* DataProcessing::getRowAttr(FrameNum row) const {
+	if(isRowCached(row)) {
+		return cachedAttributes[row - rowCacheStart];
 	}
+	return itemAttributes.at(getFramestateInfo(row));
 }
 
-wxString DataProcessing::OnGetItemText(long row, long column) const {
-	// Returns when text is needed
-	if(column == 0) {
-		// This is the frame, which is just the row number
-		return wxString::Format(wxT("%ld"), row);
-	} else {
-		// Fallback for every other column
-		return "";
+uint8_t DataProcessing::getRowDiffMark(FrameNum row) const {
+	return comparingBranches ? branchDiff.getMark(row) : DIFF_NONE;
+}
+
+void DataProcessing::prepareRows(FrameNum first, FrameNum last) {
+	updateBranchDiff();
+
+	// The page is small, so just copy it all
+	fillRowCache(first, last);
+
+	if(viewableInputsCallback) {
+		viewableInputsCallback(first, last);
+	}
+
+	if(timelineCallback) {
+		timelineCallback();
+	}
+}
+
+void DataProcessing::fillRowCache(long first, long last) {
+	rowCacheStart = first;
+	cachedButtons.clear();
+	cachedAttributes.clear();
+
+	FrameNum watermark = getRunWatermark(viewingPlayerIndex, currentSavestateHook, viewingBranchIndex);
+	for(long row = first; row <= last; row++) {
+		const ControllerData& data = *currentBranchData->at(row);
+		cachedButtons.push_back(data.buttons);
+		cachedAttributes.push_back(itemAttributes.at(getFramestateWithRun(data, row, watermark)));
+	}
+}
+
+void DataProcessing::updateCachedRow(FrameNum frame) {
+	if(isRowCached(frame)) {
+		const ControllerData& data              = *currentBranchData->at(frame);
+		cachedButtons[frame - rowCacheStart]    = data.buttons;
+		cachedAttributes[frame - rowCacheStart] = itemAttributes.at(getFramestateWithRun(data, frame, getRunWatermark(viewingPlayerIndex, currentSavestateHook, viewingBranchIndex)));
 	}
-	// This function shouldn't receive any other column
 }
 
-// EXCUSE ME, WUT TODO
-// Why can't I call a const method from a const method hmmm
-wxItemAttr* DataProcessing::OnGetItemAttr(long item) const {
-	return itemAttributes.at(getFramestateInfo(item));
+void DataProcessing::clearRowCache() {
+	cachedButtons.clear();
+	cachedAttributes.clear();
+	// Done after every bulk edit and branch change
+	branchDiffDirty = true;
 }
 
 void DataProcessing::setItemAttributes() {
@@ -282,60 +345,10 @@ void DataProcessing::setItemAttributes() {
 	itemAttributes[state] = itemAttribute;
 }
 
-void DataProcessing::OnEraseBackground(wxEraseEvent& event) {
-	// to prevent flickering, erase only content *outside* of the
-	// actual list items stuff
-
-	if(GetItemCount() != 0) {
-		wxDC* dc = event.GetDC();
-		assert(dc);
-
-		// get some info
-		wxCoord width = 0, height = 0;
-		GetClientSize(&width, &height);
-
-		wxCoord x, y, w, h;
-		dc->SetClippingRegion(0, 0, width, height);
-		dc->GetClippingBox(&x, &y, &w, &h);
-
-		long top_item    = GetTopItem();
-		long bottom_item = top_item + GetCountPerPage();
-		if(bottom_item >= GetItemCount()) {
-			bottom_item = GetItemCount() - 1;
-		}
-
-		// trick: we want to exclude a couple pixels
-		// on the left side thus use wxLIST_RECT_LABEL
-		// for the top rect and wxLIST_RECT_BOUNDS for bottom
-		// rect
-		wxRect top_rect, bottom_rect;
-		GetItemRect(top_item, top_rect, wxLIST_RECT_LABEL);
-		GetItemRect(bottom_item, bottom_rect, wxLIST_RECT_BOUNDS);
-
-		// set the new clipping region and do erasing
-		wxRect items_rect(top_rect.GetLeftTop(), bottom_rect.GetBottomRight());
-		wxRegion reg(wxRegion(x, y, w, h));
-		reg.Subtract(items_rect);
-		dc->DestroyClippingRegion();
-		dc->SetClippingRegion(reg);
-
-		// do erasing
-		dc->SetBackground(wxBrush(GetBackgroundColour(), wxSOLID));
-		dc->Clear();
-
-		// restore old clipping region
-		dc->DestroyClippingRegion();
-		dc->SetClippingRegion(wxRegion(x, y, w, h));
-	} else {
-		event.Skip();
-	}
-}
-
 void DataProcessing::onRightClick(wxContextMenuEvent& event) {
 	// Get item at location
 	const wxPoint mousePosition = ScreenToClient(event.GetPosition());
-	int flags                   = wxLIST_HITTEST_ONITEM;
-	const FrameNum item         = HitTest(mousePosition, flags);
+	const long item             = hitTestRow(mousePosition);
 	if(item != wxNOT_FOUND) {
 		setCurrentFrame(item);
 	}
@@ -343,43 +356,31 @@ void DataProcessing::onRightClick(wxContextMenuEvent& event) {
 	PopupMenu(&editMenu, mousePosition);
 }
 
-void DataProcessing::onSelect(wxListEvent& event) {
+void DataProcessing::onRowFocused(FrameNum row) {
 	// The current frame has changed
-	setCurrentFrame(event.GetIndex());
+	setCurrentFrame(row);
 }
 
-void DataProcessing::onActivate(wxListEvent& event) {
+void DataProcessing::onRowActivated(FrameNum row) {
 	// Select the current image frame
-	currentImageFrame = event.GetIndex();
-	setCurrentFrame(event.GetIndex());
+	currentImageFrame = row;
+	setCurrentFrame(row);
 }
 
 void DataProcessing::onCopy(wxCommandEvent& event) {
 	// First, try opening the clipboard
 	// https://docs.wxwidgets.org/3.0/classwx_clipboard.html#a6c56dbf02b1807ce61cac8134a534336
 	if(wxTheClipboard->Open()) {
-		long firstSelectedItem = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
-		if(firstSelectedItem != wxNOT_FOUND) {
-			long lastSelectedItem = firstSelectedItem + GetSelectedItemCount() - 1;
-
+		if(hasSelection()) {
 			// There is a selected item
-			if(currentFrame >= firstSelectedItem && currentFrame <= lastSelectedItem) {
-				// Add these items to the clipboard
-				wxTheClipboard->SetData(new wxTextDataObject(buttonData->framesToText(this, firstSelectedItem, lastSelectedItem, -1, viewingBranchIndex)));
-			} else {
-				// Deselect the others
-				for(FrameNum i = firstSelectedItem; i <= lastSelectedItem; i++) {
-					SetItemState(i, 0, wxLIST_STATE_SELECTED);
-				}
-				// Select just the one
-				SetItemState(currentFrame, wxLIST_STATE_SELECTED, wxLIST_STATE_SELECTED);
-
-				wxTheClipboard->SetData(new wxTextDataObject(buttonData->framesToText(this, currentFrame, currentFrame, -1, viewingBranchIndex)));
-
-				// See the new selection
-				RefreshItem(currentFrame);
+			if(!isRowSelected(currentFrame)) {
+				// Select just the one, the others are deselected with it
+				setSelection(currentFrame, currentFrame);
 			}
 
+			// Add these items to the clipboard
+			wxTheClipboard->SetData(new wxTextDataObject(buttonData->selectionToText(this, getSelection(), viewingBranchIndex)));
+
 			wxTheClipboard->Close();
 		}
 	}
@@ -389,18 +390,101 @@ void DataProcessing::onCut(wxCommandEvent& event) {
 	// Copy the elements, then delete
 	onCopy(event);
 	// Erase the frames
-	long firstSelectedItem = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
-	if(firstSelectedItem != wxNOT_FOUND) {
-		long lastSelectedItem = firstSelectedItem + GetSelectedItemCount() - 1;
-		removeFrames(firstSelectedItem, lastSelectedItem);
+	if(hasSelection()) {
+		removeFrames(getSelection());
+	}
+}
+
+void DataProcessing::onForkBranch(wxCommandEvent& event) {
+	forkBranch();
+}
+
+void DataProcessing::onExportFramebuffers(wxCommandEvent& event) {
+	// Back to one JPEG per frame, for use outside of the program
+	std::shared_ptr<FramebufferArchive> archive = getFramebufferArchive(currentSavestateHook, viewingBranchIndex, false);
+	if(!archive) {
+		wxMessageBox("This branch has no framebuffers", "Export Framebuffers", wxOK | wxICON_INFORMATION, this);
+		return;
 	}
+
+	wxDirDialog dlg(this, "Choose Export Directory", "", wxDD_DEFAULT_STYLE);
+	if(dlg.ShowModal() == wxID_OK) {
+		wxFileName exportDir = wxFileName::DirName(dlg.GetPath());
+		FrameNum numExported = archive->exportToFolder(exportDir);
+		wxMessageBox(wxString::Format("Exported %u framebuffers", numExported), "Export Framebuffers", wxOK | wxICON_INFORMATION, this);
+	}
+}
+
+void DataProcessing::onFindFrames(wxCommandEvent& event) {
+	wxString query = wxGetTextFromUser("Frames to select, like ZR && LS_X < -20000 or pressed(A) && frame > 500", "Find Frames", wxString::FromUTF8(lastQueryText), this);
+	if(query.IsEmpty()) {
+		return;
+	}
+
+	std::string error;
+	if(!findFrames(query.ToStdString(), error)) {
+		wxMessageBox(error, "Find Frames", wxOK | wxICON_ERROR, this);
+	}
+}
+
+void DataProcessing::onNextMatch(wxCommandEvent& event) {
+	if(lastQueryText.empty()) {
+		onFindFrames(event);
+	} else if(!jumpToNextMatch()) {
+		wxMessageBox("No frames match", "Next Match", wxOK | wxICON_INFORMATION, this);
+	}
+}
+
+void DataProcessing::onCompareBranch(wxCommandEvent& event) {
+	// Every branch except the one being viewed
+	wxArrayString choices;
+	std::vector<BranchNum> branches;
+	for(BranchNum branch = 0; branch < getNumBranches(); branch++) {
+		if(branch != viewingBranchIndex) {
+			choices.Add(wxString::Format("Branch %u", branch));
+			branches.push_back(branch);
+		}
+	}
+
+	if(branches.empty()) {
+		wxMessageBox("There are no other branches to compare with", "Compare With Branch", wxOK | wxICON_INFORMATION, this);
+		return;
+	}
+
+	int choice = wxGetSingleChoiceIndex("Branch to compare the viewed branch with", "Compare With Branch", choices, this);
+	if(choice != -1) {
+		compareWithBranch(branches[choice]);
+		if(branchDiff.getHunks().empty()) {
+			wxMessageBox("Both branches are the same", "Compare With Branch", wxOK | wxICON_INFORMATION, this);
+		}
+	}
+}
+
+void DataProcessing::onNextDifference(wxCommandEvent& event) {
+	if(!comparingBranches) {
+		onCompareBranch(event);
+	} else if(!jumpToNextDifference()) {
+		wxMessageBox("Both branches are the same", "Next Difference", wxOK | wxICON_INFORMATION, this);
+	}
+}
+
+void DataProcessing::onStopComparing(wxCommandEvent& event) {
+	stopComparing();
+}
+
+void DataProcessing::onUndo(wxCommandEvent& event) {
+	undo();
+}
+
+void DataProcessing::onRedo(wxCommandEvent& event) {
+	redo();
 }
 
 void DataProcessing::onPaste(wxCommandEvent& event) {
 
-	long firstSelectedItem = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
-	if(firstSelectedItem != wxNOT_FOUND) {
-		long lastSelectedItem = firstSelectedItem + GetSelectedItemCount() - 1;
+	if(hasSelection()) {
+		// Inserting moves the frames after it, so go from the end
+		std::vector<FrameInterval> intervals = getSelection().getIntervals();
 
 		if(wxTheClipboard->Open()) {
 			if(wxTheClipboard->IsSupported(wxDF_TEXT)) {
@@ -410,15 +494,24 @@ void DataProcessing::onPaste(wxCommandEvent& event) {
 
 				std::string clipboardText = data.GetText().ToStdString();
 
+				// Parsed once, then repeated over the whole selection
+				std::vector<ScriptFrame> frames;
+				buttonData->parseScript(clipboardText, frames);
+
 				Freeze();
-				FrameNum lastItem    = buttonData->textToFrames(this, clipboardText, firstSelectedItem, insertPaste, placePaste);
-				FrameNum sizeOfPaste = lastItem - firstSelectedItem + 1;
-				if(!insertPaste) {
-					for(long i = firstSelectedItem; i <= lastSelectedItem; i += sizeOfPaste) {
-						buttonData->textToFrames(this, clipboardText, i, insertPaste, placePaste);
+				editHistory.beginGroup();
+				FrameNum sizeOfPaste = 1;
+				for(auto interval = intervals.rbegin(); interval != intervals.rend(); interval++) {
+					FrameNum lastItem = pasteFrames(frames, interval->start, insertPaste, placePaste);
+					sizeOfPaste       = lastItem - interval->start + 1;
+					if(!insertPaste) {
+						for(long i = interval->start + sizeOfPaste; i <= interval->end; i += sizeOfPaste) {
+							pasteFrames(frames, i, insertPaste, placePaste);
+						}
 					}
 				}
-				setCurrentFrame(firstSelectedItem + sizeOfPaste - 1);
+				editHistory.endGroup();
+				setCurrentFrame(intervals.front().start + sizeOfPaste - 1);
 				Thaw();
 				Refresh();
 			}
@@ -449,10 +542,8 @@ void DataProcessing::onAdd10Frames(wxCommandEvent& event) {
 }
 
 void DataProcessing::onRemoveFrame(wxCommandEvent& event) {
-	long firstSelectedItem = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
-	if(firstSelectedItem != wxNOT_FOUND) {
-		long lastSelectedItem = firstSelectedItem + GetSelectedItemCount() - 1;
-		removeFrames(firstSelectedItem, lastSelectedItem);
+	if(hasSelection()) {
+		removeFrames(getSelection());
 	}
 }
 
@@ -462,6 +553,24 @@ void DataProcessing::onFrameAdvance(wxCommandEvent& event) {
 	}
 }
 
+void DataProcessing::onRunToFrame(wxCommandEvent& event) {
+	if(!tethered) {
+		wxMessageBox("You must connect to your switch to run frames", "Run To Here", wxOK | wxICON_ERROR, this);
+		return;
+	}
+
+	if(currentFrame <= currentRunFrame) {
+		wxMessageBox("Select a frame after the last one run", "Run To Here", wxOK | wxICON_INFORMATION, this);
+		return;
+	}
+
+	long interval = wxGetNumberFromUser("Frames between framebuffers sent back on the way, 0 for none", "Interval", "Run To Here", runToFrameFramebufferInterval, 0, 3600, this);
+	if(interval != -1) {
+		runToFrameFramebufferInterval = interval;
+		runToFrame(currentFrame, interval);
+	}
+}
+
 void DataProcessing::onAddSavestate(wxCommandEvent& event) {
 	// NEEDS WORK
 	createSavestateHere();
@@ -469,38 +578,63 @@ void DataProcessing::onAddSavestate(wxCommandEvent& event) {
 
 void DataProcessing::onMergeIntoMainBranch(wxCommandEvent& event) {
 	// Don't just convert into text format, merge by moving over frames
-	long firstSelectedItem = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
-	if(firstSelectedItem != wxNOT_FOUND) {
-		long lastSelectedItem = firstSelectedItem + GetSelectedItemCount() - 1;
-		for(FrameNum i = firstSelectedItem; i <= lastSelectedItem; i++) {
-			// Transfer directly
-			buttonData->transferControllerData(*(allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs[viewingBranchIndex]->at(i)), allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs[0]->at(i), false);
+	if(hasSelection() && viewingBranchIndex != 0) {
+		auto& branch     = *allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs[viewingBranchIndex];
+		auto& mainBranch = *allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs[0];
+
+		FrameNum firstChanged = UINT32_MAX;
+		editHistory.beginGroup();
+		for(auto const& interval : getSelection().getIntervals()) {
+			std::vector<HistoryCommand> commands = beginFrameEdit(interval.start, interval.end - interval.start + 1, 0);
+			for(FrameNum i = interval.start; i <= interval.end; i++) {
+				// Frames the branch never edited are still the main branch's, so only the rest are touched
+				// The main branch just points at the same frame, it's copied if either is edited later
+				if(mainBranch[i] != branch[i]) {
+					mainBranch[i] = branch[i];
+					firstChanged  = std::min(firstChanged, i);
+				}
+			}
+			endFrameEdit(commands);
+		}
+		editHistory.endGroup();
+
+		if(firstChanged != UINT32_MAX) {
+			invalidateRunSpecific(firstChanged, currentSavestateHook, 0, viewingPlayerIndex);
 		}
 	}
 	// It's up to the user to remove the frames in the other branch if they want
 }
 
+void DataProcessing::onClearButtons(wxCommandEvent& event) {
+	if(hasSelection()) {
+		clearButtonsRange(getSelection());
+	}
+}
+
+void DataProcessing::onShiftFrames(wxCommandEvent& event) {
+	if(hasSelection()) {
+		wxString text = wxGetTextFromUser("Number of frames to shift the selection by, negative moves it earlier", "Shift Frames", "1", this);
+		long offset;
+		if(!text.IsEmpty() && text.ToLong(&offset)) {
+			// Everything from the first to the last selected frame moves together
+			shiftFrames(getSelection().first(), getSelection().last(), offset);
+		}
+	}
+}
+
 void DataProcessing::setCurrentFrame(FrameNum frameNum) {
 	// Must be a frame that has already been written, else, raise error
 	if(frameNum < getFramesSize()) {
-		// Set the current frame to this frame
-		// Shared pointer so this can be done
-		currentData = allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs[viewingBranchIndex]->at(frameNum);
 		// Set the current frame to this number
 		// Focus to this specific row now
 		// This essentially scrolls to it
 
-		if(GetItemCount() != 1) {
-			EnsureVisible(frameNum);
-		}
+		ensureVisible(frameNum);
 
 		currentFrame = frameNum;
 
-		// If not selected by wxWidgets, do so
-		if(!GetItemState(frameNum, wxLIST_STATE_FOCUSED)) {
-			// This will trigger another setFrame, but that's fine
-			SetItemState(0, wxLIST_STATE_FOCUSED, wxLIST_STATE_FOCUSED);
-		}
+		// Doesn't call back into here
+		setFocusedRow(frameNum);
 
 		modifyCurrentFrameViews(frameNum);
 		if(selectedFrameCallbackVideoViewer) {
@@ -517,9 +651,8 @@ void DataProcessing::createSavestateHere() {
 	// Add one savestate hook at this frame
 	savestates[currentFrame] = std::make_shared<Savestate>();
 	// Set the style of this frame
-	SET_BIT(currentData->frameState, true, FrameState::SAVESTATE);
-	// Refresh the item for it to take effect
-	RefreshItem(currentFrame);
+	// Refreshes the item for it to take effect
+	setFramestateInfo(currentFrame, FrameState::SAVESTATE, true);
 }
 
 void DataProcessing::runFrame(uint8_t forAutoFrame, uint8_t updateFramebuffer, uint8_t includeFramebuffer) {
@@ -570,6 +703,7 @@ void DataProcessing::runFrame(uint8_t forAutoFrame, uint8_t updateFramebuffer, u
 						data.incrementFrame     = false;
 						data.includeFramebuffer = includeFramebuffer;
 						data.isAutoRun          = false;
+						data.sequence           = 0;
 					})
 				}
 				ADD_TO_QUEUE(SendFrameData, networkInstance, {
@@ -580,12 +714,128 @@ void DataProcessing::runFrame(uint8_t forAutoFrame, uint8_t updateFramebuffer, u
 					data.incrementFrame     = true;
 					data.includeFramebuffer = includeFramebuffer;
 					data.isAutoRun          = false;
+					data.sequence           = 0;
 				})
 			}
 		}
 	}
 }
 
+void DataProcessing::runToFrame(FrameNum frame, uint32_t framebufferInterval) {
+	// The same frames runFrame would go through one at a time
+	auto& inputs = *allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs[viewingBranchIndex];
+	frame        = std::min<FrameNum>(frame, inputs.size() - 1);
+	if(frame <= currentRunFrame) {
+		return;
+	}
+
+	FrameNum startFrame                = currentRunFrame + 1;
+	uint32_t numOfFrames               = frame - currentRunFrame;
+	uint8_t numOfPlayers               = allPlayers.size();
+	SavestateBlockNum savestateHookNum = currentSavestateHook;
+	BranchNum branchIndex              = viewingBranchIndex;
+	uint8_t playerIndex                = viewingPlayerIndex;
+
+	// Progress from an earlier run
+	CHECK_QUEUE(networkInstance, RecieveRunToFrameProgress, {})
+
+	ADD_TO_QUEUE(SendRunToFrame, networkInstance, {
+		data.startFrame          = startFrame;
+		data.endFrame            = frame + 1;
+		data.savestateHookNum    = savestateHookNum;
+		data.branchIndex         = branchIndex;
+		data.playerIndex         = playerIndex;
+		data.numOfPlayers        = numOfPlayers;
+		data.framebufferInterval = framebufferInterval;
+	})
+
+	SerializeProtocol serializeProtocol;
+	ControllerData blankData;
+
+	uint32_t framesSent   = 0;
+	uint32_t chunksSent   = 0;
+	uint32_t framesRun    = 0;
+	uint32_t chunksPlayed = 0;
+	uint8_t finished      = false;
+	uint8_t stopping      = false;
+
+	auto start = std::chrono::steady_clock::now();
+
+	wxProgressDialog progressDialog("Run To Here", "Starting", 1000, this, wxPD_APP_MODAL | wxPD_CAN_ABORT | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME);
+	while(!finished && networkInstance->isConnected()) {
+		CHECK_QUEUE(networkInstance, RecieveRunToFrameProgress, {
+			framesRun    = data.framesRun;
+			chunksPlayed = data.chunksPlayed;
+			finished     = data.finished;
+			if(!data.buf.empty() && data.framesRun != 0) {
+				saveFramebuffer(playerIndex, savestateHookNum, branchIndex, startFrame + data.framesRun - 1, data.buf);
+			}
+		})
+
+		// Only ever as far ahead as the switch can hold, like streaming a final TAS
+		while(!stopping && framesSent != numOfFrames && chunksSent < chunksPlayed + FINAL_TAS_STREAM_BUFFER_CHUNKS) {
+			uint32_t chunkFrames = std::min<uint32_t>(FINAL_TAS_STREAM_CHUNK_FRAMES, numOfFrames - framesSent);
+
+			ADD_TO_QUEUE(SendFinalTasChunk, networkInstance, {
+				for(FrameNum i = startFrame + framesSent; i < startFrame + framesSent + chunkFrames; i++) {
+					for(uint8_t player = 0; player < numOfPlayers; player++) {
+						// Players with fewer frames are left with nothing pressed
+						auto& playerInputs = *allPlayers[player]->at(savestateHookNum)->inputs[branchIndex];
+
+						uint8_t* serialized;
+						uint32_t serializedSize;
+						serializeProtocol.dataToBinary<ControllerData>(i < playerInputs.size() ? *playerInputs[i] : blankData, &serialized, &serializedSize);
+						data.data.push_back((uint8_t)serializedSize);
+						data.data.insert(data.data.end(), serialized, serialized + serializedSize);
+						free(serialized);
+					}
+				}
+				data.numOfFrames = chunkFrames;
+				data.isLast      = framesSent + chunkFrames == numOfFrames;
+			})
+
+			framesSent += chunkFrames;
+			chunksSent++;
+		}
+
+		if(!stopping) {
+			wxString message = wxString::Format("Ran %u of %u frames", framesRun, numOfFrames);
+			if(!progressDialog.Update(std::min(999, (int)((uint64_t)framesRun * 1000 / numOfFrames)), message)) {
+				// Still waits to hear where it stopped
+				// clang-format off
+				ADD_TO_QUEUE(SendFlag, networkInstance, {
+					data.actFlag = SendInfo::STOP_RUN_TO_FRAME;
+				})
+				// clang-format on
+				stopping = true;
+			}
+		}
+
+		wxMilliSleep(20);
+	}
+	progressDialog.Update(1000);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	wxLogMessage(wxString::Format("Ran %u of %u frames in %.2f seconds", framesRun, numOfFrames, seconds));
+
+	if(framesRun == 0 || savestateHookNum != currentSavestateHook || branchIndex != viewingBranchIndex || playerIndex != viewingPlayerIndex) {
+		return;
+	}
+
+	// Where runFrame would have left things after the last of them
+	FrameNum lastFrame = startFrame + framesRun - 1;
+	markFrameRan(lastFrame - 1, savestateHookNum, branchIndex, playerIndex);
+	currentRunFrame   = lastFrame;
+	currentImageFrame = lastFrame;
+	setCurrentFrame(lastFrame);
+
+	triggerCurrentFrameChanges();
+	if(inputCallback) {
+		inputCallback(true);
+	}
+	Refresh();
+}
+
 bool DataProcessing::handleKeyboardInput(wxChar key) {
 	if(charToButton.count(key)) {
 		triggerButton(charToButton[key]);
@@ -599,25 +849,7 @@ std::shared_ptr<std::vector<std::shared_ptr<ControllerData>>> DataProcessing::ge
 }
 
 wxRect DataProcessing::getFirstItemRect() {
-	wxRect itemRect;
-	long topItem = GetTopItem();
-	GetItemRect(topItem, itemRect);
-	return itemRect;
-}
-
-void DataProcessing::onCacheHint(wxListEvent& event) {
-	if(viewableInputsCallback) {
-		long numOfRowsVisible = GetCountPerPage();
-		if(numOfRowsVisible != 0) {
-			// Don't use the event values, they are wrong
-			long first = GetTopItem();
-			long last  = first + numOfRowsVisible;
-
-			if(viewableInputsCallback) {
-				viewableInputsCallback(first, last);
-			}
-		}
-	}
+	return getRowRect(getTopRow());
 }
 
 void DataProcessing::addNewSavestateHook(std::string dHash, wxBitmap* screenshot) {
@@ -629,6 +861,10 @@ void DataProcessing::addNewSavestateHook(std::string dHash, wxBitmap* screenshot
 		// Add a single branch for default
 		savestateHook->inputs.push_back(std::make_shared<std::vector<FrameData>>());
 		allPlayers[i]->push_back(savestateHook);
+		// Commands only know about the hooks they were made in
+		editHistory.clear();
+		inputIndex.clear();
+		timelineSummary.clear();
 		allPlayers[i]->at(0)->inputs[0]->push_back(std::make_shared<ControllerData>());
 		viewingBranchIndex = 0;
 		// NOTE: There must be at least one block with one input when this is loaded
@@ -640,10 +876,12 @@ void DataProcessing::addNewSavestateHook(std::string dHash, wxBitmap* screenshot
 
 void DataProcessing::setSavestateHook(SavestateBlockNum index) {
 	currentSavestateHook = index;
+	// Frames still in flight were run from somewhere else
+	autoRunPipeline.reset();
 
 	// Just in case, refresh branch here
 	setBranch(viewingBranchIndex);
-	SetItemCount(getInputsList()->size());
+	setRowCount(getInputsList()->size());
 	setCurrentFrame(0);
 	currentRunFrame   = 0;
 	currentImageFrame = 0;
@@ -660,11 +898,17 @@ void DataProcessing::setSavestateHook(SavestateBlockNum index) {
 void DataProcessing::removeSavestateHook(SavestateBlockNum index) {
 	if(allPlayers[viewingPlayerIndex]->size() > 1) {
 		allPlayers[viewingPlayerIndex]->erase(allPlayers[viewingPlayerIndex]->begin() + index);
+		editHistory.clear();
+		inputIndex.clear();
+		timelineSummary.clear();
 		setSavestateHook(0);
 
+		// The archives are mapped, so they can't be moved while open
+		closeFramebufferArchives();
+
 		// Move over all the framebuffer names
 		wxRemoveFile(getFramebufferPathForSavestateHook(index).GetFullPath());
-		HELPERS::popOffDirs(getFramebufferPath(0, index, 0, 0), 1).Rmdir(wxPATH_RMDIR_RECURSIVE);
+		HELPERS::popOffDirs(getFramebufferFolder(index, 0), 1).Rmdir(wxPATH_RMDIR_RECURSIVE);
 
 		// Rename all images following this hook
 		SavestateBlockNum temp1 = index;
@@ -683,9 +927,9 @@ void DataProcessing::removeSavestateHook(SavestateBlockNum index) {
 		SavestateBlockNum temp2 = index;
 		while(true) {
 			temp2++;
-			wxFileName savestateHookDir = HELPERS::popOffDirs(getFramebufferPath(0, temp2, 0, 0), 1);
+			wxFileName savestateHookDir = HELPERS::popOffDirs(getFramebufferFolder(temp2, 0), 1);
 			if(savestateHookDir.DirExists()) {
-				wxRenameFile(savestateHookDir.GetPath(), HELPERS::popOffDirs(getFramebufferPath(0, temp2 - 1, 0, 0), 1).GetPath());
+				wxRenameFile(savestateHookDir.GetPath(), HELPERS::popOffDirs(getFramebufferFolder(temp2 - 1, 0), 1).GetPath());
 			} else {
 				// Have encountered last savestate hook, break loop
 				break;
@@ -720,6 +964,10 @@ void DataProcessing::addNewPlayer() {
 	}
 
 	allPlayers.push_back(player);
+	// Removed frames are saved per player, so the old commands don't fit anymore
+	editHistory.clear();
+	inputIndex.clear();
+	timelineSummary.clear();
 
 	setPlayer(allPlayers.size() - 1);
 }
@@ -743,6 +991,9 @@ void DataProcessing::setPlayer(uint8_t playerIndex) {
 void DataProcessing::removePlayer(uint8_t playerIndex) {
 	if(allPlayers.size() > 1) {
 		allPlayers.erase(allPlayers.begin() + playerIndex);
+		editHistory.clear();
+		inputIndex.clear();
+		timelineSummary.clear();
 		setPlayer(allPlayers.size() - 1);
 	}
 	sendPlayerNum();
@@ -777,12 +1028,29 @@ void DataProcessing::addNewBranch() {
 			list[lastElement]->push_back(std::make_shared<ControllerData>());
 		}
 	}
+	// Removed frames are saved per branch, so the old commands don't fit anymore
+	editHistory.clear();
+	inputIndex.clear();
+	timelineSummary.clear();
+	setBranch(allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs.size() - 1);
+}
+
+void DataProcessing::forkBranch() {
+	for(auto& player : allPlayers) {
+		auto& list = player->at(currentSavestateHook)->inputs;
+		// Only the pointers are copied
+		list.push_back(std::make_shared<std::vector<FrameData>>(*list[std::min<std::size_t>(viewingBranchIndex, list.size() - 1)]));
+	}
+	editHistory.clear();
+	inputIndex.clear();
+	timelineSummary.clear();
 	setBranch(allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs.size() - 1);
 }
 
 void DataProcessing::setBranch(uint16_t branchIndex) {
 	viewingBranchIndex = branchIndex;
 	currentBranchData  = allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs[viewingBranchIndex];
+	clearRowCache();
 	if(branchInfoCallback) {
 		branchInfoCallback(getNumBranches(), branchIndex, true);
 	}
@@ -793,16 +1061,28 @@ void DataProcessing::setBranch(uint16_t branchIndex) {
 void DataProcessing::removeBranch(uint8_t branchIndex) {
 	if(allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs.size() > 1) {
 		allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs.erase(allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs.begin() + branchIndex);
+		auto& watermarks = allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->runWatermarks;
+		if(branchIndex < watermarks.size()) {
+			watermarks.erase(watermarks.begin() + branchIndex);
+		}
+		editHistory.clear();
+		inputIndex.clear();
+		timelineSummary.clear();
+		// The branch numbers moved
+		stopComparing();
 		setBranch(allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs.size() - 1);
 
-		getFramebufferPath(0, currentSavestateHook, branchIndex, 0).Rmdir(wxPATH_RMDIR_RECURSIVE);
+		// The archives are mapped, so they can't be moved while open
+		closeFramebufferArchives();
+
+		getFramebufferFolder(currentSavestateHook, branchIndex).Rmdir(wxPATH_RMDIR_RECURSIVE);
 
 		// Rename all images in this branch
 		while(true) {
 			branchIndex++;
-			wxFileName branchFolder = getFramebufferPath(0, currentSavestateHook, branchIndex, 0);
+			wxFileName branchFolder = getFramebufferFolder(currentSavestateHook, branchIndex);
 			if(branchFolder.DirExists()) {
-				wxRenameFile(branchFolder.GetPath(), getFramebufferPath(0, currentSavestateHook, branchIndex - 1, 0).GetPath());
+				wxRenameFile(branchFolder.GetPath(), getFramebufferFolder(currentSavestateHook, branchIndex - 1).GetPath());
 			} else {
 				// Have encountered last savestate hook, break loop
 				break;
@@ -815,6 +1095,56 @@ void DataProcessing::removeThisBranch() {
 	removeBranch(viewingBranchIndex);
 }
 
+std::shared_ptr<FramebufferArchive> DataProcessing::getFramebufferArchive(SavestateBlockNum savestateHookNum, BranchNum branch, bool create) {
+	auto key = std::make_pair(savestateHookNum, branch);
+	auto it  = framebufferArchives.find(key);
+	if(it != framebufferArchives.end()) {
+		return it->second;
+	}
+
+	// Older projects have loose framebuffers in the folder, those are moved into the new archive
+	wxFileName folder = getFramebufferFolder(savestateHookNum, branch);
+	if(!create && !folder.DirExists()) {
+		return nullptr;
+	}
+
+	std::shared_ptr<FramebufferArchive> archive = std::make_shared<FramebufferArchive>(folder);
+	framebufferArchives[key]                     = archive;
+	return archive;
+}
+
+void DataProcessing::syncFramebufferArchives() {
+	for(auto& archive : framebufferArchives) {
+		archive.second->sync();
+		archive.second->logUsage();
+	}
+}
+
+void DataProcessing::compactFramebufferArchives() {
+	for(auto& archive : framebufferArchives) {
+		archive.second->compactIfNeeded();
+		archive.second->sync();
+	}
+}
+
+bool DataProcessing::getCurrentFramebuffer(wxImage& image) {
+	if(currentImageFrame == 0) {
+		wxFileName savestateHookFile = getFramebufferPathForSavestateHook(currentSavestateHook);
+		return savestateHookFile.FileExists() && image.LoadFile(savestateHookFile.GetFullPath(), wxBITMAP_TYPE_JPEG);
+	}
+
+	std::shared_ptr<FramebufferArchive> archive = getFramebufferArchive(currentSavestateHook, viewingBranchIndex, false);
+	const uint8_t* data;
+	uint32_t size;
+	if(!archive || !archive->getFramebuffer(currentImageFrame, &data, &size)) {
+		return false;
+	}
+
+	// Decoded straight from the mapped blob
+	wxMemoryInputStream jpegStream(data, size);
+	return image.LoadFile(jpegStream, wxBITMAP_TYPE_JPEG);
+}
+
 void DataProcessing::scrollToSpecific(uint8_t player, SavestateBlockNum savestateHookNum, BranchNum branch, FrameNum frame) {
 	setPlayer(player);
 	setSavestateHook(savestateHookNum);
@@ -824,38 +1154,32 @@ void DataProcessing::scrollToSpecific(uint8_t player, SavestateBlockNum savestat
 
 void DataProcessing::triggerButton(Btn button) {
 	// Trigger button, can occur over range
-	long firstSelectedItem = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
-	if(firstSelectedItem != wxNOT_FOUND) {
-		long lastSelectedItem = firstSelectedItem + GetSelectedItemCount() - 1;
+	if(hasSelection()) {
 		// Now, apply the button
 		// Usually, just set to the opposite of the currently selected element
 		uint8_t state = !getButton(currentFrame, button);
-		for(FrameNum i = firstSelectedItem; i <= lastSelectedItem; i++) {
-			modifyButton(i, button, state);
-		}
+		setButtonRange(getSelection(), button, state);
 	}
 }
 
 // This includes joysticks, accel, gyro, etc...
 void DataProcessing::triggerNumberValues(ControllerNumberValues joystickId, int16_t value) {
 	// Trigger joystick, can occur over range
-	long firstSelectedItem = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
-	if(firstSelectedItem != wxNOT_FOUND) {
-		long lastSelectedItem = firstSelectedItem + GetSelectedItemCount() - 1;
-		for(FrameNum i = firstSelectedItem; i <= lastSelectedItem; i++) {
-			setNumberValues(i, joystickId, value);
-			// No refresh for now, as the joystick is not visible in the allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs
-		}
+	if(hasSelection()) {
+		fillNumberValuesRange(getSelection(), joystickId, value);
 	}
 }
 
 // New FANCY methods
 void DataProcessing::modifyButton(FrameNum frame, Btn button, uint8_t isPressed) {
-	SET_BIT(allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs[viewingBranchIndex]->at(frame)->buttons, isPressed, button);
+	HistoryCommand command = beginFieldEdit(frame, 1, HISTORY_FIELD_BUTTONS, 1UL << button, viewingBranchIndex);
+	SET_BIT(getWritableFrame(*getInputsList(), frame).buttons, isPressed, button);
+	endFieldEdit(command);
+	updateCachedRow(frame);
 
 	invalidateRun(frame);
 
-	RefreshItem(frame);
+	refreshRow(frame);
 	modifyCurrentFrameViews(frame);
 }
 
@@ -865,51 +1189,160 @@ void DataProcessing::toggleButton(FrameNum frame, Btn button) {
 
 void DataProcessing::clearAllButtons(FrameNum frame) {
 	// I think this works
-	getInputsList()->at(frame)->buttons = 0;
+	HistoryCommand command = beginFieldEdit(frame, 1, HISTORY_FIELD_BUTTONS, UINT32_MAX, viewingBranchIndex);
+	getWritableFrame(*getInputsList(), frame).buttons = 0;
+	endFieldEdit(command);
+	updateCachedRow(frame);
 
 	invalidateRun(frame);
 	modifyCurrentFrameViews(frame);
-	RefreshItem(frame);
+	refreshRow(frame);
 }
 
 void DataProcessing::setNumberValues(FrameNum frame, ControllerNumberValues joystickId, int16_t value) {
+	HistoryCommand command = beginFieldEdit(frame, 1, joystickId, UINT32_MAX, viewingBranchIndex);
+	ControllerData& data   = getWritableFrame(*getInputsList(), frame);
 	switch(joystickId) {
 	case ControllerNumberValues::LEFT_X:
-		getInputsList()->at(frame)->LS_X = value;
+		data.LS_X = value;
 		break;
 	case ControllerNumberValues::LEFT_Y:
-		getInputsList()->at(frame)->LS_Y = value;
+		data.LS_Y = value;
 		break;
 	case ControllerNumberValues::RIGHT_X:
-		getInputsList()->at(frame)->RS_X = value;
+		data.RS_X = value;
 		break;
 	case ControllerNumberValues::RIGHT_Y:
-		getInputsList()->at(frame)->RS_Y = value;
+		data.RS_Y = value;
 		break;
 	case ControllerNumberValues::ACCEL_X:
-		getInputsList()->at(frame)->ACCEL_X = value;
+		data.ACCEL_X = value;
 		break;
 	case ControllerNumberValues::ACCEL_Y:
-		getInputsList()->at(frame)->ACCEL_Y = value;
+		data.ACCEL_Y = value;
 		break;
 	case ControllerNumberValues::ACCEL_Z:
-		getInputsList()->at(frame)->ACCEL_Z = value;
+		data.ACCEL_Z = value;
 		break;
 	case ControllerNumberValues::GYRO_1:
-		getInputsList()->at(frame)->GYRO_1 = value;
+		data.GYRO_1 = value;
 		break;
 	case ControllerNumberValues::GYRO_2:
-		getInputsList()->at(frame)->GYRO_2 = value;
+		data.GYRO_2 = value;
 		break;
 	case ControllerNumberValues::GYRO_3:
-		getInputsList()->at(frame)->GYRO_3 = value;
+		data.GYRO_3 = value;
 		break;
 	}
+	endFieldEdit(command);
 
 	modifyCurrentFrameViews(frame);
 	invalidateRun(frame);
 }
 
+void DataProcessing::finishBulkEdit(FrameNum firstFrame) {
+	// Too many rows to update one by one
+	clearRowCache();
+	invalidateRun(firstFrame);
+	modifyCurrentFrameViews(currentFrame);
+	Refresh();
+}
+
+int16_t ControllerData::*DataProcessing::getNumberValueField(ControllerNumberValues joystickId) {
+	switch(joystickId) {
+	case ControllerNumberValues::LEFT_X:
+		return &ControllerData::LS_X;
+	case ControllerNumberValues::LEFT_Y:
+		return &ControllerData::LS_Y;
+	case ControllerNumberValues::RIGHT_X:
+		return &ControllerData::RS_X;
+	case ControllerNumberValues::RIGHT_Y:
+		return &ControllerData::RS_Y;
+	case ControllerNumberValues::ACCEL_X:
+		return &ControllerData::ACCEL_X;
+	case ControllerNumberValues::ACCEL_Y:
+		return &ControllerData::ACCEL_Y;
+	case ControllerNumberValues::ACCEL_Z:
+		return &ControllerData::ACCEL_Z;
+	case ControllerNumberValues::GYRO_1:
+		return &ControllerData::GYRO_1;
+	case ControllerNumberValues::GYRO_2:
+		return &ControllerData::GYRO_2;
+	case ControllerNumberValues::GYRO_3:
+	default:
+		return &ControllerData::GYRO_3;
+	}
+}
+
+void DataProcessing::setButtonRange(const FrameSelection& frames, Btn button, uint8_t isPressed) {
+	uint32_t mask = 1UL << button;
+	if(isPressed) {
+		editFrames(frames, HISTORY_FIELD_BUTTONS, mask, [mask](ControllerData& data) { data.buttons |= mask; });
+	} else {
+		editFrames(frames, HISTORY_FIELD_BUTTONS, mask, [mask](ControllerData& data) { data.buttons &= ~mask; });
+	}
+}
+
+void DataProcessing::toggleButtonRange(const FrameSelection& frames, Btn button) {
+	uint32_t mask = 1UL << button;
+	editFrames(frames, HISTORY_FIELD_BUTTONS, mask, [mask](ControllerData& data) { data.buttons ^= mask; });
+}
+
+void DataProcessing::clearButtonsRange(const FrameSelection& frames) {
+	editFrames(frames, HISTORY_FIELD_BUTTONS, UINT32_MAX, [](ControllerData& data) { data.buttons = 0; });
+}
+
+void DataProcessing::fillNumberValuesRange(const FrameSelection& frames, ControllerNumberValues joystickId, int16_t value) {
+	// Pick the field once instead of switching on every frame
+	int16_t ControllerData::*field = getNumberValueField(joystickId);
+	editFrames(frames, joystickId, UINT32_MAX, [field, value](ControllerData& data) { data.*field = value; });
+}
+
+void DataProcessing::rotateFrames(std::vector<FrameData>& list, FrameNum start, FrameNum end, int64_t offset) {
+	// Only the pointers move
+	auto beginning = list.begin();
+	if(offset > 0) {
+		std::rotate(beginning + start, beginning + end + 1, beginning + end + 1 + offset);
+	} else {
+		std::rotate(beginning + start + offset, beginning + start, beginning + end + 1);
+	}
+}
+
+void DataProcessing::shiftFrames(FrameNum start, FrameNum end, int32_t offset) {
+	auto& list = *currentBranchData;
+	if(start > end || end >= list.size()) {
+		return;
+	}
+
+	// Can't go past either end of the branch
+	int64_t clampedOffset = std::max<int64_t>(-(int64_t)start, std::min<int64_t>(offset, (int64_t)list.size() - 1 - end));
+	if(clampedOffset == 0) {
+		return;
+	}
+
+	FrameNum firstFrame = std::min<int64_t>(start, start + clampedOffset);
+
+	// Ran frames are always at the start, so invalidate before they get mixed up
+	invalidateRun(firstFrame);
+	rotateFrames(list, start, end, clampedOffset);
+	inputIndex.markEdited(list, firstFrame, std::max<int64_t>(end, end + clampedOffset));
+	timelineSummary.markEdited(list, firstFrame, std::max<int64_t>(end, end + clampedOffset));
+
+	HistoryCommand command;
+	command.type          = HISTORY_SHIFT_FRAMES;
+	command.player        = viewingPlayerIndex;
+	command.savestateHook = currentSavestateHook;
+	command.branch        = viewingBranchIndex;
+	command.start         = start;
+	command.count         = end - start + 1;
+	command.offset        = clampedOffset;
+	editHistory.record(command);
+
+	// Keep the moved frames selected
+	setSelection(start + clampedOffset, end + clampedOffset);
+	finishBulkEdit(firstFrame);
+}
+
 int16_t DataProcessing::getNumberValues(FrameNum frame, ControllerNumberValues joystickId) const {
 	switch(joystickId) {
 	case ControllerNumberValues::LEFT_X:
@@ -996,7 +1429,11 @@ void DataProcessing::setControllerDataForAutoRun(ControllerData controllerData)
 	// Set controller data manually
 	std::shared_ptr<ControllerData> newData = std::make_shared<ControllerData>();
 	buttonData->transferControllerData(controllerData, newData, false);
-	getInputsList()->at(currentFrame) = newData;
+	// Recorded like any other edit, so undo can't bring back inputs from before the run
+	std::vector<HistoryCommand> commands = beginFrameEdit(currentFrame, 1, viewingBranchIndex);
+	getInputsList()->at(currentFrame)    = newData;
+	endFrameEdit(commands);
+	updateCachedRow(currentFrame);
 	modifyCurrentFrameViews(currentFrame);
 }
 
@@ -1010,7 +1447,7 @@ void DataProcessing::modifyCurrentFrameViews(FrameNum frame) {
 	// Only update if it is the current frame, as this one has the focus
 	if(frame == currentFrame) {
 		// Refresh this item
-		RefreshItem(currentFrame);
+		refreshRow(currentFrame);
 		// Refresh the grid
 		if(changingSelectedFrameCallback) {
 			changingSelectedFrameCallback(currentFrame, currentRunFrame, currentImageFrame);
@@ -1021,73 +1458,143 @@ void DataProcessing::modifyCurrentFrameViews(FrameNum frame) {
 	}
 }
 
+FrameNum& DataProcessing::getRunWatermarkRef(uint8_t player, SavestateBlockNum savestateHookNum, BranchNum branch) {
+	auto& watermarks = allPlayers[player]->at(savestateHookNum)->runWatermarks;
+	if(watermarks.size() <= branch) {
+		watermarks.resize(branch + 1, 0);
+	}
+	return watermarks[branch];
+}
+
+void DataProcessing::markFrameRan(FrameNum frame, SavestateBlockNum savestateHookNum, BranchNum branch, uint8_t player) {
+	FrameNum& watermark   = getRunWatermarkRef(player, savestateHookNum, branch);
+	FrameNum oldWatermark = watermark;
+	if(frame < oldWatermark) {
+		return;
+	}
+	watermark = frame + 1;
+
+	if(savestateHookNum == currentSavestateHook && branch == viewingBranchIndex && player == viewingPlayerIndex) {
+		if(frame == oldWatermark) {
+			// The usual case, one frame after another
+			updateCachedRow(frame);
+			if(isRowVisible(frame)) {
+				refreshRow(frame);
+			}
+		} else {
+			clearRowCache();
+			Refresh();
+		}
+		modifyCurrentFrameViews(frame);
+	}
+}
+
 void DataProcessing::setFramestateInfo(FrameNum frame, FrameState id, uint8_t state) {
-	SET_BIT(getInputsList()->at(frame)->frameState, state, id);
+	if(id == FrameState::RAN) {
+		// Whether a frame ran is only the watermark
+		if(state) {
+			markFrameRan(frame, currentSavestateHook, viewingBranchIndex, viewingPlayerIndex);
+		} else {
+			invalidateRun(frame);
+		}
+		return;
+	}
+
+	// Shared frames are only split when the state actually changes
+	if((GET_BIT(getInputsList()->at(frame)->frameState, id)) != (state != 0)) {
+		SET_BIT(getWritableFrame(*getInputsList(), frame).frameState, state, id);
+		// Savestates are on the timeline
+		timelineSummary.markEdited(*getInputsList(), frame, frame);
+	}
+	updateCachedRow(frame);
 
-	if(IsVisible(frame)) {
-		RefreshItem(frame);
+	if(isRowVisible(frame)) {
+		refreshRow(frame);
 	}
 
 	modifyCurrentFrameViews(frame);
 }
 
 void DataProcessing::setFramestateInfoSpecific(FrameNum frame, FrameState id, uint8_t state, SavestateBlockNum savestateHookNum, BranchNum branch, uint8_t player) {
-	if(savestateHookNum == currentSavestateHook && player == viewingPlayerIndex) {
+	// Other branches aren't on screen, so they don't need a refresh
+	if(savestateHookNum == currentSavestateHook && branch == viewingBranchIndex && player == viewingPlayerIndex) {
 		setFramestateInfo(frame, id, state);
+	} else if(id == FrameState::RAN) {
+		if(state) {
+			markFrameRan(frame, savestateHookNum, branch, player);
+		} else {
+			invalidateRunSpecific(frame, savestateHookNum, branch, player);
+		}
 	} else {
-		SET_BIT(getControllerData(player, savestateHookNum, branch, frame)->frameState, state, id);
+		auto& list = *allPlayers[player]->at(savestateHookNum)->inputs[branch];
+		if((GET_BIT(list.at(frame)->frameState, id)) != (state != 0)) {
+			SET_BIT(getWritableFrame(list, frame).frameState, state, id);
+			timelineSummary.markEdited(list, frame, frame);
+		}
 	}
 }
 
 uint8_t DataProcessing::getFramestateInfo(FrameNum frame, FrameState id) const {
+	if(id == FrameState::RAN) {
+		return frame < getRunWatermark(viewingPlayerIndex, currentSavestateHook, viewingBranchIndex);
+	}
 	return GET_BIT(getInputsList()->at(frame)->frameState, id);
 }
 
 uint8_t DataProcessing::getFramestateInfoSpecific(FrameNum frame, FrameState id, SavestateBlockNum savestateHookNum, BranchNum branch, uint8_t player) const {
+	if(id == FrameState::RAN) {
+		return frame < getRunWatermark(player, savestateHookNum, branch);
+	}
 	return GET_BIT(getControllerData(player, savestateHookNum, branch, frame)->frameState, id);
 }
 
 // Without the id, just return the whole hog
 uint8_t DataProcessing::getFramestateInfo(FrameNum frame) const {
-	return getInputsList()->at(frame)->frameState;
+	return getFramestateWithRun(*getInputsList()->at(frame), frame, getRunWatermark(viewingPlayerIndex, currentSavestateHook, viewingBranchIndex));
 }
 
 void DataProcessing::invalidateRun(FrameNum frame) {
-	while(true) {
-		if(frame == getInputsList()->size() || !getFramestateInfo(frame, FrameState::RAN)) {
-			// Refresh all these items
-			// I don't care if it's way off the page, I think wxWidgets handles for this
-			Refresh();
-			break;
-		}
-		// Set bit
-		setFramestateInfo(frame, FrameState::RAN, false);
-		// Also delete framebuffer from filesystem if neccessary
-		wxFileName framebufferFileName = getFramebufferPath(viewingPlayerIndex, currentSavestateHook, viewingBranchIndex, frame);
-		if(framebufferFileName.FileExists()) {
-			// Delete file from filesystem
-			wxRemoveFile(framebufferFileName.GetFullPath());
-		}
-		frame++;
-	}
+	invalidateRunSpecific(frame, currentSavestateHook, viewingBranchIndex, viewingPlayerIndex);
 }
 
 void DataProcessing::invalidateRunSpecific(FrameNum frame, SavestateBlockNum savestateHookNum, BranchNum branch, uint8_t player) {
-	auto& list       = allPlayers[player]->at(savestateHookNum)->inputs[branch];
-	std::size_t size = list->size();
-	while(true) {
-		if(frame == size || !getFramestateInfoSpecific(frame, FrameState::RAN, savestateHookNum, branch, player)) {
-			// Refresh all these items
-			// I don't care if it's way off the page, I think wxWidgets handles for this
-			Refresh();
-			break;
-		} else {
-			// Set bit
-			setFramestateInfoSpecific(frame, FrameState::RAN, false, savestateHookNum, branch, player);
-			setFramestateInfoSpecific(frame, FrameState::SAVESTATE, false, savestateHookNum, branch, player);
-			frame++;
+	auto& watermarks = allPlayers[player]->at(savestateHookNum)->runWatermarks;
+	if(branch >= watermarks.size() || frame >= watermarks[branch]) {
+		// Nothing past here was run
+		return;
+	}
+
+	FrameNum oldWatermark = watermarks[branch];
+	watermarks[branch]    = frame;
+
+	bool viewing = savestateHookNum == currentSavestateHook && branch == viewingBranchIndex && player == viewingPlayerIndex;
+	if(viewing) {
+		// Savestates past this aren't valid anymore
+		auto& list = *getInputsList();
+		for(auto it = savestates.begin(); it != savestates.end();) {
+			if(it->first >= frame && it->first < oldWatermark) {
+				if(it->first < list.size() && (GET_BIT(list[it->first]->frameState, FrameState::SAVESTATE))) {
+					SET_BIT(getWritableFrame(list, it->first).frameState, false, FrameState::SAVESTATE);
+					timelineSummary.markEdited(list, it->first, it->first);
+				}
+				it = savestates.erase(it);
+			} else {
+				it++;
+			}
 		}
 	}
+
+	// Framebuffers of the frames that aren't run anymore
+	std::shared_ptr<FramebufferArchive> archive = getFramebufferArchive(savestateHookNum, branch, false);
+	if(archive) {
+		archive->invalidateFrom(frame);
+	}
+
+	if(viewing) {
+		// Every row after this changed, so the whole page is redone
+		clearRowCache();
+		Refresh();
+	}
 }
 
 void DataProcessing::addFrame(FrameNum afterFrame) {
@@ -1105,6 +1612,8 @@ void DataProcessing::addFrame(FrameNum afterFrame) {
 				auto begin = branch->begin();
 				branch->insert(begin + afterFrame + 1, newControllerData);
 			}
+			inputIndex.markMovedFrom(*branch, afterFrame + 1);
+			timelineSummary.markMovedFrom(*branch, afterFrame + 1);
 
 			// Invalidate run for the data immidiently after this frame
 			invalidateRunSpecific(afterFrame + 1, currentSavestateHook, branchIndex, playerIndex);
@@ -1115,31 +1624,188 @@ void DataProcessing::addFrame(FrameNum afterFrame) {
 		playerIndex++;
 	}
 
+	HistoryCommand command;
+	command.type          = HISTORY_INSERT_FRAMES;
+	command.player        = viewingPlayerIndex;
+	command.savestateHook = currentSavestateHook;
+	command.start         = std::min<FrameNum>(afterFrame + 1, getInputsList()->size() - 1);
+	command.count         = 1;
+	editHistory.record(command);
+
 	// Because of the usability of virtual list controls, just update the length
-	SetItemCount(getInputsList()->size());
+	clearRowCache();
+	setRowCount(getInputsList()->size());
 
 	modifyCurrentFrameViews(afterFrame + 1);
 
 	// Be very careful about refreshing, serious lag can happen if it's done wrong
-	if(IsVisible(afterFrame + 1)) {
+	if(isRowVisible(afterFrame + 1)) {
 		Refresh();
 	}
 }
 
+void DataProcessing::addFrames(FrameNum start, FrameNum count) {
+	uint8_t playerIndex = 0;
+	for(auto& player : allPlayers) {
+		BranchNum branchIndex = 0;
+
+		for(auto& branch : player->at(currentSavestateHook)->inputs) {
+			std::vector<std::shared_ptr<ControllerData>> newFrames(count);
+			for(auto& newFrame : newFrames) {
+				newFrame = std::make_shared<ControllerData>();
+			}
+
+			FrameNum insertLoc = std::min<FrameNum>(start, branch->size());
+			branch->insert(branch->begin() + insertLoc, newFrames.begin(), newFrames.end());
+			inputIndex.markMovedFrom(*branch, insertLoc);
+			timelineSummary.markMovedFrom(*branch, insertLoc);
+
+			invalidateRunSpecific(insertLoc, currentSavestateHook, branchIndex, playerIndex);
+
+			branchIndex++;
+		}
+
+		playerIndex++;
+	}
+
+	HistoryCommand command;
+	command.type          = HISTORY_INSERT_FRAMES;
+	command.player        = viewingPlayerIndex;
+	command.savestateHook = currentSavestateHook;
+	command.start         = std::min<FrameNum>(start, getInputsList()->size() - count);
+	command.count         = count;
+	editHistory.record(command);
+
+	clearRowCache();
+	setRowCount(getInputsList()->size());
+}
+
+FrameNum DataProcessing::pasteFrames(const std::vector<ScriptFrame>& frames, FrameNum startLoc, bool insertPaste, bool placePaste) {
+	if(frames.empty()) {
+		return startLoc;
+	}
+
+	FrameNum span = 0;
+	for(auto const& frame : frames) {
+		span = std::max<FrameNum>(span, frame.offset + 1);
+	}
+
+	editHistory.beginGroup();
+
+	// Gaps between script frames are left blank
+	if(insertPaste) {
+		addFrames(startLoc, span);
+	} else if(startLoc + span > getFramesSize()) {
+		addFrames(getFramesSize(), startLoc + span - getFramesSize());
+	}
+
+	std::vector<HistoryCommand> commands = beginFrameEdit(startLoc, span, viewingBranchIndex);
+
+	auto inputs = getInputsList();
+	for(auto const& frame : frames) {
+		ControllerData& data = getWritableFrame(*inputs, startLoc + frame.offset);
+
+		if(frame.lastField >= SCRIPT_BUTTONS) {
+			// Place paste adds the buttons instead of replacing them
+			data.buttons = placePaste ? (data.buttons | frame.buttons) : frame.buttons;
+		}
+		if(frame.lastField >= SCRIPT_LEFT_JOYSTICK) {
+			data.LS_X = frame.LS_X;
+			data.LS_Y = frame.LS_Y;
+		}
+		if(frame.lastField >= SCRIPT_RIGHT_JOYSTICK) {
+			data.RS_X = frame.RS_X;
+			data.RS_Y = frame.RS_Y;
+		}
+		if(frame.lastField >= SCRIPT_ACCEL) {
+			data.ACCEL_X = frame.ACCEL_X;
+			data.ACCEL_Y = frame.ACCEL_Y;
+			data.ACCEL_Z = frame.ACCEL_Z;
+		}
+		if(frame.lastField >= SCRIPT_GYRO) {
+			data.GYRO_1 = frame.GYRO_1;
+			data.GYRO_2 = frame.GYRO_2;
+			data.GYRO_3 = frame.GYRO_3;
+		}
+	}
+
+	endFrameEdit(commands);
+	editHistory.endGroup();
+
+	// One invalidation and refresh for the whole paste
+	clearRowCache();
+	invalidateRun(startLoc);
+	modifyCurrentFrameViews(currentFrame);
+	Refresh();
+
+	return startLoc + span - 1;
+}
+
 void DataProcessing::addFrameHere() {
 	addFrame(currentFrame);
 }
 
 void DataProcessing::removeFrames(FrameNum start, FrameNum end) {
+	if(start <= end) {
+		removeFrames(FrameSelection(start, end));
+	}
+}
+
+void DataProcessing::removeFrames(const FrameSelection& frames) {
 	// Since only selected frames will ever be selected, this just makes sure
 	// One frame is left over
-	if(end - start != (getFramesSize() - 1)) {
+	if(!frames.empty() && frames.size() < getFramesSize()) {
+		// The selection can change below
+		FrameNum start                       = frames.first();
+		std::vector<FrameInterval> intervals = frames.getIntervals();
+
+		// Last interval first, so undoing puts them back in order
+		editHistory.beginGroup();
+		for(auto interval = intervals.rbegin(); interval != intervals.rend(); interval++) {
+			if(interval->start >= getFramesSize()) {
+				continue;
+			}
+
+			HistoryCommand command;
+			command.type          = HISTORY_REMOVE_FRAMES;
+			command.player        = viewingPlayerIndex;
+			command.savestateHook = currentSavestateHook;
+			command.start         = interval->start;
+			command.count         = std::min<FrameNum>(interval->end, getFramesSize() - 1) - interval->start + 1;
+
+			for(auto& player : allPlayers) {
+				for(auto& branch : player->at(currentSavestateHook)->inputs) {
+					for(uint8_t field = 0; field < HISTORY_NUM_FIELDS; field++) {
+						command.removedFields.emplace_back();
+						EditHistory::captureField(*branch, command.start, command.count, field, UINT32_MAX, command.removedFields.back());
+					}
+				}
+			}
+
+			editHistory.record(command);
+		}
+		editHistory.endGroup();
+
 		uint8_t playerIndex = 0;
 		for(auto& player : allPlayers) {
 			BranchNum branchIndex = 0;
 			for(auto& branch : player->at(currentSavestateHook)->inputs) {
-				auto beginning = branch->begin();
-				branch->erase(beginning + start, beginning + end + 1);
+				// Kept frames are moved down over the removed ones, then the end is cut off
+				auto& list       = *branch;
+				std::size_t kept = start;
+				std::size_t next = start;
+				for(auto const& interval : intervals) {
+					while(next < interval.start && next < list.size()) {
+						list[kept++] = std::move(list[next++]);
+					}
+					next = (std::size_t)interval.end + 1;
+				}
+				while(next < list.size()) {
+					list[kept++] = std::move(list[next++]);
+				}
+				list.resize(std::min(kept, list.size()));
+				inputIndex.markMovedFrom(list, start);
+				timelineSummary.markMovedFrom(list, start);
 
 				// Invalidate run for the data immidiently after this frame
 				invalidateRunSpecific(start, currentSavestateHook, branchIndex, playerIndex);
@@ -1151,7 +1817,12 @@ void DataProcessing::removeFrames(FrameNum start, FrameNum end) {
 		}
 
 		// Because of the usability of virtual list controls, just update the length
-		SetItemCount(getInputsList()->size());
+		clearRowCache();
+		setRowCount(getInputsList()->size());
+
+		// The old selection is gone, select where it started
+		FrameNum newSelected = std::min<FrameNum>(start, getFramesSize() - 1);
+		setSelection(newSelected, newSelected);
 
 		if(currentFrame > (getFramesSize() - 1)) {
 			setCurrentFrame(getFramesSize() - 1);
@@ -1171,4 +1842,298 @@ DataProcessing::~DataProcessing() {
 	// Free the sucker
 	// free(itemAttribute.second);
 	//}
-}
\ No newline at end of file
+}
+HistoryCommand DataProcessing::beginFieldEdit(FrameNum start, FrameNum count, uint8_t field, uint32_t mask, BranchNum branch) {
+	HistoryCommand command;
+	command.type          = HISTORY_SET_FIELD;
+	command.player        = viewingPlayerIndex;
+	command.savestateHook = currentSavestateHook;
+	command.branch        = branch;
+	command.start         = start;
+	command.count         = count;
+	command.field         = field;
+	command.mask          = mask;
+	EditHistory::captureField(*allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs[branch], start, count, field, mask, command.oldValues);
+	return command;
+}
+
+void DataProcessing::endFieldEdit(HistoryCommand& command) {
+	auto& list = *allPlayers[command.player]->at(command.savestateHook)->inputs[command.branch];
+	EditHistory::captureField(list, command.start, command.count, command.field, command.mask, command.newValues);
+	if(command.count != 0) {
+		inputIndex.markEdited(list, command.start, command.start + command.count - 1);
+		timelineSummary.markEdited(list, command.start, command.start + command.count - 1);
+	}
+	branchDiffDirty = true;
+	editHistory.record(std::move(command));
+}
+
+std::vector<HistoryCommand> DataProcessing::beginFrameEdit(FrameNum start, FrameNum count, BranchNum branch) {
+	std::vector<HistoryCommand> commands;
+	for(uint8_t field = 0; field < HISTORY_NUM_FIELDS; field++) {
+		commands.push_back(beginFieldEdit(start, count, field, UINT32_MAX, branch));
+	}
+	return commands;
+}
+
+void DataProcessing::endFrameEdit(std::vector<HistoryCommand>& commands) {
+	// Fields that didn't change are dropped by the history
+	editHistory.beginGroup();
+	for(auto& command : commands) {
+		endFieldEdit(command);
+	}
+	editHistory.endGroup();
+}
+
+bool DataProcessing::applyHistoryCommand(const HistoryCommand& command, bool undo) {
+	if(command.player >= allPlayers.size() || command.savestateHook >= allPlayers[command.player]->size()) {
+		return false;
+	}
+
+	auto& branches = allPlayers[command.player]->at(command.savestateHook)->inputs;
+	if(command.branch >= branches.size()) {
+		return false;
+	}
+
+	switch(command.type) {
+	case HISTORY_SET_FIELD: {
+		auto& list = *branches[command.branch];
+		if((uint64_t)command.start + command.count > list.size()) {
+			return false;
+		}
+		EditHistory::applyField(list, command.start, command.field, command.mask, undo ? command.oldValues : command.newValues);
+		if(command.count != 0) {
+			inputIndex.markEdited(list, command.start, command.start + command.count - 1);
+			timelineSummary.markEdited(list, command.start, command.start + command.count - 1);
+		}
+		invalidateRunSpecific(command.start, command.savestateHook, command.branch, command.player);
+		return true;
+	}
+	case HISTORY_SHIFT_FRAMES: {
+		auto& list = *branches[command.branch];
+		// Undoing shifts the frames back from where they ended up
+		FrameNum start = undo ? command.start + command.offset : command.start;
+		int64_t offset = undo ? -command.offset : command.offset;
+		if((int64_t)start + offset < 0 || (uint64_t)start + command.count + std::max<int64_t>(offset, 0) > list.size() || command.count == 0) {
+			return false;
+		}
+		invalidateRunSpecific(std::min<int64_t>(start, start + offset), command.savestateHook, command.branch, command.player);
+		rotateFrames(list, start, start + command.count - 1, offset);
+		inputIndex.markEdited(list, std::min<int64_t>(start, start + offset), std::max<int64_t>(start, start + offset) + command.count - 1);
+		timelineSummary.markEdited(list, std::min<int64_t>(start, start + offset), std::max<int64_t>(start, start + offset) + command.count - 1);
+		return true;
+	}
+	case HISTORY_INSERT_FRAMES:
+	case HISTORY_REMOVE_FRAMES: {
+		// Undoing an insert is a remove and the other way around
+		bool insert = (command.type == HISTORY_INSERT_FRAMES) != undo;
+
+		std::size_t branchIndex = 0;
+		uint8_t playerIndex     = 0;
+		for(auto& player : allPlayers) {
+			BranchNum branchNum = 0;
+			for(auto& branch : player->at(command.savestateHook)->inputs) {
+				if(command.start > branch->size() || (!insert && (uint64_t)command.start + command.count > branch->size())) {
+					return false;
+				}
+
+				if(insert) {
+					std::vector<FrameData> newFrames(command.count);
+					for(auto& newFrame : newFrames) {
+						newFrame = std::make_shared<ControllerData>();
+					}
+					branch->insert(branch->begin() + command.start, newFrames.begin(), newFrames.end());
+
+					// Removed frames get their data back
+					if(command.type == HISTORY_REMOVE_FRAMES) {
+						for(uint8_t field = 0; field < HISTORY_NUM_FIELDS; field++) {
+							std::size_t fieldIndex = branchIndex * HISTORY_NUM_FIELDS + field;
+							if(fieldIndex < command.removedFields.size()) {
+								EditHistory::applyField(*branch, command.start, field, UINT32_MAX, command.removedFields[fieldIndex]);
+							}
+						}
+					}
+				} else {
+					branch->erase(branch->begin() + command.start, branch->begin() + command.start + command.count);
+				}
+				inputIndex.markMovedFrom(*branch, command.start);
+				timelineSummary.markMovedFrom(*branch, command.start);
+
+				invalidateRunSpecific(std::min<FrameNum>(command.start, branch->size()), command.savestateHook, branchNum, playerIndex);
+
+				branchIndex++;
+				branchNum++;
+			}
+
+			playerIndex++;
+		}
+		return true;
+	}
+	}
+
+	return false;
+}
+
+void DataProcessing::finishHistoryChange(const HistoryEntry& entry, bool valid) {
+	if(!valid) {
+		// Something changed the inputs without going through the history
+		wxLogMessage("Edit history doesn't match the inputs anymore, it has been cleared");
+		editHistory.clear();
+		inputIndex.clear();
+		timelineSummary.clear();
+	}
+
+	clearRowCache();
+	setRowCount(getInputsList()->size());
+
+	FrameNum firstFrame = UINT32_MAX;
+	for(auto const& command : entry) {
+		if(command.player == viewingPlayerIndex && command.savestateHook == currentSavestateHook) {
+			firstFrame = std::min(firstFrame, command.start);
+		}
+	}
+
+	// Jump to the change if it can be seen
+	if(firstFrame != UINT32_MAX) {
+		setCurrentFrame(std::min<FrameNum>(firstFrame, getFramesSize() - 1));
+	} else if(currentFrame > getFramesSize() - 1) {
+		setCurrentFrame(getFramesSize() - 1);
+	}
+
+	modifyCurrentFrameViews(currentFrame);
+	Refresh();
+}
+
+void DataProcessing::undo() {
+	if(editHistory.canUndo()) {
+		HistoryEntry entry = editHistory.popUndo();
+
+		// Backwards, the last command was done last
+		bool valid = true;
+		for(auto command = entry.rbegin(); valid && command != entry.rend(); command++) {
+			valid = applyHistoryCommand(*command, true);
+		}
+
+		finishHistoryChange(entry, valid);
+	}
+}
+
+void DataProcessing::redo() {
+	if(editHistory.canRedo()) {
+		HistoryEntry entry = editHistory.popRedo();
+
+		bool valid = true;
+		for(auto command = entry.begin(); valid && command != entry.end(); command++) {
+			valid = applyHistoryCommand(*command, false);
+		}
+
+		finishHistoryChange(entry, valid);
+	}
+}
+
+bool DataProcessing::runQuery(const std::string& queryText, std::string& error) {
+	InputQuery query;
+	if(!query.parse(queryText, buttonData->stringToButton)) {
+		error = query.getError();
+		return false;
+	}
+
+	auto start                = std::chrono::steady_clock::now();
+	std::size_t blocksRebuilt = inputIndex.update(*currentBranchData);
+	query.evaluate(inputIndex, queryMatches);
+	auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+	wxLogDebug("Query \"%s\" matched %llu of %u frames in %lld us, %zu blocks rebuilt, index uses %zu bytes", queryText, (unsigned long long)InputQuery::countMatches(queryMatches), inputIndex.getNumFrames(), (long long)time.count(), blocksRebuilt, inputIndex.getMemoryUsage());
+
+	lastQueryText = queryText;
+	return true;
+}
+
+bool DataProcessing::findFrames(const std::string& queryText, std::string& error) {
+	if(!runQuery(queryText, error)) {
+		return false;
+	}
+
+	FrameSelection matches;
+	InputQuery::bitmapToSelection(queryMatches, matches);
+	if(matches.empty()) {
+		error = "No frames match";
+		return false;
+	}
+
+	FrameNum firstMatch;
+	if(!InputQuery::findNextMatch(queryMatches, currentFrame, firstMatch)) {
+		firstMatch = matches.first();
+	}
+
+	setSelection(matches);
+	setCurrentFrame(firstMatch);
+	return true;
+}
+
+bool DataProcessing::jumpToNextMatch() {
+	// Run again, the inputs could have changed since, only dirty blocks are rebuilt
+	std::string error;
+	if(lastQueryText.empty() || !runQuery(lastQueryText, error)) {
+		return false;
+	}
+
+	FrameNum match;
+	if(!InputQuery::findNextMatch(queryMatches, currentFrame + 1, match) && !InputQuery::findNextMatch(queryMatches, 0, match)) {
+		return false;
+	}
+
+	setCurrentFrame(match);
+	return true;
+}
+
+void DataProcessing::updateBranchDiff() {
+	if(!comparingBranches || !branchDiffDirty) {
+		return;
+	}
+	branchDiffDirty = false;
+
+	// Can't compare a branch with itself, or one that's gone with the hook
+	auto& branches = allPlayers[viewingPlayerIndex]->at(currentSavestateHook)->inputs;
+	if(compareBranchIndex >= branches.size() || compareBranchIndex == viewingBranchIndex) {
+		branchDiff.clear();
+		return;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	branchDiff.compute(*branches[compareBranchIndex], *currentBranchData);
+	branchDiff.logStats(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+void DataProcessing::compareWithBranch(BranchNum branchIndex) {
+	comparingBranches  = true;
+	compareBranchIndex = branchIndex;
+	branchDiffDirty    = true;
+	updateBranchDiff();
+
+	wxLogMessage(wxString::Format("%u frames differ from branch %u in %zu places", branchDiff.getNumDifferentFrames(), branchIndex, branchDiff.getHunks().size()));
+
+	FrameNum firstDifference;
+	if(branchDiff.findNextHunk(0, firstDifference)) {
+		setCurrentFrame(firstDifference);
+	}
+	Refresh();
+}
+
+void DataProcessing::stopComparing() {
+	comparingBranches = false;
+	branchDiff.clear();
+	Refresh();
+}
+
+bool DataProcessing::jumpToNextDifference() {
+	updateBranchDiff();
+
+	FrameNum difference;
+	if(!branchDiff.findNextHunk(currentFrame + 1, difference) && !branchDiff.findNextHunk(0, difference)) {
+		return false;
+	}
+
+	setCurrentFrame(difference);
+	return true;
+}
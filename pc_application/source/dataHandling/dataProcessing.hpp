@@ -5,7 +5,9 @@
 #include <uxtheme.h>
 #endif
 
+#include <algorithm>
 #include <bitset>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
@@ -18,17 +20,30 @@
 #include <tuple>
 #include <utility>
 #include <vector>
+#include <wx/choicdlg.h>
 #include <wx/clipbrd.h>
+#include <wx/dirdlg.h>
 #include <wx/grid.h>
-#include <wx/imaglist.h>
 #include <wx/itemattr.h>
-#include <wx/listctrl.h>
 #include <wx/menu.h>
+#include <wx/mstream.h>
+#include <wx/numdlg.h>
+#include <wx/progdlg.h>
 #include <wx/wx.h>
 
 #include "../sharedNetworkCode/networkInterface.hpp"
+#include "../ui/inputGrid.hpp"
+#include "autoRunPipeline.hpp"
+#include "branchDiff.hpp"
 #include "buttonConstants.hpp"
 #include "buttonData.hpp"
+#include "editHistory.hpp"
+#include "frameSelection.hpp"
+#include "framebufferArchive.hpp"
+#include "inputIndex.hpp"
+#include "inputQuery.hpp"
+#include "scriptParser.hpp"
+#include "timelineSummary.hpp"
 
 typedef std::shared_ptr<ControllerData> FrameData;
 typedef std::vector<std::shared_ptr<std::vector<std::shared_ptr<SavestateHook>>>> AllPlayers;
@@ -37,13 +52,11 @@ typedef std::shared_ptr<std::vector<FrameData>> BranchData;
 
 class ButtonData;
 
-class DataProcessing : public wxListCtrl {
+class DataProcessing : public InputGrid {
 	// clang-format on
 private:
 	// Vector storing inputs for current savestate hook
 	// SavestateHookBlock inputsList;
-	// Current input
-	FrameData currentData;
 	BranchData currentBranchData;
 	// Button data instance (never changes)
 	std::shared_ptr<ButtonData> buttonData;
@@ -53,8 +66,35 @@ private:
 
 	wxFileName projectStart;
 
+	// Undo and redo for every edit made through this class
+	EditHistory editHistory;
+
+	// Opened when first used, the player doesn't matter, same as the folders
+	std::map<std::pair<SavestateBlockNum, BranchNum>, std::shared_ptr<FramebufferArchive>> framebufferArchives;
+
+	// For find frames, kept up to date as frames are edited
+	InputIndex inputIndex;
+	std::string lastQueryText;
+	FrameBitmap queryMatches;
+
+	// Button counts over the whole viewed branch, for the timeline
+	TimelineSummary timelineSummary;
+
+	// The viewed branch against another branch of the same hook, shown in the gutter
+	BranchDiff branchDiff;
+	bool comparingBranches       = false;
+	BranchNum compareBranchIndex = 0;
+	// Set by every edit, the diff is computed again before the next paint
+	bool branchDiffDirty = false;
+
 	bool tethered = false;
 
+	// Auto run frames sent and not back yet
+	AutoRunPipeline autoRunPipeline;
+
+	// Framebuffers sent back while running to a frame, asked for every time
+	int runToFrameFramebufferInterval = 60;
+
 	// Current frames (all relative to the start of the savestate hook block)
 	// What you can edit
 	FrameNum currentFrame = 0;
@@ -68,8 +108,6 @@ private:
 	uint8_t viewingPlayerIndex  = 0;
 	uint16_t viewingBranchIndex = 0;
 
-	wxImageList imageList;
-
 	// Using callbacks for inputs
 	std::function<void(uint8_t)> inputCallback;
 	std::function<void(FrameNum)> selectedFrameCallbackVideoViewer;
@@ -77,6 +115,8 @@ private:
 	std::function<void(FrameNum, FrameNum, FrameNum)> changingSelectedFrameCallback;
 	std::function<void(uint8_t, uint8_t, bool)> playerInfoCallback;
 	std::function<void(uint16_t, uint16_t, bool)> branchInfoCallback;
+	// Every time the grid is painted, the timeline checks if anything it shows changed
+	std::function<void()> timelineCallback;
 
 	// Network instance for sending to switch
 	std::shared_ptr<CommunicateWithNetwork> networkInstance;
@@ -95,13 +135,39 @@ private:
 	// Universal item attributes for certain attributes
 	std::unordered_map<uint8_t, wxItemAttr*> itemAttributes;
 
-	virtual int OnGetItemColumnImage(long item, long column) const override;
-	virtual wxString OnGetItemText(long item, long column) const override;
-	virtual wxItemAttr* OnGetItemAttr(long item) const override;
+	// Render data for the rows about to be painted, filled in prepareRows
+	// Rows outside of it go through the frame store like normal
+	long rowCacheStart = 0;
+	std::vector<uint32_t> cachedButtons;
+	std::vector<wxItemAttr*> cachedAttributes;
+
+	void fillRowCache(long first, long last);
+	// Single rows are rewritten, anything that moves frames throws the whole cache away
+	void updateCachedRow(FrameNum frame);
+	void clearRowCache();
+	bool isRowCached(long row) const {
+		return row >= rowCacheStart && row < rowCacheStart + (long)cachedButtons.size();
+	}
+
+	virtual uint32_t getRowButtons(FrameNum row) const override;
+	virtual const wxItemAttr* getRowAttr(FrameNum row) const override;
+	virtual uint8_t getRowDiffMark(FrameNum row) const override;
+	virtual void prepareRows(FrameNum first, FrameNum last) override;
+	virtual void onRowFocused(FrameNum row) override;
+	virtual void onRowActivated(FrameNum row) override;
 
 	void setItemAttributes();
 
-	void OnEraseBackground(wxEraseEvent& event);
+	// Created the first time the branch is run
+	FrameNum& getRunWatermarkRef(uint8_t player, SavestateBlockNum savestateHookNum, BranchNum branch);
+	// The frame state with the ran bit coming from the watermark
+	uint8_t getFramestateWithRun(const ControllerData& data, FrameNum frame, FrameNum watermark) const {
+		uint8_t state = data.frameState;
+		SET_BIT(state, frame < watermark, FrameState::RAN);
+		return state;
+	}
+	// Moves the watermark past this frame
+	void markFrameRan(FrameNum frame, SavestateBlockNum savestateHookNum, BranchNum branch, uint8_t player);
 
 	// Custom accelerator IDs
 	int pasteInsertID;
@@ -112,6 +178,18 @@ private:
 	int frameAdvanceID;
 	int savestateID;
 	int mergeIntoMainBranchID;
+	int clearButtonsID;
+	int shiftFramesID;
+	int forkBranchID;
+	int exportFramebuffersID;
+	int findFramesID;
+	int nextMatchID;
+	int compareBranchID;
+	int nextDifferenceID;
+	int stopComparingID;
+	int runToFrameID;
+	int undoID;
+	int redoID;
 
 	int insertPaste;
 	bool placePaste;
@@ -122,8 +200,6 @@ private:
 	void onDropFiles(wxDropFilesEvent& event);
 
 	void onRightClick(wxContextMenuEvent& event);
-	void onSelect(wxListEvent& event);
-	void onActivate(wxListEvent& event);
 	void onCopy(wxCommandEvent& event);
 	void onCut(wxCommandEvent& event);
 	void onPaste(wxCommandEvent& event);
@@ -134,29 +210,92 @@ private:
 	void onAdd10Frames(wxCommandEvent& event);
 	void onRemoveFrame(wxCommandEvent& event);
 	void onFrameAdvance(wxCommandEvent& event);
+	void onRunToFrame(wxCommandEvent& event);
 	void onAddSavestate(wxCommandEvent& event);
 	void onMergeIntoMainBranch(wxCommandEvent& event);
+	void onClearButtons(wxCommandEvent& event);
+	void onShiftFrames(wxCommandEvent& event);
+	void onForkBranch(wxCommandEvent& event);
+	void onExportFramebuffers(wxCommandEvent& event);
+	void onFindFrames(wxCommandEvent& event);
+	void onNextMatch(wxCommandEvent& event);
+	void onCompareBranch(wxCommandEvent& event);
+	void onNextDifference(wxCommandEvent& event);
+	void onStopComparing(wxCommandEvent& event);
+	void onUndo(wxCommandEvent& event);
+	void onRedo(wxCommandEvent& event);
+
+	// Runs edit on every selected frame of the viewed branch, then refreshes once
+	// Field and mask are what edit touches, for the history
+	template <typename Edit> void editFrames(const FrameSelection& frames, uint8_t field, uint32_t mask, Edit edit) {
+		if(frames.empty() || currentBranchData->empty()) {
+			return;
+		}
 
-public:
-	static const int LIST_CTRL_ID = 1000;
+		// Straight through the vector, nothing is refreshed per frame
+		auto& list = *currentBranchData;
+		editHistory.beginGroup();
+		for(auto const& interval : frames.getIntervals()) {
+			FrameNum end = std::min<FrameNum>(interval.end, list.size() - 1);
+			if(interval.start > end) {
+				break;
+			}
+
+			HistoryCommand command = beginFieldEdit(interval.start, end - interval.start + 1, field, mask, viewingBranchIndex);
+			for(FrameNum i = interval.start; i <= end; i++) {
+				edit(getWritableFrame(list, i));
+			}
+			endFieldEdit(command);
+		}
+		editHistory.endGroup();
+
+		finishBulkEdit(frames.first());
+	}
+	void finishBulkEdit(FrameNum firstFrame);
+	static int16_t ControllerData::*getNumberValueField(ControllerNumberValues joystickId);
+	// Moves start to end over by offset, the frames in the way go where they were
+	static void rotateFrames(std::vector<FrameData>& list, FrameNum start, FrameNum end, int64_t offset);
+
+	// Old values are taken before the edit and new ones after, then it's recorded
+	HistoryCommand beginFieldEdit(FrameNum start, FrameNum count, uint8_t field, uint32_t mask, BranchNum branch);
+	void endFieldEdit(HistoryCommand& command);
+	// Every field, for edits that replace whole frames
+	std::vector<HistoryCommand> beginFrameEdit(FrameNum start, FrameNum count, BranchNum branch);
+	void endFrameEdit(std::vector<HistoryCommand>& commands);
+	// Returns false if the command doesn't fit the inputs anymore
+	bool applyHistoryCommand(const HistoryCommand& command, bool undo);
+	void finishHistoryChange(const HistoryEntry& entry, bool valid);
+
+	// Fills queryMatches for the viewed branch
+	bool runQuery(const std::string& queryText, std::string& error);
+
+	// Only does anything when comparing and something changed
+	void updateBranchDiff();
 
+public:
 	// All blocks loaded in by projectManager
 	DataProcessing(rapidjson::Document* settings, std::shared_ptr<ButtonData> buttons, std::shared_ptr<CommunicateWithNetwork> communicateWithNetwork, wxWindow* parent);
 
 	void setInputCallback(std::function<void(uint8_t)> callback);
 	void setSelectedFrameCallbackVideoViewer(std::function<void(int)> callback);
 	void setViewableInputsCallback(std::function<void(FrameNum, FrameNum)> callback);
+	void setTimelineCallback(std::function<void()> callback);
 	void setChangingSelectedFrameCallback(std::function<void(FrameNum, FrameNum, FrameNum)> callback);
 	void setPlayerInfoCallback(std::function<void(uint8_t, uint8_t, bool)> callback);
 	void setBranchInfoCallback(std::function<void(uint16_t, uint16_t, bool)> callback);
 	void triggerCurrentFrameChanges();
 
+	// Sends the frame after the ones already in flight
 	void sendAutoAdvance(uint8_t includeFramebuffer);
+	AutoRunPipeline& getAutoRunPipeline() {
+		return autoRunPipeline;
+	}
 
-	std::string getExportedCurrentPlayer();
+	std::vector<ScriptFrame> getExportSnapshotCurrentPlayer();
 	void importFromFile(wxFileName importTarget);
 
 	void setProjectStart(wxFileName start) {
+		closeFramebufferArchives();
 		projectStart = start;
 	}
 
@@ -171,13 +310,28 @@ public:
 		for(auto& player : players) {
 			allPlayers.push_back(player);
 		}
+		editHistory.clear();
+		inputIndex.clear();
+		timelineSummary.clear();
+		stopComparing();
 		setPlayer(0);
 	}
 
+	// Saved and loaded with the project
+	EditHistory& getEditHistory() {
+		return editHistory;
+	}
+
 	AllPlayers& getAllPlayers() {
 		return allPlayers;
 	}
 
+	// Brought up to date with the viewed branch first
+	const TimelineSummary& getTimelineSummary() {
+		timelineSummary.update(*currentBranchData);
+		return timelineSummary;
+	}
+
 	uint8_t getCurrentPlayer() {
 		return viewingPlayerIndex;
 	}
@@ -187,6 +341,12 @@ public:
 	FrameNum getCurrentFrame() {
 		return currentFrame;
 	}
+	FrameNum getCurrentRunFrame() {
+		return currentRunFrame;
+	}
+	FrameNum getCurrentImageFrame() {
+		return currentImageFrame;
+	}
 	uint16_t getCurrentBranch() {
 		return viewingBranchIndex;
 	}
@@ -196,29 +356,43 @@ public:
 	FrameNum getNumOfFramesInSavestateHook(SavestateBlockNum i, uint8_t player) {
 		return allPlayers[player]->at(i)->inputs[viewingBranchIndex]->size();
 	}
+	// Counted from the start of the first savestate hook, previous hooks use their main branch
+	FrameNum getAbsoluteFrame(SavestateBlockNum savestateHookNum, FrameNum frame) {
+		for(SavestateBlockNum i = 0; i < savestateHookNum; i++) {
+			frame += allPlayers[viewingPlayerIndex]->at(i)->inputs[0]->size();
+		}
+		return frame;
+	}
 
-	wxFileName getFramebufferPath(uint8_t player, SavestateBlockNum savestateHookNum, BranchNum branch, FrameNum frame) {
+	wxFileName getFramebufferFolder(SavestateBlockNum savestateHookNum, BranchNum branch) {
 		// The player does not matter in the path
-		wxFileName framebufferFileName = projectStart;
-		framebufferFileName.AppendDir("framebuffers");
-		framebufferFileName.AppendDir(wxString::Format("savestate_block_%u", savestateHookNum));
+		wxFileName framebufferFolder = projectStart;
+		framebufferFolder.AppendDir("framebuffers");
+		framebufferFolder.AppendDir(wxString::Format("savestate_block_%u", savestateHookNum));
 
 		if(branch == 0) {
 			// Main branch gets a special name
-			framebufferFileName.AppendDir("branch_main");
+			framebufferFolder.AppendDir("branch_main");
 		} else {
-			framebufferFileName.AppendDir(wxString::Format("branch_%u", branch));
+			framebufferFolder.AppendDir(wxString::Format("branch_%u", branch));
 		}
 
-		framebufferFileName.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+		return framebufferFolder;
+	}
 
-		framebufferFileName.SetName(wxString::Format("frame_%lu_screenshot", frame));
-		framebufferFileName.SetExt("jpg");
-		return framebufferFileName;
+	// Returns nullptr if the branch has no archive and create isn't set
+	std::shared_ptr<FramebufferArchive> getFramebufferArchive(SavestateBlockNum savestateHookNum, BranchNum branch, bool create);
+	// Unmaps every archive, needed before their folders are moved or removed
+	void closeFramebufferArchives() {
+		framebufferArchives.clear();
 	}
+	// Writes the archives out, done when the project is saved
+	void syncFramebufferArchives();
+	// Can take seconds on big archives, so it's only done when the window closes
+	void compactFramebufferArchives();
 
-	wxFileName getFramebufferPathForCurrent() {
-		return getFramebufferPath(viewingPlayerIndex, currentSavestateHook, viewingBranchIndex, currentFrame);
+	void saveFramebuffer(uint8_t player, SavestateBlockNum savestateHookNum, BranchNum branch, FrameNum frame, const std::vector<uint8_t>& data) {
+		getFramebufferArchive(savestateHookNum, branch, true)->addFramebuffer(frame, data.data(), data.size());
 	}
 
 	wxFileName getFramebufferPathForSavestateHook(SavestateBlockNum index) {
@@ -234,13 +408,8 @@ public:
 		return framebufferFileName;
 	}
 
-	wxFileName getFramebufferPathForCurrentFramebuf() {
-		if(currentImageFrame == 0) {
-			return getFramebufferPathForSavestateHook(currentSavestateHook);
-		} else {
-			return getFramebufferPath(viewingPlayerIndex, currentSavestateHook, viewingBranchIndex, currentImageFrame);
-		}
-	}
+	// The savestate hook screenshot on the first frame, returns false if there is no framebuffer
+	bool getCurrentFramebuffer(wxImage& image);
 
 	void setTethered(bool flag) {
 		tethered = flag;
@@ -250,6 +419,9 @@ public:
 
 	void createSavestateHere();
 	void runFrame(uint8_t forAutoFrame, uint8_t updateFramebuffer, uint8_t includeFramebuffer);
+	// Runs every frame up to and including this one without pausing on each, like that many frame advances
+	// Returns once the switch stops, with a progress dialog in the meantime
+	void runToFrame(FrameNum frame, uint32_t framebufferInterval);
 
 	// TODO cache this
 	std::shared_ptr<std::vector<std::shared_ptr<ControllerData>>> getInputsList() const;
@@ -262,8 +434,6 @@ public:
 
 	bool handleKeyboardInput(wxChar key);
 
-	void onCacheHint(wxListEvent& event);
-
 	void addNewSavestateHook(std::string dHash, wxBitmap* screenshot);
 	void setSavestateHook(SavestateBlockNum index);
 	void removeSavestateHook(SavestateBlockNum index);
@@ -275,6 +445,8 @@ public:
 	void sendPlayerNum();
 
 	void addNewBranch();
+	// New branch starting with the same frames as the viewed one, nothing is copied until edited
+	void forkBranch();
 	void setBranch(uint16_t branchIndex);
 	void removeBranch(uint8_t branchIndex);
 	void removeThisBranch();
@@ -299,6 +471,14 @@ public:
 
 	// This includes joysticks, accel, gyro, etc...
 	void triggerNumberValues(ControllerNumberValues joystickId, int16_t value);
+
+	// Bulk edits over the selected frames, one pass and one refresh each
+	void setButtonRange(const FrameSelection& frames, Btn button, uint8_t isPressed);
+	void toggleButtonRange(const FrameSelection& frames, Btn button);
+	void clearButtonsRange(const FrameSelection& frames);
+	void fillNumberValuesRange(const FrameSelection& frames, ControllerNumberValues joystickId, int16_t value);
+	// Moves the frames over by offset, the frames in the way move to where they were
+	void shiftFrames(FrameNum start, FrameNum end, int32_t offset);
 	void setNumberValues(FrameNum frame, ControllerNumberValues joystickId, int16_t value);
 	int16_t getNumberValues(FrameNum frame, ControllerNumberValues joystickId) const;
 	int16_t getNumberValuesSpecific(FrameNum frame, ControllerNumberValues joystickId, SavestateBlockNum savestateHookNum, BranchNum branch, uint8_t player) const;
@@ -315,12 +495,39 @@ public:
 	// Without the id, just return the whole hog
 	uint8_t getFramestateInfo(FrameNum frame) const;
 
+	// Every frame before this has been run
+	FrameNum getRunWatermark(uint8_t player, SavestateBlockNum savestateHookNum, BranchNum branch) const {
+		auto& watermarks = allPlayers[player]->at(savestateHookNum)->runWatermarks;
+		return branch < watermarks.size() ? watermarks[branch] : 0;
+	}
+
+	// Just moves the watermark back and cuts the framebuffer archive
 	void invalidateRun(FrameNum frame);
 	void invalidateRunSpecific(FrameNum frame, SavestateBlockNum savestateHookNum, BranchNum branch, uint8_t player);
 
 	void addFrame(FrameNum afterFrame);
+	// Blank frames for every player and branch, inserted at once
+	void addFrames(FrameNum start, FrameNum count);
 	void addFrameHere();
+	// Writes a parsed script starting at startLoc with one refresh, returns the last frame written
+	FrameNum pasteFrames(const std::vector<ScriptFrame>& frames, FrameNum startLoc, bool insertPaste, bool placePaste);
 	void removeFrames(FrameNum start, FrameNum end);
+	// Every interval is removed in one pass over each branch
+	void removeFrames(const FrameSelection& frames);
+
+	void undo();
+	void redo();
+
+	// Selects every frame of the viewed branch matching the query and goes to the first one after the current frame
+	bool findFrames(const std::string& queryText, std::string& error);
+	// Goes to the next frame matching the last query, wrapping around, returns false if nothing matches
+	bool jumpToNextMatch();
+
+	// Marks every frame of the viewed branch that differs from the other branch
+	void compareWithBranch(BranchNum branchIndex);
+	void stopComparing();
+	// Goes to the start of the next differing region, wrapping around, returns false if there isn't one
+	bool jumpToNextDifference();
 
 	std::size_t getFramesSize() const;
 
@@ -0,0 +1,398 @@
+#include "editHistory.hpp"
+
+template <typename T> static void writeValue(wxOutputStream& out, T value) {
+	out.Write(&value, sizeof(T));
+}
+
+template <typename T> static bool readValue(wxInputStream& in, T& value) {
+	in.Read(&value, sizeof(T));
+	return in.LastRead() == sizeof(T);
+}
+
+std::size_t HistoryCommand::getMemoryUsage() const {
+	std::size_t size = sizeof(HistoryCommand) + (oldValues.size() + newValues.size()) * sizeof(HistoryRun);
+	for(auto const& runs : removedFields) {
+		size += sizeof(runs) + runs.size() * sizeof(HistoryRun);
+	}
+	return size;
+}
+
+uint32_t EditHistory::getFieldValue(const ControllerData& data, uint8_t field) {
+	switch(field) {
+	case ControllerNumberValues::LEFT_X:
+		return (uint16_t)data.LS_X;
+	case ControllerNumberValues::LEFT_Y:
+		return (uint16_t)data.LS_Y;
+	case ControllerNumberValues::RIGHT_X:
+		return (uint16_t)data.RS_X;
+	case ControllerNumberValues::RIGHT_Y:
+		return (uint16_t)data.RS_Y;
+	case ControllerNumberValues::ACCEL_X:
+		return (uint16_t)data.ACCEL_X;
+	case ControllerNumberValues::ACCEL_Y:
+		return (uint16_t)data.ACCEL_Y;
+	case ControllerNumberValues::ACCEL_Z:
+		return (uint16_t)data.ACCEL_Z;
+	case ControllerNumberValues::GYRO_1:
+		return (uint16_t)data.GYRO_1;
+	case ControllerNumberValues::GYRO_2:
+		return (uint16_t)data.GYRO_2;
+	case ControllerNumberValues::GYRO_3:
+		return (uint16_t)data.GYRO_3;
+	default:
+		return data.buttons;
+	}
+}
+
+void EditHistory::setFieldValue(ControllerData& data, uint8_t field, uint32_t mask, uint32_t value) {
+	switch(field) {
+	case ControllerNumberValues::LEFT_X:
+		data.LS_X = (int16_t)value;
+		break;
+	case ControllerNumberValues::LEFT_Y:
+		data.LS_Y = (int16_t)value;
+		break;
+	case ControllerNumberValues::RIGHT_X:
+		data.RS_X = (int16_t)value;
+		break;
+	case ControllerNumberValues::RIGHT_Y:
+		data.RS_Y = (int16_t)value;
+		break;
+	case ControllerNumberValues::ACCEL_X:
+		data.ACCEL_X = (int16_t)value;
+		break;
+	case ControllerNumberValues::ACCEL_Y:
+		data.ACCEL_Y = (int16_t)value;
+		break;
+	case ControllerNumberValues::ACCEL_Z:
+		data.ACCEL_Z = (int16_t)value;
+		break;
+	case ControllerNumberValues::GYRO_1:
+		data.GYRO_1 = (int16_t)value;
+		break;
+	case ControllerNumberValues::GYRO_2:
+		data.GYRO_2 = (int16_t)value;
+		break;
+	case ControllerNumberValues::GYRO_3:
+		data.GYRO_3 = (int16_t)value;
+		break;
+	default:
+		// Only the recorded bits, so edits to other buttons are kept
+		data.buttons = (data.buttons & ~mask) | (value & mask);
+		break;
+	}
+}
+
+void EditHistory::captureField(const std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum start, FrameNum count, uint8_t field, uint32_t mask, std::vector<HistoryRun>& runs) {
+	runs.clear();
+	for(FrameNum i = start; i < start + count && i < frames.size(); i++) {
+		uint32_t value = getFieldValue(*frames[i], field);
+		if(field == HISTORY_FIELD_BUTTONS) {
+			value &= mask;
+		}
+
+		if(!runs.empty() && runs.back().value == value) {
+			runs.back().count++;
+		} else {
+			runs.push_back({ value, 1 });
+		}
+	}
+	runs.shrink_to_fit();
+}
+
+void EditHistory::applyField(std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum start, uint8_t field, uint32_t mask, const std::vector<HistoryRun>& runs) {
+	FrameNum frame = start;
+	for(auto const& run : runs) {
+		for(FrameNum i = 0; i < run.count && frame < frames.size(); i++) {
+			setFieldValue(getWritableFrame(frames, frame), field, mask, run.value);
+			frame++;
+		}
+	}
+}
+
+void EditHistory::appendRuns(std::vector<HistoryRun>& runs, const std::vector<HistoryRun>& next) {
+	auto start = next.begin();
+	// The two runs at the seam are usually the same value
+	if(!runs.empty() && start != next.end() && runs.back().value == start->value) {
+		runs.back().count += start->count;
+		start++;
+	}
+	runs.insert(runs.end(), start, next.end());
+}
+
+std::size_t EditHistory::getEntryMemoryUsage(const HistoryEntry& entry) {
+	std::size_t size = sizeof(HistoryEntry);
+	for(auto const& command : entry) {
+		size += command.getMemoryUsage();
+	}
+	return size;
+}
+
+void EditHistory::beginGroup() {
+	groupDepth++;
+}
+
+void EditHistory::endGroup() {
+	if(groupDepth == 0) {
+		return;
+	}
+
+	groupDepth--;
+	if(groupDepth == 0 && !openEntry.empty()) {
+		pushEntry(std::move(openEntry));
+		openEntry.clear();
+	}
+}
+
+void EditHistory::beginDrag() {
+	if(!dragging) {
+		dragging = true;
+		beginGroup();
+	}
+}
+
+void EditHistory::endDrag() {
+	if(dragging) {
+		dragging = false;
+		endGroup();
+	}
+}
+
+void EditHistory::record(HistoryCommand command) {
+	if(command.type == HISTORY_SET_FIELD) {
+		bool changed = command.oldValues.size() != command.newValues.size();
+		for(std::size_t i = 0; !changed && i < command.oldValues.size(); i++) {
+			changed = command.oldValues[i].value != command.newValues[i].value || command.oldValues[i].count != command.newValues[i].count;
+		}
+		if(!changed) {
+			return;
+		}
+	}
+
+	numOfRecordedEdits++;
+	if(numOfRecordedEdits % EDIT_HISTORY_LOG_INTERVAL == 0) {
+		wxLogDebug("Edit history: %llu edits recorded, %zu kept in %zu bytes, %.1f bytes per edit", (unsigned long long)numOfRecordedEdits, numOfCommands, memoryUsage, numOfCommands == 0 ? 0.0 : (double)memoryUsage / numOfCommands);
+	}
+
+	if(dragging && command.type == HISTORY_SET_FIELD && command.field != HISTORY_FIELD_BUTTONS) {
+		// Dragging a joystick sets the same frames over and over, only where it started matters
+		// X and Y take turns, so the earlier command isn't always the last one
+		for(auto& earlier : openEntry) {
+			if(earlier.type == HISTORY_SET_FIELD && earlier.player == command.player && earlier.savestateHook == command.savestateHook && earlier.branch == command.branch && earlier.field == command.field && earlier.mask == command.mask && earlier.start == command.start && earlier.count == command.count) {
+				earlier.newValues = std::move(command.newValues);
+				return;
+			}
+		}
+	}
+
+	if(groupDepth == 0) {
+		HistoryEntry entry;
+		entry.push_back(std::move(command));
+		pushEntry(std::move(entry));
+		return;
+	}
+
+	// Neighbouring ranges of the same field, like the intervals of one bulk edit, become one command
+	if(!openEntry.empty()) {
+		HistoryCommand& last = openEntry.back();
+		if(command.type == HISTORY_SET_FIELD && last.type == HISTORY_SET_FIELD && last.player == command.player && last.savestateHook == command.savestateHook && last.branch == command.branch && last.field == command.field && last.mask == command.mask && last.start + last.count == command.start) {
+			last.count += command.count;
+			appendRuns(last.oldValues, command.oldValues);
+			appendRuns(last.newValues, command.newValues);
+			return;
+		}
+	}
+
+	openEntry.push_back(std::move(command));
+}
+
+void EditHistory::pushEntry(HistoryEntry entry) {
+	// A new edit means the redone entries no longer make sense
+	for(auto const& redoEntry : redoEntries) {
+		memoryUsage -= getEntryMemoryUsage(redoEntry);
+		numOfCommands -= redoEntry.size();
+	}
+	redoEntries.clear();
+
+	memoryUsage += getEntryMemoryUsage(entry);
+	numOfCommands += entry.size();
+	undoEntries.push_back(std::move(entry));
+
+	trim();
+}
+
+void EditHistory::trim() {
+	// Always keep the last entry, even if it's huge
+	while(memoryUsage > EDIT_HISTORY_MAX_BYTES && undoEntries.size() > 1) {
+		memoryUsage -= getEntryMemoryUsage(undoEntries.front());
+		numOfCommands -= undoEntries.front().size();
+		undoEntries.pop_front();
+	}
+}
+
+HistoryEntry EditHistory::popUndo() {
+	HistoryEntry entry = undoEntries.back();
+	undoEntries.pop_back();
+	redoEntries.push_back(entry);
+	return entry;
+}
+
+HistoryEntry EditHistory::popRedo() {
+	HistoryEntry entry = redoEntries.back();
+	redoEntries.pop_back();
+	undoEntries.push_back(entry);
+	return entry;
+}
+
+void EditHistory::clear() {
+	undoEntries.clear();
+	redoEntries.clear();
+	openEntry.clear();
+	groupDepth    = 0;
+	dragging      = false;
+	memoryUsage   = 0;
+	numOfCommands = 0;
+}
+
+void EditHistory::writeRuns(wxOutputStream& out, const std::vector<HistoryRun>& runs) {
+	writeValue<uint32_t>(out, runs.size());
+	for(auto const& run : runs) {
+		writeValue<uint32_t>(out, run.value);
+		writeValue<uint32_t>(out, run.count);
+	}
+}
+
+bool EditHistory::readRuns(wxInputStream& in, std::vector<HistoryRun>& runs) {
+	uint32_t size;
+	if(!readValue(in, size)) {
+		return false;
+	}
+
+	// No reserve, a broken size shouldn't allocate gigabytes
+	runs.clear();
+	for(uint32_t i = 0; i < size; i++) {
+		HistoryRun run;
+		if(!readValue(in, run.value) || !readValue(in, run.count)) {
+			return false;
+		}
+		runs.push_back(run);
+	}
+	return true;
+}
+
+void EditHistory::writeEntry(wxOutputStream& out, const HistoryEntry& entry) {
+	writeValue<uint32_t>(out, entry.size());
+	for(auto const& command : entry) {
+		writeValue<uint8_t>(out, command.type);
+		writeValue<uint8_t>(out, command.player);
+		writeValue<uint16_t>(out, command.savestateHook);
+		writeValue<uint16_t>(out, command.branch);
+		writeValue<uint32_t>(out, command.start);
+		writeValue<uint32_t>(out, command.count);
+		writeValue<uint8_t>(out, command.field);
+		writeValue<uint32_t>(out, command.mask);
+		writeValue<int32_t>(out, command.offset);
+		writeRuns(out, command.oldValues);
+		writeRuns(out, command.newValues);
+
+		writeValue<uint32_t>(out, command.removedFields.size());
+		for(auto const& runs : command.removedFields) {
+			writeRuns(out, runs);
+		}
+	}
+}
+
+bool EditHistory::readEntry(wxInputStream& in, HistoryEntry& entry) {
+	uint32_t size;
+	if(!readValue(in, size)) {
+		return false;
+	}
+
+	entry.clear();
+	for(uint32_t i = 0; i < size; i++) {
+		HistoryCommand command;
+		uint8_t type;
+		uint32_t numOfRemovedFields;
+		// clang-format off
+		if(!readValue(in, type) || type > HISTORY_SHIFT_FRAMES
+			|| !readValue(in, command.player) || !readValue(in, command.savestateHook) || !readValue(in, command.branch)
+			|| !readValue(in, command.start) || !readValue(in, command.count) || !readValue(in, command.field)
+			|| !readValue(in, command.mask) || !readValue(in, command.offset)
+			|| !readRuns(in, command.oldValues) || !readRuns(in, command.newValues)
+			|| !readValue(in, numOfRemovedFields)) {
+			return false;
+		}
+		// clang-format on
+		command.type = (HistoryCommandType)type;
+
+		for(uint32_t j = 0; j < numOfRemovedFields; j++) {
+			std::vector<HistoryRun> runs;
+			if(!readRuns(in, runs)) {
+				return false;
+			}
+			command.removedFields.push_back(std::move(runs));
+		}
+
+		entry.push_back(command);
+	}
+	return true;
+}
+
+void EditHistory::save(wxOutputStream& out) const {
+	out.Write(EDIT_HISTORY_MAGIC, 4);
+	writeValue<uint8_t>(out, EDIT_HISTORY_VERSION);
+
+	writeValue<uint32_t>(out, undoEntries.size());
+	for(auto const& entry : undoEntries) {
+		writeEntry(out, entry);
+	}
+
+	writeValue<uint32_t>(out, redoEntries.size());
+	for(auto const& entry : redoEntries) {
+		writeEntry(out, entry);
+	}
+}
+
+bool EditHistory::load(wxInputStream& in) {
+	clear();
+
+	char magic[4];
+	uint8_t version;
+	uint32_t size;
+	in.Read(magic, sizeof(magic));
+	if(in.LastRead() != sizeof(magic) || memcmp(magic, EDIT_HISTORY_MAGIC, 4) != 0 || !readValue(in, version) || version != EDIT_HISTORY_VERSION) {
+		return false;
+	}
+
+	if(!readValue(in, size)) {
+		return false;
+	}
+	for(uint32_t i = 0; i < size; i++) {
+		HistoryEntry entry;
+		if(!readEntry(in, entry)) {
+			clear();
+			return false;
+		}
+		memoryUsage += getEntryMemoryUsage(entry);
+		numOfCommands += entry.size();
+		undoEntries.push_back(std::move(entry));
+	}
+
+	if(!readValue(in, size)) {
+		clear();
+		return false;
+	}
+	for(uint32_t i = 0; i < size; i++) {
+		HistoryEntry entry;
+		if(!readEntry(in, entry)) {
+			clear();
+			return false;
+		}
+		memoryUsage += getEntryMemoryUsage(entry);
+		numOfCommands += entry.size();
+		redoEntries.push_back(std::move(entry));
+	}
+
+	trim();
+	return true;
+}
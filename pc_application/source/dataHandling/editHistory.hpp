@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <wx/log.h>
+#include <wx/stream.h>
+
+#include "../sharedNetworkCode/buttonData.hpp"
+#include "buttonConstants.hpp"
+
+// Oldest edits are forgotten once the history uses more than this
+#define EDIT_HISTORY_MAX_BYTES (32 * 1024 * 1024)
+// How many recorded edits between logs of the memory used
+#define EDIT_HISTORY_LOG_INTERVAL 100000
+#define EDIT_HISTORY_MAGIC "SHIS"
+#define EDIT_HISTORY_VERSION 1
+
+// Fields are ControllerNumberValues, with the buttons after them
+#define HISTORY_FIELD_BUTTONS 10
+#define HISTORY_NUM_FIELDS 11
+
+// A run of frames that all had the same value for a field
+struct HistoryRun {
+	uint32_t value;
+	FrameNum count;
+};
+
+enum HistoryCommandType : uint8_t {
+	// One field over a range of frames in one branch
+	HISTORY_SET_FIELD,
+	// Blank frames added to every branch of every player
+	HISTORY_INSERT_FRAMES,
+	// Frames taken out of every branch of every player
+	HISTORY_REMOVE_FRAMES,
+	// Frames in one branch moved over by offset
+	HISTORY_SHIFT_FRAMES,
+};
+
+// Deltas instead of snapshots, values are run length encoded because most edits set the same value over many frames
+struct HistoryCommand {
+	HistoryCommandType type         = HISTORY_SET_FIELD;
+	uint8_t player                  = 0;
+	SavestateBlockNum savestateHook = 0;
+	BranchNum branch                = 0;
+	FrameNum start                  = 0;
+	FrameNum count                  = 0;
+
+	// Set field
+	uint8_t field = 0;
+	// Only these bits of the buttons are touched
+	uint32_t mask = UINT32_MAX;
+	std::vector<HistoryRun> oldValues;
+	std::vector<HistoryRun> newValues;
+
+	// Shift
+	int32_t offset = 0;
+
+	// Remove, every field of the removed frames, player by player and branch by branch
+	std::vector<std::vector<HistoryRun>> removedFields;
+
+	std::size_t getMemoryUsage() const;
+};
+
+typedef std::vector<HistoryCommand> HistoryEntry;
+
+// Undo and redo stacks for the inputs
+// Everything recorded between beginGroup and endGroup is undone in one go
+// A drag is a group where setting the same frames again only keeps the newest values
+class EditHistory {
+private:
+	std::deque<HistoryEntry> undoEntries;
+	std::vector<HistoryEntry> redoEntries;
+
+	HistoryEntry openEntry;
+	uint16_t groupDepth = 0;
+	uint8_t dragging    = false;
+
+	std::size_t memoryUsage     = 0;
+	std::size_t numOfCommands   = 0;
+	uint64_t numOfRecordedEdits = 0;
+
+	static void appendRuns(std::vector<HistoryRun>& runs, const std::vector<HistoryRun>& next);
+	static std::size_t getEntryMemoryUsage(const HistoryEntry& entry);
+
+	void pushEntry(HistoryEntry entry);
+	// Forget the oldest entries until under the limit
+	void trim();
+
+	static void writeRuns(wxOutputStream& out, const std::vector<HistoryRun>& runs);
+	static bool readRuns(wxInputStream& in, std::vector<HistoryRun>& runs);
+	static void writeEntry(wxOutputStream& out, const HistoryEntry& entry);
+	static bool readEntry(wxInputStream& in, HistoryEntry& entry);
+
+public:
+	static uint32_t getFieldValue(const ControllerData& data, uint8_t field);
+	static void setFieldValue(ControllerData& data, uint8_t field, uint32_t mask, uint32_t value);
+
+	// Encodes one field of count frames starting at start
+	static void captureField(const std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum start, FrameNum count, uint8_t field, uint32_t mask, std::vector<HistoryRun>& runs);
+	// Writes the runs back starting at start
+	static void applyField(std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum start, uint8_t field, uint32_t mask, const std::vector<HistoryRun>& runs);
+
+	void beginGroup();
+	void endGroup();
+	// Mouse down and mouse up of a joystick drag
+	void beginDrag();
+	void endDrag();
+	// Set field commands that didn't change anything are dropped
+	void record(HistoryCommand command);
+
+	bool canUndo() const {
+		return !undoEntries.empty();
+	}
+	bool canRedo() const {
+		return !redoEntries.empty();
+	}
+
+	// The entry moves to the other stack, the caller applies it
+	HistoryEntry popUndo();
+	HistoryEntry popRedo();
+
+	void clear();
+
+	std::size_t getMemoryUsage() const {
+		return memoryUsage;
+	}
+
+	void save(wxOutputStream& out) const;
+	// Clears the history if the file is broken
+	bool load(wxInputStream& in);
+};
@@ -0,0 +1,82 @@
+#include "frameSelection.hpp"
+
+void FrameSelection::add(FrameNum start, FrameNum end) {
+	if(start > end) {
+		std::swap(start, end);
+	}
+
+	// Everything overlapping or touching gets merged into one
+	auto first = std::lower_bound(intervals.begin(), intervals.end(), start, [](const FrameInterval& interval, FrameNum f) { return (uint64_t)interval.end + 1 < f; });
+	auto last  = first;
+	while(last != intervals.end() && last->start <= (uint64_t)end + 1) {
+		start = std::min(start, last->start);
+		end   = std::max(end, last->end);
+		last++;
+	}
+
+	first = intervals.erase(first, last);
+	intervals.insert(first, { start, end });
+}
+
+void FrameSelection::remove(FrameNum start, FrameNum end) {
+	if(start > end) {
+		std::swap(start, end);
+	}
+
+	auto first = std::lower_bound(intervals.begin(), intervals.end(), start, [](const FrameInterval& interval, FrameNum f) { return interval.end < f; });
+	auto last  = first;
+	while(last != intervals.end() && last->start <= end) {
+		last++;
+	}
+
+	if(first == last) {
+		return;
+	}
+
+	// Only the ends can stick out of the removed range
+	std::vector<FrameInterval> leftovers;
+	if(first->start < start) {
+		leftovers.push_back({ first->start, start - 1 });
+	}
+	if((last - 1)->end > end) {
+		leftovers.push_back({ end + 1, (last - 1)->end });
+	}
+
+	first = intervals.erase(first, last);
+	intervals.insert(first, leftovers.begin(), leftovers.end());
+}
+
+void FrameSelection::toggle(FrameNum start, FrameNum end) {
+	if(start > end) {
+		std::swap(start, end);
+	}
+
+	// Gaps in the range become selected, the selected parts don't
+	FrameSelection gaps(start, end);
+	auto interval = findInterval(start);
+	while(interval != intervals.end() && interval->start <= end) {
+		gaps.remove(interval->start, interval->end);
+		interval++;
+	}
+
+	remove(start, end);
+	for(auto const& gap : gaps.intervals) {
+		add(gap.start, gap.end);
+	}
+}
+
+void FrameSelection::clamp(FrameNum numOfFrames) {
+	if(numOfFrames == 0) {
+		intervals.clear();
+	} else if(!intervals.empty() && last() >= numOfFrames) {
+		remove(numOfFrames, last());
+	}
+}
+
+uint64_t FrameSelection::size() const {
+	uint64_t total = 0;
+	for(auto const& interval : intervals) {
+		total += (uint64_t)interval.end - interval.start + 1;
+	}
+	return total;
+}
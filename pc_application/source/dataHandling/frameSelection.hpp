@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "buttonConstants.hpp"
+
+// Both ends are included
+struct FrameInterval {
+	FrameNum start;
+	FrameNum end;
+};
+
+// Selected frames as sorted intervals, so selecting a million frames is one entry
+// Intervals never overlap or touch, they are merged as they are added
+class FrameSelection {
+private:
+	std::vector<FrameInterval> intervals;
+
+	// First interval that ends at or after frame
+	std::vector<FrameInterval>::const_iterator findInterval(FrameNum frame) const {
+		return std::lower_bound(intervals.begin(), intervals.end(), frame, [](const FrameInterval& interval, FrameNum f) { return interval.end < f; });
+	}
+
+public:
+	FrameSelection() {}
+	FrameSelection(FrameNum start, FrameNum end) {
+		add(start, end);
+	}
+
+	void clear() {
+		intervals.clear();
+	}
+
+	bool empty() const {
+		return intervals.empty();
+	}
+
+	void add(FrameNum start, FrameNum end);
+	void remove(FrameNum start, FrameNum end);
+	// Selected frames are removed, the rest are added
+	void toggle(FrameNum start, FrameNum end);
+	// Drops anything at or past numOfFrames
+	void clamp(FrameNum numOfFrames);
+
+	bool contains(FrameNum frame) const {
+		auto interval = findInterval(frame);
+		return interval != intervals.end() && interval->start <= frame;
+	}
+
+	// Only valid when not empty
+	FrameNum first() const {
+		return intervals.front().start;
+	}
+	FrameNum last() const {
+		return intervals.back().end;
+	}
+
+	// Number of selected frames, not intervals
+	uint64_t size() const;
+
+	const std::vector<FrameInterval>& getIntervals() const {
+		return intervals;
+	}
+};
@@ -0,0 +1,548 @@
+#include "framebufferArchive.hpp"
+
+static const char FRAMEBUFFER_ARCHIVE_MAGIC[8] = { 'S', 'W', 'F', 'B', 'A', 'R', 'C', '2' };
+
+// Frames reserved when an archive is created, both double when they fill up
+static const uint64_t INITIAL_NUM_ENTRIES = 4096;
+static const uint64_t INITIAL_BLOB_SIZE   = 4 * 1024 * 1024;
+
+static const uint64_t XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotateLeft(uint64_t value, int bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t read64(const uint8_t* data) {
+	// Little endian, like the rest of the project files
+	uint64_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static inline uint32_t read32(const uint8_t* data) {
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static inline uint64_t xxhRound(uint64_t acc, uint64_t input) {
+	acc += input * XXH_PRIME64_2;
+	acc = rotateLeft(acc, 31);
+	return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t xxhMergeRound(uint64_t acc, uint64_t value) {
+	acc ^= xxhRound(0, value);
+	return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static double getMegabytesPerSecond(uint64_t bytes, std::chrono::steady_clock::duration time) {
+	double seconds = std::chrono::duration<double>(time).count();
+	return seconds == 0 ? 0 : bytes / (1024.0 * 1024.0) / seconds;
+}
+
+FramebufferArchive::FramebufferArchive(wxFileName folder) {
+	folder.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+
+	indexFile = folder;
+	indexFile.SetFullName("framebuffers.index");
+	blobFile = folder;
+	blobFile.SetFullName("framebuffers.blob");
+
+	bool isNew = !indexFile.FileExists() || !blobFile.FileExists();
+
+	if(!isNew) {
+		indexCapacity = indexFile.GetSize().GetValue();
+		blobCapacity  = blobFile.GetSize().GetValue();
+	}
+
+	if(!mapFile(indexMap, indexFile, indexCapacity, std::max(indexCapacity, (uint64_t)(sizeof(FramebufferArchiveHeader) + sizeof(FramebufferArchiveEntry) * INITIAL_NUM_ENTRIES))) || !mapFile(blobMap, blobFile, blobCapacity, std::max(blobCapacity, INITIAL_BLOB_SIZE))) {
+		// Framebuffers just aren't stored for this branch
+		close();
+		return;
+	}
+	mapped = true;
+
+	FramebufferArchiveHeader* header = getHeader();
+	if(isNew || memcmp(header->magic, FRAMEBUFFER_ARCHIVE_MAGIC, sizeof(FRAMEBUFFER_ARCHIVE_MAGIC)) != 0 || header->blobSize > blobCapacity) {
+		// New archive or a broken one, start over
+		memset(header, 0, sizeof(FramebufferArchiveHeader));
+		memcpy(header->magic, FRAMEBUFFER_ARCHIVE_MAGIC, sizeof(FRAMEBUFFER_ARCHIVE_MAGIC));
+		importLooseFiles(folder);
+	} else {
+		rebuildStoredBlobs();
+	}
+}
+
+FramebufferArchive::~FramebufferArchive() {
+	close();
+}
+
+bool FramebufferArchive::mapFile(mio::mmap_sink& map, wxFileName& file, uint64_t& capacity, uint64_t newCapacity) {
+	if(map.is_mapped()) {
+		map.sync(errorCode);
+		map.unmap();
+	}
+
+	if(newCapacity > capacity || !file.FileExists()) {
+		wxFile theFile;
+		if(file.FileExists()) {
+			theFile.Open(file.GetFullPath(), wxFile::read_write);
+		} else {
+			// Allow reading and writing by all users
+			theFile.Create(file.GetFullPath(), true, wxS_DEFAULT);
+		}
+		// Sparse file, same as the memory trace
+		theFile.Seek(newCapacity - 1);
+		theFile.Write("", 1);
+		theFile.Close();
+
+		capacity = newCapacity;
+	}
+
+	map = mio::make_mmap_sink(file.GetFullPath().ToStdString(), 0, mio::map_entire_file, errorCode);
+	if(errorCode) {
+		wxLogMessage("Framebuffer archive %s could not be mapped: %s", file.GetFullPath(), errorCode.message());
+		mapped = false;
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t FramebufferArchive::hashFramebuffer(const uint8_t* data, std::size_t size) {
+	const uint8_t* end = data + size;
+	uint64_t hash;
+
+	if(size >= 32) {
+		uint64_t v1 = XXH_PRIME64_1 + XXH_PRIME64_2;
+		uint64_t v2 = XXH_PRIME64_2;
+		uint64_t v3 = 0;
+		uint64_t v4 = 0 - XXH_PRIME64_1;
+
+		const uint8_t* limit = end - 32;
+		do {
+			v1 = xxhRound(v1, read64(data));
+			v2 = xxhRound(v2, read64(data + 8));
+			v3 = xxhRound(v3, read64(data + 16));
+			v4 = xxhRound(v4, read64(data + 24));
+			data += 32;
+		} while(data <= limit);
+
+		hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+		hash = xxhMergeRound(hash, v1);
+		hash = xxhMergeRound(hash, v2);
+		hash = xxhMergeRound(hash, v3);
+		hash = xxhMergeRound(hash, v4);
+	} else {
+		hash = XXH_PRIME64_5;
+	}
+
+	hash += size;
+
+	while(data + 8 <= end) {
+		hash ^= xxhRound(0, read64(data));
+		hash = rotateLeft(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+		data += 8;
+	}
+
+	if(data + 4 <= end) {
+		hash ^= (uint64_t)read32(data) * XXH_PRIME64_1;
+		hash = rotateLeft(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		data += 4;
+	}
+
+	while(data < end) {
+		hash ^= (*data) * XXH_PRIME64_5;
+		hash = rotateLeft(hash, 11) * XXH_PRIME64_1;
+		data++;
+	}
+
+	hash ^= hash >> 33;
+	hash *= XXH_PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= XXH_PRIME64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+void FramebufferArchive::rebuildStoredBlobs() {
+	storedBlobs.clear();
+
+	const FramebufferArchiveHeader* header = getHeader();
+	const FramebufferArchiveEntry* entries = getEntries();
+	for(uint64_t frame = 0; frame < header->numEntries; frame++) {
+		if(entries[frame].size != 0) {
+			storedBlobs[entries[frame].hash] = { entries[frame].offset, entries[frame].size };
+		}
+	}
+}
+
+bool FramebufferArchive::isEntryValid(FrameNum frame, const FramebufferArchiveEntry& entry) const {
+	if(entry.size == 0) {
+		return false;
+	}
+
+	const FramebufferArchiveHeader* header = getHeader();
+	for(uint32_t i = 0; i < header->numCuts; i++) {
+		const FramebufferArchiveCut& cut = header->cuts[i];
+		if(cut.generation >= entry.generation && frame >= cut.frame) {
+			return false;
+		}
+	}
+	return true;
+}
+
+uint64_t FramebufferArchive::getLiveBytes() const {
+	const FramebufferArchiveHeader* header = getHeader();
+	const FramebufferArchiveEntry* entries = getEntries();
+
+	std::unordered_set<uint64_t> countedOffsets;
+	uint64_t liveBytes = 0;
+	for(uint64_t frame = 0; frame < header->numEntries; frame++) {
+		if(isEntryValid(frame, entries[frame]) && countedOffsets.insert(entries[frame].offset).second) {
+			liveBytes += entries[frame].size;
+		}
+	}
+	return liveBytes;
+}
+
+void FramebufferArchive::applyCuts() {
+	FramebufferArchiveHeader* header = getHeader();
+	FramebufferArchiveEntry* entries = getEntries();
+
+	for(uint64_t frame = 0; frame < header->numEntries; frame++) {
+		FramebufferArchiveEntry& entry = entries[frame];
+		if(entry.size != 0 && !isEntryValid(frame, entry)) {
+			entry.size = 0;
+		}
+		entry.generation = 0;
+	}
+
+	header->numCuts    = 0;
+	header->generation = 0;
+}
+
+void FramebufferArchive::importLooseFiles(wxFileName folder) {
+	wxDir dir(folder.GetPath());
+	if(!dir.IsOpened()) {
+		return;
+	}
+
+	auto start         = std::chrono::steady_clock::now();
+	FrameNum numFrames = 0;
+	uint64_t numBytes  = 0;
+
+	std::vector<wxString> imported;
+	std::vector<uint8_t> buf;
+	wxString filename;
+	bool cont = dir.GetFirst(&filename, "frame_*_screenshot.jpg", wxDIR_FILES);
+	while(cont) {
+		unsigned long frame;
+		if(filename.AfterFirst('_').BeforeFirst('_').ToULong(&frame)) {
+			wxString path = folder.GetPathWithSep() + filename;
+			wxFile file(path, wxFile::read);
+			if(file.IsOpened()) {
+				buf.resize(file.Length());
+				if(file.Read(buf.data(), buf.size()) == (ssize_t)buf.size()) {
+					addFramebuffer(frame, buf.data(), buf.size());
+					imported.push_back(path);
+					numFrames++;
+					numBytes += buf.size();
+				}
+			}
+		}
+		cont = dir.GetNext(&filename);
+	}
+
+	// Only removed once they are all in the archive
+	sync();
+	for(auto const& path : imported) {
+		wxRemoveFile(path);
+	}
+
+	if(numFrames != 0) {
+		wxLogDebug("Imported %u loose framebuffers into %s at %.1f MB/s", numFrames, blobFile.GetFullPath(), getMegabytesPerSecond(numBytes, std::chrono::steady_clock::now() - start));
+	}
+}
+
+void FramebufferArchive::addFramebuffer(FrameNum frame, const uint8_t* data, uint32_t size) {
+	if(!mapped || size == 0) {
+		return;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	if(sizeof(FramebufferArchiveHeader) + sizeof(FramebufferArchiveEntry) * ((uint64_t)frame + 1) > indexCapacity) {
+		uint64_t numEntries = std::max<uint64_t>((indexCapacity - sizeof(FramebufferArchiveHeader)) / sizeof(FramebufferArchiveEntry) * 2, (uint64_t)frame + 1);
+		if(!mapFile(indexMap, indexFile, indexCapacity, sizeof(FramebufferArchiveHeader) + sizeof(FramebufferArchiveEntry) * numEntries)) {
+			close();
+			return;
+		}
+	}
+
+	uint64_t hash   = hashFramebuffer(data, size);
+	uint64_t offset = 0;
+	auto stored     = storedBlobs.find(hash);
+	if(stored != storedBlobs.end() && stored->second.size == size && memcmp(blobMap.data() + stored->second.offset, data, size) == 0) {
+		// Seen before, just point at it
+		offset = stored->second.offset;
+		numDeduplicated++;
+		bytesDeduplicated += size;
+	} else {
+		if(getHeader()->blobSize + size > blobCapacity) {
+			if(!mapFile(blobMap, blobFile, blobCapacity, std::max(blobCapacity * 2, getHeader()->blobSize + size))) {
+				close();
+				return;
+			}
+		}
+
+		// New JPEG, a previous one for this frame stays in the blob until compaction
+		offset = getHeader()->blobSize;
+		memcpy(blobMap.data() + offset, data, size);
+		getHeader()->blobSize += size;
+		storedBlobs[hash] = { offset, size };
+	}
+
+	FramebufferArchiveHeader* header = getHeader();
+	FramebufferArchiveEntry& entry   = getEntries()[frame];
+
+	if(frame >= header->numEntries) {
+		// Skipped frames have no framebuffer
+		memset(&getEntries()[header->numEntries], 0, sizeof(FramebufferArchiveEntry) * (frame - header->numEntries));
+		header->numEntries = (uint64_t)frame + 1;
+	}
+
+	entry.offset     = offset;
+	entry.hash       = hash;
+	entry.size       = size;
+	entry.generation = header->generation;
+
+	numIngested++;
+	bytesIngested += size;
+	ingestTime += std::chrono::steady_clock::now() - start;
+
+	if(numIngested % FRAMEBUFFER_ARCHIVE_LOG_INTERVAL == 0) {
+		wxLogDebug("Framebuffers ingested at %.1f MB/s, %llu of %llu were duplicates, saving %llu bytes", getMegabytesPerSecond(bytesIngested, ingestTime), (unsigned long long)numDeduplicated, (unsigned long long)numIngested, (unsigned long long)bytesDeduplicated);
+	}
+}
+
+bool FramebufferArchive::getFramebuffer(FrameNum frame, const uint8_t** data, uint32_t* size) const {
+	if(!mapped || frame >= getHeader()->numEntries) {
+		return false;
+	}
+
+	const FramebufferArchiveEntry& entry = getEntries()[frame];
+	if(!isEntryValid(frame, entry)) {
+		return false;
+	}
+
+	*data = (const uint8_t*)blobMap.data() + entry.offset;
+	*size = entry.size;
+	return true;
+}
+
+bool FramebufferArchive::hasFramebuffer(FrameNum frame) const {
+	return mapped && frame < getHeader()->numEntries && isEntryValid(frame, getEntries()[frame]);
+}
+
+void FramebufferArchive::invalidateFrom(FrameNum frame) {
+	if(!mapped || frame >= getHeader()->numEntries) {
+		return;
+	}
+
+	if(getHeader()->numCuts == FRAMEBUFFER_ARCHIVE_MAX_CUTS) {
+		applyCuts();
+	}
+
+	FramebufferArchiveHeader* header         = getHeader();
+	header->cuts[header->numCuts].generation = header->generation;
+	header->cuts[header->numCuts].frame      = frame;
+	header->numCuts++;
+	header->generation++;
+}
+
+bool FramebufferArchive::compactIfNeeded() {
+	if(!mapped) {
+		return false;
+	}
+
+	applyCuts();
+
+	uint64_t liveBytes = getLiveBytes();
+	uint64_t deadBytes = getHeader()->blobSize - liveBytes;
+	if(deadBytes >= FRAMEBUFFER_ARCHIVE_COMPACT_BYTES && deadBytes > liveBytes) {
+		compact();
+		return true;
+	}
+	return false;
+}
+
+void FramebufferArchive::compact() {
+	if(!mapped) {
+		return;
+	}
+
+	applyCuts();
+
+	auto start = std::chrono::steady_clock::now();
+
+	FramebufferArchiveHeader* header = getHeader();
+	FramebufferArchiveEntry* entries = getEntries();
+	uint64_t oldSize                 = header->blobSize;
+
+	// Live framebuffers are written out in frame order to a new file, then it replaces the blob
+	// Shared ones are still only written once
+	wxFileName compactFile = blobFile;
+	compactFile.SetExt("compact");
+	wxFile file;
+	if(!file.Create(compactFile.GetFullPath(), true, wxS_DEFAULT)) {
+		return;
+	}
+
+	std::unordered_map<uint64_t, uint64_t> movedOffsets;
+	std::vector<uint64_t> newOffsets(header->numEntries);
+	uint64_t newSize = 0;
+	for(uint64_t frame = 0; frame < header->numEntries; frame++) {
+		if(entries[frame].size != 0) {
+			auto moved = movedOffsets.find(entries[frame].offset);
+			if(moved != movedOffsets.end()) {
+				newOffsets[frame] = moved->second;
+				continue;
+			}
+
+			if(file.Write(blobMap.data() + entries[frame].offset, entries[frame].size) != entries[frame].size) {
+				file.Close();
+				wxRemoveFile(compactFile.GetFullPath());
+				return;
+			}
+			movedOffsets[entries[frame].offset] = newSize;
+			newOffsets[frame]                   = newSize;
+			newSize += entries[frame].size;
+		}
+	}
+	if(newSize == 0) {
+		// Can't map an empty file
+		file.Write("", 1);
+	}
+	file.Close();
+
+	blobMap.unmap();
+	if(!wxRenameFile(compactFile.GetFullPath(), blobFile.GetFullPath(), true)) {
+		wxRemoveFile(compactFile.GetFullPath());
+		blobMap = mio::make_mmap_sink(blobFile.GetFullPath().ToStdString(), 0, mio::map_entire_file, errorCode);
+		if(errorCode) {
+			wxLogMessage("Framebuffer archive %s could not be mapped: %s", blobFile.GetFullPath(), errorCode.message());
+			close();
+		}
+		return;
+	}
+
+	for(uint64_t frame = 0; frame < header->numEntries; frame++) {
+		entries[frame].offset = newOffsets[frame];
+	}
+	header->blobSize = newSize;
+
+	blobCapacity = blobFile.GetSize().GetValue();
+	blobMap      = mio::make_mmap_sink(blobFile.GetFullPath().ToStdString(), 0, mio::map_entire_file, errorCode);
+	if(errorCode) {
+		wxLogMessage("Framebuffer archive %s could not be mapped: %s", blobFile.GetFullPath(), errorCode.message());
+		close();
+		return;
+	}
+	indexMap.sync(errorCode);
+	rebuildStoredBlobs();
+
+	wxLogDebug("Compacted %s from %llu to %llu bytes in %lld ms", blobFile.GetFullPath(), (unsigned long long)oldSize, (unsigned long long)newSize, (long long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+FrameNum FramebufferArchive::exportToFolder(wxFileName folder) {
+	folder.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+
+	std::chrono::steady_clock::duration writeTime       = std::chrono::steady_clock::duration::zero();
+	std::chrono::steady_clock::duration looseReadTime   = std::chrono::steady_clock::duration::zero();
+	std::chrono::steady_clock::duration archiveReadTime = std::chrono::steady_clock::duration::zero();
+	FrameNum numFrames                                  = 0;
+	uint64_t numBytes                                   = 0;
+
+	std::vector<uint8_t> buf;
+	for(uint64_t frame = 0; mapped && frame < getHeader()->numEntries; frame++) {
+		const uint8_t* data;
+		uint32_t size;
+
+		auto start = std::chrono::steady_clock::now();
+		if(!getFramebuffer(frame, &data, &size)) {
+			continue;
+		}
+		buf.assign(data, data + size);
+		archiveReadTime += std::chrono::steady_clock::now() - start;
+
+		wxString path = folder.GetPathWithSep() + getLooseFramebufferName(frame);
+
+		start = std::chrono::steady_clock::now();
+		wxFile file(path, wxFile::write);
+		if(!file.IsOpened() || file.Write(buf.data(), buf.size()) != buf.size()) {
+			continue;
+		}
+		file.Close();
+		writeTime += std::chrono::steady_clock::now() - start;
+
+		// Read back to compare against the old layout
+		start = std::chrono::steady_clock::now();
+		wxFile readFile(path, wxFile::read);
+		readFile.Read(buf.data(), buf.size());
+		readFile.Close();
+		looseReadTime += std::chrono::steady_clock::now() - start;
+
+		numFrames++;
+		numBytes += size;
+	}
+
+	wxLogDebug("Exported %u framebuffers, %llu bytes. Archive read %.1f MB/s, loose write %.1f MB/s, loose read %.1f MB/s", numFrames, (unsigned long long)numBytes, getMegabytesPerSecond(numBytes, archiveReadTime), getMegabytesPerSecond(numBytes, writeTime), getMegabytesPerSecond(numBytes, looseReadTime));
+
+	return numFrames;
+}
+
+void FramebufferArchive::logUsage() const {
+	if(!mapped) {
+		return;
+	}
+
+	const FramebufferArchiveHeader* header = getHeader();
+	const FramebufferArchiveEntry* entries = getEntries();
+
+	uint64_t numFramebuffers  = 0;
+	uint64_t framebufferBytes = 0;
+	for(uint64_t frame = 0; frame < header->numEntries; frame++) {
+		if(isEntryValid(frame, entries[frame])) {
+			numFramebuffers++;
+			framebufferBytes += entries[frame].size;
+		}
+	}
+
+	wxLogDebug("%s: %llu framebuffers, %llu bytes stored for %llu bytes of JPEGs, %llu unique bytes live", blobFile.GetFullPath(), (unsigned long long)numFramebuffers, (unsigned long long)header->blobSize, (unsigned long long)framebufferBytes, (unsigned long long)getLiveBytes());
+}
+
+void FramebufferArchive::close() {
+	mapped = false;
+	if(indexMap.is_mapped()) {
+		indexMap.sync(errorCode);
+		indexMap.unmap();
+	}
+	if(blobMap.is_mapped()) {
+		blobMap.sync(errorCode);
+		blobMap.unmap();
+	}
+}
+
+void FramebufferArchive::sync() {
+	if(!mapped) {
+		return;
+	}
+	indexMap.sync(errorCode);
+	blobMap.sync(errorCode);
+}
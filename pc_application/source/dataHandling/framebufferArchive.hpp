@@ -0,0 +1,158 @@
+#pragma once
+
+#define wxHAS_HUGE_FILES
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mio.hpp>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <wx/dir.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/string.h>
+
+#include "buttonConstants.hpp"
+
+// Cuts kept before they are applied to the index
+#define FRAMEBUFFER_ARCHIVE_MAX_CUTS 64
+// Compacted when at least this much of the blob is dead and it's more than half of it
+#define FRAMEBUFFER_ARCHIVE_COMPACT_BYTES (16 * 1024 * 1024)
+// How many added framebuffers between logs of the ingest stats
+#define FRAMEBUFFER_ARCHIVE_LOG_INTERVAL 1000
+
+// Every framebuffer of a branch in one blob file, with an index from frame to offset
+// The blob is only appended to, rerecording a frame leaves the old JPEG behind until compaction
+// Invalidating a run doesn't touch the index, it adds a cut instead
+// Entries written before a cut (lower generation) at or after its frame aren't valid anymore
+// The blob is content addressed, identical JPEGs (loading screens, pauses) are stored once and shared by every frame showing them
+
+struct FramebufferArchiveCut {
+	uint32_t generation;
+	FrameNum frame;
+};
+
+// On disk, mapped with mio
+struct FramebufferArchiveHeader {
+	char magic[8];
+	uint32_t generation;
+	uint32_t numCuts;
+	// Frames covered by the index, not all of them have a framebuffer
+	uint64_t numEntries;
+	uint64_t blobSize;
+	FramebufferArchiveCut cuts[FRAMEBUFFER_ARCHIVE_MAX_CUTS];
+};
+
+struct FramebufferArchiveEntry {
+	uint64_t offset;
+	// Of the JPEG, so the blob index can be rebuilt without reading the blob
+	uint64_t hash;
+	// 0 when there is no framebuffer
+	uint32_t size;
+	uint32_t generation;
+};
+
+class FramebufferArchive {
+private:
+	std::error_code errorCode;
+
+	wxFileName indexFile;
+	wxFileName blobFile;
+
+	mio::mmap_sink indexMap;
+	mio::mmap_sink blobMap;
+
+	// Capacities of the files, not how much is used
+	uint64_t indexCapacity = 0;
+	uint64_t blobCapacity  = 0;
+
+	// False if a file couldn't be mapped, the archive acts empty then
+	bool mapped = false;
+
+	struct StoredBlob {
+		uint64_t offset;
+		uint32_t size;
+	};
+	// Hash to a copy already in the blob, including ones only invalidated frames point to
+	std::unordered_map<uint64_t, StoredBlob> storedBlobs;
+
+	// Since the archive was opened
+	uint64_t numIngested                           = 0;
+	uint64_t numDeduplicated                       = 0;
+	uint64_t bytesIngested                         = 0;
+	uint64_t bytesDeduplicated                     = 0;
+	std::chrono::steady_clock::duration ingestTime = std::chrono::steady_clock::duration::zero();
+
+	FramebufferArchiveHeader* getHeader() {
+		return (FramebufferArchiveHeader*)indexMap.data();
+	}
+
+	const FramebufferArchiveHeader* getHeader() const {
+		return (const FramebufferArchiveHeader*)indexMap.data();
+	}
+
+	FramebufferArchiveEntry* getEntries() {
+		return (FramebufferArchiveEntry*)(indexMap.data() + sizeof(FramebufferArchiveHeader));
+	}
+
+	const FramebufferArchiveEntry* getEntries() const {
+		return (const FramebufferArchiveEntry*)(indexMap.data() + sizeof(FramebufferArchiveHeader));
+	}
+
+	bool mapFile(mio::mmap_sink& map, wxFileName& file, uint64_t& capacity, uint64_t newCapacity);
+
+	// XXH64, JPEGs are hashed as they come in so it needs to be fast
+	static uint64_t hashFramebuffer(const uint8_t* data, std::size_t size);
+	void rebuildStoredBlobs();
+
+	bool isEntryValid(FrameNum frame, const FramebufferArchiveEntry& entry) const;
+	// Shared blobs are only counted once
+	uint64_t getLiveBytes() const;
+	// Clears every entry hit by a cut, then the cuts and generations start over
+	void applyCuts();
+
+	// Framebuffers from before the archive, as loose JPEGs in the folder
+	void importLooseFiles(wxFileName folder);
+
+public:
+	// The folder is the branch folder, the files are created if needed
+	FramebufferArchive(wxFileName folder);
+	~FramebufferArchive();
+
+	static wxString getLooseFramebufferName(FrameNum frame) {
+		return wxString::Format("frame_%lu_screenshot.jpg", frame);
+	}
+
+	void addFramebuffer(FrameNum frame, const uint8_t* data, uint32_t size);
+	// Points into the mapped blob, only valid until the next write
+	bool getFramebuffer(FrameNum frame, const uint8_t** data, uint32_t* size) const;
+	bool hasFramebuffer(FrameNum frame) const;
+
+	// Every framebuffer from this frame on is gone, O(1) until the cuts run out
+	void invalidateFrom(FrameNum frame);
+
+	// Rewrites the blob with only the live framebuffers, if enough of it is dead
+	bool compactIfNeeded();
+	void compact();
+
+	// Writes the old one file per frame layout, returns how many were written
+	FrameNum exportToFolder(wxFileName folder);
+
+	uint64_t getBlobSize() const {
+		return mapped ? getHeader()->blobSize : 0;
+	}
+
+	bool isMapped() const {
+		return mapped;
+	}
+
+	void logUsage() const;
+
+	// Closes the maps, done before the folder is moved or removed
+	void close();
+	void sync();
+};
@@ -0,0 +1,278 @@
+#include "ftpUploader.hpp"
+
+bool FtpUploader::sendAll(CActiveSocket* socket, const uint8_t* data, std::size_t size) {
+	std::size_t sent = 0;
+	while(sent < size) {
+		int32 res = socket->Send(&data[sent], size - sent);
+		if(res <= 0) {
+			lastError = socket->DescribeError();
+			return false;
+		}
+		sent += res;
+	}
+	return true;
+}
+
+bool FtpUploader::sendCommand(std::string command) {
+	command += "\r\n";
+	return sendAll(controlConnection.get(), (const uint8_t*)command.data(), command.size());
+}
+
+int FtpUploader::readReply(std::string& text) {
+	text.clear();
+
+	int code = -1;
+	while(true) {
+		std::size_t end = replyBuffer.find('\n');
+		if(end == std::string::npos) {
+			uint8_t buffer[0x400];
+			int32 res = controlConnection->Receive(sizeof(buffer), buffer);
+			if(res <= 0) {
+				lastError = res == 0 ? "Connection closed by server" : controlConnection->DescribeError();
+				return -1;
+			}
+			replyBuffer.append((const char*)buffer, res);
+			continue;
+		}
+
+		std::string line = replyBuffer.substr(0, end);
+		replyBuffer.erase(0, end + 1);
+		if(!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		text += line + "\n";
+
+		bool startsWithCode = line.size() >= 3 && isdigit(line[0]) && isdigit(line[1]) && isdigit(line[2]);
+		if(code == -1) {
+			if(!startsWithCode) {
+				lastError = "Invalid reply: " + line;
+				return -1;
+			}
+			code = std::stoi(line.substr(0, 3));
+		}
+
+		// Multi line replies end with the same code followed by a space
+		if(startsWithCode && std::stoi(line.substr(0, 3)) == code && (line.size() == 3 || line[3] == ' ')) {
+			return code;
+		}
+	}
+}
+
+bool FtpUploader::expectReply(int code, std::string& text) {
+	int res = readReply(text);
+	if(res == -1) {
+		return false;
+	}
+	// Only the first digit matters for most commands
+	if(res / 100 != code / 100) {
+		lastError = text;
+		if(!lastError.empty() && lastError.back() == '\n') {
+			lastError.pop_back();
+		}
+		return false;
+	}
+	return true;
+}
+
+bool FtpUploader::connect(std::string address, uint16_t port) {
+	disconnect();
+
+	controlConnection = std::make_shared<CActiveSocket>();
+	controlConnection->Initialize();
+	controlConnection->SetConnectTimeout(FTP_TIMEOUT_SECONDS);
+	controlConnection->SetReceiveTimeout(FTP_TIMEOUT_SECONDS);
+	controlConnection->SetSendTimeout(FTP_TIMEOUT_SECONDS);
+
+	if(!controlConnection->Open(address.c_str(), port)) {
+		lastError = controlConnection->DescribeError();
+		controlConnection.reset();
+		return false;
+	}
+
+	std::string text;
+	// Greeting, then anonymous login, the Switch server takes anything
+	if(!expectReply(220) || !sendCommand("USER anonymous")) {
+		disconnect();
+		return false;
+	}
+
+	int res = readReply(text);
+	if(res == 331) {
+		if(!sendCommand("PASS anonymous") || !expectReply(230)) {
+			disconnect();
+			return false;
+		}
+	} else if(res / 100 != 2) {
+		if(res != -1) {
+			lastError = text;
+		}
+		disconnect();
+		return false;
+	}
+
+	// Scripts are binary
+	if(!sendCommand("TYPE I") || !expectReply(200)) {
+		disconnect();
+		return false;
+	}
+
+	return true;
+}
+
+void FtpUploader::disconnect() {
+	if(dataConnection) {
+		dataConnection->Close();
+		dataConnection.reset();
+	}
+	if(controlConnection) {
+		// Don't care about the reply, the connection is going away anyway
+		// Keep the error that caused the disconnect
+		std::string error = lastError;
+		sendCommand("QUIT");
+		lastError = error;
+		controlConnection->Close();
+		controlConnection.reset();
+	}
+	replyBuffer.clear();
+}
+
+std::shared_ptr<CActiveSocket> FtpUploader::openPassiveConnection() {
+	std::string text;
+	if(!sendCommand("PASV") || !expectReply(227, text)) {
+		return nullptr;
+	}
+
+	// 227 Entering Passive Mode (h1,h2,h3,h4,p1,p2)
+	std::size_t start = text.find('(');
+	unsigned int parts[6];
+	if(start == std::string::npos || sscanf(&text[start + 1], "%u,%u,%u,%u,%u,%u", &parts[0], &parts[1], &parts[2], &parts[3], &parts[4], &parts[5]) != 6) {
+		lastError = "Invalid passive reply: " + text;
+		return nullptr;
+	}
+
+	// Use the address the control connection went to, like curl does, servers behind NAT report the wrong one
+	uint16_t port = (uint16_t)((parts[4] << 8) | parts[5]);
+
+	auto dataConnection = std::make_shared<CActiveSocket>();
+	dataConnection->Initialize();
+	dataConnection->SetConnectTimeout(FTP_TIMEOUT_SECONDS);
+	dataConnection->SetSendTimeout(FTP_TIMEOUT_SECONDS);
+
+	if(!dataConnection->Open(controlConnection->GetServerAddr(), port)) {
+		lastError = dataConnection->DescribeError();
+		return nullptr;
+	}
+
+	return dataConnection;
+}
+
+bool FtpUploader::parseUrl(std::string url, std::string& host, uint16_t& port, std::string& path) {
+	const std::string scheme = "ftp://";
+	if(url.compare(0, scheme.size(), scheme) == 0) {
+		url.erase(0, scheme.size());
+	}
+
+	std::size_t pathStart = url.find('/');
+	if(pathStart == std::string::npos || pathStart == 0 || pathStart == url.size() - 1) {
+		return false;
+	}
+
+	host = url.substr(0, pathStart);
+	path = url.substr(pathStart);
+	port = FTP_PORT;
+
+	std::size_t portStart = host.find(':');
+	if(portStart != std::string::npos) {
+		std::string portString = host.substr(portStart + 1);
+		host.erase(portStart);
+		if(portString.empty() || portString.size() > 5 || !std::all_of(portString.begin(), portString.end(), ::isdigit) || std::stoul(portString) > UINT16_MAX) {
+			return false;
+		}
+		port = std::stoul(portString);
+	}
+
+	return !host.empty();
+}
+
+bool FtpUploader::beginUpload(std::string path) {
+	if(!controlConnection) {
+		lastError = "Not connected";
+		return false;
+	}
+
+	dataConnection = openPassiveConnection();
+	if(!dataConnection) {
+		return false;
+	}
+
+	if(!sendCommand("STOR " + path) || !expectReply(150)) {
+		dataConnection->Close();
+		dataConnection.reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool FtpUploader::sendData(const uint8_t* data, std::size_t size) {
+	if(!dataConnection) {
+		lastError = "No upload in progress";
+		return false;
+	}
+
+	if(!sendAll(dataConnection.get(), data, size)) {
+		dataConnection->Close();
+		dataConnection.reset();
+		disconnect();
+		return false;
+	}
+
+	return true;
+}
+
+bool FtpUploader::finishUpload() {
+	if(!dataConnection) {
+		lastError = "No upload in progress";
+		return false;
+	}
+
+	// Closing the data connection is what marks the end of the file
+	dataConnection->Close();
+	dataConnection.reset();
+	return expectReply(226);
+}
+
+void FtpUploader::abortUpload() {
+	if(dataConnection) {
+		dataConnection->Close();
+		dataConnection.reset();
+	}
+	disconnect();
+	lastError = "Upload cancelled";
+}
+
+bool FtpUploader::upload(std::string path, const uint8_t* data, std::size_t size, ProgressCallback progress, const std::atomic_bool* cancel) {
+	if(!beginUpload(path)) {
+		return false;
+	}
+
+	std::size_t sent = 0;
+	while(sent < size) {
+		if((cancel != nullptr && *cancel) || (progress && !progress(sent))) {
+			abortUpload();
+			return false;
+		}
+
+		std::size_t chunkSize = std::min<std::size_t>(FTP_CHUNK_SIZE, size - sent);
+		if(!sendData(&data[sent], chunkSize)) {
+			return false;
+		}
+		sent += chunkSize;
+	}
+
+	if(progress) {
+		progress(sent);
+	}
+
+	return finishUpload();
+}
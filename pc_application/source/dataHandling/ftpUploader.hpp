@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../sharedNetworkCode/thirdParty/clsocket/ActiveSocket.h"
+
+// Same port curl used, the Switch FTP server listens here
+#define FTP_PORT 21
+#define FTP_TIMEOUT_SECONDS 10
+#define FTP_CHUNK_SIZE 0x10000
+
+// Tiny passive mode FTP client, only enough to STOR files onto the Switch
+// One control connection is kept for every upload, so several files don't pay for logging in again
+// Only depends on the standard library and clsocket
+class FtpUploader {
+public:
+	// Called with the bytes sent so far, returns false to stop
+	typedef std::function<bool(uint64_t sent)> ProgressCallback;
+
+private:
+	std::shared_ptr<CActiveSocket> controlConnection;
+	// Only open between beginUpload and finishUpload
+	std::shared_ptr<CActiveSocket> dataConnection;
+	// Replies can come in pieces, the leftovers are kept for the next one
+	std::string replyBuffer;
+	std::string lastError;
+
+	bool sendCommand(std::string command);
+	// Handles multi line replies, returns the code
+	int readReply(std::string& text);
+	bool expectReply(int code, std::string& text);
+	bool expectReply(int code) {
+		std::string text;
+		return expectReply(code, text);
+	}
+
+	bool sendAll(CActiveSocket* socket, const uint8_t* data, std::size_t size);
+	std::shared_ptr<CActiveSocket> openPassiveConnection();
+
+public:
+	~FtpUploader() {
+		disconnect();
+	}
+
+	// ftp://host[:port]/path, the path keeps its leading slash
+	static bool parseUrl(std::string url, std::string& host, uint16_t& port, std::string& path);
+
+	bool connect(std::string address, uint16_t port = FTP_PORT);
+	void disconnect();
+
+	bool isConnected() {
+		return controlConnection != nullptr;
+	}
+
+	bool upload(std::string path, const uint8_t* data, std::size_t size, ProgressCallback progress = nullptr, const std::atomic_bool* cancel = nullptr);
+
+	// For files that are made while they are sent, nothing has to be kept in memory
+	bool beginUpload(std::string path);
+	bool sendData(const uint8_t* data, std::size_t size);
+	bool finishUpload();
+	// The transfer can't be stopped cleanly, so this hangs up
+	void abortUpload();
+
+	std::string getError() {
+		return lastError;
+	}
+};
@@ -16,6 +16,79 @@ GameCorruptor::GameCorruptor(wxWindow* parent, std::shared_ptr<ProjectHandler> p
 
 	memorySectionViewer = new MemorySectionViewer(this);
 
+	wxFileName scanDir = projectHandler->getProjectStart();
+	scanDir.AppendDir("memoryScan");
+	scanDir.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+	memoryScanner = std::make_shared<MemoryScanner>(scanDir.GetPath().ToStdString());
+
+	scanSizer = new wxBoxSizer(wxVERTICAL);
+
+	wxString typeChoices[MemoryRegionTypes::NUM_OF_TYPES];
+
+	typeChoices[MemoryRegionTypes::Bit8]        = "8 Bit Number";
+	typeChoices[MemoryRegionTypes::Bit16]       = "16 Bit Number";
+	typeChoices[MemoryRegionTypes::Bit32]       = "32 Bit Number";
+	typeChoices[MemoryRegionTypes::Bit64]       = "64 Bit Number";
+	typeChoices[MemoryRegionTypes::Float]       = "Float";
+	typeChoices[MemoryRegionTypes::Double]      = "Double";
+	typeChoices[MemoryRegionTypes::Bool]        = "Bool";
+	typeChoices[MemoryRegionTypes::CharPointer] = "Char String";
+	typeChoices[MemoryRegionTypes::ByteArray]   = "Byte Array";
+
+	typeSelection = new wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, MemoryRegionTypes::NUM_OF_TYPES, typeChoices);
+	typeSelection->SetSelection(MemoryRegionTypes::Bit32);
+
+	unsignedCheckbox = new wxCheckBox(this, wxID_ANY, "Unsigned");
+
+	wxString scanTypeChoices[MemoryScanType::NUM_OF_SCAN_TYPES];
+
+	scanTypeChoices[MemoryScanType::EXACT]     = "Exact Value";
+	scanTypeChoices[MemoryScanType::CHANGED]   = "Changed Value";
+	scanTypeChoices[MemoryScanType::UNCHANGED] = "Unchanged Value";
+	scanTypeChoices[MemoryScanType::INCREASED] = "Increased Value";
+	scanTypeChoices[MemoryScanType::DECREASED] = "Decreased Value";
+
+	scanTypeSelection = new wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, MemoryScanType::NUM_OF_SCAN_TYPES, scanTypeChoices);
+	scanTypeSelection->SetSelection(MemoryScanType::EXACT);
+
+	scanValue = new wxTextCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxTE_CENTRE);
+	scanValue->SetToolTip("Value to search for, byte arrays are written in hex");
+
+	newScanButton  = new wxButton(this, wxID_ANY, "New Scan");
+	nextScanButton = new wxButton(this, wxID_ANY, "Next Scan");
+	nextScanButton->Enable(false);
+
+	newScanButton->Bind(wxEVT_BUTTON, &GameCorruptor::onNewScan, this);
+	nextScanButton->Bind(wxEVT_BUTTON, &GameCorruptor::onNextScan, this);
+
+	scanStatus = new wxStaticText(this, wxID_ANY, "No scan yet");
+
+	scanResults = new wxListCtrl(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_HRULES);
+	scanResults->InsertColumn(0, "Address", wxLIST_FORMAT_CENTER, wxLIST_AUTOSIZE);
+	scanResults->InsertColumn(1, "Value", wxLIST_FORMAT_CENTER, wxLIST_AUTOSIZE);
+
+	scanSizer->Add(typeSelection, 0, wxEXPAND | wxALL);
+	scanSizer->Add(unsignedCheckbox, 0, wxEXPAND | wxALL);
+	scanSizer->Add(scanTypeSelection, 0, wxEXPAND | wxALL);
+	scanSizer->Add(scanValue, 0, wxEXPAND | wxALL);
+	scanSizer->Add(newScanButton, 0, wxEXPAND | wxALL);
+	scanSizer->Add(nextScanButton, 0, wxEXPAND | wxALL);
+	scanSizer->Add(scanStatus, 0, wxEXPAND | wxALL);
+	scanSizer->Add(scanResults, 1, wxEXPAND | wxALL);
+
+	mainSizer->Add(scanSizer, 1, wxEXPAND | wxALL);
+
+	ADD_NETWORK_CALLBACK(RecieveMemorySnapshotChunk, {
+		if(data.aborted) {
+			abortScan();
+		} else {
+			memoryScanner->addChunk(data.addr, data.memory.data(), data.memory.size());
+			if(data.isLast) {
+				finishScan();
+			}
+		}
+	})
+
 	// Implement RTC algorithms here
 	// Starting with Vector Engine
 
@@ -39,12 +112,195 @@ GameCorruptor::GameCorruptor(wxWindow* parent, std::shared_ptr<ProjectHandler> p
 // clang-format off
 BEGIN_EVENT_TABLE(GameCorruptor, wxDialog)
     EVT_IDLE(GameCorruptor::onIdle)
+    EVT_CLOSE(GameCorruptor::onClose)
 END_EVENT_TABLE()
 // clang-format on
 
 void GameCorruptor::onIdle(wxIdleEvent& event) {
 	// Check networkInstance for memory info and enable everything
+	PROCESS_NETWORK_CALLBACKS(networkInstance, RecieveMemorySnapshotChunk)
+
+	if(memoryScanner->isScanning()) {
+		scanStatus->SetLabel(wxString::Format("Scanning, %.1f MB read", memoryScanner->getBytesScanned() / 1000000.0));
+	}
+
 	if(!IsBeingDeleted()) {
 		event.RequestMore();
 	}
+}
+
+void GameCorruptor::onClose(wxCloseEvent& event) {
+	if(memoryScanner->isScanning()) {
+		// Don't leave the switch sending memory nobody will read
+		ADD_TO_QUEUE(SendMemorySnapshot, networkInstance, {
+			data.cancel = true;
+		})
+	}
+
+	REMOVE_NETWORK_CALLBACK(RecieveMemorySnapshotChunk)
+
+	event.Skip();
+}
+
+void GameCorruptor::onNewScan(wxCommandEvent& event) {
+	memoryScanner->reset();
+	startScan();
+}
+
+void GameCorruptor::onNextScan(wxCommandEvent& event) {
+	startScan();
+}
+
+void GameCorruptor::startScan() {
+	if(!networkInstance->isConnected()) {
+		wxMessageDialog notConnectedDialog(this, "The switch needs to be connected to scan memory", "Not connected", wxOK | wxICON_ERROR);
+		notConnectedDialog.ShowModal();
+		return;
+	}
+
+	MemoryRegionTypes type  = (MemoryRegionTypes)typeSelection->GetSelection();
+	MemoryScanType scanType = (MemoryScanType)scanTypeSelection->GetSelection();
+	uint8_t isUnsigned      = unsignedCheckbox->GetValue();
+	uint8_t needsValue      = scanType == MemoryScanType::EXACT || type == MemoryRegionTypes::CharPointer || type == MemoryRegionTypes::ByteArray;
+
+	std::vector<uint8_t> bytes;
+	if(!parseScanValue(type, isUnsigned, bytes) && needsValue) {
+		wxMessageDialog invalidValueDialog(this, "This value is invalid for this type", "Invalid value", wxOK | wxICON_ERROR);
+		invalidValueDialog.ShowModal();
+		return;
+	}
+
+	// Leftovers from a canceled scan
+	Protocol::Struct_RecieveMemorySnapshotChunk leftover;
+	while(networkInstance->Queue_RecieveMemorySnapshotChunk.try_dequeue(leftover)) {}
+
+	if(!memoryScanner->startScan(type, isUnsigned, scanType, bytes)) {
+		wxMessageDialog fileDialog(this, "The memory snapshot file could not be created", "Scan failed", wxOK | wxICON_ERROR);
+		fileDialog.ShowModal();
+		return;
+	}
+	scanStart = std::chrono::steady_clock::now();
+
+	newScanButton->Enable(false);
+	nextScanButton->Enable(false);
+
+	ADD_TO_QUEUE(SendMemorySnapshot, networkInstance, {
+		data.cancel = false;
+	})
+}
+
+void GameCorruptor::finishScan() {
+	if(!memoryScanner->endScan()) {
+		// The scanner already started over, the old results are gone
+		scanStatus->SetLabel("Scan failed, results cleared");
+		wxLogMessage("Memory scan failed: " + wxString::FromUTF8(memoryScanner->getError()));
+		scanResults->DeleteAllItems();
+
+		newScanButton->Enable(true);
+		nextScanButton->Enable(false);
+
+		wxMessageDialog errorDialog(this, wxString::FromUTF8(memoryScanner->getError()), "Scan failed", wxOK | wxICON_ERROR);
+		errorDialog.ShowModal();
+		return;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - scanStart).count();
+	wxString status = wxString::Format("%llu results, %.1f KB of candidates, %.1f MB/s", (unsigned long long)memoryScanner->getNumCandidates(), memoryScanner->getCandidateMemoryUsage() / 1000.0, memoryScanner->getBytesScanned() / 1000000.0 / seconds);
+	scanStatus->SetLabel(status);
+	wxLogMessage("Memory scan: " + status);
+
+	MemoryRegionTypes type = (MemoryRegionTypes)typeSelection->GetSelection();
+	uint8_t isUnsigned     = unsignedCheckbox->GetValue();
+
+	scanResults->Freeze();
+	scanResults->DeleteAllItems();
+	long row = 0;
+	for(auto const& result : memoryScanner->getResults(MAX_LISTED_RESULTS)) {
+		scanResults->InsertItem(row, wxString::Format("0x%016" PRIX64, result.addr));
+		scanResults->SetItem(row, 1, wxString::FromUTF8(MemoryTraceColumn::valueToString(type, isUnsigned, result.value)));
+		row++;
+	}
+	scanResults->Thaw();
+
+	newScanButton->Enable(true);
+	nextScanButton->Enable(memoryScanner->hasResults());
+}
+
+void GameCorruptor::abortScan() {
+	memoryScanner->abortScan();
+
+	scanStatus->SetLabel("Scan aborted, the game has to stay paused and connected");
+	wxLogMessage("Memory scan aborted, previous results kept");
+
+	newScanButton->Enable(true);
+	nextScanButton->Enable(memoryScanner->hasResults());
+}
+
+bool GameCorruptor::parseScanValue(MemoryRegionTypes type, uint8_t isUnsigned, std::vector<uint8_t>& bytes) {
+	wxString text = scanValue->GetValue().Trim().Trim(false);
+
+	switch(type) {
+	case MemoryRegionTypes::Bit8:
+	case MemoryRegionTypes::Bit16:
+	case MemoryRegionTypes::Bit32:
+	case MemoryRegionTypes::Bit64:
+	case MemoryRegionTypes::Bool: {
+		// Base 0 allows hex with 0x
+		uint64_t number;
+		if(isUnsigned || type == MemoryRegionTypes::Bool) {
+			unsigned long long unsignedNumber;
+			if(!text.ToULongLong(&unsignedNumber, 0)) {
+				return false;
+			}
+			number = unsignedNumber;
+		} else {
+			long long signedNumber;
+			if(!text.ToLongLong(&signedNumber, 0)) {
+				return false;
+			}
+			number = signedNumber;
+		}
+		// Little endian, so the low bytes come first
+		bytes.resize(MemoryScanner::getTypeSize(type));
+		memcpy(bytes.data(), &number, bytes.size());
+		return true;
+	}
+	case MemoryRegionTypes::Float:
+	case MemoryRegionTypes::Double: {
+		double number;
+		if(!text.ToDouble(&number)) {
+			return false;
+		}
+		if(type == MemoryRegionTypes::Float) {
+			float smallNumber = number;
+			bytes.resize(sizeof(float));
+			memcpy(bytes.data(), &smallNumber, sizeof(float));
+		} else {
+			bytes.resize(sizeof(double));
+			memcpy(bytes.data(), &number, sizeof(double));
+		}
+		return true;
+	}
+	case MemoryRegionTypes::CharPointer: {
+		wxScopedCharBuffer utf8 = text.ToUTF8();
+		bytes.assign(utf8.data(), utf8.data() + utf8.length());
+		return !bytes.empty();
+	}
+	case MemoryRegionTypes::ByteArray: {
+		text.Replace(" ", "");
+		if(text.empty() || text.length() % 2 != 0) {
+			return false;
+		}
+		for(std::size_t i = 0; i < text.length(); i += 2) {
+			unsigned long byte;
+			if(!text.Mid(i, 2).ToULong(&byte, 16)) {
+				return false;
+			}
+			bytes.push_back(byte);
+		}
+		return true;
+	}
+	default:
+		return false;
+	}
 }
\ No newline at end of file
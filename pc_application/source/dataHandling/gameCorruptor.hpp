@@ -1,10 +1,14 @@
 #pragma once
 
+#include <chrono>
+#include <wx/listctrl.h>
 #include <wx/wx.h>
 
 #include "../sharedNetworkCode/networkInterface.hpp"
 #include "../ui/drawingCanvas.hpp"
 #include "dataProcessing.hpp"
+#include "memoryScanner.hpp"
+#include "memoryTrace.hpp"
 #include "projectHandler.hpp"
 
 class MemorySectionViewer : public DrawingCanvas {
@@ -26,7 +30,33 @@ private:
 
 	MemorySectionViewer* memorySectionViewer;
 
+	// Only the first results are listed, the scanner can hold millions
+	static constexpr std::size_t MAX_LISTED_RESULTS = 1000;
+
+	std::shared_ptr<MemoryScanner> memoryScanner;
+	std::chrono::steady_clock::time_point scanStart;
+
+	wxBoxSizer* scanSizer;
+	wxChoice* typeSelection;
+	wxCheckBox* unsignedCheckbox;
+	wxChoice* scanTypeSelection;
+	wxTextCtrl* scanValue;
+	wxButton* newScanButton;
+	wxButton* nextScanButton;
+	wxStaticText* scanStatus;
+	wxListCtrl* scanResults;
+
 	void onIdle(wxIdleEvent& event);
+	void onClose(wxCloseEvent& event);
+
+	void onNewScan(wxCommandEvent& event);
+	void onNextScan(wxCommandEvent& event);
+	void startScan();
+	void finishScan();
+	void abortScan();
+
+	// Returns false if the text isn't a valid value of this type
+	bool parseScanValue(MemoryRegionTypes type, uint8_t isUnsigned, std::vector<uint8_t>& bytes);
 
 public:
 	GameCorruptor(wxWindow* parent, std::shared_ptr<ProjectHandler> projHandler, std::shared_ptr<CommunicateWithNetwork> networkImp);
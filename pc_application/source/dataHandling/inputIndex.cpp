@@ -0,0 +1,258 @@
+#include "inputIndex.hpp"
+
+// In ControllerNumberValues order
+static int16_t ControllerData::*const valueFields[INPUT_INDEX_NUM_VALUES] = {
+	&ControllerData::LS_X,
+	&ControllerData::LS_Y,
+	&ControllerData::RS_X,
+	&ControllerData::RS_Y,
+	&ControllerData::ACCEL_X,
+	&ControllerData::ACCEL_Y,
+	&ControllerData::ACCEL_Z,
+	&ControllerData::GYRO_1,
+	&ControllerData::GYRO_2,
+	&ControllerData::GYRO_3,
+};
+
+void InputIndex::setFrames(FrameBitmap& bitmap, std::size_t start, std::size_t count) {
+	// Whole words where possible
+	std::size_t end = start + count;
+	while(start < end && start % 64 != 0) {
+		bitmap[start / 64] |= 1ULL << (start % 64);
+		start++;
+	}
+	while(start + 64 <= end) {
+		bitmap[start / 64] = UINT64_MAX;
+		start += 64;
+	}
+	while(start < end) {
+		bitmap[start / 64] |= 1ULL << (start % 64);
+		start++;
+	}
+}
+
+void InputIndex::maskBitmap(FrameBitmap& bitmap, std::size_t numFrames) {
+	if(numFrames % 64 != 0 && !bitmap.empty()) {
+		bitmap.back() &= (1ULL << (numFrames % 64)) - 1;
+	}
+}
+
+void InputIndex::buildBlock(std::size_t blockIndex) {
+	Block& block        = blocks[blockIndex];
+	FrameNum blockStart = blockIndex * INPUT_INDEX_BLOCK_SIZE;
+	FrameNum blockSize  = getBlockSize(blockIndex);
+	const auto& frames  = *indexedFrames;
+
+	uint64_t bits[BUTTONS_SIZE][INPUT_INDEX_BLOCK_WORDS] = {};
+	std::fill_n(block.minValues, INPUT_INDEX_NUM_VALUES, INT16_MAX);
+	std::fill_n(block.maxValues, INPUT_INDEX_NUM_VALUES, INT16_MIN);
+
+	// One pass over the frames for every field
+	for(FrameNum i = 0; i < blockSize; i++) {
+		const ControllerData& data = *frames[blockStart + i];
+
+		uint32_t buttons = data.buttons;
+		while(buttons != 0) {
+			uint8_t button = __builtin_ctz(buttons);
+			if(button < BUTTONS_SIZE) {
+				bits[button][i / 64] |= 1ULL << (i % 64);
+			}
+			buttons &= buttons - 1;
+		}
+
+		for(uint8_t field = 0; field < INPUT_INDEX_NUM_VALUES; field++) {
+			int16_t value          = data.*valueFields[field];
+			block.minValues[field] = std::min(block.minValues[field], value);
+			block.maxValues[field] = std::max(block.maxValues[field], value);
+		}
+	}
+
+	for(uint8_t button = 0; button < BUTTONS_SIZE; button++) {
+		ButtonContainer& container = block.buttons[button];
+		container.frames.clear();
+		container.bits.clear();
+
+		uint32_t count = 0;
+		for(uint64_t word : bits[button]) {
+			count += std::bitset<64>(word).count();
+		}
+		container.count = count;
+
+		if(count == 0 || count == blockSize) {
+			// Nothing needs to be stored
+		} else if(count <= INPUT_INDEX_ARRAY_MAX) {
+			container.frames.reserve(count);
+			for(uint16_t word = 0; word < INPUT_INDEX_BLOCK_WORDS; word++) {
+				uint64_t value = bits[button][word];
+				while(value != 0) {
+					container.frames.push_back(word * 64 + __builtin_ctzll(value));
+					value &= value - 1;
+				}
+			}
+		} else {
+			container.bits.assign(bits[button], bits[button] + INPUT_INDEX_BLOCK_WORDS);
+		}
+	}
+
+	block.dirty = false;
+}
+
+bool InputIndex::compareValue(int32_t left, InputCompare compare, int32_t right) {
+	switch(compare) {
+	case COMPARE_LESS:
+		return left < right;
+	case COMPARE_LESS_EQUAL:
+		return left <= right;
+	case COMPARE_GREATER:
+		return left > right;
+	case COMPARE_GREATER_EQUAL:
+		return left >= right;
+	case COMPARE_EQUAL:
+		return left == right;
+	case COMPARE_NOT_EQUAL:
+	default:
+		return left != right;
+	}
+}
+
+std::size_t InputIndex::update(const std::vector<std::shared_ptr<ControllerData>>& frames) {
+	if(&frames != indexedFrames) {
+		blocks.clear();
+		indexedFrames = &frames;
+		indexedSize   = 0;
+	}
+
+	if(frames.size() != indexedSize) {
+		// The last block changes size, new blocks start dirty
+		if(!blocks.empty()) {
+			blocks.back().dirty = true;
+		}
+		indexedSize = frames.size();
+		blocks.resize((indexedSize + INPUT_INDEX_BLOCK_SIZE - 1) / INPUT_INDEX_BLOCK_SIZE);
+		if(!blocks.empty()) {
+			blocks.back().dirty = true;
+		}
+	}
+
+	std::size_t numRebuilt = 0;
+	for(std::size_t i = 0; i < blocks.size(); i++) {
+		if(blocks[i].dirty) {
+			buildBlock(i);
+			numRebuilt++;
+		}
+	}
+	return numRebuilt;
+}
+
+void InputIndex::markEdited(const std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum start, FrameNum end) {
+	if(&frames != indexedFrames || start > end) {
+		return;
+	}
+
+	std::size_t lastBlock = std::min<std::size_t>(end / INPUT_INDEX_BLOCK_SIZE + 1, blocks.size());
+	for(std::size_t i = start / INPUT_INDEX_BLOCK_SIZE; i < lastBlock; i++) {
+		blocks[i].dirty = true;
+	}
+}
+
+void InputIndex::markMovedFrom(const std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum start) {
+	if(&frames != indexedFrames) {
+		return;
+	}
+
+	for(std::size_t i = start / INPUT_INDEX_BLOCK_SIZE; i < blocks.size(); i++) {
+		blocks[i].dirty = true;
+	}
+}
+
+void InputIndex::clear() {
+	indexedFrames = nullptr;
+	indexedSize   = 0;
+	blocks.clear();
+}
+
+void InputIndex::getButtonBitmap(Btn button, FrameBitmap& bitmap) const {
+	bitmap.assign((indexedSize + 63) / 64, 0);
+
+	for(std::size_t i = 0; i < blocks.size(); i++) {
+		const ButtonContainer& container = blocks[i].buttons[button];
+		std::size_t blockStart           = i * INPUT_INDEX_BLOCK_SIZE;
+		FrameNum blockSize               = getBlockSize(i);
+
+		if(container.count == 0) {
+			continue;
+		} else if(container.count == blockSize) {
+			setFrames(bitmap, blockStart, blockSize);
+		} else if(!container.frames.empty()) {
+			for(uint16_t frame : container.frames) {
+				bitmap[(blockStart + frame) / 64] |= 1ULL << (frame % 64);
+			}
+		} else {
+			std::copy(container.bits.begin(), container.bits.begin() + (blockSize + 63) / 64, bitmap.begin() + blockStart / 64);
+		}
+	}
+}
+
+void InputIndex::getCompareBitmap(uint8_t field, InputCompare compare, int32_t value, FrameBitmap& bitmap) const {
+	bitmap.assign((indexedSize + 63) / 64, 0);
+
+	for(std::size_t i = 0; i < blocks.size(); i++) {
+		int32_t min            = blocks[i].minValues[field];
+		int32_t max            = blocks[i].maxValues[field];
+		std::size_t blockStart = i * INPUT_INDEX_BLOCK_SIZE;
+		FrameNum blockSize     = getBlockSize(i);
+
+		// Decided by the range of the block alone
+		bool all  = false;
+		bool none = false;
+		switch(compare) {
+		case COMPARE_LESS:
+			all  = max < value;
+			none = min >= value;
+			break;
+		case COMPARE_LESS_EQUAL:
+			all  = max <= value;
+			none = min > value;
+			break;
+		case COMPARE_GREATER:
+			all  = min > value;
+			none = max <= value;
+			break;
+		case COMPARE_GREATER_EQUAL:
+			all  = min >= value;
+			none = max < value;
+			break;
+		case COMPARE_EQUAL:
+			all  = min == value && max == value;
+			none = value < min || value > max;
+			break;
+		case COMPARE_NOT_EQUAL:
+			all  = value < min || value > max;
+			none = min == value && max == value;
+			break;
+		}
+
+		if(none) {
+			continue;
+		} else if(all) {
+			setFrames(bitmap, blockStart, blockSize);
+		} else {
+			const auto& frames = *indexedFrames;
+			for(FrameNum frame = 0; frame < blockSize; frame++) {
+				if(compareValue((*frames[blockStart + frame]).*valueFields[field], compare, value)) {
+					bitmap[(blockStart + frame) / 64] |= 1ULL << (frame % 64);
+				}
+			}
+		}
+	}
+}
+
+std::size_t InputIndex::getMemoryUsage() const {
+	std::size_t usage = blocks.capacity() * sizeof(Block);
+	for(auto const& block : blocks) {
+		for(auto const& container : block.buttons) {
+			usage += container.frames.capacity() * sizeof(uint16_t) + container.bits.capacity() * sizeof(uint64_t);
+		}
+	}
+	return usage;
+}
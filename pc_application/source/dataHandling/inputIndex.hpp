@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../sharedNetworkCode/buttonData.hpp"
+#include "buttonConstants.hpp"
+
+// Frames per block, a multiple of 64 so blocks start on a word
+#define INPUT_INDEX_BLOCK_SIZE 4096
+#define INPUT_INDEX_BLOCK_WORDS (INPUT_INDEX_BLOCK_SIZE / 64)
+// Buttons held on fewer frames than this in a block store the frames instead of a bitmap
+#define INPUT_INDEX_ARRAY_MAX 256
+// Sticks, accel and gyro, in ControllerNumberValues order
+#define INPUT_INDEX_NUM_VALUES 10
+
+// One bit per frame of a branch, 64 frames to a word
+typedef std::vector<uint64_t> FrameBitmap;
+
+enum InputCompare : uint8_t {
+	COMPARE_LESS,
+	COMPARE_LESS_EQUAL,
+	COMPARE_GREATER,
+	COMPARE_GREATER_EQUAL,
+	COMPARE_EQUAL,
+	COMPARE_NOT_EQUAL,
+};
+
+// Search index over one branch, split into blocks like a roaring bitmap
+// Each button in a block is stored as nothing (never or always held), a list of frames or a bitmap, whichever is smallest
+// Stick, accel and gyro values only keep the min and max of each block, so most blocks never have to be scanned
+// Edits mark blocks dirty, they are rebuilt the next time the index is used
+class InputIndex {
+private:
+	struct ButtonContainer {
+		uint16_t count = 0;
+		// Relative to the start of the block, when sparse
+		std::vector<uint16_t> frames;
+		// When dense
+		std::vector<uint64_t> bits;
+	};
+
+	struct Block {
+		bool dirty = true;
+		ButtonContainer buttons[BUTTONS_SIZE];
+		int16_t minValues[INPUT_INDEX_NUM_VALUES];
+		int16_t maxValues[INPUT_INDEX_NUM_VALUES];
+	};
+
+	// Only one branch at a time, the one being searched
+	const std::vector<std::shared_ptr<ControllerData>>* indexedFrames = nullptr;
+	std::size_t indexedSize                                           = 0;
+	std::vector<Block> blocks;
+
+	FrameNum getBlockSize(std::size_t blockIndex) const {
+		return std::min<std::size_t>(INPUT_INDEX_BLOCK_SIZE, indexedSize - blockIndex * INPUT_INDEX_BLOCK_SIZE);
+	}
+
+	void buildBlock(std::size_t blockIndex);
+
+	static bool compareValue(int32_t left, InputCompare compare, int32_t right);
+
+public:
+	// Rebuilds the dirty blocks, or everything if it's a different branch
+	// Returns how many blocks were rebuilt
+	std::size_t update(const std::vector<std::shared_ptr<ControllerData>>& frames);
+
+	// Both are ignored if it's not the indexed branch
+	// Both ends included
+	void markEdited(const std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum start, FrameNum end);
+	// Frames were added or removed at start, so every block after it has changed
+	void markMovedFrom(const std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum start);
+	// When branches are removed, the memory of a removed one could be reused by a new one
+	void clear();
+
+	// Both used by the queries
+	static void setFrames(FrameBitmap& bitmap, std::size_t start, std::size_t count);
+	// Clears the bits past the last frame
+	static void maskBitmap(FrameBitmap& bitmap, std::size_t numFrames);
+
+	FrameNum getNumFrames() const {
+		return indexedSize;
+	}
+
+	// Whole branch bitmaps, update has to be called first
+	void getButtonBitmap(Btn button, FrameBitmap& bitmap) const;
+	void getCompareBitmap(uint8_t field, InputCompare compare, int32_t value, FrameBitmap& bitmap) const;
+
+	std::size_t getMemoryUsage() const;
+};
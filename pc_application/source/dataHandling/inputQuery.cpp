@@ -0,0 +1,398 @@
+#include "inputQuery.hpp"
+
+// In ControllerNumberValues order
+static const char* valueNames[INPUT_INDEX_NUM_VALUES] = { "LS_X", "LS_Y", "RS_X", "RS_Y", "ACCEL_X", "ACCEL_Y", "ACCEL_Z", "GYRO_1", "GYRO_2", "GYRO_3" };
+
+static std::string toUpper(std::string_view word) {
+	std::string upper(word);
+	for(char& c : upper) {
+		if(c >= 'a' && c <= 'z') {
+			c -= 'a' - 'A';
+		}
+	}
+	return upper;
+}
+
+static bool isWordChar(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+void InputQuery::skipSpaces() {
+	while(pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+		pos++;
+	}
+}
+
+std::string_view InputQuery::peekWord() {
+	skipSpaces();
+	std::size_t end = pos;
+	while(end < text.size() && isWordChar(text[end])) {
+		end++;
+	}
+	return text.substr(pos, end - pos);
+}
+
+bool InputQuery::acceptSymbol(std::string_view symbol) {
+	skipSpaces();
+	if(text.substr(pos, symbol.size()) == symbol) {
+		pos += symbol.size();
+		return true;
+	}
+	return false;
+}
+
+bool InputQuery::acceptWord(std::string_view word) {
+	std::string_view next = peekWord();
+	if(!next.empty() && toUpper(next) == word) {
+		pos += next.size();
+		return true;
+	}
+	return false;
+}
+
+int InputQuery::addNode(QueryNode node) {
+	nodes.push_back(node);
+	return nodes.size() - 1;
+}
+
+int InputQuery::parseOr() {
+	int left = parseAnd();
+	while(left != -1 && (acceptSymbol("||") || acceptWord("OR"))) {
+		int right = parseAnd();
+		if(right == -1) {
+			return -1;
+		}
+
+		QueryNode node;
+		node.type  = QUERY_OR;
+		node.left  = left;
+		node.right = right;
+		left       = addNode(node);
+	}
+	return left;
+}
+
+int InputQuery::parseAnd() {
+	int left = parseUnary();
+	while(left != -1 && (acceptSymbol("&&") || acceptWord("AND"))) {
+		int right = parseUnary();
+		if(right == -1) {
+			return -1;
+		}
+
+		QueryNode node;
+		node.type  = QUERY_AND;
+		node.left  = left;
+		node.right = right;
+		left       = addNode(node);
+	}
+	return left;
+}
+
+int InputQuery::parseUnary() {
+	skipSpaces();
+	// Not the start of !=, that can't come first
+	if(acceptSymbol("!") || acceptWord("NOT")) {
+		int child = parseUnary();
+		if(child == -1) {
+			return -1;
+		}
+
+		QueryNode node;
+		node.type = QUERY_NOT;
+		node.left = child;
+		return addNode(node);
+	}
+	return parsePrimary();
+}
+
+int InputQuery::parsePrimary() {
+	if(acceptSymbol("(")) {
+		int inner = parseOr();
+		if(inner != -1 && !acceptSymbol(")")) {
+			error = "Missing ) at position " + std::to_string(pos + 1);
+			return -1;
+		}
+		return inner;
+	}
+
+	std::string_view word = peekWord();
+	if(word.empty()) {
+		if(pos == text.size()) {
+			error = "Query ends too early";
+		} else {
+			error = "Expected a button or value at position " + std::to_string(pos + 1);
+		}
+		return -1;
+	}
+	pos += word.size();
+	std::string name = toUpper(word);
+
+	QueryNode node;
+	if(name == "PRESSED" || name == "RELEASED") {
+		node.type = name == "PRESSED" ? QUERY_PRESSED : QUERY_RELEASED;
+
+		std::string_view buttonName;
+		if(!acceptSymbol("(") || (buttonName = peekWord()).empty()) {
+			error = name + " needs a button, like " + name + "(A)";
+			return -1;
+		}
+		pos += buttonName.size();
+		if(!lookupButton(buttonName, node.button)) {
+			error = "Unknown button \"" + std::string(buttonName) + "\"";
+			return -1;
+		}
+		if(!acceptSymbol(")")) {
+			error = "Missing ) at position " + std::to_string(pos + 1);
+			return -1;
+		}
+		return addNode(node);
+	}
+
+	if(name == "FRAME") {
+		node.type = QUERY_FRAME;
+		if(!parseCompare(node.compare) || !parseNumber(node.value)) {
+			return -1;
+		}
+		return addNode(node);
+	}
+
+	for(uint8_t field = 0; field < INPUT_INDEX_NUM_VALUES; field++) {
+		if(name == valueNames[field]) {
+			node.type  = QUERY_VALUE;
+			node.field = field;
+			if(!parseCompare(node.compare) || !parseNumber(node.value)) {
+				return -1;
+			}
+			return addNode(node);
+		}
+	}
+
+	node.type = QUERY_BUTTON;
+	if(!lookupButton(word, node.button)) {
+		error = "Unknown button or value \"" + std::string(word) + "\"";
+		return -1;
+	}
+	return addNode(node);
+}
+
+bool InputQuery::parseCompare(InputCompare& compare) {
+	// Longer ones first
+	if(acceptSymbol("<=")) {
+		compare = COMPARE_LESS_EQUAL;
+	} else if(acceptSymbol(">=")) {
+		compare = COMPARE_GREATER_EQUAL;
+	} else if(acceptSymbol("==")) {
+		compare = COMPARE_EQUAL;
+	} else if(acceptSymbol("!=")) {
+		compare = COMPARE_NOT_EQUAL;
+	} else if(acceptSymbol("<")) {
+		compare = COMPARE_LESS;
+	} else if(acceptSymbol(">")) {
+		compare = COMPARE_GREATER;
+	} else if(acceptSymbol("=")) {
+		compare = COMPARE_EQUAL;
+	} else {
+		error = "Expected a comparison at position " + std::to_string(pos + 1);
+		return false;
+	}
+	return true;
+}
+
+bool InputQuery::parseNumber(int64_t& value) {
+	skipSpaces();
+	if(pos < text.size() && text[pos] == '+') {
+		pos++;
+	}
+
+	auto result = std::from_chars(text.data() + pos, text.data() + text.size(), value);
+	if(result.ec != std::errc()) {
+		error = "Expected a number at position " + std::to_string(pos + 1);
+		return false;
+	}
+	pos = result.ptr - text.data();
+	return true;
+}
+
+bool InputQuery::lookupButton(std::string_view name, Btn& button) const {
+	auto found = buttonNames->find(toUpper(name));
+	if(found == buttonNames->end()) {
+		return false;
+	}
+	button = found->second;
+	return true;
+}
+
+bool InputQuery::parse(std::string_view query, const std::map<std::string, Btn>& names) {
+	nodes.clear();
+	error.clear();
+	text        = query;
+	pos         = 0;
+	buttonNames = &names;
+
+	root = parseOr();
+	if(root != -1) {
+		skipSpaces();
+		if(pos != text.size()) {
+			error = "Unexpected \"" + std::string(text.substr(pos)) + "\"";
+			root  = -1;
+		}
+	}
+
+	// Only the nodes are kept, the text can go away
+	text = std::string_view();
+	return root != -1;
+}
+
+void InputQuery::evaluate(int node, const InputIndex& index, FrameBitmap& result) const {
+	const QueryNode& queryNode = nodes[node];
+	std::size_t numFrames      = index.getNumFrames();
+
+	switch(queryNode.type) {
+	case QUERY_BUTTON:
+		index.getButtonBitmap(queryNode.button, result);
+		break;
+	case QUERY_PRESSED:
+	case QUERY_RELEASED: {
+		FrameBitmap held;
+		index.getButtonBitmap(queryNode.button, held);
+		result.resize(held.size());
+
+		// Held on the frame before, the first frame has nothing before it
+		uint64_t carry = 0;
+		for(std::size_t word = 0; word < held.size(); word++) {
+			uint64_t previous = (held[word] << 1) | carry;
+			carry             = held[word] >> 63;
+			result[word]      = queryNode.type == QUERY_PRESSED ? held[word] & ~previous : ~held[word] & previous;
+		}
+		InputIndex::maskBitmap(result, numFrames);
+		break;
+	}
+	case QUERY_VALUE: {
+		int32_t value = std::max<int64_t>(INT32_MIN, std::min<int64_t>(INT32_MAX, queryNode.value));
+		index.getCompareBitmap(queryNode.field, queryNode.compare, value, result);
+		break;
+	}
+	case QUERY_FRAME: {
+		result.assign((numFrames + 63) / 64, 0);
+
+		// Always a range, except for not equal
+		int64_t start = 0;
+		int64_t end   = numFrames;
+		switch(queryNode.compare) {
+		case COMPARE_LESS:
+			end = queryNode.value;
+			break;
+		case COMPARE_LESS_EQUAL:
+			end = queryNode.value + 1;
+			break;
+		case COMPARE_GREATER:
+			start = queryNode.value + 1;
+			break;
+		case COMPARE_GREATER_EQUAL:
+			start = queryNode.value;
+			break;
+		case COMPARE_EQUAL:
+			start = queryNode.value;
+			end   = queryNode.value + 1;
+			break;
+		case COMPARE_NOT_EQUAL:
+			break;
+		}
+
+		start = std::max<int64_t>(start, 0);
+		end   = std::min<int64_t>(end, numFrames);
+		if(start < end) {
+			InputIndex::setFrames(result, start, end - start);
+		}
+		if(queryNode.compare == COMPARE_NOT_EQUAL && queryNode.value >= 0 && queryNode.value < (int64_t)numFrames) {
+			result[queryNode.value / 64] &= ~(1ULL << (queryNode.value % 64));
+		}
+		break;
+	}
+	case QUERY_NOT:
+		evaluate(queryNode.left, index, result);
+		for(auto& word : result) {
+			word = ~word;
+		}
+		InputIndex::maskBitmap(result, numFrames);
+		break;
+	case QUERY_AND:
+	case QUERY_OR: {
+		FrameBitmap right;
+		evaluate(queryNode.left, index, result);
+		evaluate(queryNode.right, index, right);
+		for(std::size_t word = 0; word < result.size(); word++) {
+			result[word] = queryNode.type == QUERY_AND ? result[word] & right[word] : result[word] | right[word];
+		}
+		break;
+	}
+	}
+}
+
+void InputQuery::evaluate(const InputIndex& index, FrameBitmap& result) const {
+	if(root == -1) {
+		result.assign((index.getNumFrames() + 63) / 64, 0);
+	} else {
+		evaluate(root, index, result);
+	}
+}
+
+void InputQuery::bitmapToSelection(const FrameBitmap& bitmap, FrameSelection& selection) {
+	selection.clear();
+
+	bool inRun        = false;
+	FrameNum runStart = 0;
+	for(std::size_t word = 0; word < bitmap.size(); word++) {
+		uint64_t bits = bitmap[word];
+		// Whole words that don't end or start a run are skipped
+		if((!inRun && bits == 0) || (inRun && bits == UINT64_MAX)) {
+			continue;
+		}
+
+		for(uint8_t bit = 0; bit < 64; bit++) {
+			bool set       = (bits >> bit) & 1;
+			FrameNum frame = word * 64 + bit;
+			if(set && !inRun) {
+				runStart = frame;
+				inRun    = true;
+			} else if(!set && inRun) {
+				selection.add(runStart, frame - 1);
+				inRun = false;
+			}
+		}
+	}
+
+	if(inRun) {
+		selection.add(runStart, bitmap.size() * 64 - 1);
+	}
+}
+
+uint64_t InputQuery::countMatches(const FrameBitmap& bitmap) {
+	uint64_t count = 0;
+	for(uint64_t word : bitmap) {
+		count += std::bitset<64>(word).count();
+	}
+	return count;
+}
+
+bool InputQuery::findNextMatch(const FrameBitmap& bitmap, FrameNum from, FrameNum& match) {
+	std::size_t word = from / 64;
+	if(word >= bitmap.size()) {
+		return false;
+	}
+
+	// Frames before from in the first word don't count
+	uint64_t bits = bitmap[word] & (UINT64_MAX << (from % 64));
+	while(true) {
+		if(bits != 0) {
+			match = word * 64 + __builtin_ctzll(bits);
+			return true;
+		}
+		word++;
+		if(word == bitmap.size()) {
+			return false;
+		}
+		bits = bitmap[word];
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../sharedNetworkCode/buttonData.hpp"
+#include "buttonConstants.hpp"
+#include "frameSelection.hpp"
+#include "inputIndex.hpp"
+
+// Small expression language for finding frames, like
+//   ZR && LS_X < -20000
+//   !A && frame > 5000
+//   pressed(ZL) || released(B)
+// Buttons use the same names as the settings, values are LS_X, LS_Y, RS_X, RS_Y,
+// ACCEL_X, ACCEL_Y, ACCEL_Z, GYRO_1, GYRO_2, GYRO_3 and frame
+// and, or and not work as well as &&, || and !
+// Every node is evaluated as a bitmap over the whole branch, so nothing is done per frame except scanning blocks the index can't rule out
+class InputQuery {
+private:
+	enum QueryNodeType : uint8_t {
+		QUERY_BUTTON,
+		// Held this frame but not the last
+		QUERY_PRESSED,
+		// Held last frame but not this one
+		QUERY_RELEASED,
+		QUERY_VALUE,
+		QUERY_FRAME,
+		QUERY_NOT,
+		QUERY_AND,
+		QUERY_OR,
+	};
+
+	struct QueryNode {
+		QueryNodeType type;
+		Btn button           = Btn::A;
+		uint8_t field        = 0;
+		InputCompare compare = COMPARE_EQUAL;
+		int64_t value        = 0;
+		int left             = -1;
+		int right            = -1;
+	};
+
+	std::vector<QueryNode> nodes;
+	int root = -1;
+
+	// While parsing
+	std::string_view text;
+	std::size_t pos = 0;
+	std::string error;
+	const std::map<std::string, Btn>* buttonNames = nullptr;
+
+	void skipSpaces();
+	std::string_view peekWord();
+	bool acceptSymbol(std::string_view symbol);
+	bool acceptWord(std::string_view word);
+
+	int addNode(QueryNode node);
+	int parseOr();
+	int parseAnd();
+	int parseUnary();
+	int parsePrimary();
+	bool parseCompare(InputCompare& compare);
+	bool parseNumber(int64_t& value);
+	bool lookupButton(std::string_view name, Btn& button) const;
+
+	void evaluate(int node, const InputIndex& index, FrameBitmap& result) const;
+
+public:
+	// Returns false and sets the error if the query is invalid
+	bool parse(std::string_view query, const std::map<std::string, Btn>& names);
+	const std::string& getError() const {
+		return error;
+	}
+
+	// The index has to be updated first
+	void evaluate(const InputIndex& index, FrameBitmap& result) const;
+
+	static void bitmapToSelection(const FrameBitmap& bitmap, FrameSelection& selection);
+	static uint64_t countMatches(const FrameBitmap& bitmap);
+	// First match at or after from, returns false if there isn't one
+	static bool findNextMatch(const FrameBitmap& bitmap, FrameNum from, FrameNum& match);
+};
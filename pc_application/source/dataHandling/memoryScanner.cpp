@@ -0,0 +1,491 @@
+#include "memoryScanner.hpp"
+
+// Values are compared 64 at a time, one word of the candidate bitset
+// The compare loops are branchless with a fixed length so the compiler vectorizes them
+// at whatever width the type has
+static const uint32_t BLOCK_SIZE = 64;
+
+struct ScanExact {
+	template <typename T> static uint8_t compare(T current, T previous, T value) {
+		return current == value;
+	}
+};
+
+struct ScanChanged {
+	template <typename T> static uint8_t compare(T current, T previous, T value) {
+		return current != previous;
+	}
+};
+
+struct ScanUnchanged {
+	template <typename T> static uint8_t compare(T current, T previous, T value) {
+		return current == previous;
+	}
+};
+
+struct ScanIncreased {
+	template <typename T> static uint8_t compare(T current, T previous, T value) {
+		return current > previous;
+	}
+};
+
+struct ScanDecreased {
+	template <typename T> static uint8_t compare(T current, T previous, T value) {
+		return current < previous;
+	}
+};
+
+template <typename T, typename Scan> static void filterBlocks(const uint8_t* current, const uint8_t* previous, uint32_t numElements, T value, std::vector<uint64_t>& words) {
+	T currentValues[BLOCK_SIZE];
+	T previousValues[BLOCK_SIZE];
+	uint8_t matches[BLOCK_SIZE];
+
+	for(uint32_t word = 0; word < words.size(); word++) {
+		if(words[word] == 0) {
+			// Nothing left to check here
+			continue;
+		}
+
+		uint32_t first = word * BLOCK_SIZE;
+		uint32_t count = std::min(BLOCK_SIZE, numElements - first);
+
+		if(count != BLOCK_SIZE) {
+			memset(currentValues, 0, sizeof(currentValues));
+			memset(previousValues, 0, sizeof(previousValues));
+		}
+
+		// Memory isn't guaranteed to be aligned for T
+		memcpy(currentValues, current + first * sizeof(T), count * sizeof(T));
+		if(previous != NULL) {
+			memcpy(previousValues, previous + first * sizeof(T), count * sizeof(T));
+		}
+
+		for(uint32_t i = 0; i < BLOCK_SIZE; i++) {
+			matches[i] = Scan::compare(currentValues[i], previousValues[i], value);
+		}
+
+		uint64_t mask = 0;
+		for(uint32_t i = 0; i < count; i++) {
+			mask |= (uint64_t)matches[i] << i;
+		}
+
+		words[word] &= mask;
+	}
+}
+
+template <typename T> static void filterTyped(const uint8_t* current, const uint8_t* previous, uint32_t numElements, MemoryScanType scanType, const std::vector<uint8_t>& valueBytes, std::vector<uint64_t>& words) {
+	T value = 0;
+	memcpy(&value, valueBytes.data(), std::min(valueBytes.size(), sizeof(T)));
+
+	switch(scanType) {
+	case MemoryScanType::EXACT:
+		filterBlocks<T, ScanExact>(current, previous, numElements, value, words);
+		break;
+	case MemoryScanType::CHANGED:
+		filterBlocks<T, ScanChanged>(current, previous, numElements, value, words);
+		break;
+	case MemoryScanType::UNCHANGED:
+		filterBlocks<T, ScanUnchanged>(current, previous, numElements, value, words);
+		break;
+	case MemoryScanType::INCREASED:
+		filterBlocks<T, ScanIncreased>(current, previous, numElements, value, words);
+		break;
+	case MemoryScanType::DECREASED:
+		filterBlocks<T, ScanDecreased>(current, previous, numElements, value, words);
+		break;
+	default:
+		break;
+	}
+}
+
+// Strings and byte arrays are searched at every byte, so they go one at a time
+static void filterBytes(const uint8_t* current, const uint8_t* previous, uint32_t numElements, MemoryScanType scanType, const std::vector<uint8_t>& valueBytes, std::vector<uint64_t>& words) {
+	std::size_t size = valueBytes.size();
+	for(uint32_t word = 0; word < words.size(); word++) {
+		uint64_t bits = words[word];
+		while(bits != 0) {
+			uint32_t bit   = __builtin_ctzll(bits);
+			uint32_t i     = word * BLOCK_SIZE + bit;
+			uint8_t result = false;
+
+			switch(scanType) {
+			case MemoryScanType::EXACT:
+				result = memcmp(current + i, valueBytes.data(), size) == 0;
+				break;
+			case MemoryScanType::CHANGED:
+				result = memcmp(current + i, previous + i, size) != 0;
+				break;
+			case MemoryScanType::UNCHANGED:
+				result = memcmp(current + i, previous + i, size) == 0;
+				break;
+			case MemoryScanType::INCREASED:
+				result = memcmp(current + i, previous + i, size) > 0;
+				break;
+			case MemoryScanType::DECREASED:
+				result = memcmp(current + i, previous + i, size) < 0;
+				break;
+			default:
+				break;
+			}
+
+			if(!result) {
+				words[word] &= ~((uint64_t)1 << bit);
+			}
+			bits &= bits - 1;
+		}
+	}
+}
+
+void MemoryScanCandidates::setFull(uint32_t elements) {
+	type        = FULL;
+	numElements = elements;
+	numSet      = elements;
+	sparse.clear();
+	sparse.shrink_to_fit();
+	dense.clear();
+	dense.shrink_to_fit();
+}
+
+void MemoryScanCandidates::setFromWords(const std::vector<uint64_t>& words, uint32_t elements) {
+	numElements = elements;
+	numSet      = 0;
+	for(uint64_t word : words) {
+		numSet += __builtin_popcountll(word);
+	}
+
+	if(numSet == numElements) {
+		setFull(elements);
+	} else if(numSet * sizeof(uint16_t) < words.size() * sizeof(uint64_t)) {
+		// Cheaper to list the indexes
+		type = SPARSE;
+		dense.clear();
+		dense.shrink_to_fit();
+		sparse.clear();
+		sparse.reserve(numSet);
+		for(uint32_t word = 0; word < words.size(); word++) {
+			uint64_t bits = words[word];
+			while(bits != 0) {
+				sparse.push_back(word * BLOCK_SIZE + __builtin_ctzll(bits));
+				bits &= bits - 1;
+			}
+		}
+	} else {
+		type = DENSE;
+		sparse.clear();
+		sparse.shrink_to_fit();
+		dense = words;
+	}
+}
+
+void MemoryScanCandidates::getWords(std::vector<uint64_t>& words) const {
+	uint32_t numWords = (numElements + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+	switch(type) {
+	case FULL:
+		words.assign(numWords, UINT64_MAX);
+		if(numElements % BLOCK_SIZE != 0) {
+			words[numWords - 1] = ((uint64_t)1 << (numElements % BLOCK_SIZE)) - 1;
+		}
+		break;
+	case SPARSE:
+		words.assign(numWords, 0);
+		for(uint16_t i : sparse) {
+			words[i / BLOCK_SIZE] |= (uint64_t)1 << (i % BLOCK_SIZE);
+		}
+		break;
+	case DENSE:
+		words = dense;
+		break;
+	}
+}
+
+MemoryScanner::MemoryScanner(std::string dir) {
+	snapshotDir = dir;
+}
+
+uint32_t MemoryScanner::getTypeSize(MemoryRegionTypes valueType) {
+	switch(valueType) {
+	case MemoryRegionTypes::Bit8:
+	case MemoryRegionTypes::Bool:
+		return sizeof(uint8_t);
+	case MemoryRegionTypes::Bit16:
+		return sizeof(uint16_t);
+	case MemoryRegionTypes::Bit32:
+	case MemoryRegionTypes::Float:
+		return sizeof(uint32_t);
+	case MemoryRegionTypes::Bit64:
+	case MemoryRegionTypes::Double:
+		return sizeof(uint64_t);
+	default:
+		// Strings and byte arrays can start anywhere
+		return 1;
+	}
+}
+
+uint32_t MemoryScanner::getStep() const {
+	// Numbers are only searched at aligned addresses, like the game stores them
+	return getTypeSize(type);
+}
+
+uint32_t MemoryScanner::getNumElements(uint32_t size) const {
+	if(type == MemoryRegionTypes::CharPointer || type == MemoryRegionTypes::ByteArray) {
+		if(value.empty() || size < value.size()) {
+			return 0;
+		}
+		return size - value.size() + 1;
+	}
+	return size / getStep();
+}
+
+bool MemoryScanner::startScan(MemoryRegionTypes valueType, uint8_t valueIsUnsigned, MemoryScanType scan, std::vector<uint8_t> exactValue) {
+	uint8_t isByteArray = valueType == MemoryRegionTypes::CharPointer || valueType == MemoryRegionTypes::ByteArray;
+	if(!isFirstScan && (valueType != type || valueIsUnsigned != isUnsigned || (isByteArray && exactValue.size() != value.size()))) {
+		// Old results mean nothing with another type
+		reset();
+	}
+
+	type       = valueType;
+	isUnsigned = valueIsUnsigned;
+	scanType   = scan;
+	value      = exactValue;
+
+	newChunks.clear();
+	newSnapshotSize     = 0;
+	bytesScanned        = 0;
+	snapshotWriteFailed = false;
+	lastError.clear();
+
+	// Write to the snapshot not currently mapped
+	newSnapshot = fopen(getSnapshotPath(!currentSnapshot).c_str(), "wb");
+	if(newSnapshot == NULL) {
+		scanInProgress = false;
+		return false;
+	}
+
+	scanInProgress = true;
+	return true;
+}
+
+void MemoryScanner::filterChunk(const uint8_t* current, const uint8_t* previous, uint32_t numElements) {
+	switch(type) {
+	case MemoryRegionTypes::Bit8:
+		if(isUnsigned) {
+			filterTyped<uint8_t>(current, previous, numElements, scanType, value, candidateWords);
+		} else {
+			filterTyped<int8_t>(current, previous, numElements, scanType, value, candidateWords);
+		}
+		break;
+	case MemoryRegionTypes::Bit16:
+		if(isUnsigned) {
+			filterTyped<uint16_t>(current, previous, numElements, scanType, value, candidateWords);
+		} else {
+			filterTyped<int16_t>(current, previous, numElements, scanType, value, candidateWords);
+		}
+		break;
+	case MemoryRegionTypes::Bit32:
+		if(isUnsigned) {
+			filterTyped<uint32_t>(current, previous, numElements, scanType, value, candidateWords);
+		} else {
+			filterTyped<int32_t>(current, previous, numElements, scanType, value, candidateWords);
+		}
+		break;
+	case MemoryRegionTypes::Bit64:
+		if(isUnsigned) {
+			filterTyped<uint64_t>(current, previous, numElements, scanType, value, candidateWords);
+		} else {
+			filterTyped<int64_t>(current, previous, numElements, scanType, value, candidateWords);
+		}
+		break;
+	case MemoryRegionTypes::Float:
+		filterTyped<float>(current, previous, numElements, scanType, value, candidateWords);
+		break;
+	case MemoryRegionTypes::Double:
+		filterTyped<double>(current, previous, numElements, scanType, value, candidateWords);
+		break;
+	case MemoryRegionTypes::Bool:
+		filterTyped<uint8_t>(current, previous, numElements, scanType, value, candidateWords);
+		break;
+	case MemoryRegionTypes::CharPointer:
+	case MemoryRegionTypes::ByteArray:
+		filterBytes(current, previous, numElements, scanType, value, candidateWords);
+		break;
+	default:
+		break;
+	}
+}
+
+void MemoryScanner::addChunk(uint64_t addr, const uint8_t* data, uint32_t size) {
+	if(!scanInProgress) {
+		return;
+	}
+
+	bytesScanned += size;
+
+	uint32_t numElements = getNumElements(size);
+	if(numElements == 0) {
+		return;
+	}
+
+	const uint8_t* previous = NULL;
+
+	if(isFirstScan) {
+		MemoryScanCandidates all;
+		all.setFull(numElements);
+		all.getWords(candidateWords);
+	} else {
+		auto chunk = chunks.find(addr);
+		if(chunk == chunks.end() || chunk->second.size != size) {
+			// Had no candidates last time, so it can't have any now
+			return;
+		}
+		chunk->second.candidates.getWords(candidateWords);
+		previous = (const uint8_t*)previousSnapshot.data() + chunk->second.snapshotOffset;
+	}
+
+	// An unknown initial value keeps everything
+	if(!isFirstScan || scanType == MemoryScanType::EXACT) {
+		filterChunk(data, previous, numElements);
+	}
+
+	MemoryScanChunk newChunk;
+	newChunk.addr = addr;
+	newChunk.size = size;
+	newChunk.candidates.setFromWords(candidateWords, numElements);
+
+	if(newChunk.candidates.count() != 0) {
+		if(snapshotWriteFailed || fwrite(data, size, 1, newSnapshot) != 1) {
+			snapshotWriteFailed = true;
+			return;
+		}
+
+		newChunk.snapshotOffset = newSnapshotSize;
+		newSnapshotSize += size;
+
+		newChunks.emplace(addr, std::move(newChunk));
+	}
+}
+
+bool MemoryScanner::endScan() {
+	if(!scanInProgress) {
+		return false;
+	}
+
+	if(fclose(newSnapshot) != 0) {
+		snapshotWriteFailed = true;
+	}
+	newSnapshot = NULL;
+
+	if(snapshotWriteFailed) {
+		lastError = "The memory snapshot file could not be written";
+		// The old results would be compared against a snapshot that no longer matches them
+		reset();
+		return false;
+	}
+
+	previousSnapshot.unmap();
+	chunks          = std::move(newChunks);
+	currentSnapshot = !currentSnapshot;
+
+	if(newSnapshotSize != 0) {
+		previousSnapshot = mio::make_mmap_source(getSnapshotPath(currentSnapshot), 0, mio::map_entire_file, errorCode);
+		if(errorCode || previousSnapshot.size() < newSnapshotSize) {
+			lastError = errorCode ? "The memory snapshot file could not be mapped: " + errorCode.message() : "The memory snapshot file is shorter than the scan";
+			reset();
+			return false;
+		}
+	}
+
+	newChunks.clear();
+	isFirstScan    = false;
+	scanInProgress = false;
+	return true;
+}
+
+void MemoryScanner::abortScan() {
+	if(!scanInProgress) {
+		return;
+	}
+
+	// Only the unmapped snapshot was being written, the mapped one is untouched
+	fclose(newSnapshot);
+	newSnapshot = NULL;
+
+	newChunks.clear();
+	scanInProgress = false;
+}
+
+void MemoryScanner::scanDumpFile(std::string path, uint64_t baseAddr) {
+	FILE* dump = fopen(path.c_str(), "rb");
+	if(dump != NULL) {
+		std::vector<uint8_t> buf(MEMORY_SNAPSHOT_CHUNK_SIZE);
+		uint64_t offset = 0;
+		while(true) {
+			std::size_t bytesRead = fread(buf.data(), 1, buf.size(), dump);
+			if(bytesRead == 0) {
+				break;
+			}
+			addChunk(baseAddr + offset, buf.data(), bytesRead);
+			offset += bytesRead;
+		}
+		fclose(dump);
+	}
+}
+
+void MemoryScanner::reset() {
+	if(newSnapshot != NULL) {
+		fclose(newSnapshot);
+		newSnapshot = NULL;
+	}
+
+	previousSnapshot.unmap();
+	chunks.clear();
+	newChunks.clear();
+	isFirstScan    = true;
+	scanInProgress = false;
+}
+
+uint64_t MemoryScanner::getNumCandidates() const {
+	uint64_t total = 0;
+	for(auto const& chunk : chunks) {
+		total += chunk.second.candidates.count();
+	}
+	return total;
+}
+
+uint64_t MemoryScanner::getCandidateMemoryUsage() const {
+	uint64_t total = 0;
+	for(auto const& chunk : chunks) {
+		total += sizeof(MemoryScanChunk) + chunk.second.candidates.getMemoryUsage();
+	}
+	return total;
+}
+
+std::vector<MemoryScanResult> MemoryScanner::getResults(std::size_t maxResults) {
+	std::vector<MemoryScanResult> results;
+
+	uint32_t step      = getStep();
+	uint32_t valueSize = (type == MemoryRegionTypes::CharPointer || type == MemoryRegionTypes::ByteArray) ? value.size() : step;
+
+	for(auto const& chunk : chunks) {
+		if(results.size() == maxResults) {
+			break;
+		}
+
+		const uint8_t* snapshot = (const uint8_t*)previousSnapshot.data() + chunk.second.snapshotOffset;
+		chunk.second.candidates.forEach([&](uint32_t i) {
+			MemoryScanResult result;
+			result.addr = chunk.second.addr + (uint64_t)i * step;
+			result.value.assign(snapshot + i * step, snapshot + i * step + valueSize);
+			results.push_back(result);
+			return results.size() != maxResults;
+		});
+	}
+
+	return results;
+}
+
+MemoryScanner::~MemoryScanner() {
+	if(newSnapshot != NULL) {
+		fclose(newSnapshot);
+	}
+}
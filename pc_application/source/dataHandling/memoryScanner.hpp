@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mio.hpp>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "../sharedNetworkCode/networkingStructures.hpp"
+
+// Cheat Engine style value scanner
+// Snapshots of the game's writable memory come in one chunk at a time, every
+// scan compares the new chunk against the previous snapshot and drops the
+// addresses that don't match anymore
+// Only depends on the standard library and mio, so it can be run against memory dumps on any PC
+
+enum MemoryScanType : uint8_t {
+	EXACT,
+	CHANGED,
+	UNCHANGED,
+	INCREASED,
+	DECREASED,
+	NUM_OF_SCAN_TYPES,
+};
+
+// Compressed bitset of the candidates in one chunk, like a single roaring bitmap container
+// Chunks with no candidates are dropped entirely, so memory only grows with the results
+class MemoryScanCandidates {
+public:
+	enum ContainerType : uint8_t {
+		FULL,
+		SPARSE,
+		DENSE,
+	};
+
+private:
+	ContainerType type   = FULL;
+	uint32_t numElements = 0;
+	uint32_t numSet      = 0;
+
+	// Indexes of the candidates, chunks are never bigger than 0x10000 elements
+	std::vector<uint16_t> sparse;
+	std::vector<uint64_t> dense;
+
+public:
+	void setFull(uint32_t elements);
+	// Chooses the smallest representation
+	void setFromWords(const std::vector<uint64_t>& words, uint32_t elements);
+	void getWords(std::vector<uint64_t>& words) const;
+
+	uint32_t count() const {
+		return numSet;
+	}
+
+	ContainerType getType() const {
+		return type;
+	}
+
+	std::size_t getMemoryUsage() const {
+		return sparse.capacity() * sizeof(uint16_t) + dense.capacity() * sizeof(uint64_t);
+	}
+
+	template <typename Callback> void forEach(Callback callback) const {
+		switch(type) {
+		case FULL:
+			for(uint32_t i = 0; i < numElements; i++) {
+				if(!callback(i)) {
+					return;
+				}
+			}
+			break;
+		case SPARSE:
+			for(uint16_t i : sparse) {
+				if(!callback(i)) {
+					return;
+				}
+			}
+			break;
+		case DENSE:
+			for(uint32_t word = 0; word < dense.size(); word++) {
+				uint64_t bits = dense[word];
+				while(bits != 0) {
+					if(!callback(word * 64 + __builtin_ctzll(bits))) {
+						return;
+					}
+					bits &= bits - 1;
+				}
+			}
+			break;
+		}
+	}
+};
+
+struct MemoryScanChunk {
+	uint64_t addr;
+	uint32_t size;
+	// Where this chunk lives in the snapshot file
+	uint64_t snapshotOffset;
+	MemoryScanCandidates candidates;
+};
+
+struct MemoryScanResult {
+	uint64_t addr;
+	std::vector<uint8_t> value;
+};
+
+class MemoryScanner {
+private:
+	std::error_code errorCode;
+
+	std::string snapshotDir;
+
+	MemoryRegionTypes type;
+	uint8_t isUnsigned;
+	MemoryScanType scanType;
+	std::vector<uint8_t> value;
+
+	uint8_t isFirstScan    = true;
+	uint8_t scanInProgress = false;
+
+	// Chunks of the last finished scan, sorted by address
+	std::map<uint64_t, MemoryScanChunk> chunks;
+	std::map<uint64_t, MemoryScanChunk> newChunks;
+
+	// Two snapshot files are alternated, the last one is mapped while the next one is written
+	uint8_t currentSnapshot = 0;
+	mio::mmap_source previousSnapshot;
+	FILE* newSnapshot        = NULL;
+	uint64_t newSnapshotSize = 0;
+	// A short write leaves offsets past the end of the file, so the scan can't be used
+	uint8_t snapshotWriteFailed = false;
+
+	std::string lastError;
+
+	// Reused for every chunk
+	std::vector<uint64_t> candidateWords;
+
+	uint64_t bytesScanned = 0;
+
+	std::string getSnapshotPath(uint8_t index) {
+		return snapshotDir + "/snapshot_" + std::to_string(index) + ".bin";
+	}
+
+	uint32_t getStep() const;
+	uint32_t getNumElements(uint32_t size) const;
+
+	void filterChunk(const uint8_t* current, const uint8_t* previous, uint32_t numElements);
+
+public:
+	MemoryScanner(std::string dir);
+
+	// The first scan, or any scan with a different type, starts from every address
+	// Anything but an exact first scan is an unknown initial value scan
+	// False if the snapshot file can't be written
+	bool startScan(MemoryRegionTypes valueType, uint8_t valueIsUnsigned, MemoryScanType scan, std::vector<uint8_t> exactValue);
+	// Chunks have to use the same addresses every scan, the switch always sends the same ones
+	void addChunk(uint64_t addr, const uint8_t* data, uint32_t size);
+	// False if the snapshot couldn't be written or mapped, the scanner starts over from a first scan then
+	bool endScan();
+	// The last finished scan stays as it was, a partial one would drop every candidate it didn't see
+	void abortScan();
+
+	// Raw dumps of memory, read in the same chunks the switch would send
+	void scanDumpFile(std::string path, uint64_t baseAddr);
+
+	void reset();
+
+	uint8_t isScanning() const {
+		return scanInProgress;
+	}
+
+	uint8_t hasResults() const {
+		return !isFirstScan;
+	}
+
+	uint64_t getNumCandidates() const;
+	uint64_t getCandidateMemoryUsage() const;
+	uint64_t getBytesScanned() const {
+		return bytesScanned;
+	}
+
+	std::string getError() const {
+		return lastError;
+	}
+
+	// Values are read from the latest snapshot
+	std::vector<MemoryScanResult> getResults(std::size_t maxResults);
+
+	static uint32_t getTypeSize(MemoryRegionTypes valueType);
+
+	~MemoryScanner();
+};
@@ -0,0 +1,450 @@
+#include "memoryTrace.hpp"
+
+static const char MEMORY_TRACE_MAGIC[8] = { 'S', 'W', 'T', 'R', 'A', 'C', 'E', '1' };
+
+// Runs reserved when a column is created, doubles when it fills up
+static const uint64_t INITIAL_NUM_RUNS   = 1024;
+static const uint64_t INITIAL_BLOB_SIZE  = 4096;
+static const std::size_t CSV_WRITE_CHUNK = 1024 * 1024;
+
+static std::string csvEscape(const std::string& field) {
+	if(field.find_first_of(",\"\n") == std::string::npos) {
+		return field;
+	}
+
+	std::string escaped = "\"";
+	for(char c : field) {
+		if(c == '"') {
+			escaped += '"';
+		}
+		escaped += c;
+	}
+	escaped += '"';
+	return escaped;
+}
+
+MemoryTraceColumn::MemoryTraceColumn(wxFileName file, MemoryRegionTypes type, uint8_t isUnsigned, uint32_t valueSize) {
+	runsFile = file;
+	runsFile.SetExt("trace");
+	blobFile = file;
+	blobFile.SetExt("blob");
+
+	if(runsFile.FileExists()) {
+		runsCapacity = runsFile.GetSize().GetValue();
+	}
+
+	if(!mapFile(runsMap, runsFile, runsCapacity, std::max(runsCapacity, (uint64_t)(sizeof(MemoryTraceHeader) + sizeof(MemoryTraceRun) * INITIAL_NUM_RUNS)))) {
+		return;
+	}
+
+	MemoryTraceHeader* header = getHeader();
+	if(memcmp(header->magic, MEMORY_TRACE_MAGIC, sizeof(MEMORY_TRACE_MAGIC)) != 0 || header->type != type || header->isUnsigned != isUnsigned || header->valueSize != valueSize) {
+		// New column or the watch was changed, start over
+		memcpy(header->magic, MEMORY_TRACE_MAGIC, sizeof(MEMORY_TRACE_MAGIC));
+		header->type       = type;
+		header->isUnsigned = isUnsigned;
+		header->padding    = 0;
+		header->valueSize  = valueSize;
+		header->numRuns    = 0;
+		header->blobSize   = 0;
+	}
+
+	if(usesBlob()) {
+		if(blobFile.FileExists()) {
+			blobCapacity = blobFile.GetSize().GetValue();
+		}
+
+		if(!mapFile(blobMap, blobFile, blobCapacity, std::max(blobCapacity, INITIAL_BLOB_SIZE))) {
+			runsMap.unmap();
+			return;
+		}
+	}
+
+	mapped = true;
+}
+
+bool MemoryTraceColumn::mapFile(mio::mmap_sink& map, wxFileName& file, uint64_t& capacity, uint64_t newCapacity) {
+	if(map.is_mapped()) {
+		map.sync(errorCode);
+		map.unmap();
+	}
+
+	if(newCapacity > capacity || !file.FileExists()) {
+		wxFile theFile;
+		if(file.FileExists()) {
+			theFile.Open(file.GetFullPath(), wxFile::read_write);
+		} else {
+			// Allow reading and writing by all users
+			theFile.Create(file.GetFullPath(), true, wxS_DEFAULT);
+		}
+		// Sparse file, same as the memory sections
+		theFile.Seek(newCapacity - 1);
+		theFile.Write("", 1);
+		theFile.Close();
+
+		capacity = newCapacity;
+	}
+
+	map = mio::make_mmap_sink(file.GetFullPath().ToStdString(), 0, mio::map_entire_file, errorCode);
+	if(errorCode) {
+		wxLogMessage("Memory trace %s could not be mapped: %s", file.GetFullPath(), errorCode.message());
+		mapped = false;
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t MemoryTraceColumn::valueToBits(const std::vector<uint8_t>& bytes) const {
+	// The switch is little endian, like every PC this runs on
+	uint64_t bits = 0;
+	memcpy(&bits, bytes.data(), std::min(bytes.size(), sizeof(uint64_t)));
+	return bits;
+}
+
+uint64_t MemoryTraceColumn::maskValueBits(uint64_t bits) const {
+	// Wrap around like the value in the game would
+	uint32_t valueSize = getHeader()->valueSize;
+	if(valueSize < sizeof(uint64_t)) {
+		bits &= ((uint64_t)1 << (valueSize * 8)) - 1;
+	}
+	return bits;
+}
+
+uint64_t MemoryTraceColumn::getValueBitsInRun(const MemoryTraceRun& run, FrameNum frame) const {
+	return maskValueBits(run.base + run.delta * (uint64_t)(frame - run.startFrame));
+}
+
+uint8_t MemoryTraceColumn::runMatches(const MemoryTraceRun& run, FrameNum frame, const std::vector<uint8_t>& bytes) const {
+	if(usesBlob()) {
+		return run.delta == bytes.size() && memcmp(blobMap.data() + run.base, bytes.data(), bytes.size()) == 0;
+	} else {
+		return getValueBitsInRun(run, frame) == maskValueBits(valueToBits(bytes));
+	}
+}
+
+void MemoryTraceColumn::truncate(FrameNum frame) {
+	MemoryTraceHeader* header = getHeader();
+	MemoryTraceRun* runs      = getRuns();
+
+	// First run that ends after this frame
+	MemoryTraceRun* firstAffected = std::upper_bound(runs, runs + header->numRuns, frame, [](FrameNum f, const MemoryTraceRun& run) {
+		return f < run.startFrame + run.numFrames;
+	});
+
+	if(firstAffected == runs + header->numRuns) {
+		return;
+	}
+
+	MemoryTraceRun* firstRemoved = firstAffected;
+	if(firstAffected->startFrame < frame) {
+		// Keep the frames before this one
+		firstAffected->numFrames = frame - firstAffected->startFrame;
+		firstRemoved++;
+	}
+
+	if(usesBlob() && firstRemoved != runs + header->numRuns) {
+		// Blob is appended in order, so everything past this run is unused
+		header->blobSize = firstRemoved->base;
+	}
+
+	header->numRuns = firstRemoved - runs;
+}
+
+void MemoryTraceColumn::addValue(FrameNum frame, const std::vector<uint8_t>& bytes) {
+	if(!mapped) {
+		return;
+	}
+
+	if(getHeader()->numRuns != 0 && frame < getEndFrame()) {
+		truncate(frame);
+	}
+
+	MemoryTraceHeader* header = getHeader();
+
+	if(header->numRuns != 0) {
+		MemoryTraceRun& lastRun = getRuns()[header->numRuns - 1];
+		if(lastRun.startFrame + lastRun.numFrames == frame) {
+			if(runMatches(lastRun, frame, bytes)) {
+				lastRun.numFrames++;
+				return;
+			}
+
+			if(lastRun.numFrames == 1 && usesDelta()) {
+				// The second value decides how fast the run changes
+				lastRun.delta = valueToBits(bytes) - lastRun.base;
+				lastRun.numFrames++;
+				return;
+			}
+		}
+	}
+
+	if(sizeof(MemoryTraceHeader) + sizeof(MemoryTraceRun) * (header->numRuns + 1) > runsCapacity) {
+		if(!mapFile(runsMap, runsFile, runsCapacity, runsCapacity * 2)) {
+			return;
+		}
+		header = getHeader();
+	}
+
+	MemoryTraceRun run;
+	run.startFrame = frame;
+	run.numFrames  = 1;
+
+	if(usesBlob()) {
+		if(header->blobSize + bytes.size() > blobCapacity) {
+			if(!mapFile(blobMap, blobFile, blobCapacity, std::max(blobCapacity * 2, (uint64_t)(header->blobSize + bytes.size())))) {
+				return;
+			}
+		}
+
+		memcpy(blobMap.data() + header->blobSize, bytes.data(), bytes.size());
+		run.base  = header->blobSize;
+		run.delta = bytes.size();
+		header->blobSize += bytes.size();
+	} else {
+		run.base  = maskValueBits(valueToBits(bytes));
+		run.delta = 0;
+	}
+
+	getRuns()[header->numRuns] = run;
+	header->numRuns++;
+}
+
+bool MemoryTraceColumn::getValue(FrameNum frame, std::vector<uint8_t>& bytes) const {
+	if(!mapped) {
+		return false;
+	}
+
+	const MemoryTraceRun* runs = getRuns();
+	uint64_t numRuns           = getHeader()->numRuns;
+
+	// Last run starting at or before this frame
+	const MemoryTraceRun* run = std::upper_bound(runs, runs + numRuns, frame, [](FrameNum f, const MemoryTraceRun& run) {
+		return f < run.startFrame;
+	});
+
+	if(run == runs) {
+		return false;
+	}
+
+	run--;
+	if(frame >= run->startFrame + run->numFrames) {
+		// Gap in the recording
+		return false;
+	}
+
+	if(usesBlob()) {
+		bytes.assign(blobMap.data() + run->base, blobMap.data() + run->base + run->delta);
+	} else {
+		uint64_t bits      = getValueBitsInRun(*run, frame);
+		uint32_t valueSize = std::min(getHeader()->valueSize, (uint32_t)sizeof(uint64_t));
+		bytes.resize(valueSize);
+		memcpy(bytes.data(), &bits, valueSize);
+	}
+
+	return true;
+}
+
+std::string MemoryTraceColumn::getValueString(FrameNum frame) const {
+	std::vector<uint8_t> bytes;
+	if(!getValue(frame, bytes)) {
+		return "";
+	}
+
+	return valueToString((MemoryRegionTypes)getHeader()->type, getHeader()->isUnsigned, bytes);
+}
+
+std::string MemoryTraceColumn::valueToString(MemoryRegionTypes type, uint8_t isUnsigned, const std::vector<uint8_t>& bytes) {
+	// Same formatting the switch uses for its string representation
+	switch(type) {
+	case MemoryRegionTypes::Bit8:
+		return isUnsigned ? std::to_string(*(uint8_t*)bytes.data()) : std::to_string(*(int8_t*)bytes.data());
+	case MemoryRegionTypes::Bit16:
+		return isUnsigned ? std::to_string(*(uint16_t*)bytes.data()) : std::to_string(*(int16_t*)bytes.data());
+	case MemoryRegionTypes::Bit32:
+		return isUnsigned ? std::to_string(*(uint32_t*)bytes.data()) : std::to_string(*(int32_t*)bytes.data());
+	case MemoryRegionTypes::Bit64:
+		return isUnsigned ? std::to_string(*(uint64_t*)bytes.data()) : std::to_string(*(int64_t*)bytes.data());
+	case MemoryRegionTypes::Float:
+		return std::to_string(*(float*)bytes.data());
+	case MemoryRegionTypes::Double:
+		return std::to_string(*(double*)bytes.data());
+	case MemoryRegionTypes::Bool:
+		return *(bool*)bytes.data() ? "1" : "0";
+	case MemoryRegionTypes::CharPointer:
+		return std::string((const char*)bytes.data(), bytes.size());
+	case MemoryRegionTypes::ByteArray: {
+		std::string hex;
+		char byteHex[3];
+		for(uint8_t byte : bytes) {
+			snprintf(byteHex, sizeof(byteHex), "%02X", byte);
+			hex += byteHex;
+		}
+		return hex;
+	}
+	default:
+		return "";
+	}
+}
+
+FrameNum MemoryTraceColumn::getFirstFrame() const {
+	if(getNumRuns() == 0) {
+		return 0;
+	}
+	return getRuns()[0].startFrame;
+}
+
+FrameNum MemoryTraceColumn::getEndFrame() const {
+	uint64_t numRuns = getNumRuns();
+	if(numRuns == 0) {
+		return 0;
+	}
+	const MemoryTraceRun& lastRun = getRuns()[numRuns - 1];
+	return lastRun.startFrame + lastRun.numFrames;
+}
+
+void MemoryTraceColumn::clear() {
+	if(!mapped) {
+		return;
+	}
+	getHeader()->numRuns  = 0;
+	getHeader()->blobSize = 0;
+}
+
+void MemoryTraceColumn::sync() {
+	if(!mapped) {
+		return;
+	}
+	runsMap.sync(errorCode);
+	if(blobMap.is_mapped()) {
+		blobMap.sync(errorCode);
+	}
+}
+
+MemoryTrace::MemoryTrace(wxFileName projectStart) {
+	traceDir = projectStart;
+	traceDir.AppendDir("memoryTrace");
+	// Create dir if needed
+	traceDir.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+}
+
+wxFileName MemoryTrace::getColumnFile(std::size_t index, BranchNum branch) {
+	wxFileName columnFile = traceDir;
+	if(branch == 0) {
+		// Main branch keeps the plain name
+		columnFile.SetName(wxString::Format("watch_%zu", index));
+	} else {
+		columnFile.SetName(wxString::Format("watch_%zu_branch_%u", index, branch));
+	}
+	return columnFile;
+}
+
+void MemoryTrace::addColumn(wxString name, MemoryRegionTypes type, uint8_t isUnsigned, uint32_t valueSize) {
+	Watch watch;
+	watch.name       = name;
+	watch.type       = type;
+	watch.isUnsigned = isUnsigned;
+	watch.valueSize  = valueSize;
+	watches.push_back(watch);
+}
+
+void MemoryTrace::clearColumns() {
+	// The files stay around, they are reused if the same watches are added again
+	sync();
+	watches.clear();
+}
+
+std::shared_ptr<MemoryTraceColumn> MemoryTrace::getColumn(uint16_t index, BranchNum branch, bool create) {
+	if(index >= watches.size()) {
+		return nullptr;
+	}
+
+	Watch& watch = watches[index];
+	auto column  = watch.branches.find(branch);
+	if(column != watch.branches.end()) {
+		return column->second;
+	}
+
+	wxFileName columnFile = getColumnFile(index, branch);
+	wxFileName runsFile   = columnFile;
+	runsFile.SetExt("trace");
+	if(!create && !runsFile.FileExists()) {
+		return nullptr;
+	}
+
+	std::shared_ptr<MemoryTraceColumn> newColumn = std::make_shared<MemoryTraceColumn>(columnFile, watch.type, watch.isUnsigned, watch.valueSize);
+	if(!newColumn->isMapped()) {
+		return nullptr;
+	}
+
+	watch.branches[branch] = newColumn;
+	return newColumn;
+}
+
+void MemoryTrace::recordValue(uint16_t index, BranchNum branch, FrameNum frame, const std::vector<uint8_t>& bytes) {
+	std::shared_ptr<MemoryTraceColumn> column = getColumn(index, branch, true);
+	if(column) {
+		column->addValue(frame, bytes);
+	}
+}
+
+void MemoryTrace::exportToCsv(wxString path, BranchNum branch) {
+	wxFile file(path, wxFile::write);
+
+	if(file.IsOpened()) {
+		std::string buffer = "frame";
+		std::vector<std::shared_ptr<MemoryTraceColumn>> columns;
+		for(uint16_t i = 0; i < watches.size(); i++) {
+			buffer += ',';
+			buffer += csvEscape(watches[i].name.ToStdString());
+			columns.push_back(getColumn(i, branch));
+		}
+		buffer += '\n';
+
+		// Only export frames that any column has recorded
+		FrameNum firstFrame = UINT32_MAX;
+		FrameNum endFrame   = 0;
+		for(auto const& column : columns) {
+			if(column && column->getNumRuns() != 0) {
+				firstFrame = std::min(firstFrame, column->getFirstFrame());
+				endFrame   = std::max(endFrame, column->getEndFrame());
+			}
+		}
+
+		std::string row;
+		for(FrameNum frame = firstFrame; frame < endFrame; frame++) {
+			row = std::to_string(frame);
+
+			bool anyRecorded = false;
+			for(auto const& column : columns) {
+				std::string value = column ? column->getValueString(frame) : "";
+				if(!value.empty()) {
+					anyRecorded = true;
+				}
+				row += ',';
+				row += csvEscape(value);
+			}
+
+			if(anyRecorded) {
+				buffer += row;
+				buffer += '\n';
+			}
+
+			if(buffer.size() > CSV_WRITE_CHUNK) {
+				file.Write(buffer.data(), buffer.size());
+				buffer.clear();
+			}
+		}
+
+		file.Write(buffer.data(), buffer.size());
+		file.Close();
+	}
+}
+
+void MemoryTrace::sync() {
+	for(auto const& watch : watches) {
+		for(auto const& column : watch.branches) {
+			column.second->sync();
+		}
+	}
+}
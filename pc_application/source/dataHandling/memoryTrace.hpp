@@ -0,0 +1,170 @@
+#pragma once
+
+#define wxHAS_HUGE_FILES
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mio.hpp>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/string.h>
+
+#include "../sharedNetworkCode/networkingStructures.hpp"
+#include "buttonConstants.hpp"
+
+// Every watch gets its own column file in the project folder, so a trace of
+// 100k frames can be graphed without re-running the game
+// The column is a sorted array of runs, each run covers a range of frames and
+// describes every value in it as base + delta * (frame - startFrame)
+// Constant values are plain RLE (delta is 0), counters and positions moving at
+// a constant speed collapse into one run too
+// The runs are sorted by frame, so they double as the frame index
+// Every branch gets its own column, frames on different branches are different values
+
+// On disk, mapped with mio
+struct MemoryTraceHeader {
+	char magic[8];
+	uint8_t type;
+	uint8_t isUnsigned;
+	uint16_t padding;
+	uint32_t valueSize;
+	uint64_t numRuns;
+	// Only used by strings and byte arrays, stored in the blob file
+	uint64_t blobSize;
+};
+
+struct MemoryTraceRun {
+	FrameNum startFrame;
+	FrameNum numFrames;
+	// Raw bits of the value, or the offset into the blob for strings and byte arrays
+	uint64_t base;
+	// Added every frame, or the size in the blob for strings and byte arrays
+	uint64_t delta;
+};
+
+class MemoryTraceColumn {
+private:
+	std::error_code errorCode;
+
+	wxFileName runsFile;
+	wxFileName blobFile;
+
+	mio::mmap_sink runsMap;
+	mio::mmap_sink blobMap;
+
+	// Capacities of the files, not how much is used
+	uint64_t runsCapacity = 0;
+	uint64_t blobCapacity = 0;
+
+	// False if a file couldn't be mapped, nothing is recorded or read then
+	bool mapped = false;
+
+	MemoryTraceHeader* getHeader() {
+		return (MemoryTraceHeader*)runsMap.data();
+	}
+
+	const MemoryTraceHeader* getHeader() const {
+		return (const MemoryTraceHeader*)runsMap.data();
+	}
+
+	MemoryTraceRun* getRuns() {
+		return (MemoryTraceRun*)(runsMap.data() + sizeof(MemoryTraceHeader));
+	}
+
+	const MemoryTraceRun* getRuns() const {
+		return (const MemoryTraceRun*)(runsMap.data() + sizeof(MemoryTraceHeader));
+	}
+
+	uint8_t usesBlob() const {
+		return getHeader()->type == MemoryRegionTypes::CharPointer || getHeader()->type == MemoryRegionTypes::ByteArray;
+	}
+
+	uint8_t usesDelta() const {
+		MemoryRegionTypes type = (MemoryRegionTypes)getHeader()->type;
+		return type == MemoryRegionTypes::Bit8 || type == MemoryRegionTypes::Bit16 || type == MemoryRegionTypes::Bit32 || type == MemoryRegionTypes::Bit64;
+	}
+
+	bool mapFile(mio::mmap_sink& map, wxFileName& file, uint64_t& capacity, uint64_t newCapacity);
+
+	uint64_t valueToBits(const std::vector<uint8_t>& bytes) const;
+	uint64_t maskValueBits(uint64_t bits) const;
+	uint64_t getValueBitsInRun(const MemoryTraceRun& run, FrameNum frame) const;
+	uint8_t runMatches(const MemoryTraceRun& run, FrameNum frame, const std::vector<uint8_t>& bytes) const;
+
+	// Rerecording a frame throws away it and everything after it, like invalidateRun
+	void truncate(FrameNum frame);
+
+public:
+	// Opens the existing column if the type matches, otherwise starts a new one
+	MemoryTraceColumn(wxFileName file, MemoryRegionTypes type, uint8_t isUnsigned, uint32_t valueSize);
+
+	void addValue(FrameNum frame, const std::vector<uint8_t>& bytes);
+
+	// Binary search through the runs, returns false if the frame was never recorded
+	bool getValue(FrameNum frame, std::vector<uint8_t>& bytes) const;
+	std::string getValueString(FrameNum frame) const;
+	static std::string valueToString(MemoryRegionTypes type, uint8_t isUnsigned, const std::vector<uint8_t>& bytes);
+
+	// Exclusive end
+	FrameNum getFirstFrame() const;
+	FrameNum getEndFrame() const;
+	uint64_t getNumRuns() const {
+		return mapped ? getHeader()->numRuns : 0;
+	}
+
+	bool isMapped() const {
+		return mapped;
+	}
+
+	void clear();
+	void sync();
+};
+
+class MemoryTrace {
+private:
+	struct Watch {
+		wxString name;
+		MemoryRegionTypes type;
+		uint8_t isUnsigned;
+		uint32_t valueSize;
+		// Opened the first time a branch is recorded or read
+		std::unordered_map<BranchNum, std::shared_ptr<MemoryTraceColumn>> branches;
+	};
+
+	wxFileName traceDir;
+
+	std::vector<Watch> watches;
+
+	wxFileName getColumnFile(std::size_t index, BranchNum branch);
+
+public:
+	MemoryTrace(wxFileName projectStart);
+
+	// Index matches the index of the memory region on the switch
+	void addColumn(wxString name, MemoryRegionTypes type, uint8_t isUnsigned, uint32_t valueSize);
+	void clearColumns();
+
+	void recordValue(uint16_t index, BranchNum branch, FrameNum frame, const std::vector<uint8_t>& bytes);
+
+	// Null if this branch never recorded this watch
+	std::shared_ptr<MemoryTraceColumn> getColumn(uint16_t index, BranchNum branch, bool create = false);
+
+	std::size_t getNumColumns() {
+		return watches.size();
+	}
+
+	wxString getColumnName(uint16_t index) {
+		return watches[index].name;
+	}
+
+	// One row per frame, one column per watch, unrecorded values are left empty
+	void exportToCsv(wxString path, BranchNum branch);
+
+	void sync();
+};
@@ -68,6 +68,23 @@ void ProjectHandler::loadProject() {
 						uint8_t sizeOfControllerData = bufferPointer[sizeRead];
 						// Possibility that I will save filespace by making sizeOfControllerData==0 be an empty controller data
 						sizeRead += sizeof(sizeOfControllerData);
+
+						if(sizeOfControllerData == sharedFramesMarker) {
+							// Share the frames with the main branch again, it's always loaded first
+							uint32_t start;
+							uint32_t count;
+							memcpy(&start, &bufferPointer[sizeRead], sizeof(start));
+							memcpy(&count, &bufferPointer[sizeRead + sizeof(start)], sizeof(count));
+							sizeRead += sizeof(start) + sizeof(count);
+
+							if(!savestateHook->inputs.empty()) {
+								auto& mainBranch = *savestateHook->inputs[0];
+								for(uint32_t i = start; i < (uint64_t)start + count && i < mainBranch.size(); i++) {
+									inputs->push_back(mainBranch[i]);
+								}
+							}
+							continue;
+						}
 						// Load the data
 						std::shared_ptr<ControllerData> controllerData = std::make_shared<ControllerData>();
 
@@ -78,6 +95,17 @@ void ProjectHandler::loadProject() {
 					}
 
 					savestateHook->inputs.push_back(inputs);
+
+					// Older projects only have the ran bit on each frame, the run is always from the start
+					FrameNum ranFrames = 0;
+					if(branch.HasMember("ranFrames")) {
+						ranFrames = std::min<FrameNum>(branch["ranFrames"].GetUint(), inputs->size());
+					} else {
+						while(ranFrames < inputs->size() && (GET_BIT(inputs->at(ranFrames)->frameState, FrameState::RAN))) {
+							ranFrames++;
+						}
+					}
+					savestateHook->runWatermarks.push_back(ranFrames);
 				}
 			}
 
@@ -102,6 +130,18 @@ void ProjectHandler::loadProject() {
 	dataProcessing->sendPlayerNum();
 	dataProcessing->scrollToSpecific(jsonSettings["currentPlayer"].GetUint(), jsonSettings["currentSavestateBlock"].GetUint(), jsonSettings["currentBranch"].GetUint(), jsonSettings["currentFrame"].GetUint64());
 
+	// Older projects don't have one
+	wxFileName historyFilename = getProjectStart();
+	historyFilename.SetName("history");
+	historyFilename.SetExt("bin");
+	if(historyFilename.FileExists()) {
+		wxFFileInputStream historyFileStream(historyFilename.GetFullPath(), "rb");
+		wxZlibInputStream historyDecompressStream(historyFileStream, wxZLIB_ZLIB);
+		if(!dataProcessing->getEditHistory().load(historyDecompressStream)) {
+			wxLogMessage("Edit history could not be loaded, starting with an empty one");
+		}
+	}
+
 	imageExportIndex = jsonSettings["currentImageExportIndex"].GetUint();
 	rerecordCount    = jsonSettings["currentRerecordCount"].GetUint();
 
@@ -142,6 +182,15 @@ void ProjectHandler::saveProject() {
 			for(auto const& savestateHookBlock : savestateHookBlocks) {
 				rapidjson::Value branchesJSON(rapidjson::kArrayType);
 
+				// Forked branches point at the main branch's frames until edited, so those are saved only once
+				auto& mainBranch = *savestateHookBlock->inputs[0];
+				std::unordered_map<const ControllerData*, FrameNum> mainBranchFrames;
+				if(savestateHookBlock->inputs.size() > 1) {
+					for(FrameNum i = 0; i < mainBranch.size(); i++) {
+						mainBranchFrames[mainBranch[i].get()] = i;
+					}
+				}
+
 				BranchNum branchIndexNum = 0;
 				for(auto const& branch : savestateHookBlock->inputs) {
 					// Create path as "hooks/player_[num]/savestate_block_[num]/branch_[num]"
@@ -164,14 +213,32 @@ void ProjectHandler::saveProject() {
 					wxZlibOutputStream inputsCompressStream(inputsFileStream, compressionLevel, wxZLIB_ZLIB);
 
 					// Kinda annoying, but actually break up the vector and add each part with the size
-					for(auto const& controllerData : *branch) {
+					FrameNum frame = 0;
+					while(frame < branch->size()) {
+						auto shared = branchIndexNum != 0 ? mainBranchFrames.find(branch->at(frame).get()) : mainBranchFrames.end();
+						if(shared != mainBranchFrames.end()) {
+							// Write the whole run of frames still shared with the main branch as one entry
+							uint32_t start = shared->second;
+							uint32_t count = 1;
+							while(frame + count < branch->size() && start + count < mainBranch.size() && branch->at(frame + count) == mainBranch[start + count]) {
+								count++;
+							}
+
+							inputsCompressStream.WriteAll(&sharedFramesMarker, sizeof(sharedFramesMarker));
+							inputsCompressStream.WriteAll(&start, sizeof(start));
+							inputsCompressStream.WriteAll(&count, sizeof(count));
+							frame += count;
+							continue;
+						}
+
 						uint8_t* data;
 						uint32_t dataSize;
-						serializeProtocol.dataToBinary<ControllerData>(*controllerData, &data, &dataSize);
+						serializeProtocol.dataToBinary<ControllerData>(*branch->at(frame), &data, &dataSize);
 						uint8_t sizeToPrint = (uint8_t)dataSize;
 						// Probably endian issues
 						inputsCompressStream.WriteAll(&sizeToPrint, sizeof(sizeToPrint));
 						inputsCompressStream.WriteAll(data, dataSize);
+						frame++;
 					}
 
 					inputsCompressStream.Sync();
@@ -186,6 +253,7 @@ void ProjectHandler::saveProject() {
 					inputs.SetString(inputsPath.c_str(), inputsPath.size(), settingsJSON.GetAllocator());
 
 					branchJSON.AddMember("filename", inputs, settingsJSON.GetAllocator());
+					branchJSON.AddMember("ranFrames", dataProcessing->getRunWatermark(playerIndexNum, savestateHookIndexNum, branchIndexNum), settingsJSON.GetAllocator());
 
 					branchesJSON.PushBack(branchJSON, settingsJSON.GetAllocator());
 
@@ -241,6 +309,20 @@ void ProjectHandler::saveProject() {
 
 		settingsJSON.AddMember("players", playersJSON, settingsJSON.GetAllocator());
 
+		// Undo history, so edits can still be undone after reopening
+		wxFileName historyFilename = getProjectStart();
+		historyFilename.SetName("history");
+		historyFilename.SetExt("bin");
+
+		wxFFileOutputStream historyFileStream(historyFilename.GetFullPath(), "wb");
+		wxZlibOutputStream historyCompressStream(historyFileStream, compressionLevel, wxZLIB_ZLIB);
+		dataProcessing->getEditHistory().save(historyCompressStream);
+		historyCompressStream.Close();
+		historyFileStream.Close();
+
+		// Framebuffers are already on disk, this just flushes the archives
+		dataProcessing->syncFramebufferArchives();
+
 		rapidjson::Value lastPlayerIndex;
 		lastPlayerIndex.SetUint(dataProcessing->getCurrentPlayer());
 
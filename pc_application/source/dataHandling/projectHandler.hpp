@@ -80,6 +80,9 @@ private:
 	std::string lastEnteredFtpPath;
 
 	static constexpr int compressionLevel = 7;
+	// In place of the size of a frame in inputs.bin, followed by uint32_t start and count
+	// Those frames are the same ones as in the main branch, serialized frames are never this big
+	static constexpr uint8_t sharedFramesMarker = 0xFF;
 
 	// Main settings variable
 	rapidjson::Document* mainSettings;
@@ -103,6 +106,8 @@ public:
 	ADD_NETWORK_CALLBACK_MAP(RecieveApplicationConnected)
 	ADD_NETWORK_CALLBACK_MAP(RecieveLogging)
 	ADD_NETWORK_CALLBACK_MAP(RecieveMemoryRegion)
+	ADD_NETWORK_CALLBACK_MAP(RecieveMemorySnapshotChunk)
+	ADD_NETWORK_CALLBACK_MAP(RecieveHeapUsage)
 
 	void loadProject();
 	void saveProject();
@@ -19,6 +19,17 @@ TasRunner::TasRunner(wxFrame* parent, std::shared_ptr<CommunicateWithNetwork> ne
 	hookSelectionSizer->Add(firstSavestateHook, 0);
 	hookSelectionSizer->Add(lastSavestateHook, 0);
 
+	luaScriptPath       = new wxTextCtrl(this, wxID_ANY, wxEmptyString);
+	precompileLuaScript = new wxCheckBox(this, wxID_ANY, "Precompile Lua script");
+	streamInputs        = new wxCheckBox(this, wxID_ANY, "Stream inputs over the network");
+
+	luaScriptPath->SetHint("Lua script path on SD card");
+	luaScriptPath->SetToolTip("Lua script run alongside the TAS, leave empty to not use one");
+	precompileLuaScript->SetToolTip("Write the compiled bytecode next to the script, it can be shipped instead of the source");
+	streamInputs->SetToolTip("Send inputs as the TAS plays instead of uploading script files to the SD card, no FTP server needed");
+
+	streamInputs->SetValue(true);
+
 	startTasHomebrew = HELPERS::getBitmapButton(parent, mainSettings, "startTasHomebrewButton");
 	// startTasArduino  = HELPERS::getBitmapButton(parent, mainSettings, "startTasArduinoButton");
 
@@ -33,6 +44,9 @@ TasRunner::TasRunner(wxFrame* parent, std::shared_ptr<CommunicateWithNetwork> ne
 	stopTas->Bind(wxEVT_BUTTON, &TasRunner::onStopTasPressed, this);
 
 	mainSizer->Add(hookSelectionSizer, 1, wxEXPAND | wxALL);
+	mainSizer->Add(luaScriptPath, 0, wxEXPAND | wxALL);
+	mainSizer->Add(precompileLuaScript, 0, wxEXPAND | wxALL);
+	mainSizer->Add(streamInputs, 0, wxEXPAND | wxALL);
 	mainSizer->Add(startTasHomebrew, 1, wxEXPAND | wxALL);
 	// mainSizer->Add(startTasArduino, 1, wxEXPAND | wxALL);
 	mainSizer->Add(stopTas, 1, wxEXPAND | wxALL);
@@ -46,112 +60,340 @@ TasRunner::TasRunner(wxFrame* parent, std::shared_ptr<CommunicateWithNetwork> ne
 	Layout();
 }
 
-void TasRunner::onStartTasHomebrewPressed(wxCommandEvent& event) {
-	int firstHook = firstSavestateHook->GetValue();
-	int lastHook  = lastSavestateHook->GetValue();
-
-	if(lastHook < firstHook) {
-		wxMessageDialog invalidRangeMessage(this, "Invalid savestate hook range", "Invalid Range", wxOK | wxICON_ERROR);
-		invalidRangeMessage.ShowModal();
-	} else {
-		if(networkInstance->isConnected()) {
-			// Build a large binary blob with all the data
-			AllPlayers& allPlayers = dataProcessing->getAllPlayers();
-			// Create a different file for each player
-			std::vector<wxString> playerFiles;
-			uint8_t playerIndex = 1;
-			for(auto const& player : allPlayers) {
-				wxString tempPath = wxFileName::CreateTempFileName("script");
-				wxFFileOutputStream fileStream(tempPath, "wb");
-
-				for(SavestateBlockNum hook = firstHook; hook <= lastHook; hook++) {
-					// Always first branch
-					for(auto const& controllerData : *(player->at(hook)->inputs[0])) {
-						// Continually write the savestate hook data in one unbroken stream
-						uint8_t* data;
-						uint32_t dataSize;
-						serializeProtocol.dataToBinary<ControllerData>(*controllerData, &data, &dataSize);
-						uint8_t sizeToPrint = (uint8_t)dataSize;
-						// Probably endian issues
-						fileStream.WriteAll(&sizeToPrint, sizeof(sizeToPrint));
-						fileStream.WriteAll(data, dataSize);
-					}
-				}
+void TasRunner::serializePlayer(std::shared_ptr<std::vector<std::shared_ptr<SavestateHook>>> player, SavestateBlockNum firstHook, SavestateBlockNum lastHook, uint32_t numOfFrames, std::vector<std::vector<uint8_t>>& output, std::atomic<uint32_t>& chunksSerialized, std::atomic<uint64_t>& framesSerialized, const std::atomic_bool& cancel) {
+	// Each thread needs its own, it keeps a buffer around
+	SerializeProtocol serializeProtocol;
 
-				fileStream.Close();
+	uint32_t framesLeft    = numOfFrames;
+	uint32_t framesInChunk = 0;
 
-				playerFiles.push_back(tempPath);
-				playerIndex++;
+	for(SavestateBlockNum hook = firstHook; hook <= lastHook && framesLeft != 0; hook++) {
+		// Always first branch
+		for(auto const& controllerData : *(player->at(hook)->inputs[0])) {
+			if(cancel) {
+				return;
 			}
 
-			wxString address = wxString::FromUTF8(networkInstance->getSwitchIP());
+			// Continually write the savestate hook data in one unbroken stream
+			uint8_t* data;
+			uint32_t dataSize;
+			serializeProtocol.dataToBinary<ControllerData>(*controllerData, &data, &dataSize);
+			// Probably endian issues
+			std::vector<uint8_t>& chunk = output[chunksSerialized];
+			chunk.push_back((uint8_t)dataSize);
+			chunk.insert(chunk.end(), data, data + dataSize);
+			free(data);
 
-			std::vector<std::string> scriptPaths;
+			framesSerialized++;
+			framesInChunk++;
+			framesLeft--;
 
-			for(uint8_t currentWorkingPlayer = 0; currentWorkingPlayer < playerFiles.size(); currentWorkingPlayer++) {
-				wxString ftpPath = wxString::Format("/switas-script-temp-%d.txt", currentWorkingPlayer);
+			if(framesInChunk == FINAL_TAS_STREAM_CHUNK_FRAMES || framesLeft == 0) {
+				// The chunk can be sent once the count says it's done
+				chunksSerialized++;
+				framesInChunk = 0;
+			}
 
-				std::string output = HELPERS::exec(wxString::Format("curl -T %s -m 10 --connect-timeout 3 --verbose %s", playerFiles[currentWorkingPlayer], wxString::Format("ftp://%s%s", address, ftpPath)).c_str());
+			if(framesLeft == 0) {
+				break;
+			}
+		}
+	}
+}
 
-				if(output.find("is not recognized") != std::string::npos || output.find("command not found") != std::string::npos) {
-					wxMessageDialog errorDialog(this, "The Curl executable was not found, please install it to PATH right now", "Curl Not Found", wxOK | wxICON_ERROR);
-					errorDialog.ShowModal();
+void TasRunner::encodePlayer(std::shared_ptr<std::vector<std::shared_ptr<SavestateHook>>> player, SavestateBlockNum firstHook, SavestateBlockNum lastHook, uint32_t numOfFrames, std::vector<std::vector<uint8_t>>& output, std::atomic<uint32_t>& blocksEncoded, std::atomic<uint64_t>& framesSerialized, const std::atomic_bool& cancel) {
+	// Only one block of frames is kept around
+	std::vector<TasScriptFrame> frames;
+	frames.reserve(TAS_SCRIPT_FRAMES_PER_BLOCK);
+	uint32_t framesLeft = numOfFrames;
 
-					for(auto const& playerFile : playerFiles) {
-						wxRemoveFile(playerFile);
-					}
+	for(SavestateBlockNum hook = firstHook; hook <= lastHook && framesLeft != 0; hook++) {
+		// Always first branch
+		for(auto const& controllerData : *(player->at(hook)->inputs[0])) {
+			if(cancel) {
+				return;
+			}
 
-					return;
-				} else if(output.find("Closing connection 0") != std::string::npos) {
-					std::vector<std::string> lines = HELPERS::splitString(output, '\n');
+			frames.push_back(TasScriptFrame::fromControllerData(*controllerData));
+			framesSerialized++;
+			framesLeft--;
 
-					wxMessageDialog errorDialog(this, wxString::FromUTF8(lines[lines.size() - 1]), "Curl Error", wxOK | wxICON_ERROR);
-					errorDialog.ShowModal();
+			if(frames.size() == TAS_SCRIPT_FRAMES_PER_BLOCK || framesLeft == 0) {
+				// The uploader only reads this slot once the count says it's done
+				output[blocksEncoded] = TasScriptEncoder::encodeBlock(frames.data(), frames.size());
+				blocksEncoded++;
+				frames.clear();
+			}
 
-					for(auto const& playerFile : playerFiles) {
-						wxRemoveFile(playerFile);
-					}
+			if(framesLeft == 0) {
+				break;
+			}
+		}
+	}
+}
+
+void TasRunner::uploadFinalTas(int firstHook, int lastHook) {
+	AllPlayers& allPlayers = dataProcessing->getAllPlayers();
+	std::size_t numPlayers = allPlayers.size();
+
+	// Players play in lockstep, so the shortest one decides the length
+	uint32_t numOfFrames = numPlayers == 0 ? 0 : UINT32_MAX;
+	for(auto const& player : allPlayers) {
+		uint32_t playerFrames = 0;
+		for(SavestateBlockNum hook = firstHook; hook <= lastHook; hook++) {
+			playerFrames += player->at(hook)->inputs[0]->size();
+		}
+		numOfFrames = std::min(numOfFrames, playerFrames);
+	}
+	uint64_t totalFrames = (uint64_t)numOfFrames * numPlayers;
+	uint32_t numOfBlocks = (numOfFrames + TAS_SCRIPT_FRAMES_PER_BLOCK - 1) / TAS_SCRIPT_FRAMES_PER_BLOCK;
+
+	std::atomic_bool cancel(false);
+	std::atomic<uint64_t> framesSerialized(0);
+
+	// Every player is encoded on its own thread, blocks are freed as soon as they're sent
+	std::vector<std::vector<std::vector<uint8_t>>> playerBlocks(numPlayers, std::vector<std::vector<uint8_t>>(numOfBlocks));
+	std::vector<std::atomic<uint32_t>> blocksEncoded(numPlayers);
+	std::vector<std::future<void>> encoding;
+	for(std::size_t i = 0; i < numPlayers; i++) {
+		encoding.push_back(std::async(std::launch::async, &TasRunner::encodePlayer, allPlayers[i], (SavestateBlockNum)firstHook, (SavestateBlockNum)lastHook, numOfFrames, std::ref(playerBlocks[i]), std::ref(blocksEncoded[i]), std::ref(framesSerialized), std::cref(cancel)));
+	}
 
-					return;
-				} else {
-					// Assume successful writing, go on
-					wxRemoveFile(playerFiles[currentWorkingPlayer]);
-					scriptPaths.push_back(ftpPath.ToStdString());
-					currentWorkingPlayer++;
-					// EndModal(wxID_OK);
+	// Connects while the players are still encoding, then sends every block once all players have it
+	// The header is known up front, so the file goes out while the rest is still being encoded
+	std::string address = networkInstance->getSwitchIP();
+	std::string ftpPath = "/switas-script-temp.stas";
+	std::atomic<uint64_t> uploadSent(0);
+	std::atomic<uint32_t> blocksSent(0);
+	std::string uploadError;
+
+	std::future<bool> uploading = std::async(std::launch::async, [&]() {
+		FtpUploader uploader;
+		if(!uploader.connect(address) || !uploader.beginUpload(ftpPath)) {
+			uploadError = uploader.getError();
+			return false;
+		}
+
+		std::vector<uint8_t> header = TasScriptEncoder::writeHeader(numPlayers, numOfFrames);
+		if(!uploader.sendData(header.data(), header.size())) {
+			uploadError = uploader.getError();
+			return false;
+		}
+		uploadSent = header.size();
+
+		std::vector<std::vector<uint8_t>> blockPlayers(numPlayers);
+		for(uint32_t blockIndex = 0; blockIndex < numOfBlocks; blockIndex++) {
+			for(std::size_t player = 0; player < numPlayers; player++) {
+				while(blocksEncoded[player] <= blockIndex && !cancel) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
 				}
 			}
+			if(cancel) {
+				uploader.abortUpload();
+				return false;
+			}
+
+			for(std::size_t player = 0; player < numPlayers; player++) {
+				blockPlayers[player] = std::move(playerBlocks[player][blockIndex]);
+			}
+
+			std::vector<uint8_t> block = TasScriptEncoder::writeBlock(blockPlayers);
+			if(!uploader.sendData(block.data(), block.size())) {
+				uploadError = uploader.getError();
+				return false;
+			}
+			uploadSent += block.size();
+			blocksSent++;
+		}
+
+		if(!uploader.finishUpload()) {
+			uploadError = uploader.getError();
+			return false;
+		}
+		return true;
+	});
+
+	auto start = std::chrono::steady_clock::now();
+
+	// Half for encoding, half for uploading, both happen at once
+	wxProgressDialog progressDialog("Uploading TAS", "Encoding players", 1000, this, wxPD_APP_MODAL | wxPD_CAN_ABORT | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME);
+	while(uploading.wait_for(std::chrono::milliseconds(50)) != std::future_status::ready) {
+		double serializedFraction = totalFrames == 0 ? 1.0 : (double)framesSerialized / totalFrames;
+		double uploadedFraction   = numOfBlocks == 0 ? 1.0 : (double)blocksSent / numOfBlocks;
+
+		wxString message = wxString::Format("Encoded %llu of %llu frames, uploaded %u of %u blocks, %llu bytes", (unsigned long long)framesSerialized, (unsigned long long)totalFrames, (unsigned)blocksSent, numOfBlocks, (unsigned long long)uploadSent);
+		if(!progressDialog.Update(std::min(999, (int)((serializedFraction + uploadedFraction) * 500)), message)) {
+			cancel = true;
+		}
+	}
+
+	bool succeeded = uploading.get();
+	bool cancelled = cancel;
+
+	// Stop anything still encoding if the upload failed
+	cancel = true;
+	for(auto& player : encoding) {
+		player.wait();
+	}
+	progressDialog.Update(1000);
+
+	if(!succeeded) {
+		if(!cancelled) {
+			wxMessageDialog errorDialog(this, wxString::FromUTF8(uploadError), "FTP Error", wxOK | wxICON_ERROR);
+			errorDialog.ShowModal();
+		}
+		return;
+	}
 
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	wxLogMessage(wxString::Format("Encoded and uploaded %u frames for %zu players in %.2f seconds, %llu bytes, %.2f bytes per frame", numOfFrames, numPlayers, seconds, (unsigned long long)uploadSent, totalFrames == 0 ? 0.0 : (double)uploadSent / totalFrames));
+
+	// clang-format off
+	ADD_TO_QUEUE(SendStartFinalTas, networkInstance, {
+		data.scriptPaths          = { ftpPath };
+		data.luaScriptPath        = luaScriptPath->GetValue().ToStdString();
+		data.precompileLuaScript  = precompileLuaScript->GetValue();
+		data.numOfStreamedPlayers = 0;
+	})
+	// clang-format on
+}
+
+void TasRunner::streamFinalTas(int firstHook, int lastHook) {
+	AllPlayers& allPlayers = dataProcessing->getAllPlayers();
+	std::size_t numPlayers = allPlayers.size();
+
+	// Players play in lockstep, so the shortest one decides the length
+	uint32_t numOfFrames = numPlayers == 0 ? 0 : UINT32_MAX;
+	for(auto const& player : allPlayers) {
+		uint32_t playerFrames = 0;
+		for(SavestateBlockNum hook = firstHook; hook <= lastHook; hook++) {
+			playerFrames += player->at(hook)->inputs[0]->size();
+		}
+		numOfFrames = std::min(numOfFrames, playerFrames);
+	}
+	uint32_t numOfChunks = (numOfFrames + FINAL_TAS_STREAM_CHUNK_FRAMES - 1) / FINAL_TAS_STREAM_CHUNK_FRAMES;
+
+	std::atomic_bool cancel(false);
+	std::atomic<uint64_t> framesSerialized(0);
+
+	// Serialized in parallel while the TAS plays, chunks go out as soon as every player has them
+	std::vector<std::vector<std::vector<uint8_t>>> playerChunks(numPlayers, std::vector<std::vector<uint8_t>>(numOfChunks));
+	std::vector<std::atomic<uint32_t>> chunksSerialized(numPlayers);
+	std::vector<std::future<void>> serializing;
+	for(std::size_t i = 0; i < numPlayers; i++) {
+		serializing.push_back(std::async(std::launch::async, &TasRunner::serializePlayer, allPlayers[i], (SavestateBlockNum)firstHook, (SavestateBlockNum)lastHook, numOfFrames, std::ref(playerChunks[i]), std::ref(chunksSerialized[i]), std::ref(framesSerialized), std::cref(cancel)));
+	}
+
+	auto chunksReady = [&]() {
+		uint32_t ready = numOfChunks;
+		for(auto const& count : chunksSerialized) {
+			ready = std::min<uint32_t>(ready, count);
+		}
+		return ready;
+	};
+
+	// Progress from an earlier run
+	CHECK_QUEUE(networkInstance, RecieveFinalTasProgress, {})
+
+	uint32_t framesSent   = 0;
+	uint32_t chunksSent   = 0;
+	uint32_t framesPlayed = 0;
+	uint32_t chunksPlayed = 0;
+	uint8_t started       = false;
+	uint8_t lastSent      = false;
+	uint8_t finished      = false;
+
+	auto start = std::chrono::steady_clock::now();
+
+	wxProgressDialog progressDialog("Streaming TAS", "Serializing", 1000, this, wxPD_APP_MODAL | wxPD_CAN_ABORT | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME);
+	while(!finished && networkInstance->isConnected()) {
+		uint32_t ready = chunksReady();
+
+		if(!started && ready >= std::min<uint32_t>(FINAL_TAS_STREAM_BUFFER_CHUNKS, numOfChunks)) {
+			// Enough to fill the switch's buffer, the rest is serialized while it plays
 			// clang-format off
 			ADD_TO_QUEUE(SendStartFinalTas, networkInstance, {
-				data.scriptPaths = scriptPaths;
+				data.luaScriptPath        = luaScriptPath->GetValue().ToStdString();
+				data.precompileLuaScript  = precompileLuaScript->GetValue();
+				data.numOfStreamedPlayers = numPlayers;
+			})
+			// clang-format on
+			started = true;
+		}
+
+		if(started) {
+			// clang-format off
+			CHECK_QUEUE(networkInstance, RecieveFinalTasProgress, {
+				framesPlayed = data.framesPlayed;
+				chunksPlayed = data.chunksPlayed;
+				finished     = data.finished;
 			})
 			// clang-format on
+		}
+
+		// Stay as far ahead as the switch can hold, never more
+		// An empty TAS still needs the last chunk to end it
+		while(started && !lastSent && (chunksSent < ready || numOfChunks == 0) && chunksSent < chunksPlayed + FINAL_TAS_STREAM_BUFFER_CHUNKS) {
+			uint32_t chunkFrames = std::min<uint32_t>(FINAL_TAS_STREAM_CHUNK_FRAMES, numOfFrames - framesSent);
+
+			// clang-format off
+			ADD_TO_QUEUE(SendFinalTasChunk, networkInstance, {
+				// Chunks interleave the players frame by frame
+				std::vector<std::size_t> offsets(numPlayers, 0);
+				for(uint32_t frame = 0; frame < chunkFrames; frame++) {
+					for(std::size_t player = 0; player < numPlayers; player++) {
+						std::vector<uint8_t>& chunk = playerChunks[player][chunksSent];
+						std::size_t size            = chunk[offsets[player]] + 1;
+						data.data.insert(data.data.end(), chunk.begin() + offsets[player], chunk.begin() + offsets[player] + size);
+						offsets[player] += size;
+					}
+				}
+				data.numOfFrames = chunkFrames;
+				data.isLast      = framesSent + chunkFrames == numOfFrames;
+			})
+			// clang-format on
+
+			// Sent chunks aren't needed anymore
+			for(std::size_t player = 0; player < numPlayers && chunksSent < numOfChunks; player++) {
+				std::vector<uint8_t>().swap(playerChunks[player][chunksSent]);
+			}
+
+			framesSent += chunkFrames;
+			chunksSent++;
+			lastSent = framesSent == numOfFrames;
+		}
+
+		wxString message;
+		int progress;
+		if(started) {
+			message  = wxString::Format("Played %u of %u frames, %u frames buffered, %llu frames serialized", framesPlayed, numOfFrames, framesSent - framesPlayed, (unsigned long long)framesSerialized);
+			progress = numOfFrames == 0 ? 999 : std::min(999, (int)((uint64_t)framesPlayed * 1000 / numOfFrames));
 		} else {
-			// Not connected, cannot run final TAS with homebrew then
-			wxMessageDialog connectedDialog(this, "You must connect to your switch in order to run using this method", "Not Connected", wxOK | wxICON_ERROR);
-			connectedDialog.ShowModal();
+			message  = wxString::Format("Serializing the first %u chunks", std::min<uint32_t>(FINAL_TAS_STREAM_BUFFER_CHUNKS, numOfChunks));
+			progress = 0;
 		}
-	}
-}
 
-void TasRunner::onStartTasArduinoPressed(wxCommandEvent& event) {
-	int firstHook = firstSavestateHook->GetValue();
-	int lastHook  = lastSavestateHook->GetValue();
+		if(!progressDialog.Update(progress, message)) {
+			if(started) {
+				// clang-format off
+				ADD_TO_QUEUE(SendFlag, networkInstance, {
+					data.actFlag = SendInfo::STOP_FINAL_TAS;
+				})
+				// clang-format on
+			}
+			break;
+		}
 
-	if(lastHook < firstHook) {
-		wxMessageDialog invalidRangeMessage(this, "Invalid savestate hook range", "Invalid Range", wxOK | wxICON_ERROR);
-		invalidRangeMessage.ShowModal();
-	} else {
-		// TODO use arduino TAS
-		// UNIMPLEMENTED
+		wxMilliSleep(20);
 	}
-}
 
-void TasRunner::onStopTasPressed(wxCommandEvent& event) {
-	// clang-format off
-	ADD_TO_QUEUE(SendFlag, networkInstance, {
-		data.actFlag = SendInfo::STOP_FINAL_TAS;
-	})
-	// clang-format on
-}
\ No newline at end of file
+	// The serializers write into this function's buffers
+	cancel = true;
+	for(auto& player : serializing) {
+		player.wait();
+	}
+	progressDialog.Update(1000);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	wxLogMessage(wxString::Format("Streamed %u of %u frames for %zu players in %.2f seconds", framesPlayed, numOfFrames, numPlayers, seconds));
+}
@@ -1,5 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+#include <wx/progdlg.h>
 #include <wx/spinctrl.h>
 #include <wx/wfstream.h>
 #include <wx/wx.h>
@@ -7,9 +15,11 @@
 #include "../helpers.hpp"
 #include "../sharedNetworkCode/networkInterface.hpp"
 #include "../sharedNetworkCode/serializeUnserializeData.hpp"
+#include "../sharedNetworkCode/tasScriptFormat.hpp"
 #include "buttonConstants.hpp"
 #include "buttonData.hpp"
 #include "dataProcessing.hpp"
+#include "ftpUploader.hpp"
 
 class TasRunner : public wxDialog {
 private:
@@ -17,14 +27,18 @@ private:
 	rapidjson::Document* mainSettings;
 	DataProcessing* dataProcessing;
 
-	SerializeProtocol serializeProtocol;
-
 	wxBoxSizer* mainSizer;
 	wxBoxSizer* hookSelectionSizer;
 
 	wxSpinCtrl* firstSavestateHook;
 	wxSpinCtrl* lastSavestateHook;
 
+	// Optional Lua script already on the SD card
+	wxTextCtrl* luaScriptPath;
+	wxCheckBox* precompileLuaScript;
+	// Script files on the SD card are still there for long unattended runs
+	wxCheckBox* streamInputs;
+
 	wxBitmapButton* startTasHomebrew;
 	wxBitmapButton* startTasArduino;
 	// More will be added as needed
@@ -33,6 +47,15 @@ private:
 	// Stopping will also close the dialog
 	wxBitmapButton* stopTas;
 
+	// Runs on its own thread, every player is encoded at the same time
+	// Output has a slot for every block, blocksEncoded says how many are ready to be sent
+	static void encodePlayer(std::shared_ptr<std::vector<std::shared_ptr<SavestateHook>>> player, SavestateBlockNum firstHook, SavestateBlockNum lastHook, uint32_t numOfFrames, std::vector<std::vector<uint8_t>>& output, std::atomic<uint32_t>& blocksEncoded, std::atomic<uint64_t>& framesSerialized, const std::atomic_bool& cancel);
+	// Same, but the old record format used when streaming, one slot for every chunk
+	static void serializePlayer(std::shared_ptr<std::vector<std::shared_ptr<SavestateHook>>> player, SavestateBlockNum firstHook, SavestateBlockNum lastHook, uint32_t numOfFrames, std::vector<std::vector<uint8_t>>& output, std::atomic<uint32_t>& chunksSerialized, std::atomic<uint64_t>& framesSerialized, const std::atomic_bool& cancel);
+
+	void uploadFinalTas(int firstHook, int lastHook);
+	void streamFinalTas(int firstHook, int lastHook);
+
 	void onStartTasHomebrewPressed(wxCommandEvent& event);
 	void onStartTasArduinoPressed(wxCommandEvent& event);
 
@@ -0,0 +1,149 @@
+#include "scriptParser.hpp"
+
+void ScriptParser::setButtonNames(const std::vector<std::pair<std::string, Btn>>& names) {
+	std::size_t tableSize = 8;
+	while(tableSize < names.size() * 2) {
+		tableSize *= 2;
+	}
+
+	while(true) {
+		// Try seeds until nothing collides, grow the table if that takes too long
+		for(uint32_t seed = 1; seed < 10000; seed++) {
+			buttonTable.assign(tableSize, ButtonEntry());
+			bool collided = false;
+			for(auto const& name : names) {
+				ButtonEntry& entry = buttonTable[hashName(name.first, seed) & (tableSize - 1)];
+				if(entry.used) {
+					collided = true;
+					break;
+				}
+				entry.name   = name.first;
+				entry.button = name.second;
+				entry.used   = true;
+			}
+
+			if(!collided) {
+				hashSeed = seed;
+				hashMask = tableSize - 1;
+				return;
+			}
+		}
+
+		tableSize *= 2;
+	}
+}
+
+bool ScriptParser::lookupButton(std::string_view name, Btn& button) const {
+	if(buttonTable.empty()) {
+		return false;
+	}
+
+	// Still have to compare, the name might not be a button at all
+	const ButtonEntry& entry = buttonTable[hashName(name, hashSeed) & hashMask];
+	if(entry.used && entry.name == name) {
+		button = entry.button;
+		return true;
+	}
+	return false;
+}
+
+std::string_view ScriptParser::nextToken(std::string_view& line, char delim) {
+	std::size_t end       = line.find(delim);
+	std::string_view part = line.substr(0, end);
+	line.remove_prefix(end == std::string_view::npos ? line.size() : end + 1);
+	return part;
+}
+
+template <std::size_t N> bool ScriptParser::parseNumbers(std::string_view token, int16_t* (&values)[N]) {
+	for(std::size_t i = 0; i < N; i++) {
+		if(token.empty()) {
+			return false;
+		}
+		std::string_view number = nextToken(token, ';');
+
+		// Values that don't fit in 16 bits are a broken part, like any other bad number
+		auto result = std::from_chars(number.data(), number.data() + number.size(), *values[i]);
+		if(result.ec != std::errc() || result.ptr != number.data() + number.size()) {
+			return false;
+		}
+	}
+	return token.empty();
+}
+
+void ScriptParser::parse(std::string_view text, std::vector<ScriptFrame>& frames) const {
+	frames.clear();
+	frames.reserve(text.size() / 32);
+
+	bool haveFirstFrame = false;
+	uint32_t firstFrame = 0;
+
+	while(!text.empty()) {
+		std::string_view line = nextToken(text, '\n');
+		if(!line.empty() && line.back() == '\r') {
+			line.remove_suffix(1);
+		}
+
+		std::string_view token = nextToken(line, ' ');
+		uint32_t frameNum;
+		auto result = std::from_chars(token.data(), token.data() + token.size(), frameNum);
+		if(result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+			continue;
+		}
+
+		if(!haveFirstFrame) {
+			// This is the first script frame, it will be put at the start location
+			firstFrame     = frameNum;
+			haveFirstFrame = true;
+		} else if(frameNum < firstFrame) {
+			continue;
+		}
+
+		ScriptFrame& frame = frames.emplace_back();
+		frame              = ScriptFrame { 0 };
+		frame.offset       = frameNum - firstFrame;
+		frame.lastField    = SCRIPT_FRAME_ONLY;
+
+		// Variable number of parts, stop at the first missing or broken one
+		if(line.empty()) {
+			continue;
+		}
+
+		token = nextToken(line, ' ');
+		// Can be no buttons at all
+		if(token != "NONE") {
+			while(!token.empty()) {
+				Btn button;
+				if(lookupButton(nextToken(token, ';'), button)) {
+					frame.buttons |= 1U << button;
+				}
+			}
+		}
+		frame.lastField = SCRIPT_BUTTONS;
+
+		int16_t* leftJoystick[]  = { &frame.LS_X, &frame.LS_Y };
+		int16_t* rightJoystick[] = { &frame.RS_X, &frame.RS_Y };
+		int16_t* accel[]         = { &frame.ACCEL_X, &frame.ACCEL_Y, &frame.ACCEL_Z };
+		int16_t* gyro[]          = { &frame.GYRO_1, &frame.GYRO_2, &frame.GYRO_3 };
+
+		if(line.empty() || !parseNumbers(nextToken(line, ' '), leftJoystick)) {
+			continue;
+		}
+		frame.lastField = SCRIPT_LEFT_JOYSTICK;
+
+		if(line.empty() || !parseNumbers(nextToken(line, ' '), rightJoystick)) {
+			continue;
+		}
+		frame.lastField = SCRIPT_RIGHT_JOYSTICK;
+
+		// Accelerometer and gyro data
+		if(line.empty() || !parseNumbers(nextToken(line, ' '), accel)) {
+			continue;
+		}
+		frame.lastField = SCRIPT_ACCEL;
+
+		if(line.empty() || !parseNumbers(nextToken(line, ' '), gyro)) {
+			continue;
+		}
+		frame.lastField = SCRIPT_GYRO;
+	}
+}
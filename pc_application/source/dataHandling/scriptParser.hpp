@@ -0,0 +1,76 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../sharedNetworkCode/buttonData.hpp"
+
+// How far a script line got, fields after the last one are left alone when pasting
+enum ScriptFields : uint8_t {
+	SCRIPT_FRAME_ONLY,
+	SCRIPT_BUTTONS,
+	SCRIPT_LEFT_JOYSTICK,
+	SCRIPT_RIGHT_JOYSTICK,
+	SCRIPT_ACCEL,
+	SCRIPT_GYRO,
+};
+
+// One line of an nx-TAS script, plain data so a whole script can be parsed before touching the inputs
+struct ScriptFrame {
+	// Relative to the first frame of the script
+	uint32_t offset;
+	uint8_t lastField;
+	uint32_t buttons;
+	int16_t LS_X;
+	int16_t LS_Y;
+	int16_t RS_X;
+	int16_t RS_Y;
+	int16_t ACCEL_X;
+	int16_t ACCEL_Y;
+	int16_t ACCEL_Z;
+	int16_t GYRO_1;
+	int16_t GYRO_2;
+	int16_t GYRO_3;
+};
+
+// Single pass nx-TAS script parser, works on views of the text and never allocates per line
+// Only depends on the standard library
+class ScriptParser {
+private:
+	struct ButtonEntry {
+		std::string name;
+		Btn button;
+		uint8_t used = false;
+	};
+
+	// Perfect hash of the script names, every name gets its own slot
+	std::vector<ButtonEntry> buttonTable;
+	uint32_t hashSeed = 0;
+	uint32_t hashMask = 0;
+
+	static uint32_t hashName(std::string_view name, uint32_t seed) {
+		uint32_t hash = 2166136261u ^ seed;
+		for(char c : name) {
+			hash ^= (uint8_t)c;
+			hash *= 16777619u;
+		}
+		return hash ^ (hash >> 15);
+	}
+
+	static std::string_view nextToken(std::string_view& line, char delim);
+
+	template <std::size_t N> static bool parseNumbers(std::string_view token, int16_t* (&values)[N]);
+
+	bool lookupButton(std::string_view name, Btn& button) const;
+
+public:
+	// Script names come from the settings, so the hash is searched for at runtime
+	void setButtonNames(const std::vector<std::pair<std::string, Btn>>& names);
+
+	// Lines that don't start with a frame number are skipped
+	void parse(std::string_view text, std::vector<ScriptFrame>& frames) const;
+};
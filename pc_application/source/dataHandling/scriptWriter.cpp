@@ -0,0 +1,86 @@
+#include "scriptWriter.hpp"
+
+char* ScriptWriter::writeFrame(char* out, const ScriptFrame& frame) const {
+	out = std::to_chars(out, out + 16, frame.offset).ptr;
+	*out++ = ' ';
+
+	bool haveButton = false;
+	for(uint8_t btn = 0; btn < buttonNames.size(); btn++) {
+		if((frame.buttons >> btn) & 1U) {
+			if(haveButton) {
+				*out++ = ';';
+			}
+			std::memcpy(out, buttonNames[btn].data(), buttonNames[btn].size());
+			out += buttonNames[btn].size();
+			haveButton = true;
+		}
+	}
+
+	if(!haveButton) {
+		// Sometimes, it's nothing, so push a constant
+		std::memcpy(out, "NONE", 4);
+		out += 4;
+	}
+
+	const int16_t numbers[] = { frame.LS_X, frame.LS_Y, frame.RS_X, frame.RS_Y, frame.ACCEL_X, frame.ACCEL_Y, frame.ACCEL_Z, frame.GYRO_1, frame.GYRO_2, frame.GYRO_3 };
+	// Space starts a new part, everything else in the part is split with semicolons
+	const char separators[] = { ' ', ';', ' ', ';', ' ', ';', ';', ' ', ';', ';' };
+	for(uint8_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++) {
+		*out++ = separators[i];
+		out    = writeNumber(out, numbers[i]);
+	}
+
+	return out;
+}
+
+bool ScriptWriter::write(const std::vector<ScriptFrame>& frames, Sink sink, const std::atomic_bool* cancel) const {
+	std::vector<char> buffer(std::max(BUFFER_SIZE, maxLineSize * 2));
+	char* start = buffer.data();
+	char* out   = start;
+
+	for(std::size_t i = 0; i < frames.size(); i++) {
+		if(out - start > (std::ptrdiff_t)(buffer.size() - maxLineSize)) {
+			if((cancel != nullptr && *cancel) || !sink(start, out - start)) {
+				return false;
+			}
+			out = start;
+		}
+
+		// Lines are joined with newlines, no trailing one
+		if(i != 0) {
+			*out++ = '\n';
+		}
+		out = writeFrame(out, frames[i]);
+	}
+
+	if(out != start) {
+		return sink(start, out - start);
+	}
+	return true;
+}
+
+bool ScriptWriter::writeToFile(const std::vector<ScriptFrame>& frames, std::string path, const std::atomic_bool* cancel) const {
+	FILE* file = fopen(path.c_str(), "wb");
+	if(file == NULL) {
+		return false;
+	}
+
+	bool succeeded = write(
+		frames,
+		[file](const char* data, std::size_t size) {
+			return fwrite(data, 1, size, file) == size;
+		},
+		cancel);
+
+	fclose(file);
+	return succeeded;
+}
+
+std::string ScriptWriter::writeToString(const std::vector<ScriptFrame>& frames) const {
+	std::string text;
+	write(frames, [&text](const char* data, std::size_t size) {
+		text.append(data, size);
+		return true;
+	});
+	return text;
+}
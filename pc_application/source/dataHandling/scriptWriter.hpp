@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "scriptParser.hpp"
+
+// Formats frames as an nx-TAS script straight into a buffered sink
+// Works on a snapshot of plain frames, so it can run on any thread while the editor keeps going
+// Only depends on the standard library
+class ScriptWriter {
+public:
+	// Returns false to stop writing
+	typedef std::function<bool(const char* data, std::size_t size)> Sink;
+
+private:
+	static constexpr std::size_t BUFFER_SIZE = 0x10000;
+
+	// Indexed by Btn
+	std::vector<std::string> buttonNames;
+	// Longest line possible, the buffer is flushed before it gets this close to full
+	std::size_t maxLineSize = 0x100;
+
+	static char* writeNumber(char* out, long number) {
+		return std::to_chars(out, out + 8, number).ptr;
+	}
+
+	char* writeFrame(char* out, const ScriptFrame& frame) const;
+
+public:
+	void setButtonNames(std::vector<std::string> names) {
+		buttonNames = names;
+		// Frame number, numbers and separators all fit in the base size
+		maxLineSize = 0x100;
+		for(auto const& name : buttonNames) {
+			maxLineSize += name.size() + 1;
+		}
+	}
+
+	bool write(const std::vector<ScriptFrame>& frames, Sink sink, const std::atomic_bool* cancel = nullptr) const;
+
+	bool writeToFile(const std::vector<ScriptFrame>& frames, std::string path, const std::atomic_bool* cancel = nullptr) const;
+	std::string writeToString(const std::vector<ScriptFrame>& frames) const;
+};
@@ -0,0 +1,161 @@
+#include "timelineSummary.hpp"
+
+void TimelineSummary::countFrame(const ControllerData& data, TimelineCounts& counts) {
+	uint32_t buttons = data.buttons;
+	while(buttons != 0) {
+		uint8_t button = __builtin_ctz(buttons);
+		if(button >= BUTTONS_SIZE) {
+			break;
+		}
+		counts.counts[button]++;
+		buttons &= buttons - 1;
+	}
+
+	if(GET_BIT(data.frameState, FrameState::SAVESTATE)) {
+		counts.counts[TIMELINE_SAVESTATE_CHANNEL]++;
+	}
+}
+
+void TimelineSummary::summarizeLeaf(std::size_t leaf) {
+	TimelineCounts& counts = tree[numLeaves + leaf];
+	counts                 = TimelineCounts();
+
+	// Leaves past the end stay empty
+	std::size_t start = leaf * TIMELINE_LEAF_FRAMES;
+	std::size_t end   = std::min<std::size_t>(start + TIMELINE_LEAF_FRAMES, summarizedSize);
+	for(std::size_t frame = start; frame < end; frame++) {
+		countFrame(*(*summarizedFrames)[frame], counts);
+	}
+}
+
+void TimelineSummary::updateParents(std::size_t firstLeaf, std::size_t lastLeaf) {
+	// One level at a time, so a big edit touches each parent once
+	std::size_t first = (numLeaves + firstLeaf) / 2;
+	std::size_t last  = (numLeaves + lastLeaf) / 2;
+	while(first != 0) {
+		for(std::size_t node = first; node <= last; node++) {
+			tree[node] = tree[node * 2];
+			tree[node].add(tree[node * 2 + 1]);
+		}
+		first /= 2;
+		last /= 2;
+	}
+}
+
+void TimelineSummary::rebuild(FrameNum from) {
+	std::size_t neededLeaves = std::max<std::size_t>(1, (summarizedSize + TIMELINE_LEAF_FRAMES - 1) / TIMELINE_LEAF_FRAMES);
+
+	std::size_t firstLeaf = from / TIMELINE_LEAF_FRAMES;
+	if(neededLeaves > numLeaves || neededLeaves * 4 < numLeaves) {
+		// A power of two with room to grow, shrunk when it's mostly empty
+		numLeaves = 1;
+		while(numLeaves < neededLeaves) {
+			numLeaves *= 2;
+		}
+		tree.assign(numLeaves * 2, TimelineCounts());
+		firstLeaf = 0;
+	}
+
+	if(firstLeaf >= numLeaves) {
+		return;
+	}
+
+	// Leaves that used to have frames are emptied too
+	for(std::size_t leaf = firstLeaf; leaf < numLeaves; leaf++) {
+		summarizeLeaf(leaf);
+	}
+	updateParents(firstLeaf, numLeaves - 1);
+}
+
+bool TimelineSummary::update(const std::vector<std::shared_ptr<ControllerData>>& frames) {
+	if(&frames != summarizedFrames) {
+		summarizedFrames = &frames;
+		summarizedSize   = frames.size();
+		numLeaves        = 0;
+		rebuild(0);
+	} else if(rebuildFrom != UINT32_MAX || frames.size() != summarizedSize) {
+		FrameNum from  = std::min<std::size_t>(rebuildFrom, std::min(summarizedSize, frames.size()));
+		summarizedSize = frames.size();
+		rebuild(from);
+	} else {
+		return false;
+	}
+
+	rebuildFrom = UINT32_MAX;
+	version++;
+	return true;
+}
+
+void TimelineSummary::markEdited(const std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum start, FrameNum end) {
+	if(&frames != summarizedFrames || start > end) {
+		return;
+	}
+
+	if(rebuildFrom != UINT32_MAX || frames.size() != summarizedSize || end >= summarizedSize) {
+		// Everything after it is being redone anyway
+		rebuildFrom = std::min(rebuildFrom, start);
+		return;
+	}
+
+	std::size_t firstLeaf = start / TIMELINE_LEAF_FRAMES;
+	std::size_t lastLeaf  = end / TIMELINE_LEAF_FRAMES;
+	for(std::size_t leaf = firstLeaf; leaf <= lastLeaf; leaf++) {
+		summarizeLeaf(leaf);
+	}
+	updateParents(firstLeaf, lastLeaf);
+	version++;
+}
+
+void TimelineSummary::markMovedFrom(const std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum start) {
+	if(&frames == summarizedFrames) {
+		rebuildFrom = std::min(rebuildFrom, start);
+	}
+}
+
+void TimelineSummary::clear() {
+	summarizedFrames = nullptr;
+	summarizedSize   = 0;
+	numLeaves        = 0;
+	rebuildFrom      = UINT32_MAX;
+	tree.clear();
+	version++;
+}
+
+void TimelineSummary::query(FrameNum start, FrameNum end, TimelineCounts& counts) const {
+	counts = TimelineCounts();
+	end    = std::min<FrameNum>(end, summarizedSize);
+	if(start >= end) {
+		return;
+	}
+
+	// Whole leaves come from the tree, the frames around them are counted directly
+	std::size_t firstLeaf = (start + TIMELINE_LEAF_FRAMES - 1) / TIMELINE_LEAF_FRAMES;
+	std::size_t endLeaf   = end / TIMELINE_LEAF_FRAMES;
+	if(firstLeaf >= endLeaf) {
+		for(FrameNum frame = start; frame < end; frame++) {
+			countFrame(*(*summarizedFrames)[frame], counts);
+		}
+		return;
+	}
+
+	for(FrameNum frame = start; frame < firstLeaf * TIMELINE_LEAF_FRAMES; frame++) {
+		countFrame(*(*summarizedFrames)[frame], counts);
+	}
+	for(FrameNum frame = endLeaf * TIMELINE_LEAF_FRAMES; frame < end; frame++) {
+		countFrame(*(*summarizedFrames)[frame], counts);
+	}
+
+	// Bottom up, each level adds at most one node from each side
+	std::size_t left  = numLeaves + firstLeaf;
+	std::size_t right = numLeaves + endLeaf;
+	while(left < right) {
+		if(left & 1) {
+			counts.add(tree[left++]);
+		}
+		if(right & 1) {
+			counts.add(tree[--right]);
+		}
+		left /= 2;
+		right /= 2;
+	}
+}
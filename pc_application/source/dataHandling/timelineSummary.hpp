@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../sharedNetworkCode/buttonData.hpp"
+#include "buttonConstants.hpp"
+
+// Frames summarized by one leaf, the frames of partial leaves are read directly
+#define TIMELINE_LEAF_FRAMES 64
+// Every button, then frames with a savestate
+#define TIMELINE_NUM_CHANNELS (BUTTONS_SIZE + 1)
+#define TIMELINE_SAVESTATE_CHANNEL BUTTONS_SIZE
+
+struct TimelineCounts {
+	uint32_t counts[TIMELINE_NUM_CHANNELS] = { 0 };
+
+	void add(const TimelineCounts& other) {
+		for(uint8_t channel = 0; channel < TIMELINE_NUM_CHANNELS; channel++) {
+			counts[channel] += other.counts[channel];
+		}
+	}
+};
+
+// How many frames hold each button, over any range of the viewed branch, for the timeline
+// A segment tree of counts, so a range is O(log n) no matter how many frames it covers
+// Edits fix their leaves and the parents above them right away
+// Inserting or removing frames moves everything after it, those leaves are redone the next time it's used
+class TimelineSummary {
+private:
+	// Like the input index, only the branch being viewed
+	const std::vector<std::shared_ptr<ControllerData>>* summarizedFrames = nullptr;
+	std::size_t summarizedSize                                           = 0;
+
+	// Leaves start at numLeaves, the children of node i are 2i and 2i + 1
+	std::size_t numLeaves = 0;
+	std::vector<TimelineCounts> tree;
+
+	// Set by frames moving
+	FrameNum rebuildFrom = UINT32_MAX;
+	// Bumped on every change, so the timeline knows to redraw
+	uint64_t version = 0;
+
+	static void countFrame(const ControllerData& data, TimelineCounts& counts);
+	void summarizeLeaf(std::size_t leaf);
+	// Both ends included
+	void updateParents(std::size_t firstLeaf, std::size_t lastLeaf);
+	void rebuild(FrameNum from);
+
+public:
+	// Returns true if anything had to be redone
+	bool update(const std::vector<std::shared_ptr<ControllerData>>& frames);
+
+	// Ignored if it's not the summarized branch, both ends included
+	void markEdited(const std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum start, FrameNum end);
+	void markMovedFrom(const std::vector<std::shared_ptr<ControllerData>>& frames, FrameNum start);
+	void clear();
+
+	// Totals of every channel from start up to but not including end, update has to be called first
+	void query(FrameNum start, FrameNum end, TimelineCounts& counts) const;
+
+	FrameNum getNumFrames() const {
+		return summarizedSize;
+	}
+
+	uint64_t getVersion() const {
+		return version;
+	}
+
+	std::size_t getMemoryUsage() const {
+		return tree.capacity() * sizeof(TimelineCounts);
+	}
+};
@@ -1,18 +1,20 @@
 #pragma once
 
 // clang-format off
-#define SEND_QUEUE_DATA(Flag) { \
+#define SEND_QUEUE_DATA(Flag) SEND_QUEUE_DATA_AND_RETURN(Flag, [](Protocol::Struct_##Flag& sent) {})
+
+// Like above, but the struct is handed to returnFunc once it's sent, so buffers inside can be reused
+#define SEND_QUEUE_DATA_AND_RETURN(Flag, returnFunc) { \
 	while(true) { \
 		Protocol::Struct_##Flag structData; \
 		if(self->Queue_##Flag.try_dequeue(structData)) { \
-			uint8_t* data; \
 			uint32_t size; \
-			self->serializingProtocol.dataToBinary<Protocol::Struct_##Flag>(structData, &data, &size); \
+			uint8_t* data = self->serializingProtocol.dataToScratch<Protocol::Struct_##Flag>(structData, &size); \
 			uint32_t dataSize = htonl(size); \
 			self->sendData(&dataSize, sizeof(dataSize)); \
 			self->sendData(&structData.flag, sizeof(DataFlag)); \
 			self->sendData(data, size); \
-			free(data); \
+			returnFunc(structData); \
 		} else { \
 			break; \
 		} \
@@ -26,7 +28,7 @@
 	if (self->currentFlag == DataFlag::Flag) { \
 		Protocol::Struct_##Flag data; \
 		self->serializingProtocol.binaryToData<Protocol::Struct_##Flag>(data, self->dataToRead, self->dataSize); \
-		self->Queue_##Flag.enqueue(data); \
+		self->Queue_##Flag.enqueue(std::move(data)); \
 	} \
 // clang-format on
 
@@ -39,7 +41,7 @@
 #define ADD_TO_QUEUE(Flag, networkImp, bodyOfCode) { \
 	Protocol::Struct_##Flag data; \
 	bodyOfCode \
-	networkImp->Queue_##Flag.enqueue(data); \
+	networkImp->Queue_##Flag.enqueue(std::move(data)); \
 }
 // clang-format on
 
@@ -73,6 +75,7 @@
 #include <functional>
 #include <unistd.h>
 #include <unordered_map>
+#include <vector>
 
 #ifdef __SWITCH__
 #include <plog/Log.h>
@@ -118,6 +121,8 @@ private:
 
 	std::function<void(CommunicateWithNetwork*)> sendQueueDataCallback;
 	std::function<void(CommunicateWithNetwork*)> recieveQueueDataCallback;
+	// Lets the main thread sleep until something comes in or the connection changes
+	std::function<void()> wakeCallback;
 
 	std::mutex ipMutex;
 	std::condition_variable cv;
@@ -143,6 +148,12 @@ private:
 		std::this_thread::sleep_for(std::chrono::milliseconds(1));
 	}
 
+	void wakeMainThread() {
+		if(wakeCallback) {
+			wakeCallback();
+		}
+	}
+
 public:
 	// Protcol for serializing
 	SerializeProtocol serializingProtocol;
@@ -161,8 +172,17 @@ public:
 	ADD_QUEUE(RecieveMemoryRegion)
 	ADD_QUEUE(SendAddMemoryRegion)
 	ADD_QUEUE(SendStartFinalTas)
-
-	CommunicateWithNetwork(std::function<void(CommunicateWithNetwork*)> sendCallback, std::function<void(CommunicateWithNetwork*)> recieveCallback);
+	ADD_QUEUE(SendMemorySnapshot)
+	ADD_QUEUE(RecieveMemorySnapshotChunk)
+	ADD_QUEUE(SendRunLuaScript)
+	ADD_QUEUE(SendFinalTasChunk)
+	ADD_QUEUE(RecieveFinalTasProgress)
+	ADD_QUEUE(SendRunToFrame)
+	ADD_QUEUE(RecieveRunToFrameProgress)
+	ADD_QUEUE(RecieveHeapUsage)
+
+	// The wake callback is called from the network threads
+	CommunicateWithNetwork(std::function<void(CommunicateWithNetwork*)> sendCallback, std::function<void(CommunicateWithNetwork*)> recieveCallback, std::function<void()> wake = nullptr);
 
 #ifdef CLIENT_IMP
 	uint8_t attemptConnectionToServer(std::string ip);
@@ -208,4 +228,6 @@ public:
 	uint32_t dataSize;
 	DataFlag currentFlag;
 	uint8_t* dataToRead;
+	// Reused for every message, only grows
+	std::vector<uint8_t> readBuffer;
 };
\ No newline at end of file
@@ -22,7 +22,7 @@ public:
 		in(outputData);
 	}
 
-	template <typename T> void dataToBinary(T inputData, uint8_t** data, uint32_t* size) {
+	template <typename T> void dataToBinary(const T& inputData, uint8_t** data, uint32_t* size) {
 		serializingData.clear();
 		// Create the archive
 		zpp::serializer::memory_output_archive out(serializingData);
@@ -36,4 +36,17 @@ public:
 		*data = (uint8_t*)malloc(*size);
 		memcpy(*data, serializingData.data(), *size);
 	}
+
+	// Same as above, but the bytes are left in the reused buffer instead of copied out
+	// Nothing to free, only valid until the next call
+	template <typename T> uint8_t* dataToScratch(const T& inputData, uint32_t* size) {
+		// Clearing keeps the capacity, so it only allocates when a message is bigger than any before
+		serializingData.clear();
+		zpp::serializer::memory_output_archive out(serializingData);
+
+		out(inputData);
+
+		*size = serializingData.size();
+		return serializingData.data();
+	}
 };
\ No newline at end of file
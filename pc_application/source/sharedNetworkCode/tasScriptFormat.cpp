@@ -0,0 +1,318 @@
+#include "tasScriptFormat.hpp"
+
+// Indexed by the bit of the field, values are copied as is so this assumes little endian like the rest
+static const uint8_t fieldOffsets[] = { offsetof(TasScriptFrame, buttons), offsetof(TasScriptFrame, leftJoystick), offsetof(TasScriptFrame, rightJoystick), offsetof(TasScriptFrame, accel), offsetof(TasScriptFrame, gyro) };
+static const uint8_t fieldSizes[]   = { sizeof(uint32_t), sizeof(int16_t) * 2, sizeof(int16_t) * 2, sizeof(int16_t) * 3, sizeof(int16_t) * 3 };
+
+static constexpr uint8_t NUM_OF_FIELDS   = sizeof(fieldSizes) / sizeof(fieldSizes[0]);
+static constexpr std::size_t HEADER_SIZE = 16;
+
+// Bytes of data following every possible mask, so a record needs only one bounds check
+static const std::vector<uint8_t> maskSizes = []() {
+	std::vector<uint8_t> sizes(TAS_FIELD_ALL + 1);
+	for(uint8_t mask = 0; mask <= TAS_FIELD_ALL; mask++) {
+		for(uint8_t field = 0; field < NUM_OF_FIELDS; field++) {
+			if(mask & (1 << field)) {
+				sizes[mask] += fieldSizes[field];
+			}
+		}
+	}
+	return sizes;
+}();
+
+template <typename T> static void appendValue(std::vector<uint8_t>& out, T value) {
+	uint8_t bytes[sizeof(T)];
+	memcpy(bytes, &value, sizeof(T));
+	out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T> static T readValue(const uint8_t* data) {
+	T value;
+	memcpy(&value, data, sizeof(T));
+	return value;
+}
+
+TasScriptFrame TasScriptFrame::fromControllerData(const ControllerData& data) {
+	TasScriptFrame frame;
+	frame.buttons          = data.buttons;
+	frame.leftJoystick[0]  = data.LS_X;
+	frame.leftJoystick[1]  = data.LS_Y;
+	frame.rightJoystick[0] = data.RS_X;
+	frame.rightJoystick[1] = data.RS_Y;
+	frame.accel[0]         = data.ACCEL_X;
+	frame.accel[1]         = data.ACCEL_Y;
+	frame.accel[2]         = data.ACCEL_Z;
+	frame.gyro[0]          = data.GYRO_1;
+	frame.gyro[1]          = data.GYRO_2;
+	frame.gyro[2]          = data.GYRO_3;
+	return frame;
+}
+
+void TasScriptFrame::toControllerData(ControllerData& data) const {
+	data.buttons = buttons;
+	data.LS_X    = leftJoystick[0];
+	data.LS_Y    = leftJoystick[1];
+	data.RS_X    = rightJoystick[0];
+	data.RS_Y    = rightJoystick[1];
+	data.ACCEL_X = accel[0];
+	data.ACCEL_Y = accel[1];
+	data.ACCEL_Z = accel[2];
+	data.GYRO_1  = gyro[0];
+	data.GYRO_2  = gyro[1];
+	data.GYRO_3  = gyro[2];
+}
+
+void TasScriptEncoder::writeFrameFields(std::vector<uint8_t>& out, const TasScriptFrame& frame, uint8_t mask) {
+	out.push_back(mask);
+	for(uint8_t field = 0; field < NUM_OF_FIELDS; field++) {
+		if(mask & (1 << field)) {
+			const uint8_t* start = (const uint8_t*)&frame + fieldOffsets[field];
+			out.insert(out.end(), start, start + fieldSizes[field]);
+		}
+	}
+}
+
+std::vector<uint8_t> TasScriptEncoder::encodeBlock(const TasScriptFrame* frames, std::size_t numOfFrames) {
+	std::vector<uint8_t> out;
+	if(numOfFrames == 0) {
+		return out;
+	}
+
+	// Keyframe
+	writeFrameFields(out, frames[0], TAS_FIELD_ALL);
+
+	uint8_t repeats = 0;
+	for(std::size_t i = 1; i < numOfFrames; i++) {
+		const TasScriptFrame& previous = frames[i - 1];
+		const TasScriptFrame& frame    = frames[i];
+
+		uint8_t mask = 0;
+		for(uint8_t field = 0; field < NUM_OF_FIELDS; field++) {
+			if(memcmp((const uint8_t*)&frame + fieldOffsets[field], (const uint8_t*)&previous + fieldOffsets[field], fieldSizes[field]) != 0) {
+				mask |= 1 << field;
+			}
+		}
+
+		if(mask == 0) {
+			// Most frames are the same as the last one
+			repeats++;
+			if(repeats == UINT8_MAX) {
+				out.push_back(TAS_RECORD_REPEAT);
+				out.push_back(repeats);
+				repeats = 0;
+			}
+		} else {
+			if(repeats != 0) {
+				out.push_back(TAS_RECORD_REPEAT);
+				out.push_back(repeats);
+				repeats = 0;
+			}
+			writeFrameFields(out, frame, mask);
+		}
+	}
+
+	if(repeats != 0) {
+		out.push_back(TAS_RECORD_REPEAT);
+		out.push_back(repeats);
+	}
+
+	return out;
+}
+
+std::vector<std::vector<uint8_t>> TasScriptEncoder::encodePlayer(const std::vector<TasScriptFrame>& frames, uint16_t framesPerBlock) {
+	std::vector<std::vector<uint8_t>> blocks((frames.size() + framesPerBlock - 1) / framesPerBlock);
+
+	for(std::size_t blockIndex = 0; blockIndex < blocks.size(); blockIndex++) {
+		std::size_t start = blockIndex * framesPerBlock;
+		std::size_t end   = std::min(start + framesPerBlock, frames.size());
+
+		blocks[blockIndex] = encodeBlock(&frames[start], end - start);
+	}
+
+	return blocks;
+}
+
+std::vector<uint8_t> TasScriptEncoder::writeHeader(uint8_t numOfPlayers, uint32_t numOfFrames, uint16_t framesPerBlock) {
+	std::vector<uint8_t> out(4);
+	memcpy(out.data(), TAS_SCRIPT_MAGIC, 4);
+	appendValue<uint8_t>(out, TAS_SCRIPT_VERSION);
+	appendValue<uint8_t>(out, numOfPlayers);
+	appendValue<uint16_t>(out, framesPerBlock);
+	appendValue<uint32_t>(out, numOfFrames);
+	appendValue<uint32_t>(out, (numOfFrames + framesPerBlock - 1) / framesPerBlock);
+	return out;
+}
+
+std::vector<uint8_t> TasScriptEncoder::writeBlock(const std::vector<std::vector<uint8_t>>& playerBlocks) {
+	std::size_t size = playerBlocks.size() * sizeof(uint32_t);
+	for(auto const& player : playerBlocks) {
+		size += player.size();
+	}
+
+	std::vector<uint8_t> out;
+	out.reserve(size);
+	for(auto const& player : playerBlocks) {
+		appendValue<uint32_t>(out, player.size());
+	}
+	for(auto const& player : playerBlocks) {
+		out.insert(out.end(), player.begin(), player.end());
+	}
+	return out;
+}
+
+std::vector<uint8_t> TasScriptEncoder::assemble(const std::vector<std::vector<std::vector<uint8_t>>>& players, uint32_t numOfFrames, uint16_t framesPerBlock) {
+	uint32_t numOfBlocks = (numOfFrames + framesPerBlock - 1) / framesPerBlock;
+
+	std::vector<uint8_t> out = writeHeader(players.size(), numOfFrames, framesPerBlock);
+	std::vector<std::vector<uint8_t>> playerBlocks(players.size());
+	for(uint32_t blockIndex = 0; blockIndex < numOfBlocks; blockIndex++) {
+		for(std::size_t player = 0; player < players.size(); player++) {
+			playerBlocks[player] = blockIndex < players[player].size() ? players[player][blockIndex] : std::vector<uint8_t>();
+		}
+
+		std::vector<uint8_t> block = writeBlock(playerBlocks);
+		out.insert(out.end(), block.begin(), block.end());
+	}
+
+	return out;
+}
+
+bool TasScriptDecoder::open(Reader scriptReader) {
+	reader = scriptReader;
+
+	uint8_t header[HEADER_SIZE];
+	if(!reader(0, header, sizeof(header)) || !isCompactScript(header, sizeof(header)) || header[4] != TAS_SCRIPT_VERSION) {
+		return false;
+	}
+
+	numOfPlayers         = header[5];
+	framesPerBlock       = readValue<uint16_t>(&header[6]);
+	numOfFrames          = readValue<uint32_t>(&header[8]);
+	uint32_t numOfBlocks = readValue<uint32_t>(&header[12]);
+
+	if(framesPerBlock == 0 || numOfBlocks != (numOfFrames + framesPerBlock - 1) / framesPerBlock) {
+		return false;
+	}
+
+	// Walk the block sizes once, only a few bytes are read for every block
+	std::vector<uint8_t> playerSizes(numOfPlayers * sizeof(uint32_t));
+	blockOffsets.resize(numOfBlocks + 1);
+	blockOffsets[0] = HEADER_SIZE;
+	for(uint32_t blockIndex = 0; blockIndex < numOfBlocks; blockIndex++) {
+		if(!playerSizes.empty() && !reader(blockOffsets[blockIndex], playerSizes.data(), playerSizes.size())) {
+			return false;
+		}
+
+		uint64_t blockSize = playerSizes.size();
+		for(uint8_t player = 0; player < numOfPlayers; player++) {
+			uint32_t size = readValue<uint32_t>(&playerSizes[player * sizeof(uint32_t)]);
+			// Even every field changing every frame can't get bigger, a broken size would allocate forever
+			if(size > (uint64_t)framesPerBlock * (1 + maskSizes[TAS_FIELD_ALL])) {
+				return false;
+			}
+			blockSize += size;
+		}
+		blockOffsets[blockIndex + 1] = blockOffsets[blockIndex] + blockSize;
+	}
+
+	cursors.resize(numOfPlayers);
+	loadedBlock  = UINT32_MAX;
+	currentFrame = 0;
+	return true;
+}
+
+bool TasScriptDecoder::loadBlock(uint32_t blockIndex) {
+	if(blockIndex + 1 >= blockOffsets.size()) {
+		return false;
+	}
+
+	// The buffer keeps its memory, blocks are about the same size
+	block.resize(blockOffsets[blockIndex + 1] - blockOffsets[blockIndex]);
+	if(block.size() < numOfPlayers * sizeof(uint32_t) || !reader(blockOffsets[blockIndex], block.data(), block.size())) {
+		return false;
+	}
+
+	const uint8_t* pos = block.data() + numOfPlayers * sizeof(uint32_t);
+	const uint8_t* end = block.data() + block.size();
+	for(uint8_t player = 0; player < numOfPlayers; player++) {
+		uint32_t size = readValue<uint32_t>(&block[player * sizeof(uint32_t)]);
+		if(size > (std::size_t)(end - pos)) {
+			return false;
+		}
+
+		cursors[player].pos         = pos;
+		cursors[player].end         = pos + size;
+		cursors[player].repeatsLeft = 0;
+		pos += size;
+	}
+
+	loadedBlock = blockIndex;
+	return true;
+}
+
+bool TasScriptDecoder::seek(uint32_t frame) {
+	if(frame > numOfFrames) {
+		return false;
+	}
+
+	// Start at the keyframe and skip the rest
+	currentFrame = frame - frame % framesPerBlock;
+	loadedBlock  = UINT32_MAX;
+
+	std::vector<TasScriptFrame> skipped;
+	while(currentFrame != frame) {
+		if(!readFrame(skipped)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool TasScriptDecoder::readFrame(std::vector<TasScriptFrame>& frames) {
+	if(currentFrame >= numOfFrames) {
+		return false;
+	}
+
+	uint32_t blockIndex = currentFrame / framesPerBlock;
+	if(blockIndex != loadedBlock && !loadBlock(blockIndex)) {
+		return false;
+	}
+
+	frames.resize(numOfPlayers);
+	for(uint8_t player = 0; player < numOfPlayers; player++) {
+		PlayerCursor& cursor = cursors[player];
+
+		if(cursor.repeatsLeft != 0) {
+			cursor.repeatsLeft--;
+		} else {
+			if(cursor.pos == cursor.end) {
+				return false;
+			}
+
+			uint8_t mask = *cursor.pos++;
+			if(mask & TAS_RECORD_REPEAT) {
+				if(cursor.pos == cursor.end || *cursor.pos == 0) {
+					return false;
+				}
+				cursor.repeatsLeft = *cursor.pos++ - 1;
+			} else {
+				if(mask > TAS_FIELD_ALL || maskSizes[mask] > cursor.end - cursor.pos) {
+					return false;
+				}
+
+				// Only walks the set bits
+				while(mask != 0) {
+					uint8_t field = __builtin_ctz(mask);
+					memcpy((uint8_t*)&cursor.frame + fieldOffsets[field], cursor.pos, fieldSizes[field]);
+					cursor.pos += fieldSizes[field];
+					mask &= mask - 1;
+				}
+			}
+		}
+
+		frames[player] = cursor.frame;
+	}
+
+	currentFrame++;
+	return true;
+}
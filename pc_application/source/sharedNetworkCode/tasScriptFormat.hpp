@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "buttonData.hpp"
+
+// Compact final TAS script, every player in one file
+//
+// Header, little endian:
+//   char magic[4], uint8_t version, uint8_t numOfPlayers, uint16_t framesPerBlock,
+//   uint32_t numOfFrames, uint32_t numOfBlocks
+//   Everything in it is known before encoding, so the file can be sent while it is encoded
+// Block:
+//   uint32_t playerSizes[numOfPlayers], then each player's records one after another
+//   Blocks follow each other with no index, the decoder finds them from the sizes when opening
+// Record:
+//   uint8_t mask, then only the fields in the mask, in bit order
+//   With TAS_RECORD_REPEAT, one uint8_t saying how many times the last frame repeats instead
+//
+// The first record of every block has every field, so any block can be decoded on its own
+#define TAS_SCRIPT_MAGIC "STAS"
+#define TAS_SCRIPT_VERSION 2
+// 10 seconds, how far a seek has to decode at most
+#define TAS_SCRIPT_FRAMES_PER_BLOCK 600
+
+enum TasScriptFields : uint8_t {
+	TAS_FIELD_BUTTONS        = 1 << 0,
+	TAS_FIELD_LEFT_JOYSTICK  = 1 << 1,
+	TAS_FIELD_RIGHT_JOYSTICK = 1 << 2,
+	TAS_FIELD_ACCEL          = 1 << 3,
+	TAS_FIELD_GYRO           = 1 << 4,
+	TAS_FIELD_ALL            = 0x1F,
+	TAS_RECORD_REPEAT        = 1 << 7,
+};
+
+// Plain copy of what the switch needs from ControllerData, fields are laid out in mask order
+// The editor only frame state is left out
+struct TasScriptFrame {
+	uint32_t buttons;
+	int16_t leftJoystick[2];
+	int16_t rightJoystick[2];
+	int16_t accel[3];
+	int16_t gyro[3];
+
+	static TasScriptFrame fromControllerData(const ControllerData& data);
+	void toControllerData(ControllerData& data) const;
+};
+
+class TasScriptEncoder {
+private:
+	static void writeFrameFields(std::vector<uint8_t>& out, const TasScriptFrame& frame, uint8_t mask);
+
+public:
+	// One player's frames for one block, every player is encoded separately so they can be done in parallel
+	static std::vector<uint8_t> encodeBlock(const TasScriptFrame* frames, std::size_t numOfFrames);
+	// All blocks of one player, one buffer per block
+	static std::vector<std::vector<uint8_t>> encodePlayer(const std::vector<TasScriptFrame>& frames, uint16_t framesPerBlock = TAS_SCRIPT_FRAMES_PER_BLOCK);
+
+	// Files are written as the header, then every block in order
+	static std::vector<uint8_t> writeHeader(uint8_t numOfPlayers, uint32_t numOfFrames, uint16_t framesPerBlock = TAS_SCRIPT_FRAMES_PER_BLOCK);
+	// Block encoded by every player, in player order
+	static std::vector<uint8_t> writeBlock(const std::vector<std::vector<uint8_t>>& playerBlocks);
+	// The whole file at once, players need to have the same number of frames
+	static std::vector<uint8_t> assemble(const std::vector<std::vector<std::vector<uint8_t>>>& players, uint32_t numOfFrames, uint16_t framesPerBlock = TAS_SCRIPT_FRAMES_PER_BLOCK);
+};
+
+class TasScriptDecoder {
+public:
+	// Reads size bytes at offset, returns false on failure
+	typedef std::function<bool(uint64_t offset, void* data, std::size_t size)> Reader;
+
+private:
+	struct PlayerCursor {
+		const uint8_t* pos;
+		const uint8_t* end;
+		uint8_t repeatsLeft;
+		TasScriptFrame frame;
+	};
+
+	Reader reader;
+
+	uint8_t numOfPlayers    = 0;
+	uint16_t framesPerBlock = 0;
+	uint32_t numOfFrames    = 0;
+	// Found when opening, the last one is the end of the file
+	std::vector<uint64_t> blockOffsets;
+
+	// Only the current block is in memory
+	std::vector<uint8_t> block;
+	std::vector<PlayerCursor> cursors;
+	uint32_t loadedBlock  = UINT32_MAX;
+	uint32_t currentFrame = 0;
+
+	bool loadBlock(uint32_t blockIndex);
+
+public:
+	// Files without the magic aren't in this format, so the old one can be used
+	static bool isCompactScript(const uint8_t* data, std::size_t size) {
+		return size >= 4 && memcmp(data, TAS_SCRIPT_MAGIC, 4) == 0;
+	}
+
+	bool open(Reader scriptReader);
+	bool seek(uint32_t frame);
+	// One frame for every player, false at the end or on a broken file
+	bool readFrame(std::vector<TasScriptFrame>& frames);
+
+	uint8_t getNumOfPlayers() {
+		return numOfPlayers;
+	}
+
+	uint32_t getNumOfFrames() {
+		return numOfFrames;
+	}
+
+	uint32_t getCurrentFrame() {
+		return currentFrame;
+	}
+};
@@ -135,8 +135,10 @@ JoystickCanvas::JoystickCanvas(rapidjson::Document* settings, wxFrame* parent, D
 	xInput->Bind(wxEVT_COMMAND_SPINCTRL_UPDATED, &JoystickCanvas::xValueSet, this);
 	yInput->Bind(wxEVT_COMMAND_SPINCTRL_UPDATED, &JoystickCanvas::yValueSet, this);
 
-	Bind(wxEVT_LEFT_DOWN, &JoystickCanvas::onMouseClick, this);
+	Bind(wxEVT_LEFT_DOWN, &JoystickCanvas::onLeftDown, this);
+	Bind(wxEVT_LEFT_UP, &JoystickCanvas::onLeftUp, this);
 	Bind(wxEVT_MOTION, &JoystickCanvas::onMouseDrag, this);
+	Bind(wxEVT_MOUSE_CAPTURE_LOST, &JoystickCanvas::onCaptureLost, this);
 
 	xInput->SetRange(ButtonData::axisMin, ButtonData::axisMax);
 	yInput->SetRange(ButtonData::axisMin, ButtonData::axisMax);
@@ -289,6 +291,25 @@ void JoystickCanvas::onMouseDrag(wxMouseEvent& event) {
 	}
 }
 
+void JoystickCanvas::onLeftDown(wxMouseEvent& event) {
+	inputInstance->getEditHistory().beginDrag();
+	CaptureMouse();
+	onMouseClick(event);
+}
+
+void JoystickCanvas::onLeftUp(wxMouseEvent& event) {
+	if(HasCapture()) {
+		ReleaseMouse();
+	}
+	inputInstance->getEditHistory().endDrag();
+	event.Skip();
+}
+
+void JoystickCanvas::onCaptureLost(wxMouseCaptureLostEvent& event) {
+	// wxWidgets requires this to be handled when capturing
+	inputInstance->getEditHistory().endDrag();
+}
+
 void JoystickCanvas::xValueSet(wxSpinEvent& event) {
 	int position = event.GetPosition();
 	if(position > ButtonData::axisMax) {
@@ -432,9 +453,8 @@ void BottomUI::refreshDataViews(uint8_t refreshFramebuffer) {
 	buttonGrid->Refresh();
 	if(refreshFramebuffer) {
 		// Check to see if framebuffer is avaliable to draw
-		wxFileName framebufferFileName = inputInstance->getFramebufferPathForCurrentFramebuf();
-		if(framebufferFileName.FileExists()) {
-			wxImage framebuf(framebufferFileName.GetFullPath(), wxBITMAP_TYPE_JPEG);
+		wxImage framebuf;
+		if(inputInstance->getCurrentFramebuffer(framebuf)) {
 			frameViewerCanvas->setPrimaryBitmap(new wxBitmap(framebuf));
 		} else {
 			// Go back to default
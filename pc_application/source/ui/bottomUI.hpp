@@ -90,6 +90,10 @@ private:
 
 	void onMouseClick(wxMouseEvent& event);
 	void onMouseDrag(wxMouseEvent& event);
+	// The whole drag is one undo
+	void onLeftDown(wxMouseEvent& event);
+	void onLeftUp(wxMouseEvent& event);
+	void onCaptureLost(wxMouseCaptureLostEvent& event);
 
 public:
 	JoystickCanvas(rapidjson::Document* settings, wxFrame* parent, DataProcessing* inputData, uint8_t leftJoy);
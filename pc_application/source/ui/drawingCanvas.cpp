@@ -1,7 +1,7 @@
 #include "drawingCanvas.hpp"
 
-DrawingCanvas::DrawingCanvas(wxWindow* parent, wxSize size)
-	: wxWindow(parent, wxID_ANY, wxDefaultPosition, size, wxFULL_REPAINT_ON_RESIZE) {
+DrawingCanvas::DrawingCanvas(wxWindow* parent, wxSize size, long style)
+	: wxWindow(parent, wxID_ANY, wxDefaultPosition, size, wxFULL_REPAINT_ON_RESIZE | style) {
 	// By default it's black
 	backgroundColor  = *wxBLACK;
 	panningOffset    = wxPoint(0, 0);
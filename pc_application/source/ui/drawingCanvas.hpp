@@ -19,7 +19,8 @@ protected:
 	bool leftUp = true;
 
 public:
-	DrawingCanvas(wxWindow* parent, wxSize size);
+	// Extra styles, like scrollbars, can be passed in
+	DrawingCanvas(wxWindow* parent, wxSize size, long style = 0);
 
 	// To be overriden
 	virtual void draw(wxDC& dc) = 0;
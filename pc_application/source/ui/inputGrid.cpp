@@ -0,0 +1,520 @@
+#include "inputGrid.hpp"
+
+InputGrid::InputGrid(wxWindow* parent)
+	: DrawingCanvas(parent, wxDefaultSize, wxVSCROLL | wxHSCROLL | wxWANTS_CHARS) {
+	// Painting is already buffered by DrawingCanvas
+	SetDoubleBuffered(false);
+
+	// Same colors the list used to have
+	wxColour background = wxSystemSettings::GetColour(wxSYS_COLOUR_LISTBOX);
+	SetBackgroundColour(background);
+	setBackgroundColor(background);
+
+	// Darker on light themes, lighter on dark themes
+	bool isDark         = background.Red() + background.Green() + background.Blue() < 384;
+	alternateRowColour  = background.ChangeLightness(isDark ? 115 : 95);
+	selectionColour     = wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHT);
+	selectionTextColour = wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHTTEXT);
+	headerColour        = wxSystemSettings::GetColour(wxSYS_COLOUR_BTNFACE);
+	gridLineColour      = background.ChangeLightness(isDark ? 130 : 85);
+	diffAddedColour     = wxColour(46, 160, 67);
+	diffChangedColour   = wxColour(210, 153, 34);
+	diffRemovedColour   = wxColour(248, 81, 73);
+
+	// Dynamic handlers go before the zooming and panning of DrawingCanvas
+	Bind(wxEVT_SCROLLWIN_TOP, &InputGrid::onScroll, this);
+	Bind(wxEVT_SCROLLWIN_BOTTOM, &InputGrid::onScroll, this);
+	Bind(wxEVT_SCROLLWIN_LINEUP, &InputGrid::onScroll, this);
+	Bind(wxEVT_SCROLLWIN_LINEDOWN, &InputGrid::onScroll, this);
+	Bind(wxEVT_SCROLLWIN_PAGEUP, &InputGrid::onScroll, this);
+	Bind(wxEVT_SCROLLWIN_PAGEDOWN, &InputGrid::onScroll, this);
+	Bind(wxEVT_SCROLLWIN_THUMBTRACK, &InputGrid::onScroll, this);
+	Bind(wxEVT_SCROLLWIN_THUMBRELEASE, &InputGrid::onScroll, this);
+	Bind(wxEVT_MOUSEWHEEL, &InputGrid::onMouseWheel, this);
+	Bind(wxEVT_LEFT_DOWN, &InputGrid::onLeftDown, this);
+	Bind(wxEVT_LEFT_DCLICK, &InputGrid::onLeftDoubleClick, this);
+	Bind(wxEVT_MOTION, &InputGrid::onMouseDrag, this);
+	Bind(wxEVT_LEFT_UP, &InputGrid::onLeftUp, this);
+	Bind(wxEVT_MOUSE_CAPTURE_LOST, &InputGrid::onCaptureLost, this);
+	Bind(wxEVT_KEY_DOWN, &InputGrid::onKeyDown, this);
+	Bind(wxEVT_SIZE, &InputGrid::onSize, this);
+}
+
+void InputGrid::setColumns(std::vector<wxString> names, std::vector<wxBitmap*> icons, wxColour maskColor) {
+	columnNames = names;
+
+	if(!icons.empty()) {
+		iconWidth  = icons[0]->GetWidth();
+		iconHeight = icons[0]->GetHeight();
+
+		// Transparent parts are left as the mask color, then masked out of the whole atlas at once
+		iconAtlas = wxBitmap(iconWidth * (int)icons.size(), iconHeight);
+		wxMemoryDC atlasDC(iconAtlas);
+		atlasDC.SetBackground(wxBrush(maskColor));
+		atlasDC.Clear();
+		for(std::size_t i = 0; i < icons.size(); i++) {
+			atlasDC.DrawBitmap(*icons[i], i * iconWidth, 0, true);
+		}
+		atlasDC.SelectObject(wxNullBitmap);
+		iconAtlas.SetMask(new wxMask(iconAtlas, maskColor));
+	}
+
+	wxClientDC dc(this);
+	dc.SetFont(GetFont());
+	wxSize textSize = dc.GetTextExtent("00000000");
+
+	// Shouldn't be the exact width, it's a bit too small that way
+	buttonColumnWidth = std::max((int)(iconWidth * 1.5f), dc.GetTextExtent("ZR").GetWidth() + 8);
+	frameColumnWidth  = textSize.GetWidth() + 8;
+	rowHeight         = std::max(iconHeight, textSize.GetHeight()) + 4;
+	headerHeight      = textSize.GetHeight() + 8;
+
+	updateScrollbars();
+	Refresh();
+}
+
+void InputGrid::draw(wxDC& dc) {
+	auto start = std::chrono::steady_clock::now();
+
+	int width;
+	int height;
+	GetClientSize(&width, &height);
+
+	dc.SetFont(GetFont());
+
+	// Partially visible rows at the bottom are drawn too
+	FrameNum lastRow = topRow + (std::max(0, height - headerHeight) + rowHeight - 1) / rowHeight;
+	if(numOfRows != 0) {
+		lastRow = std::min(lastRow, numOfRows - 1);
+		prepareRows(topRow, lastRow);
+	}
+
+	bool haveAtlas = iconAtlas.IsOk();
+	wxMemoryDC atlasDC;
+	if(haveAtlas) {
+		atlasDC.SelectObjectAsSource(iconAtlas);
+	}
+
+	int rowWidth = std::min(width, getTotalWidth() - leftOffset);
+	dc.SetPen(*wxTRANSPARENT_PEN);
+
+	for(FrameNum row = topRow; numOfRows != 0 && row <= lastRow; row++) {
+		int y = headerHeight + (row - topRow) * rowHeight;
+
+		bool selected = isRowSelected(row);
+		wxColour background;
+		if(selected) {
+			background = selectionColour;
+		} else {
+			// Plain rows alternate so the eye can follow them
+			const wxItemAttr* attr = getRowAttr(row);
+			if(attr != NULL && attr->HasBackgroundColour() && attr->GetBackgroundColour() != GetBackgroundColour()) {
+				background = attr->GetBackgroundColour();
+			} else {
+				background = row % 2 == 1 ? alternateRowColour : GetBackgroundColour();
+			}
+		}
+
+		dc.SetBrush(wxBrush(background));
+		dc.DrawRectangle(0, y, rowWidth, rowHeight);
+
+		uint8_t diffMark = getRowDiffMark(row);
+		if(diffMark != DIFF_NONE) {
+			drawDiffMark(dc, diffMark, y);
+		}
+
+		// Frame number
+		wxString frameText = wxString::Format("%u", row);
+		wxSize textSize    = dc.GetTextExtent(frameText);
+		dc.SetTextForeground(selected ? selectionTextColour : GetForegroundColour());
+		dc.DrawText(frameText, (frameColumnWidth - textSize.GetWidth()) / 2 - leftOffset, y + (rowHeight - textSize.GetHeight()) / 2);
+
+		// Only the icons of pressed buttons are drawn
+		uint32_t buttons = getRowButtons(row);
+		int iconY        = y + (rowHeight - iconHeight) / 2;
+		while(buttons != 0 && haveAtlas) {
+			uint8_t button = __builtin_ctz(buttons);
+			if(button >= columnNames.size()) {
+				break;
+			}
+			int iconX = frameColumnWidth + button * buttonColumnWidth + (buttonColumnWidth - iconWidth) / 2 - leftOffset;
+			dc.Blit(iconX, iconY, iconWidth, iconHeight, &atlasDC, button * iconWidth, 0, wxCOPY, true);
+			buttons &= buttons - 1;
+		}
+
+		if(row == focusedRow) {
+			dc.SetPen(wxPen(GetForegroundColour(), 1, wxPENSTYLE_DOT));
+			dc.SetBrush(*wxTRANSPARENT_BRUSH);
+			dc.DrawRectangle(0, y, rowWidth, rowHeight);
+			dc.SetPen(*wxTRANSPARENT_PEN);
+		}
+	}
+
+	// Horizontal rules, like the list had
+	dc.SetPen(wxPen(gridLineColour));
+	for(FrameNum row = topRow; numOfRows != 0 && row <= lastRow; row++) {
+		int y = headerHeight + (row - topRow + 1) * rowHeight - 1;
+		dc.DrawLine(0, y, rowWidth, y);
+	}
+
+	drawHeader(dc, width);
+
+	recordPaint(std::chrono::steady_clock::now() - start);
+}
+
+void InputGrid::drawHeader(wxDC& dc, int width) {
+	dc.SetPen(wxPen(gridLineColour));
+	dc.SetBrush(wxBrush(headerColour));
+	dc.DrawRectangle(0, 0, width, headerHeight);
+	dc.SetTextForeground(GetForegroundColour());
+
+	wxString frameText = "Frame";
+	wxSize textSize    = dc.GetTextExtent(frameText);
+	dc.DrawText(frameText, (frameColumnWidth - textSize.GetWidth()) / 2 - leftOffset, (headerHeight - textSize.GetHeight()) / 2);
+	dc.DrawLine(frameColumnWidth - leftOffset, 0, frameColumnWidth - leftOffset, headerHeight);
+
+	for(std::size_t i = 0; i < columnNames.size(); i++) {
+		int x = frameColumnWidth + (int)i * buttonColumnWidth - leftOffset;
+		if(x + buttonColumnWidth < 0 || x > width) {
+			continue;
+		}
+
+		textSize = dc.GetTextExtent(columnNames[i]);
+		dc.DrawText(columnNames[i], x + (buttonColumnWidth - textSize.GetWidth()) / 2, (headerHeight - textSize.GetHeight()) / 2);
+		dc.DrawLine(x + buttonColumnWidth, 0, x + buttonColumnWidth, headerHeight);
+	}
+}
+
+void InputGrid::drawDiffMark(wxDC& dc, uint8_t mark, int y) {
+	// Like the gutter of a text editor, a strip for changed or added rows and a line where rows were removed
+	if(mark & (DIFF_CHANGED | DIFF_ADDED)) {
+		dc.SetBrush(wxBrush((mark & DIFF_ADDED) ? diffAddedColour : diffChangedColour));
+		dc.DrawRectangle(-leftOffset, y, INPUT_GRID_GUTTER_WIDTH, rowHeight);
+	}
+
+	dc.SetBrush(wxBrush(diffRemovedColour));
+	if(mark & DIFF_REMOVED_ABOVE) {
+		dc.DrawRectangle(-leftOffset, y, frameColumnWidth, 2);
+	}
+	if(mark & DIFF_REMOVED_BELOW) {
+		dc.DrawRectangle(-leftOffset, y + rowHeight - 2, frameColumnWidth, 2);
+	}
+}
+
+void InputGrid::recordPaint(std::chrono::steady_clock::duration paintTime) {
+	totalPaintTime += paintTime;
+	numOfPaintedPages++;
+
+	if(numOfPaintedPages == INPUT_GRID_PROFILE_PAGES) {
+		double microseconds = std::chrono::duration<double, std::micro>(totalPaintTime).count();
+		wxLogDebug(wxString::Format("Input grid paint: %.2f us per page over %u pages", microseconds / numOfPaintedPages, numOfPaintedPages));
+
+		totalPaintTime    = std::chrono::steady_clock::duration::zero();
+		numOfPaintedPages = 0;
+	}
+}
+
+void InputGrid::updateScrollbars() {
+	int width;
+	int height;
+	GetClientSize(&width, &height);
+
+	FrameNum rowsPerPage = getRowsPerPage();
+	if(numOfRows <= rowsPerPage) {
+		topRow = 0;
+	} else if(topRow > numOfRows - rowsPerPage) {
+		topRow = numOfRows - rowsPerPage;
+	}
+	SetScrollbar(wxVERTICAL, topRow, rowsPerPage, numOfRows);
+
+	int totalWidth = getTotalWidth();
+	leftOffset     = std::max(0, std::min(leftOffset, totalWidth - width));
+	SetScrollbar(wxHORIZONTAL, leftOffset, width, totalWidth);
+}
+
+void InputGrid::scrollToRow(long row) {
+	FrameNum rowsPerPage = getRowsPerPage();
+	long maxTop          = numOfRows > rowsPerPage ? numOfRows - rowsPerPage : 0;
+	FrameNum newTop      = std::max<long>(0, std::min(row, maxTop));
+
+	if(newTop != topRow) {
+		topRow = newTop;
+		SetScrollPos(wxVERTICAL, topRow);
+		Refresh(false);
+	}
+}
+
+void InputGrid::onScroll(wxScrollWinEvent& event) {
+	wxEventType type = event.GetEventType();
+
+	if(event.GetOrientation() == wxHORIZONTAL) {
+		int width = GetClientSize().GetWidth();
+		int step  = buttonColumnWidth;
+
+		int newOffset = leftOffset;
+		if(type == wxEVT_SCROLLWIN_LINEUP) {
+			newOffset -= step;
+		} else if(type == wxEVT_SCROLLWIN_LINEDOWN) {
+			newOffset += step;
+		} else if(type == wxEVT_SCROLLWIN_PAGEUP) {
+			newOffset -= width;
+		} else if(type == wxEVT_SCROLLWIN_PAGEDOWN) {
+			newOffset += width;
+		} else if(type == wxEVT_SCROLLWIN_TOP) {
+			newOffset = 0;
+		} else if(type == wxEVT_SCROLLWIN_BOTTOM) {
+			newOffset = getTotalWidth();
+		} else {
+			newOffset = event.GetPosition();
+		}
+
+		leftOffset = std::max(0, std::min(newOffset, getTotalWidth() - width));
+		SetScrollPos(wxHORIZONTAL, leftOffset);
+		Refresh(false);
+		return;
+	}
+
+	long rowsPerPage = getRowsPerPage();
+	if(type == wxEVT_SCROLLWIN_LINEUP) {
+		scrollToRow((long)topRow - 1);
+	} else if(type == wxEVT_SCROLLWIN_LINEDOWN) {
+		scrollToRow((long)topRow + 1);
+	} else if(type == wxEVT_SCROLLWIN_PAGEUP) {
+		scrollToRow((long)topRow - rowsPerPage);
+	} else if(type == wxEVT_SCROLLWIN_PAGEDOWN) {
+		scrollToRow((long)topRow + rowsPerPage);
+	} else if(type == wxEVT_SCROLLWIN_TOP) {
+		scrollToRow(0);
+	} else if(type == wxEVT_SCROLLWIN_BOTTOM) {
+		scrollToRow(numOfRows);
+	} else {
+		// Thumb dragging, only the visible page is drawn so this stays smooth
+		scrollToRow(event.GetPosition());
+	}
+}
+
+void InputGrid::onMouseWheel(wxMouseEvent& event) {
+	int ticks = event.GetWheelRotation() / event.GetWheelDelta();
+	if(event.GetWheelAxis() == wxMOUSE_WHEEL_HORIZONTAL) {
+		int width  = GetClientSize().GetWidth();
+		leftOffset = std::max(0, std::min(leftOffset + ticks * buttonColumnWidth, getTotalWidth() - width));
+		SetScrollPos(wxHORIZONTAL, leftOffset);
+		Refresh(false);
+	} else {
+		scrollToRow((long)topRow - ticks * INPUT_GRID_WHEEL_ROWS);
+	}
+}
+
+void InputGrid::moveFocus(long row, bool extendSelection, bool addToSelection) {
+	if(numOfRows == 0) {
+		return;
+	}
+
+	row = std::max<long>(0, std::min<long>(row, numOfRows - 1));
+
+	if(extendSelection && !selection.empty()) {
+		selection = selectionBase;
+		selection.add(selectionAnchor, row);
+	} else if(addToSelection) {
+		// Clicking a selected row with control deselects it
+		selection.toggle(row, row);
+		selectionBase = selection;
+		selectionBase.remove(row, row);
+		selectionAnchor = row;
+	} else {
+		selection.clear();
+		selection.add(row, row);
+		selectionBase.clear();
+		selectionAnchor = row;
+	}
+	Refresh(false);
+
+	ensureVisible(row);
+	setFocusedRow(row);
+	onRowFocused(row);
+}
+
+void InputGrid::onLeftDown(wxMouseEvent& event) {
+	SetFocus();
+
+	long row = hitTestRow(event.GetPosition());
+	if(row != wxNOT_FOUND) {
+		// Keep the selection when extending it, the anchor stays put
+		moveFocus(row, event.ShiftDown(), event.ControlDown());
+		draggingSelection = true;
+		CaptureMouse();
+	}
+}
+
+void InputGrid::onLeftDoubleClick(wxMouseEvent& event) {
+	long row = hitTestRow(event.GetPosition());
+	if(row != wxNOT_FOUND) {
+		onRowActivated(row);
+	}
+}
+
+void InputGrid::onMouseDrag(wxMouseEvent& event) {
+	if(draggingSelection && event.LeftIsDown()) {
+		int y = event.GetPosition().y;
+		long row;
+		if(y < headerHeight) {
+			// Above the rows, scroll up while dragging
+			row = (long)topRow - 1;
+		} else {
+			row = topRow + (y - headerHeight) / rowHeight;
+		}
+		moveFocus(row, true);
+	}
+}
+
+void InputGrid::onLeftUp(wxMouseEvent& event) {
+	if(draggingSelection) {
+		draggingSelection = false;
+		if(HasCapture()) {
+			ReleaseMouse();
+		}
+	}
+	event.Skip();
+}
+
+void InputGrid::onCaptureLost(wxMouseCaptureLostEvent& event) {
+	// wxWidgets requires this to be handled when capturing
+	draggingSelection = false;
+}
+
+void InputGrid::onKeyDown(wxKeyEvent& event) {
+	long rowsPerPage = std::max<long>(1, getRowsPerPage());
+	bool shift       = event.ShiftDown();
+
+	switch(event.GetKeyCode()) {
+	case WXK_UP:
+		moveFocus((long)focusedRow - 1, shift);
+		break;
+	case WXK_DOWN:
+		moveFocus((long)focusedRow + 1, shift);
+		break;
+	case WXK_PAGEUP:
+		moveFocus((long)focusedRow - rowsPerPage, shift);
+		break;
+	case WXK_PAGEDOWN:
+		moveFocus((long)focusedRow + rowsPerPage, shift);
+		break;
+	case WXK_HOME:
+		moveFocus(0, shift);
+		break;
+	case WXK_END:
+		moveFocus((long)numOfRows - 1, shift);
+		break;
+	case WXK_RETURN:
+	case WXK_NUMPAD_ENTER:
+		onRowActivated(focusedRow);
+		break;
+	default:
+		// Accelerators and the like
+		event.Skip();
+		break;
+	}
+}
+
+void InputGrid::onSize(wxSizeEvent& event) {
+	updateScrollbars();
+	event.Skip();
+}
+
+void InputGrid::setRowCount(FrameNum count) {
+	numOfRows = count;
+
+	selection.clamp(count);
+	selectionBase.clamp(count);
+	if(count == 0) {
+		focusedRow = 0;
+	} else {
+		focusedRow = std::min(focusedRow, count - 1);
+	}
+
+	updateScrollbars();
+	Refresh(false);
+}
+
+void InputGrid::refreshRow(FrameNum row) {
+	if(isRowVisible(row)) {
+		RefreshRect(getRowRect(row), false);
+	}
+}
+
+void InputGrid::ensureVisible(FrameNum row) {
+	FrameNum rowsPerPage = std::max<FrameNum>(1, getRowsPerPage());
+	if(row < topRow) {
+		scrollToRow(row);
+	} else if(row >= topRow + rowsPerPage) {
+		scrollToRow((long)row - rowsPerPage + 1);
+	}
+}
+
+bool InputGrid::isRowVisible(FrameNum row) const {
+	int height = GetClientSize().GetHeight();
+	// Partially visible rows count
+	FrameNum numVisible = (std::max(0, height - headerHeight) + rowHeight - 1) / rowHeight;
+	return row >= topRow && row < topRow + numVisible;
+}
+
+FrameNum InputGrid::getRowsPerPage() const {
+	int height = GetClientSize().GetHeight();
+	return std::max(0, height - headerHeight) / rowHeight;
+}
+
+wxRect InputGrid::getRowRect(FrameNum row) const {
+	int width = GetClientSize().GetWidth();
+	// Rows above the top get negative positions, like the list did
+	return wxRect(0, headerHeight + (int)((long)row - (long)topRow) * rowHeight, width, rowHeight);
+}
+
+long InputGrid::hitTestRow(wxPoint point) const {
+	if(point.y < headerHeight || point.x + leftOffset >= getTotalWidth()) {
+		return wxNOT_FOUND;
+	}
+
+	FrameNum row = topRow + (point.y - headerHeight) / rowHeight;
+	if(row >= numOfRows) {
+		return wxNOT_FOUND;
+	}
+	return row;
+}
+
+void InputGrid::setFocusedRow(FrameNum row) {
+	if(row != focusedRow) {
+		refreshRow(focusedRow);
+		focusedRow = row;
+	}
+	refreshRow(focusedRow);
+}
+
+void InputGrid::setSelection(FrameNum start, FrameNum end) {
+	if(numOfRows == 0) {
+		return;
+	}
+
+	selection.clear();
+	selection.add(start, end);
+	selection.clamp(numOfRows);
+	selectionBase.clear();
+	selectionAnchor = std::min(start, end);
+	// Cheap, only the visible page is ever drawn
+	Refresh(false);
+}
+
+void InputGrid::setSelection(const FrameSelection& frames) {
+	selection = frames;
+	selection.clamp(numOfRows);
+	selectionBase.clear();
+	if(!selection.empty()) {
+		selectionAnchor = selection.first();
+	}
+	Refresh(false);
+}
+
+void InputGrid::clearSelection() {
+	selection.clear();
+	selectionBase.clear();
+	Refresh(false);
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <wx/dcbuffer.h>
+#include <wx/itemattr.h>
+#include <wx/settings.h>
+#include <wx/wx.h>
+
+#include "../dataHandling/branchDiff.hpp"
+#include "../dataHandling/buttonConstants.hpp"
+#include "../dataHandling/frameSelection.hpp"
+#include "drawingCanvas.hpp"
+
+// How many painted pages to average before logging the paint time
+#define INPUT_GRID_PROFILE_PAGES 200
+// Rows scrolled by one mouse wheel notch
+#define INPUT_GRID_WHEEL_ROWS 3
+// Width of the diff marks on the left of the frame column
+#define INPUT_GRID_GUTTER_WIDTH 4
+
+// Custom drawn grid of frames, one icon column per button
+// Only the rows on screen are ever asked for, so the number of frames doesn't matter
+// The selection is a set of ranges instead of a flag on every row
+class InputGrid : public DrawingCanvas {
+private:
+	// Every on icon side by side, scaled once and blitted from
+	wxBitmap iconAtlas;
+	int iconWidth  = 0;
+	int iconHeight = 0;
+
+	std::vector<wxString> columnNames;
+
+	int rowHeight         = 1;
+	int headerHeight      = 0;
+	int frameColumnWidth  = 0;
+	int buttonColumnWidth = 0;
+
+	FrameNum numOfRows = 0;
+	FrameNum topRow    = 0;
+	// Horizontal scroll in pixels, the columns are usually wider than the window
+	int leftOffset = 0;
+
+	FrameNum focusedRow = 0;
+	FrameSelection selection;
+	// What was selected before the anchor was set, shift extends from the anchor on top of it
+	FrameSelection selectionBase;
+	FrameNum selectionAnchor = 0;
+	bool draggingSelection   = false;
+
+	wxColour alternateRowColour;
+	wxColour selectionColour;
+	wxColour selectionTextColour;
+	wxColour headerColour;
+	wxColour gridLineColour;
+	wxColour diffAddedColour;
+	wxColour diffChangedColour;
+	wxColour diffRemovedColour;
+
+	std::chrono::steady_clock::duration totalPaintTime = std::chrono::steady_clock::duration::zero();
+	uint32_t numOfPaintedPages                         = 0;
+
+	int getTotalWidth() const {
+		return frameColumnWidth + buttonColumnWidth * (int)columnNames.size();
+	}
+
+	void updateScrollbars();
+	void scrollToRow(long row);
+	// Control adds to the selection instead of replacing it
+	void moveFocus(long row, bool extendSelection, bool addToSelection = false);
+
+	void drawHeader(wxDC& dc, int width);
+	void drawDiffMark(wxDC& dc, uint8_t mark, int y);
+	void recordPaint(std::chrono::steady_clock::duration paintTime);
+
+	void onScroll(wxScrollWinEvent& event);
+	void onMouseWheel(wxMouseEvent& event);
+	void onLeftDown(wxMouseEvent& event);
+	void onLeftDoubleClick(wxMouseEvent& event);
+	void onMouseDrag(wxMouseEvent& event);
+	void onLeftUp(wxMouseEvent& event);
+	void onCaptureLost(wxMouseCaptureLostEvent& event);
+	void onKeyDown(wxKeyEvent& event);
+	void onSize(wxSizeEvent& event);
+
+protected:
+	// Row data, only asked for rows on screen
+	virtual uint32_t getRowButtons(FrameNum row) const = 0;
+	// Returning NULL uses the default background
+	virtual const wxItemAttr* getRowAttr(FrameNum row) const = 0;
+	// BranchDiffMark flags for the gutter, nothing is drawn by default
+	virtual uint8_t getRowDiffMark(FrameNum row) const {
+		return DIFF_NONE;
+	}
+	// Called with the rows about to be painted, like the cache hint of the list
+	virtual void prepareRows(FrameNum first, FrameNum last) {}
+
+	virtual void onRowFocused(FrameNum row) {}
+	// Double click
+	virtual void onRowActivated(FrameNum row) {}
+
+public:
+	InputGrid(wxWindow* parent);
+
+	// Names and icons in button order, the icons need to be the same size
+	void setColumns(std::vector<wxString> names, std::vector<wxBitmap*> icons, wxColour maskColor);
+
+	virtual void draw(wxDC& dc) override;
+
+	void setRowCount(FrameNum count);
+	FrameNum getRowCount() const {
+		return numOfRows;
+	}
+
+	void refreshRow(FrameNum row);
+	void ensureVisible(FrameNum row);
+	bool isRowVisible(FrameNum row) const;
+	FrameNum getTopRow() const {
+		return topRow;
+	}
+	// Only rows that fit completely
+	FrameNum getRowsPerPage() const;
+	wxRect getRowRect(FrameNum row) const;
+	// wxNOT_FOUND when not on a row
+	long hitTestRow(wxPoint point) const;
+
+	// Just moves the highlight, no callback
+	void setFocusedRow(FrameNum row);
+	FrameNum getFocusedRow() const {
+		return focusedRow;
+	}
+
+	bool hasSelection() const {
+		return !selection.empty();
+	}
+	const FrameSelection& getSelection() const {
+		return selection;
+	}
+	bool isRowSelected(FrameNum row) const {
+		return selection.contains(row);
+	}
+	void setSelection(FrameNum start, FrameNum end);
+	void setSelection(const FrameSelection& frames);
+	void clearSelection();
+};
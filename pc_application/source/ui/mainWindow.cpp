@@ -41,6 +41,10 @@ MainWindow::MainWindow()
 			SEND_QUEUE_DATA(SendSetNumControllers)
 			SEND_QUEUE_DATA(SendAddMemoryRegion)
 			SEND_QUEUE_DATA(SendStartFinalTas)
+			SEND_QUEUE_DATA(SendMemorySnapshot)
+			SEND_QUEUE_DATA(SendRunLuaScript)
+			SEND_QUEUE_DATA(SendFinalTasChunk)
+			SEND_QUEUE_DATA(SendRunToFrame)
 		},
 		[](CommunicateWithNetwork* self) {
 			RECIEVE_QUEUE_DATA(RecieveFlag)
@@ -49,6 +53,10 @@ MainWindow::MainWindow()
 			RECIEVE_QUEUE_DATA(RecieveApplicationConnected)
 			RECIEVE_QUEUE_DATA(RecieveLogging)
 			RECIEVE_QUEUE_DATA(RecieveMemoryRegion)
+			RECIEVE_QUEUE_DATA(RecieveMemorySnapshotChunk)
+			RECIEVE_QUEUE_DATA(RecieveFinalTasProgress)
+			RECIEVE_QUEUE_DATA(RecieveRunToFrameProgress)
+			RECIEVE_QUEUE_DATA(RecieveHeapUsage)
 		});
 
 	// DataProcessing can now start with the networking instance
@@ -106,6 +114,8 @@ void MainWindow::onStart() {
 	}
 
 	dataProcessingInstance->setProjectStart(projectHandler->getProjectStart());
+	applicationMemoryManager = std::make_shared<ApplicationMemoryManager>(projectHandler->getProjectStart().GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR), networkInstance);
+	memoryViewer             = new MemoryViewer(this, dataProcessingInstance, applicationMemoryManager);
 
 	// Ask for internet connection to get started
 	askForIP();
@@ -167,6 +177,7 @@ void MainWindow::onIdle(wxIdleEvent& event) {
 	PROCESS_NETWORK_CALLBACKS(networkInstance, RecieveApplicationConnected)
 	PROCESS_NETWORK_CALLBACKS(networkInstance, RecieveLogging)
 	PROCESS_NETWORK_CALLBACKS(networkInstance, RecieveMemoryRegion)
+	PROCESS_NETWORK_CALLBACKS(networkInstance, RecieveHeapUsage)
 
 	if(!IsBeingDeleted()) {
 		event.RequestMore();
@@ -181,32 +192,30 @@ void MainWindow::handleNetworkQueues() {
 	ADD_NETWORK_CALLBACK(RecieveLogging, {
 		wxLogMessage(wxString("SWITCH: " + data.log));
 	})
+	ADD_NETWORK_CALLBACK(RecieveMemoryRegion, {
+		if(applicationMemoryManager) {
+			applicationMemoryManager->recordMemoryRegion(data, dataProcessingInstance->getAbsoluteFrame(data.savestateHookNum, data.frame));
+			memoryViewer->dataRecorded();
+		}
+	})
+	ADD_NETWORK_CALLBACK(RecieveHeapUsage, {
+		// Running out of heap on the switch is a fatal, so keep an eye on it
+		SetStatusText(wxString::Format("Switch heap: %u / %u KB, peak %u KB", data.inUse / 1024, data.heapSize / 1024, data.peakInUse / 1024), 1);
+	})
 	// clang-format on
 
 	ADD_NETWORK_CALLBACK(RecieveGameFramebuffer, {
-		uint8_t framebufferIncluded = data.buf.size() == 0 ? false : true;
-		if(framebufferIncluded) {
-			bottomUI->recieveGameFramebuffer(data.buf);
-		}
-		if(data.fromFrameAdvance == 1) {
-			sideUI->enableAdvance();
-			if(framebufferIncluded) {
-				wxFileName framebufferFileName = dataProcessingInstance->getFramebufferPath(data.playerIndex, data.savestateHookNum, data.branchIndex, data.frame);
-				wxFile file(framebufferFileName.GetFullPath(), wxFile::write);
-				file.Write(data.buf.data(), data.buf.size());
-				file.Close();
-			}
-			if(dataProcessingInstance->getNumOfFramesInSavestateHook(data.savestateHookNum, data.playerIndex) == data.frame) {
-				dataProcessingInstance->addFrameHere();
+		if(data.sequence == 0) {
+			handleGameFramebuffer(data);
+		} else {
+			// Auto run frames are handled in the order they were sent, no matter how they come in
+			AutoRunPipeline& pipeline = dataProcessingInstance->getAutoRunPipeline();
+			pipeline.recieve(data);
+
+			Protocol::Struct_RecieveGameFramebuffer nextData;
+			while(pipeline.takeNext(nextData)) {
+				handleGameFramebuffer(nextData);
 			}
-			if(data.controllerDataIncluded) {
-				dataProcessingInstance->setControllerDataForAutoRun(data.controllerData);
-				dataProcessingInstance->runFrame(true, true, true);
-			}
-			if(sideUI->getAutoRunActive()) {
-				autoFrameAdvanceTimer->StartOnce(sideUI->getAutoRunDelay());
-			}
-			bottomUI->refreshDataViews(true);
 		}
 	})
 
@@ -222,12 +231,40 @@ void MainWindow::handleNetworkQueues() {
 	// clang-format on
 	if(networkInstance->hasOtherSideJustDisconnected()) {
 		wxLogMessage("Server disconnected, required to re-enter IP");
+		// Nothing in flight is coming back now
+		dataProcessingInstance->getAutoRunPipeline().reset();
 		SetStatusText("", 0);
+		SetStatusText("", 1);
 		// Show the dialog
 		askForIP();
 	}
 }
 
+void MainWindow::handleGameFramebuffer(const Protocol::Struct_RecieveGameFramebuffer& data) {
+	uint8_t framebufferIncluded = data.buf.size() == 0 ? false : true;
+	if(framebufferIncluded) {
+		bottomUI->recieveGameFramebuffer(data.buf);
+	}
+	if(data.fromFrameAdvance == 1) {
+		sideUI->enableAdvance();
+		if(framebufferIncluded) {
+			dataProcessingInstance->saveFramebuffer(data.playerIndex, data.savestateHookNum, data.branchIndex, data.frame, data.buf);
+		}
+		if(dataProcessingInstance->getNumOfFramesInSavestateHook(data.savestateHookNum, data.playerIndex) == data.frame) {
+			dataProcessingInstance->addFrameHere();
+		}
+		if(data.controllerDataIncluded) {
+			dataProcessingInstance->setControllerDataForAutoRun(data.controllerData);
+			dataProcessingInstance->runFrame(true, true, true);
+		}
+		if(sideUI->getAutoRunActive()) {
+			// Fills the window back up
+			autoFrameAdvanceTimer->StartOnce(sideUI->getAutoRunDelay());
+		}
+		bottomUI->refreshDataViews(true);
+	}
+}
+
 void MainWindow::startedIncrementFrame() {
 	// bottomUI->getFrameViewerCanvas()->Freeze();
 }
@@ -237,19 +274,24 @@ void MainWindow::addMenuBar() {
 
 	wxMenu* fileMenu = new wxMenu();
 
-	selectIPID          = NewControlId();
-	exportAsText        = NewControlId();
-	importAsText        = NewControlId();
-	saveProject         = NewControlId();
-	setNameID           = NewControlId();
-	toggleLoggingID     = NewControlId();
-	toggleDebugMenuID   = NewControlId();
-	openGameCorruptorID = NewControlId();
-	runFinalTasID       = NewControlId();
+	selectIPID           = NewControlId();
+	exportAsText         = NewControlId();
+	importAsText         = NewControlId();
+	saveProject          = NewControlId();
+	setNameID            = NewControlId();
+	toggleLoggingID      = NewControlId();
+	toggleDebugMenuID    = NewControlId();
+	openGameCorruptorID  = NewControlId();
+	runFinalTasID        = NewControlId();
+	exportMemoryTraceID  = NewControlId();
+	toggleMemoryViewerID = NewControlId();
+	runLuaScriptID       = NewControlId();
+	stopLuaScriptID      = NewControlId();
 
 	fileMenu->Append(saveProject, "Save Project\tCtrl+S");
 	fileMenu->Append(exportAsText, "Export To Text Format\tCtrl+Alt+E");
 	fileMenu->Append(importAsText, "Import From Text Format\tCtrl+Alt+I");
+	fileMenu->Append(exportMemoryTraceID, "Export Memory Trace To CSV\tCtrl+Alt+M");
 	fileMenu->Append(setNameID, "Set Name\tCtrl+Alt+N");
 	// Also not finished
 	// fileMenu->Append(runFinalTasID, "Run Final TAS\tCtrl+R");
@@ -265,8 +307,11 @@ void MainWindow::addMenuBar() {
 	fileMenu->Append(selectIPID, "Set Switch IP\tCtrl+I");
 	fileMenu->Append(toggleLoggingID, "Toggle Logging\tCtrl+Shift+L");
 	fileMenu->Append(toggleDebugMenuID, "Toggle Debug Menu\tCtrl+D");
-	// Not finished as of now
-	// fileMenu->Append(openGameCorruptorID, "Open Game Corruptor\tCtrl+B");
+	fileMenu->Append(toggleMemoryViewerID, "Toggle Memory Viewer\tCtrl+Alt+W");
+	// Only the memory scanner is finished as of now
+	fileMenu->Append(openGameCorruptorID, "Open Game Corruptor\tCtrl+B");
+	fileMenu->Append(runLuaScriptID, "Run Lua Script On Switch\tCtrl+Shift+R");
+	fileMenu->Append(stopLuaScriptID, "Stop Lua Script On Switch\tCtrl+Shift+T");
 
 	menuBar->Append(fileMenu, "&File");
 
@@ -276,8 +321,8 @@ void MainWindow::addMenuBar() {
 }
 
 void MainWindow::addStatusBar() {
-	// 1 element for now
-	CreateStatusBar(1);
+	// Connection and the switch heap
+	CreateStatusBar(2);
 
 	SetStatusText("No Network Connected", 0);
 }
@@ -307,6 +352,10 @@ void MainWindow::handleMenuBar(wxCommandEvent& commandEvent) {
 		} else if(id == toggleDebugMenuID) {
 			debugWindow->Show(!debugWindow->IsShown());
 			wxLogMessage("Toggled debug window");
+		} else if(id == toggleMemoryViewerID) {
+			if(memoryViewer) {
+				memoryViewer->Show(!memoryViewer->IsShown());
+			}
 		} else if(id == openGameCorruptorID) {
 			Show(false);
 			sideUI->untether();
@@ -321,7 +370,7 @@ void MainWindow::handleMenuBar(wxCommandEvent& commandEvent) {
 			*/
 
 			// User sets their own name
-			ScriptExporter scriptExporter(this, projectHandler, dataProcessingInstance->getExportedCurrentPlayer());
+			ScriptExporter scriptExporter(this, projectHandler, dataProcessingInstance->getExportSnapshotCurrentPlayer(), buttonData->scriptWriter);
 			scriptExporter.ShowModal();
 
 		} else if(id == importAsText) {
@@ -332,6 +381,25 @@ void MainWindow::handleMenuBar(wxCommandEvent& commandEvent) {
 
 				dataProcessingInstance->importFromFile(importPath);
 			}
+		} else if(id == exportMemoryTraceID) {
+			wxFileDialog saveFileDialog(this, _("Export Memory Trace"), "", "", "CSV files (*.csv)|*.csv", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+			if(saveFileDialog.ShowModal() == wxID_OK) {
+				// The branch being viewed, the other branches have their own values
+				applicationMemoryManager->getMemoryTrace()->exportToCsv(saveFileDialog.GetPath(), dataProcessingInstance->getCurrentBranch());
+			}
+		} else if(id == runLuaScriptID) {
+			// Scripts live on the SD card, the switch runs them every frame
+			wxString scriptPath = wxGetTextFromUser("Please enter the path of the Lua script on the SD card", "Run Lua script", wxEmptyString);
+			if(!scriptPath.empty()) {
+				ADD_TO_QUEUE(SendRunLuaScript, networkInstance, {
+					data.path = scriptPath.ToStdString();
+				})
+			}
+		} else if(id == stopLuaScriptID) {
+			ADD_TO_QUEUE(SendRunLuaScript, networkInstance, {
+				data.path = "";
+			})
 		} else if(id == runFinalTasID) {
 			// Open the run final TAS dialog and untether
 			sideUI->untether();
@@ -375,9 +443,18 @@ void MainWindow::onClose(wxCloseEvent& event) {
 	REMOVE_NETWORK_CALLBACK(RecieveLogging)
 	REMOVE_NETWORK_CALLBACK(RecieveGameFramebuffer)
 	REMOVE_NETWORK_CALLBACK(RecieveFlag)
+	REMOVE_NETWORK_CALLBACK(RecieveMemoryRegion)
 
 	// Close project dialog and save
 	projectHandler->saveProject();
+	{
+		// Saving doesn't compact, dead framebuffers are only cleaned up here
+		wxBusyCursor busyCursor;
+		dataProcessingInstance->compactFramebufferArchives();
+	}
+	if(applicationMemoryManager) {
+		applicationMemoryManager->getMemoryTrace()->sync();
+	}
 	networkInstance->endNetwork();
 
 	delete wxLog::SetActiveTarget(NULL);
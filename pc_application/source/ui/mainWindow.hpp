@@ -13,6 +13,7 @@
 
 #include "../sharedNetworkCode/networkInterface.hpp"
 
+#include "../dataHandling/applicationMemoryViewer.hpp"
 #include "../dataHandling/buttonData.hpp"
 #include "../dataHandling/dataProcessing.hpp"
 #include "../dataHandling/gameCorruptor.hpp"
@@ -21,6 +22,7 @@
 #include "../helpers.hpp"
 #include "bottomUI.hpp"
 #include "debugWindow.hpp"
+#include "memoryViewer.hpp"
 #include "scriptExporter.hpp"
 #include "sideUI.hpp"
 
@@ -47,6 +49,8 @@ private:
 	DataProcessing* dataProcessingInstance;
 	// Networking stuff
 	std::shared_ptr<CommunicateWithNetwork> networkInstance;
+	// Records watched memory, created once the project is known
+	std::shared_ptr<ApplicationMemoryManager> applicationMemoryManager;
 
 	// For sideUI
 	wxTimer* autoFrameAdvanceTimer;
@@ -55,6 +59,8 @@ private:
 	wxLogWindow* logWindow;
 	// Main debug command window
 	DebugWindow* debugWindow;
+	// Watches and their recorded values
+	MemoryViewer* memoryViewer = nullptr;
 
 	// Menubar
 	wxMenuBar* menuBar;
@@ -68,6 +74,10 @@ private:
 	wxWindowID toggleDebugMenuID;
 	wxWindowID openGameCorruptorID;
 	wxWindowID runFinalTasID;
+	wxWindowID exportMemoryTraceID;
+	wxWindowID toggleMemoryViewerID;
+	wxWindowID runLuaScriptID;
+	wxWindowID stopLuaScriptID;
 
 	void handlePreviousWindowTransform();
 
@@ -91,6 +101,8 @@ private:
 
 	bool askForIP();
 	void handleNetworkQueues();
+	// Frame advance and auto run framebuffers, in the order they were sent
+	void handleGameFramebuffer(const Protocol::Struct_RecieveGameFramebuffer& data);
 
 	// Used to freeze the current frame view to make it look good
 	void startedIncrementFrame();
@@ -1,9 +1,11 @@
 #include "memoryViewer.hpp"
 
-MemoryViewer::MemoryViewer(wxFrame* parent, std::shared_ptr<ProjectHandler> proj, std::shared_ptr<CommunicateWithNetwork> networkImp)
-	: wxFrame(parent, wxID_ANY, "Memory Viewer", wxDefaultPosition, wxSize(300, 200), wxDEFAULT_FRAME_STYLE | wxFRAME_FLOAT_ON_PARENT) {
-	projectHandler   = proj;
-	networkInterface = networkImp;
+MemoryViewer::MemoryViewer(wxFrame* parent, DataProcessing* input, std::shared_ptr<ApplicationMemoryManager> memoryManager)
+	: wxFrame(parent, wxID_ANY, "Memory Viewer", wxDefaultPosition, wxSize(600, 300), wxDEFAULT_FRAME_STYLE | wxFRAME_FLOAT_ON_PARENT) {
+	// Start hidden
+	Hide();
+	inputData                = input;
+	applicationMemoryManager = memoryManager;
 
 	mainSizer        = new wxBoxSizer(wxHORIZONTAL);
 	entryEditerSizer = new wxBoxSizer(wxVERTICAL);
@@ -11,8 +13,6 @@ MemoryViewer::MemoryViewer(wxFrame* parent, std::shared_ptr<ProjectHandler> proj
 	unsignedCheckbox = new wxCheckBox(this, wxID_ANY, "Unsigned");
 	unsignedCheckbox->SetValue(true);
 
-	wxString typeChoices[MemoryRegionTypes::NUM_OF_TYPES];
-
 	typeChoices[MemoryRegionTypes::Bit8]        = "8 Bit Number";
 	typeChoices[MemoryRegionTypes::Bit16]       = "16 Bit Number";
 	typeChoices[MemoryRegionTypes::Bit32]       = "32 Bit Number";
@@ -24,38 +24,113 @@ MemoryViewer::MemoryViewer(wxFrame* parent, std::shared_ptr<ProjectHandler> proj
 	typeChoices[MemoryRegionTypes::ByteArray]   = "Byte Array";
 
 	typeSelection = new wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, MemoryRegionTypes::NUM_OF_TYPES, typeChoices);
+	typeSelection->SetSelection(MemoryRegionTypes::Bit32);
+	typeSelection->Bind(wxEVT_CHOICE, &MemoryViewer::onTypeSelected, this);
+
+	itemSize = new wxSpinCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 1, UINT16_MAX, 16);
+	itemSize->Enable(false);
 
 	pointerPath = new wxTextCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxTE_CENTRE);
+	pointerPath->SetHint("[main+0x100]+0x20");
 
-	updateEntry = new wxButton(this, wxID_ANY, "Update Entry");
-	addEntry    = new wxButton(this, wxID_ANY, "Add Entry");
+	addEntry     = new wxButton(this, wxID_ANY, "Add Entry");
+	clearEntries = new wxButton(this, wxID_ANY, "Clear Entries");
 
-	updateEntry->Bind(wxEVT_BUTTON, &MemoryViewer::onUpdateEntry, this);
 	addEntry->Bind(wxEVT_BUTTON, &MemoryViewer::onAddEntry, this);
+	clearEntries->Bind(wxEVT_BUTTON, &MemoryViewer::onClearEntries, this);
 
 	itemsList = new wxListCtrl(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_SINGLE_SEL | wxLC_HRULES);
 
-	itemsList->Bind(wxEVT_LIST_ITEM_SELECTED, &MemoryViewer::selectedItemChanged, this);
+	itemsList->InsertColumn(0, "Index", wxLIST_FORMAT_CENTER, wxLIST_AUTOSIZE_USEHEADER);
+	itemsList->InsertColumn(1, "Data Type", wxLIST_FORMAT_CENTER, wxLIST_AUTOSIZE_USEHEADER);
+	itemsList->InsertColumn(2, "Pointer Path", wxLIST_FORMAT_CENTER, 150);
+	itemsList->InsertColumn(3, "Value", wxLIST_FORMAT_CENTER, 150);
+
+	entryEditerSizer->Add(pointerPath, 0, wxEXPAND | wxALL, 2);
+	entryEditerSizer->Add(typeSelection, 0, wxEXPAND | wxALL, 2);
+	entryEditerSizer->Add(unsignedCheckbox, 0, wxALL, 2);
+	entryEditerSizer->Add(itemSize, 0, wxEXPAND | wxALL, 2);
+	entryEditerSizer->Add(addEntry, 0, wxEXPAND | wxALL, 2);
+	entryEditerSizer->Add(clearEntries, 0, wxEXPAND | wxALL, 2);
 
-	itemsList->InsertColumn(0, "Index", wxLIST_FORMAT_CENTER, wxLIST_AUTOSIZE);
-	itemsList->InsertColumn(1, "Data Type", wxLIST_FORMAT_CENTER, wxLIST_AUTOSIZE);
-	itemsList->InsertColumn(2, "Pointer Path", wxLIST_FORMAT_CENTER, wxLIST_AUTOSIZE);
-	itemsList->InsertColumn(3, "Value", wxLIST_FORMAT_CENTER, wxLIST_AUTOSIZE);
+	mainSizer->Add(entryEditerSizer, 0, wxEXPAND);
+	mainSizer->Add(itemsList, 1, wxEXPAND);
+
+	SetSizer(mainSizer);
+	Layout();
+	Center(wxBOTH);
 }
 
-void MemoryViewer::selectedItemChanged(wxListEvent& event) {}
+// clang-format off
+BEGIN_EVENT_TABLE(MemoryViewer, wxFrame)
+	EVT_IDLE(MemoryViewer::onIdle)
+	EVT_CLOSE(MemoryViewer::onClose)
+END_EVENT_TABLE()
+// clang-format on
+
+void MemoryViewer::onClose(wxCloseEvent& event) {
+	// Only hide, the watches keep recording
+	Show(false);
+}
 
-void MemoryViewer::onUpdateEntry(wxCommandEvent& event) {}
+void MemoryViewer::onTypeSelected(wxCommandEvent& event) {
+	int type = typeSelection->GetSelection();
+	itemSize->Enable(type == MemoryRegionTypes::CharPointer || type == MemoryRegionTypes::ByteArray);
+}
 
 void MemoryViewer::onAddEntry(wxCommandEvent& event) {
+	if(pointerPath->GetValue().empty() || typeSelection->GetSelection() == wxNOT_FOUND) {
+		return;
+	}
+
 	MemoryItemInfo info;
+	info.isUnsigned  = unsignedCheckbox->GetValue();
+	info.type        = (MemoryRegionTypes)typeSelection->GetSelection();
+	info.size        = itemSize->GetValue();
+	info.pointerPath = pointerPath->GetValue();
 
-	info.isUnsigned;
-	info.type;
-	info.size;
-	info.saveToFile;
-	info.filePath;
-	info.pointerPath;
+	applicationMemoryManager->addMemoryWatch(info.pointerPath.ToStdString(), info.type, info.isUnsigned, info.size);
+
+	long item = itemsList->InsertItem(infos.size(), wxString::Format("%zu", infos.size()));
+	itemsList->SetItem(item, 1, typeChoices[info.type]);
+	itemsList->SetItem(item, 2, info.pointerPath);
 
 	infos.push_back(info);
-}
\ No newline at end of file
+	valuesOutOfDate = true;
+
+	pointerPath->Clear();
+}
+
+void MemoryViewer::onClearEntries(wxCommandEvent& event) {
+	applicationMemoryManager->clearMemoryWatches();
+	infos.clear();
+	itemsList->DeleteAllItems();
+}
+
+void MemoryViewer::onIdle(wxIdleEvent& event) {
+	if(!IsShown() || infos.empty()) {
+		return;
+	}
+
+	FrameNum frame   = inputData->getAbsoluteFrame(inputData->getCurrentSavestateHook(), inputData->getCurrentFrame());
+	BranchNum branch = inputData->getCurrentBranch();
+
+	if(valuesOutOfDate || frame != lastFrame || branch != lastBranch) {
+		lastFrame       = frame;
+		lastBranch      = branch;
+		valuesOutOfDate = false;
+		updateValues();
+	}
+}
+
+void MemoryViewer::updateValues() {
+	std::vector<uint8_t> bytes;
+	for(uint16_t i = 0; i < infos.size(); i++) {
+		if(applicationMemoryManager->getData(i, lastBranch, lastFrame, bytes)) {
+			itemsList->SetItem(i, 3, wxString::FromUTF8(MemoryTraceColumn::valueToString(infos[i].type, infos[i].isUnsigned, bytes)));
+		} else {
+			// Not recorded at this frame
+			itemsList->SetItem(i, 3, wxEmptyString);
+		}
+	}
+}
@@ -2,26 +2,23 @@
 
 #include <cstdint>
 #include <memory>
-#include <mio.hpp>
-#include <system_error>
 #include <vector>
-#include <wx/filepicker.h>
+#include <wx/listctrl.h>
+#include <wx/spinctrl.h>
 #include <wx/wx.h>
 
-#include "../dataHandling/projectHandler.hpp"
-#include "../sharedNetworkCode/networkInterface.hpp"
+#include "../dataHandling/applicationMemoryViewer.hpp"
+#include "../dataHandling/dataProcessing.hpp"
 #include "../sharedNetworkCode/networkingStructures.hpp"
 
-// This will use a wxListCtrl to list the memory locations currently shown
-// You will be able to add values by using their memory viewer fancy string version
-// The type will be specified and the data will be exported to a file on demand
+// This uses a wxListCtrl to list the memory locations currently watched
+// You add values by using their memory viewer fancy string version, like [main+0x100]+0x20
+// The value shown is the one recorded at the current frame and branch
 
 struct MemoryItemInfo {
 	uint8_t isUnsigned;
 	MemoryRegionTypes type;
 	uint16_t size;
-	uint8_t saveToFile;
-	wxString filePath;
 	wxString pointerPath;
 };
 
@@ -30,34 +27,49 @@ private:
 	wxBoxSizer* mainSizer;
 	wxBoxSizer* entryEditerSizer;
 
-	uint16_t currentItemSelection = 0;
-
-	std::shared_ptr<ProjectHandler> projectHandler;
-	std::shared_ptr<CommunicateWithNetwork> networkInterface;
+	DataProcessing* inputData;
+	std::shared_ptr<ApplicationMemoryManager> applicationMemoryManager;
 
+	// Same order as the watches on the switch
 	std::vector<MemoryItemInfo> infos;
 
+	wxString typeChoices[MemoryRegionTypes::NUM_OF_TYPES];
+
 	wxCheckBox* unsignedCheckbox;
 	// Doesn't apply because the switch is little endian
 	// wxCheckBox* littleEndianCheckbox;
 	wxChoice* typeSelection;
-	// Used only for byte arrays and char strings, hidden for all others
+	// Used only for byte arrays and char strings, disabled for all others
 	wxSpinCtrl* itemSize;
-	wxCheckBox* saveToFile;
-	wxFilePickerCtrl* filePath;
 
 	wxTextCtrl* pointerPath;
 
-	wxButton* updateEntry;
 	wxButton* addEntry;
+	wxButton* clearEntries;
 
 	wxListCtrl* itemsList;
 
-	void onUpdateEntry(wxCommandEvent& event);
+	// Values are only read again when these change
+	FrameNum lastFrame   = UINT32_MAX;
+	BranchNum lastBranch = UINT16_MAX;
+	bool valuesOutOfDate = true;
+
 	void onAddEntry(wxCommandEvent& event);
+	void onClearEntries(wxCommandEvent& event);
+	void onTypeSelected(wxCommandEvent& event);
+
+	void onIdle(wxIdleEvent& event);
+	void onClose(wxCloseEvent& event);
 
-	void selectedItemChanged(wxListEvent& event);
+	void updateValues();
 
 public:
-	MemoryViewer(wxFrame* parent, std::shared_ptr<ProjectHandler> proj, std::shared_ptr<CommunicateWithNetwork> networkImp);
-};
\ No newline at end of file
+	MemoryViewer(wxFrame* parent, DataProcessing* input, std::shared_ptr<ApplicationMemoryManager> memoryManager);
+
+	// New values were recorded by the switch
+	void dataRecorded() {
+		valuesOutOfDate = true;
+	}
+
+	DECLARE_EVENT_TABLE();
+};
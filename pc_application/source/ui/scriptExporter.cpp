@@ -1,9 +1,10 @@
 #include "scriptExporter.hpp"
 
-ScriptExporter::ScriptExporter(wxFrame* parent, std::shared_ptr<ProjectHandler> projHandler, std::string data)
+ScriptExporter::ScriptExporter(wxFrame* parent, std::shared_ptr<ProjectHandler> projHandler, std::vector<ScriptFrame> frames, ScriptWriter writer)
 	: wxDialog(parent, wxID_ANY, "Savestate Selection", wxDefaultPosition, wxDefaultSize, wxDEFAULT_FRAME_STYLE) {
 	projectHandler = projHandler;
-	dataToSave     = data;
+	framesToSave   = frames;
+	scriptWriter   = writer;
 
 	// TODO
 	// FTP path (standard format)
@@ -38,30 +39,89 @@ ScriptExporter::ScriptExporter(wxFrame* parent, std::shared_ptr<ProjectHandler>
 	Layout();
 }
 
-void ScriptExporter::onFtpSelect(wxCommandEvent& event) {
-	// The thing passed is a ftp address, parse it
-	// wxFTP ftp;
-	ftpAddress = ftpEntry->GetLineText(0).ToStdString();
+bool ScriptExporter::runExport(wxString title, std::function<bool(const std::atomic_bool& cancel, std::string& error)> exportFunc, std::string& error) {
+	std::atomic_bool cancel(false);
 
-	wxString tempPath = wxFileName::CreateTempFileName("script");
-	wxFile file(tempPath, wxFile::write);
-	file.Write(wxString::FromUTF8(dataToSave));
-	file.Close();
+	auto start                  = std::chrono::steady_clock::now();
+	std::future<bool> exporting = std::async(std::launch::async, [&]() {
+		return exportFunc(cancel, error);
+	});
 
-	std::string output = HELPERS::exec(wxString::Format("curl -T %s -m 10 --connect-timeout 3 --verbose %s", tempPath, ftpAddress).c_str());
+	wxProgressDialog progressDialog(title, wxString::Format("Exporting %zu frames", framesToSave.size()), 100, this, wxPD_APP_MODAL | wxPD_CAN_ABORT | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME);
+	while(exporting.wait_for(std::chrono::milliseconds(50)) != std::future_status::ready) {
+		if(!progressDialog.Pulse()) {
+			cancel = true;
+		}
+	}
 
-	wxRemoveFile(tempPath);
+	bool succeeded = exporting.get();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	progressDialog.Update(100);
 
-	if(output.find("is not recognized") != std::string::npos || output.find("command not found") != std::string::npos) {
-		wxMessageDialog errorDialog(this, "Curl Not Found", "The Curl executable was not found", wxOK | wxICON_ERROR);
-		errorDialog.ShowModal();
-	} else if(output.find("Closing connection 0") != std::string::npos) {
-		std::vector<std::string> lines = HELPERS::splitString(output, '\n');
+	if(succeeded) {
+		wxLogMessage(wxString::Format("Exported %zu frames in %.2f seconds", framesToSave.size(), seconds));
+	} else if(cancel) {
+		// Not an error worth showing
+		error.clear();
+	}
+
+	return succeeded;
+}
+
+void ScriptExporter::onFtpSelect(wxCommandEvent& event) {
+	// The thing passed is a ftp address, parse it
+	ftpAddress = ftpEntry->GetLineText(0).ToStdString();
 
-		wxMessageDialog errorDialog(this, "Curl Error", wxString::FromUTF8(lines[lines.size() - 1]), wxOK | wxICON_ERROR);
+	std::string host;
+	uint16_t port;
+	std::string path;
+	if(!FtpUploader::parseUrl(ftpAddress, host, port, path)) {
+		wxMessageDialog errorDialog(this, "The address should look like ftp://192.168.1.2:5000/script.txt", "Invalid FTP Address", wxOK | wxICON_ERROR);
 		errorDialog.ShowModal();
-	} else {
+		return;
+	}
+
+	projectHandler->setLastEnteredFtpPath(ftpAddress);
+
+	// Formatted straight into the upload, no temp file
+	std::string error;
+	bool succeeded = runExport(
+		"Uploading Script",
+		[this, &host, port, &path](const std::atomic_bool& cancel, std::string& error) {
+			FtpUploader uploader;
+			if(!uploader.connect(host, port) || !uploader.beginUpload(path)) {
+				error = uploader.getError();
+				return false;
+			}
+
+			bool written = scriptWriter.write(
+				framesToSave,
+				[&uploader](const char* data, std::size_t size) {
+					return uploader.sendData((const uint8_t*)data, size);
+				},
+				&cancel);
+
+			if(!written) {
+				if(cancel) {
+					uploader.abortUpload();
+				}
+				error = uploader.getError();
+				return false;
+			}
+
+			if(!uploader.finishUpload()) {
+				error = uploader.getError();
+				return false;
+			}
+			return true;
+		},
+		error);
+
+	if(succeeded) {
 		EndModal(wxID_OK);
+	} else if(!error.empty()) {
+		wxMessageDialog errorDialog(this, wxString::FromUTF8(error), "FTP Error", wxOK | wxICON_ERROR);
+		errorDialog.ShowModal();
 	}
 }
 
@@ -72,10 +132,27 @@ void ScriptExporter::onFilesystemOpen(wxCommandEvent& event) {
 	saveFileDialog.SetDirectory(projectHandler->getProjectStart().GetFullPath());
 
 	if(saveFileDialog.ShowModal() == wxID_OK) {
-		wxFile file(saveFileDialog.GetPath(), wxFile::write);
-		file.Write(wxString::FromUTF8(dataToSave));
-		file.Close();
-
-		EndModal(wxID_OK);
+		std::string path = saveFileDialog.GetPath().ToStdString();
+
+		std::string error;
+		bool succeeded = runExport(
+			"Exporting Script",
+			[this, &path](const std::atomic_bool& cancel, std::string& error) {
+				if(!scriptWriter.writeToFile(framesToSave, path, &cancel)) {
+					error = "Could not write to " + path;
+					return false;
+				}
+				return true;
+			},
+			error);
+
+		if(succeeded) {
+			double megabytes = wxFileName::GetSize(saveFileDialog.GetPath()).ToDouble() / 1000000.0;
+			wxLogMessage(wxString::Format("Exported %.2f MB to %s", megabytes, saveFileDialog.GetPath()));
+			EndModal(wxID_OK);
+		} else if(!error.empty()) {
+			wxMessageDialog errorDialog(this, wxString::FromUTF8(error), "Export Error", wxOK | wxICON_ERROR);
+			errorDialog.ShowModal();
+		}
 	}
-}
\ No newline at end of file
+}
@@ -1,23 +1,32 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <functional>
+#include <future>
 #include <rapidjson/document.h>
 #include <string>
 #include <vector>
 #include <wx/filepicker.h>
+#include <wx/progdlg.h>
 #include <wx/sstream.h>
 #include <wx/stream.h>
 #include <wx/wx.h>
 
 #include "../dataHandling/dataProcessing.hpp"
+#include "../dataHandling/ftpUploader.hpp"
 #include "../dataHandling/projectHandler.hpp"
+#include "../dataHandling/scriptWriter.hpp"
 #include "../helpers.hpp"
 #include "../sharedNetworkCode/networkInterface.hpp"
 
 class ScriptExporter : public wxDialog {
 private:
 	std::shared_ptr<ProjectHandler> projectHandler;
-	std::string dataToSave;
+	// Snapshot of the frames, formatted when exporting
+	std::vector<ScriptFrame> framesToSave;
+	ScriptWriter scriptWriter;
 
 	wxBoxSizer* mainSizer;
 
@@ -29,9 +38,13 @@ private:
 
 	std::string ftpAddress;
 
+	// Runs on a worker thread while a progress dialog keeps the UI going
+	// The dialog waits for it, so nothing outlives the exporter
+	bool runExport(wxString title, std::function<bool(const std::atomic_bool& cancel, std::string& error)> exportFunc, std::string& error);
+
 	void onFtpSelect(wxCommandEvent& event);
 	void onFilesystemOpen(wxCommandEvent& event);
 
 public:
-	ScriptExporter(wxFrame* parent, std::shared_ptr<ProjectHandler> projHandler, std::string data);
+	ScriptExporter(wxFrame* parent, std::shared_ptr<ProjectHandler> projHandler, std::vector<ScriptFrame> frames, ScriptWriter writer);
 };
\ No newline at end of file
@@ -92,8 +92,12 @@ SideUI::SideUI(wxFrame* parentFrame, rapidjson::Document* settings, std::shared_
 	frameDrawer = new FrameCanvas(parentFrame, inputData);
 	frameDrawer->setBackgroundColor(inputData->GetBackgroundColour());
 
+	timelineMinimap = new TimelineMinimap(parentFrame, inputData);
+	timelineMinimap->setBackgroundColor(inputData->GetBackgroundColour());
+
 	frameDrawer->SetToolTip("View selected frame");
 	inputData->SetToolTip("Edit frames");
+	timelineMinimap->SetToolTip("Click to seek, scroll to zoom");
 
 	addFrameButton            = HELPERS::getBitmapButton(parentFrame, mainSettings, "addFrameButton");
 	frameAdvanceButton        = HELPERS::getBitmapButton(parentFrame, mainSettings, "frameAdvanceButton");
@@ -112,7 +116,7 @@ SideUI::SideUI(wxFrame* parentFrame, rapidjson::Document* settings, std::shared_
 	savestateHookModifyButton->SetToolTip("Modify current savestate hook");
 	playerAddButton->SetToolTip("Add player");
 	playerRemoveButton->SetToolTip("Remove current player");
-	branchAddButton->SetToolTip("Add branch");
+	branchAddButton->SetToolTip("Add branch, hold shift to fork the current one");
 	branchRemoveButton->SetToolTip("Remove current branch");
 
 	playerSelect = new wxComboBox(parentFrame, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize, 0, NULL, wxCB_DROPDOWN | wxCB_READONLY);
@@ -161,6 +165,7 @@ SideUI::SideUI(wxFrame* parentFrame, rapidjson::Document* settings, std::shared_
 	inputData->SetMinSize(wxSize(0, 0));
 	inputsViewSizer->Add(frameDrawer, 1, wxEXPAND | wxALL);
 	inputsViewSizer->Add(inputData, 5, wxEXPAND | wxALL);
+	inputsViewSizer->Add(timelineMinimap, 0, wxEXPAND | wxALL);
 
 	verticalBoxSizer->Add(inputsViewSizer, 1, wxEXPAND | wxALL);
 
@@ -181,6 +186,10 @@ SideUI::SideUI(wxFrame* parentFrame, rapidjson::Document* settings, std::shared_
 
 	autoRunFramesPerSecond->SetToolTip("Delay in mlliseconds for automatically incrementing frame");
 
+	autoRunFramesInFlight = new wxSpinCtrl(parentFrame, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 1, AUTO_RUN_MAX_FRAMES_IN_FLIGHT, 1);
+
+	autoRunFramesInFlight->SetToolTip("Frames sent ahead while recording controller data, so the switch doesn't wait on the screenshot of the last one");
+
 	autoRunWithFramebuffer    = new wxCheckBox(parentFrame, wxID_ANY, "Include Screenshot");
 	autoRunWithControllerData = new wxCheckBox(parentFrame, wxID_ANY, "Include Controller Data");
 
@@ -192,6 +201,7 @@ SideUI::SideUI(wxFrame* parentFrame, rapidjson::Document* settings, std::shared_
 
 	verticalBoxSizer->Add(autoFrameSizer, 0, wxEXPAND | wxALL);
 	verticalBoxSizer->Add(autoRunFramesPerSecond, 0, wxEXPAND | wxALL);
+	verticalBoxSizer->Add(autoRunFramesInFlight, 0, wxEXPAND | wxALL);
 	verticalBoxSizer->Add(autoRunWithFramebuffer, 0, wxEXPAND | wxALL);
 	verticalBoxSizer->Add(autoRunWithControllerData, 0, wxEXPAND | wxALL);
 
@@ -323,7 +333,7 @@ void SideUI::onSavestateHookModifyPressed(wxCommandEvent& event) {
 
 			inputData->invalidateRun(0);
 
-			modifySavestateSelection.getNewScreenshot()->SaveFile(inputData->getFramebufferPathForCurrentFramebuf().GetFullPath(), wxBITMAP_TYPE_JPEG);
+			modifySavestateSelection.getNewScreenshot()->SaveFile(inputData->getFramebufferPathForSavestateHook(inputData->getCurrentSavestateHook()).GetFullPath(), wxBITMAP_TYPE_JPEG);
 
 			inputData->setSavestateHook(inputData->getCurrentSavestateHook());
 
@@ -343,7 +353,12 @@ void SideUI::onPlayerRemovePressed(wxCommandEvent& event) {
 }
 
 void SideUI::onBranchAddPressed(wxCommandEvent& event) {
-	inputData->addNewBranch();
+	if(wxGetKeyState(WXK_SHIFT)) {
+		// Start from the current branch instead of blank frames
+		inputData->forkBranch();
+	} else {
+		inputData->addNewBranch();
+	}
 }
 
 void SideUI::onBranchRemovePressed(wxCommandEvent& event) {
@@ -370,7 +385,7 @@ bool SideUI::createSavestateHook() {
 			blocks[blocks.size() - 1]->dHash      = savestateSelection.getNewDhash();
 			blocks[blocks.size() - 1]->screenshot = savestateSelection.getNewScreenshot();
 
-			savestateSelection.getNewScreenshot()->SaveFile(inputData->getFramebufferPathForCurrentFramebuf().GetFullPath(), wxBITMAP_TYPE_JPEG);
+			savestateSelection.getNewScreenshot()->SaveFile(inputData->getFramebufferPathForSavestateHook(blocks.size() - 1).GetFullPath(), wxBITMAP_TYPE_JPEG);
 
 			inputData->setSavestateHook(blocks.size() - 1);
 
@@ -446,13 +461,19 @@ void SideUI::onStartAutoFramePressed(wxCommandEvent& event) {
 	// autoTimer.Start(1000 / (float)autoRunFramesPerSecond->GetValue(), wxTIMER_CONTINUOUS);
 	autoRunActive = true;
 	autoFrameStart->Disable();
+	inputData->getAutoRunPipeline().startTiming();
 	sendAutoRunData();
 }
 
 void SideUI::sendAutoRunData() {
 	if(autoRunActive) {
 		if(autoRunWithControllerData->GetValue()) {
-			inputData->sendAutoAdvance(autoRunWithFramebuffer->GetValue());
+			// Up to the window, the rest go out as framebuffers come back
+			AutoRunPipeline& pipeline = inputData->getAutoRunPipeline();
+			pipeline.setWindow(autoRunFramesInFlight->GetValue());
+			while(pipeline.canSend()) {
+				inputData->sendAutoAdvance(autoRunWithFramebuffer->GetValue());
+			}
 		} else {
 			inputData->runFrame(false, false, autoRunWithFramebuffer->GetValue());
 		}
@@ -460,6 +481,12 @@ void SideUI::sendAutoRunData() {
 }
 
 void SideUI::onEndAutoFramePressed(wxCommandEvent& event) {
+	if(autoRunActive) {
+		AutoRunPipeline& pipeline = inputData->getAutoRunPipeline();
+		double seconds            = pipeline.getSecondsElapsed();
+		wxLogMessage(wxString::Format("Auto run handled %u frames in %.2f seconds, %.2f frames per second with %u in flight", pipeline.getFramesHandled(), seconds, seconds == 0 ? 0.0 : pipeline.getFramesHandled() / seconds, pipeline.getWindow()));
+	}
+
 	autoRunActive = false;
 	autoFrameStart->Enable();
 }
\ No newline at end of file
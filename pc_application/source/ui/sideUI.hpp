@@ -12,6 +12,7 @@
 #include "../sharedNetworkCode/networkInterface.hpp"
 #include "drawingCanvas.hpp"
 #include "savestateSelection.hpp"
+#include "timelineMinimap.hpp"
 
 class FrameCanvas : public DrawingCanvas {
 private:
@@ -69,6 +70,8 @@ private:
 	wxBoxSizer* inputsViewSizer;
 
 	FrameCanvas* frameDrawer;
+	// Density of every button over the whole branch
+	TimelineMinimap* timelineMinimap;
 
 	std::function<void()> incrementFrameCallback;
 
@@ -76,6 +79,7 @@ private:
 	wxBitmapButton* autoFrameStart;
 	wxBitmapButton* autoFrameEnd;
 	wxSpinCtrl* autoRunFramesPerSecond;
+	wxSpinCtrl* autoRunFramesInFlight;
 
 	wxCheckBox* autoRunWithFramebuffer;
 	wxCheckBox* autoRunWithControllerData;
@@ -0,0 +1,210 @@
+#include "timelineMinimap.hpp"
+
+TimelineMinimap::TimelineMinimap(wxFrame* parent, DataProcessing* dataProcessing)
+	: DrawingCanvas(parent, wxSize(TIMELINE_NUM_CHANNELS * TIMELINE_MINIMAP_COLUMN_WIDTH + 4, -1)) {
+	inputData = dataProcessing;
+	SetMinSize(wxSize(TIMELINE_NUM_CHANNELS * TIMELINE_MINIMAP_COLUMN_WIDTH + 4, -1));
+
+	// Buttons go around the color wheel, savestates stand out
+	for(uint8_t channel = 0; channel < BUTTONS_SIZE; channel++) {
+		wxImage::RGBValue colour = wxImage::HSVtoRGB(wxImage::HSVValue((double)channel / BUTTONS_SIZE, 0.75, 0.9));
+		channelColours[channel]  = wxColour(colour.red, colour.green, colour.blue);
+	}
+	channelColours[TIMELINE_SAVESTATE_CHANNEL] = wxColour(255, 215, 0);
+
+	// Dynamic handlers go before the zooming and panning of DrawingCanvas
+	Bind(wxEVT_LEFT_DOWN, &TimelineMinimap::onLeftDown, this);
+	Bind(wxEVT_MOTION, &TimelineMinimap::onMouseMove, this);
+	Bind(wxEVT_LEFT_UP, &TimelineMinimap::onLeftUp, this);
+	Bind(wxEVT_MOUSE_CAPTURE_LOST, &TimelineMinimap::onCaptureLost, this);
+	Bind(wxEVT_MOUSEWHEEL, &TimelineMinimap::onMouseWheel, this);
+
+	inputData->setTimelineCallback(std::bind(&TimelineMinimap::timelineChanged, this));
+}
+
+void TimelineMinimap::getView(FrameNum numFrames, FrameNum& start, FrameNum& count) const {
+	if(viewFrames == 0 || viewFrames >= numFrames) {
+		start = 0;
+		count = numFrames;
+	} else {
+		count = viewFrames;
+		start = std::min(viewStart, numFrames - viewFrames);
+	}
+}
+
+FrameNum TimelineMinimap::frameAtY(int y) const {
+	int height         = std::max(1, GetClientSize().GetHeight());
+	FrameNum numFrames = inputData->getTimelineSummary().getNumFrames();
+
+	FrameNum start;
+	FrameNum count;
+	getView(numFrames, start, count);
+
+	y = std::max(0, std::min(y, height - 1));
+	return std::min<FrameNum>(start + (uint64_t)count * y / height, numFrames == 0 ? 0 : numFrames - 1);
+}
+
+int TimelineMinimap::yOfFrame(FrameNum frame, FrameNum start, FrameNum count, int height) const {
+	return (uint64_t)(frame - start) * height / count;
+}
+
+void TimelineMinimap::seekTo(int y) {
+	if(inputData->getFramesSize() != 0) {
+		inputData->setCurrentFrame(frameAtY(y));
+	}
+}
+
+void TimelineMinimap::timelineChanged() {
+	// Called on every paint of the grid, so only redraw if something shown moved
+	uint64_t version = inputData->getTimelineSummary().getVersion();
+	if(version != drawnVersion || inputData->getTopRow() != drawnTopRow || inputData->getCurrentFrame() != drawnFrame || inputData->getCurrentRunFrame() != drawnRunFrame || inputData->getCurrentImageFrame() != drawnImageFrame) {
+		Refresh(false);
+	}
+}
+
+void TimelineMinimap::draw(wxDC& dc) {
+	const TimelineSummary& summary = inputData->getTimelineSummary();
+
+	drawnVersion    = summary.getVersion();
+	drawnTopRow     = inputData->getTopRow();
+	drawnFrame      = inputData->getCurrentFrame();
+	drawnRunFrame   = inputData->getCurrentRunFrame();
+	drawnImageFrame = inputData->getCurrentImageFrame();
+
+	int width;
+	int height;
+	GetClientSize(&width, &height);
+
+	FrameNum numFrames = summary.getNumFrames();
+	if(numFrames == 0 || width <= 0 || height <= 0) {
+		return;
+	}
+
+	FrameNum start;
+	FrameNum count;
+	getView(numFrames, start, count);
+
+	if(!densityImage.IsOk() || densityImage.GetWidth() != width || densityImage.GetHeight() != height) {
+		densityImage.Create(width, height, false);
+	}
+
+	// Straight into the RGB data, one range query per row of pixels
+	wxColour background    = inputData->GetBackgroundColour();
+	unsigned char* pixels  = densityImage.GetData();
+	int columnsStart       = (width - TIMELINE_NUM_CHANNELS * TIMELINE_MINIMAP_COLUMN_WIDTH) / 2;
+	TimelineCounts counts;
+	for(int y = 0; y < height; y++) {
+		FrameNum rowStart = start + (uint64_t)count * y / height;
+		FrameNum rowEnd   = std::max<FrameNum>(start + (uint64_t)count * (y + 1) / height, rowStart + 1);
+		summary.query(rowStart, rowEnd, counts);
+
+		unsigned char* row = pixels + (std::size_t)y * width * 3;
+		for(int x = 0; x < width; x++) {
+			row[x * 3]     = background.Red();
+			row[x * 3 + 1] = background.Green();
+			row[x * 3 + 2] = background.Blue();
+		}
+
+		for(uint8_t channel = 0; channel < TIMELINE_NUM_CHANNELS; channel++) {
+			if(counts.counts[channel] == 0) {
+				continue;
+			}
+
+			// A single press in a huge range still has to show up
+			float amount          = 0.3f + 0.7f * counts.counts[channel] / (rowEnd - rowStart);
+			const wxColour& color = channelColours[channel];
+			unsigned char red     = background.Red() + (color.Red() - background.Red()) * amount;
+			unsigned char green   = background.Green() + (color.Green() - background.Green()) * amount;
+			unsigned char blue    = background.Blue() + (color.Blue() - background.Blue()) * amount;
+
+			int columnX = columnsStart + channel * TIMELINE_MINIMAP_COLUMN_WIDTH;
+			for(int x = std::max(0, columnX); x < std::min(width, columnX + TIMELINE_MINIMAP_COLUMN_WIDTH); x++) {
+				row[x * 3]     = red;
+				row[x * 3 + 1] = green;
+				row[x * 3 + 2] = blue;
+			}
+		}
+	}
+
+	dc.DrawBitmap(wxBitmap(densityImage), 0, 0, false);
+
+	// Rows visible in the grid
+	FrameNum topRow    = inputData->getTopRow();
+	FrameNum bottomRow = std::min<FrameNum>(topRow + std::max<FrameNum>(inputData->getRowsPerPage(), 1), numFrames);
+	if(topRow < start + count && bottomRow > start) {
+		int topY    = yOfFrame(std::max(topRow, start), start, count, height);
+		int bottomY = yOfFrame(std::min(bottomRow, start + count), start, count, height);
+		dc.SetPen(wxPen(inputData->GetForegroundColour()));
+		dc.SetBrush(*wxTRANSPARENT_BRUSH);
+		dc.DrawRectangle(0, topY, width, std::max(bottomY - topY, 2));
+	}
+
+	// Same colors as the frame markers next to the grid
+	dc.SetPen(*wxTRANSPARENT_PEN);
+	FrameNum markers[]       = { drawnFrame, drawnRunFrame, drawnImageFrame };
+	const wxBrush* brushes[] = { wxYELLOW_BRUSH, wxGREEN_BRUSH, wxRED_BRUSH };
+	for(int i = 0; i < 3; i++) {
+		if(markers[i] >= start && markers[i] < start + count) {
+			dc.SetBrush(*brushes[i]);
+			dc.DrawRectangle(0, yOfFrame(markers[i], start, count, height), width, 2);
+		}
+	}
+}
+
+void TimelineMinimap::onLeftDown(wxMouseEvent& event) {
+	seeking = true;
+	CaptureMouse();
+	seekTo(event.GetPosition().y);
+}
+
+void TimelineMinimap::onMouseMove(wxMouseEvent& event) {
+	if(seeking && event.LeftIsDown()) {
+		seekTo(event.GetPosition().y);
+	}
+}
+
+void TimelineMinimap::onLeftUp(wxMouseEvent& event) {
+	if(seeking) {
+		seeking = false;
+		if(HasCapture()) {
+			ReleaseMouse();
+		}
+	}
+}
+
+void TimelineMinimap::onCaptureLost(wxMouseCaptureLostEvent& event) {
+	// wxWidgets requires this to be handled when capturing
+	seeking = false;
+}
+
+void TimelineMinimap::onMouseWheel(wxMouseEvent& event) {
+	FrameNum numFrames = inputData->getTimelineSummary().getNumFrames();
+	int height         = std::max(1, GetClientSize().GetHeight());
+	int y              = std::max(0, std::min(event.GetPosition().y, height - 1));
+	int ticks          = event.GetWheelRotation() / event.GetWheelDelta();
+	if(numFrames == 0 || ticks == 0) {
+		return;
+	}
+
+	FrameNum start;
+	FrameNum count;
+	getView(numFrames, start, count);
+
+	// The frame under the mouse stays there
+	FrameNum anchor   = frameAtY(y);
+	uint64_t newCount = count;
+	for(int i = 0; i < std::abs(ticks); i++) {
+		newCount = ticks > 0 ? newCount / TIMELINE_MINIMAP_ZOOM_FACTOR : newCount * TIMELINE_MINIMAP_ZOOM_FACTOR;
+	}
+	newCount = std::max<uint64_t>(newCount, std::min<FrameNum>(TIMELINE_MINIMAP_MIN_FRAMES, numFrames));
+
+	if(newCount >= numFrames) {
+		viewStart  = 0;
+		viewFrames = 0;
+	} else {
+		uint64_t above = newCount * y / height;
+		viewFrames     = newCount;
+		viewStart      = std::min<uint64_t>(anchor > above ? anchor - above : 0, numFrames - newCount);
+	}
+	Refresh(false);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <wx/dcbuffer.h>
+#include <wx/image.h>
+#include <wx/wx.h>
+
+#include "../dataHandling/dataProcessing.hpp"
+#include "../dataHandling/timelineSummary.hpp"
+#include "drawingCanvas.hpp"
+
+// Width of each button column
+#define TIMELINE_MINIMAP_COLUMN_WIDTH 3
+// Frames shown per wheel notch is multiplied or divided by this
+#define TIMELINE_MINIMAP_ZOOM_FACTOR 2
+// Can't zoom in past this many frames on screen
+#define TIMELINE_MINIMAP_MIN_FRAMES 32
+
+// The whole branch top to bottom, one column per button, darker where it's held more
+// Every row of pixels is a range query on the timeline summary, so it doesn't matter how many frames there are
+// Click or drag to seek, scroll to zoom in around the mouse
+class TimelineMinimap : public DrawingCanvas {
+private:
+	DataProcessing* inputData;
+
+	// Zoomed in part, 0 frames is the whole branch
+	FrameNum viewStart  = 0;
+	FrameNum viewFrames = 0;
+
+	bool seeking = false;
+
+	// What was last drawn, nothing is redrawn if none of it changed
+	uint64_t drawnVersion    = UINT64_MAX;
+	FrameNum drawnTopRow     = 0;
+	FrameNum drawnFrame      = 0;
+	FrameNum drawnRunFrame   = 0;
+	FrameNum drawnImageFrame = 0;
+
+	wxColour channelColours[TIMELINE_NUM_CHANNELS];
+	// Reused between draws
+	wxImage densityImage;
+
+	// Clamped to the branch
+	void getView(FrameNum numFrames, FrameNum& start, FrameNum& count) const;
+	FrameNum frameAtY(int y) const;
+	int yOfFrame(FrameNum frame, FrameNum start, FrameNum count, int height) const;
+	void seekTo(int y);
+
+	void timelineChanged();
+
+	void onLeftDown(wxMouseEvent& event);
+	void onMouseMove(wxMouseEvent& event);
+	void onLeftUp(wxMouseEvent& event);
+	void onCaptureLost(wxMouseCaptureLostEvent& event);
+	void onMouseWheel(wxMouseEvent& event);
+
+public:
+	TimelineMinimap(wxFrame* parent, DataProcessing* dataProcessing);
+
+	virtual void draw(wxDC& dc) override;
+};
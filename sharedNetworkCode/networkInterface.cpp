@@ -67,6 +67,7 @@ void CommunicateWithNetwork::handleFatalError() {
 #endif
 	connectedToSocket     = false;
 	otherSideDisconnected = true;
+	wakeMainThread();
 	networkConnection->Close();
 #ifdef SERVER_IMP
 	waitForNetworkConnection();
@@ -80,7 +81,7 @@ void CommunicateWithNetwork::handleFatalError() {
 	prepareNetworkConnection();
 }
 
-CommunicateWithNetwork::CommunicateWithNetwork(std::function<void(CommunicateWithNetwork*)> sendCallback, std::function<void(CommunicateWithNetwork*)> recieveCallback) {
+CommunicateWithNetwork::CommunicateWithNetwork(std::function<void(CommunicateWithNetwork*)> sendCallback, std::function<void(CommunicateWithNetwork*)> recieveCallback, std::function<void()> wake) {
 	// Should keep reading network at the beginning
 	keepReading           = true;
 	connectedToSocket     = false;
@@ -88,6 +89,7 @@ CommunicateWithNetwork::CommunicateWithNetwork(std::function<void(CommunicateWit
 
 	sendQueueDataCallback    = sendCallback;
 	recieveQueueDataCallback = recieveCallback;
+	wakeCallback             = wake;
 
 	// Start the thread, this means that this class goes on the main thread
 	networkThread = std::make_shared<std::thread>(&CommunicateWithNetwork::initNetwork, this);
@@ -156,6 +158,7 @@ void CommunicateWithNetwork::waitForNetworkConnection() {
 		if(networkConnection != NULL) {
 			// Connection established, stop while looping
 			connectedToSocket = true;
+			wakeMainThread();
 			break;
 		} else {
 			handleSocketError("during server accept attempts");
@@ -208,6 +211,14 @@ void CommunicateWithNetwork::endNetwork() {
 	CLEAN_QUEUE(RecieveMemoryRegion)
 	CLEAN_QUEUE(SendAddMemoryRegion)
 	CLEAN_QUEUE(SendStartFinalTas)
+	CLEAN_QUEUE(SendMemorySnapshot)
+	CLEAN_QUEUE(RecieveMemorySnapshotChunk)
+	CLEAN_QUEUE(SendRunLuaScript)
+	CLEAN_QUEUE(SendFinalTasChunk)
+	CLEAN_QUEUE(RecieveFinalTasProgress)
+	CLEAN_QUEUE(SendRunToFrame)
+	CLEAN_QUEUE(RecieveRunToFrameProgress)
+	CLEAN_QUEUE(RecieveHeapUsage)
 
 #ifdef SERVER_IMP
 	listeningServer.Close();
@@ -311,11 +322,14 @@ void CommunicateWithNetwork::readFunc() {
 			}
 			// Flag now tells us the data we expect to recieve
 
-			dataToRead = (uint8_t*)malloc(dataSize);
+			// No allocation unless this is the biggest message yet
+			if(readBuffer.size() < dataSize) {
+				readBuffer.resize(dataSize);
+			}
+			dataToRead = readBuffer.data();
 
 			// The message worked, so get the data
 			if(readData(dataToRead, dataSize)) {
-				free(dataToRead);
 				networkError = true;
 				continue;
 			}
@@ -323,9 +337,7 @@ void CommunicateWithNetwork::readFunc() {
 			// Now, check over incoming queues, they will absorb the data if they correspond with the flag
 			// Keep in mind, this is not the main thread, so can't act upon the data instantly
 			recieveQueueDataCallback(this);
-
-			// Free memory
-			free(dataToRead);
+			wakeMainThread();
 		}
 
 		yieldThread();
@@ -0,0 +1,21 @@
+#include "captureBufferPool.hpp"
+
+CaptureBufferPool::CaptureBufferPool() {
+	for(uint8_t i = 0; i < CAPTURE_BUFFER_POOL_SIZE; i++) {
+		std::vector<uint8_t> buf;
+		buf.reserve(JPEG_BUF_SIZE);
+		freeBuffers.enqueue(std::move(buf));
+	}
+}
+
+bool CaptureBufferPool::take(std::vector<uint8_t>& buf) {
+	return freeBuffers.try_dequeue(buf);
+}
+
+void CaptureBufferPool::giveBack(std::vector<uint8_t>& buf) {
+	// Frames without a framebuffer send an empty vector
+	if(buf.capacity() >= JPEG_BUF_SIZE) {
+		buf.clear();
+		freeBuffers.enqueue(std::move(buf));
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "screenshotHandler.hpp"
+#include "sharedNetworkCode/include/concurrentqueue.h"
+
+// Enough that the switch can capture the next frame while the last ones are still sending
+#define CAPTURE_BUFFER_POOL_SIZE 3
+
+// Framebuffers are captured into one of these and moved through the send queue
+// The network thread gives them back once they're sent, so nothing is allocated per frame
+// Every buffer is allocated at the start, the heap is too small to find 512 KB later
+class CaptureBufferPool {
+private:
+	// Filled and emptied from different threads
+	moodycamel::ConcurrentQueue<std::vector<uint8_t>> freeBuffers;
+
+public:
+	CaptureBufferPool();
+
+	// False if every buffer is still waiting to be sent
+	bool take(std::vector<uint8_t>& buf);
+	// Anything that didn't come from the pool is left alone
+	void giveBack(std::vector<uint8_t>& buf);
+};
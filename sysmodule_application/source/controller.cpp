@@ -75,6 +75,27 @@ void ControllerHandler::setFrame(u64 buttons, JoystickPosition& left, JoystickPo
 }
 #endif
 
+void ControllerHandler::setButtonState(Btn button, uint8_t pressed) {
+#ifdef __SWITCH__
+	if(pressed) {
+		state.buttons |= btnToHidKeys.at(button);
+	} else {
+		state.buttons &= ~btnToHidKeys.at(button);
+	}
+#endif
+}
+
+void ControllerHandler::setJoystickState(uint8_t isRight, uint8_t isY, int16_t value) {
+#ifdef __SWITCH__
+	JoystickPosition& joystick = state.joysticks[isRight ? JOYSTICK_RIGHT : JOYSTICK_LEFT];
+	if(isY) {
+		joystick.dy = value;
+	} else {
+		joystick.dx = value;
+	}
+#endif
+}
+
 std::shared_ptr<ControllerData> ControllerHandler::getControllerData() {
 	std::shared_ptr<ControllerData> newControllerData = std::make_shared<ControllerData>();
 
@@ -42,6 +42,10 @@ public:
 #endif
 	}
 
+	// Write straight into the state, setInput applies it
+	void setButtonState(Btn button, uint8_t pressed);
+	void setJoystickState(uint8_t isRight, uint8_t isY, int16_t value);
+
 	void setInput() {
 #ifdef __SWITCH__
 		rc = hiddbgSetHdlsState(HdlsHandle, &state);
@@ -1,18 +1,35 @@
 #include "mainLoopHandler.hpp"
 
+#ifdef __SWITCH__
+// From main.cpp
+extern "C" size_t nx_inner_heap_size;
+#endif
+
 MainLoop::MainLoop() {
 #ifdef __SWITCH__
+	// Has to exist before the network threads can signal it
+	ueventCreate(&networkEvent, true);
+	networkSignalTick = 0;
+
 	LOGD << "Start networking";
 #endif
 	// Start networking with set queues
 	networkInstance = std::make_shared<CommunicateWithNetwork>(
-		[](CommunicateWithNetwork* self) {
+		[this](CommunicateWithNetwork* self) {
 			SEND_QUEUE_DATA(RecieveFlag)
 			SEND_QUEUE_DATA(RecieveGameInfo)
-			SEND_QUEUE_DATA(RecieveGameFramebuffer)
+			SEND_QUEUE_DATA_AND_RETURN(RecieveGameFramebuffer, [this](Protocol::Struct_RecieveGameFramebuffer& sent) {
+				capturePool.giveBack(sent.buf);
+			})
 			SEND_QUEUE_DATA(RecieveApplicationConnected)
 			SEND_QUEUE_DATA(RecieveLogging)
 			SEND_QUEUE_DATA(RecieveMemoryRegion)
+			SEND_QUEUE_DATA(RecieveMemorySnapshotChunk)
+			SEND_QUEUE_DATA(RecieveFinalTasProgress)
+			SEND_QUEUE_DATA_AND_RETURN(RecieveRunToFrameProgress, [this](Protocol::Struct_RecieveRunToFrameProgress& sent) {
+				capturePool.giveBack(sent.buf);
+			})
+			SEND_QUEUE_DATA(RecieveHeapUsage)
 		},
 		[](CommunicateWithNetwork* self) {
 			RECIEVE_QUEUE_DATA(SendFlag)
@@ -22,8 +39,31 @@ MainLoop::MainLoop() {
 			RECIEVE_QUEUE_DATA(SendSetNumControllers)
 			RECIEVE_QUEUE_DATA(SendAddMemoryRegion)
 			RECIEVE_QUEUE_DATA(SendStartFinalTas)
+			RECIEVE_QUEUE_DATA(SendMemorySnapshot)
+			RECIEVE_QUEUE_DATA(SendRunLuaScript)
+			RECIEVE_QUEUE_DATA(SendFinalTasChunk)
+			RECIEVE_QUEUE_DATA(SendRunToFrame)
+		},
+		[this]() {
+#ifdef __SWITCH__
+			// Only the first one is kept, so the latency is of the oldest command waiting
+			uint64_t noSignal = 0;
+			networkSignalTick.compare_exchange_strong(noSignal, armGetSystemTick());
+			ueventSignal(&networkEvent);
+#endif
 		});
 
+	luaScripting = std::make_shared<LuaScripting>();
+	luaScripting->setControllers(&controllers);
+	luaScripting->setLogCallback([this](std::string log) {
+#ifdef __SWITCH__
+		LOGD << log;
+#endif
+		ADD_TO_QUEUE(RecieveLogging, networkInstance, {
+			data.log = log;
+		})
+	});
+
 #ifdef __SWITCH__
 	LOGD << "Open display";
 	ViDisplay disp;
@@ -63,6 +103,94 @@ void MainLoop::mainLoopHandler() {
 	}
 	*/
 
+#ifdef __SWITCH__
+	// Sleeps until the network, vsync or the process check needs something
+	Waiter waiters[2];
+	s32 numWaiters   = 0;
+	s32 networkIndex = numWaiters++;
+	s32 vsyncIndex   = -1;
+	waiters[networkIndex] = waiterForUEvent(&networkEvent);
+	if(needsVsync()) {
+		vsyncIndex          = numWaiters++;
+		waiters[vsyncIndex] = waiterForEvent(&vsyncEvent);
+	}
+
+	uint64_t nowNs = armTicksToNs(armGetSystemTick());
+	uint64_t timeoutNs;
+	if(snapshotInProgress) {
+		// Chunks go out as fast as the network thread takes them
+		timeoutNs = 1000000;
+	} else {
+		timeoutNs = nextProcessCheckNs > nowNs ? nextProcessCheckNs - nowNs : 0;
+	}
+
+	s32 index = -1;
+	if(R_FAILED(waitObjects(&index, waiters, numWaiters, timeoutNs))) {
+		// Timed out
+		index = -1;
+	}
+	nowNs = armTicksToNs(armGetSystemTick());
+
+	if(index == networkIndex) {
+		networkWakeups++;
+		uint64_t signalTick = networkSignalTick.exchange(0);
+		if(signalTick != 0) {
+			uint64_t latencyNs = nowNs - armTicksToNs(signalTick);
+			totalCommandLatencyNs += latencyNs;
+			maxCommandLatencyNs = std::max(maxCommandLatencyNs, latencyNs);
+		}
+	} else if(index == vsyncIndex) {
+		vsyncWakeups++;
+	} else {
+		timeoutWakeups++;
+	}
+
+	if(nowNs >= nextProcessCheckNs) {
+		handleProcessState();
+		nextProcessCheckNs = nowNs + PROCESS_CHECK_INTERVAL_MS * 1000000ULL;
+	}
+
+	handleConnectionState();
+
+	if(applicationOpened) {
+		// Commands that came in before the application opened are still waiting
+		handleNetworkUpdates();
+	}
+
+	if(snapshotInProgress) {
+		sendMemorySnapshotChunk();
+	}
+
+	if(index == vsyncIndex) {
+		handleVsync();
+	}
+
+	logMainLoopStats(nowNs);
+#else
+	// The emulator calls this itself
+	handleProcessState();
+	handleConnectionState();
+
+	if(applicationOpened) {
+		// handle network updates always, they are stored in the queue regardless of the internet
+		handleNetworkUpdates();
+	}
+
+	if(snapshotInProgress) {
+		sendMemorySnapshotChunk();
+	}
+
+	// Match first controller inputs as often as possible
+	if(!isPaused) {
+		// TODO handle when running final TAS
+		matchFirstControllerToTASController(0);
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+}
+
+void MainLoop::handleProcessState() {
 	if(!isPaused) {
 #ifdef __SWITCH__
 		// Being debugged might break this application
@@ -89,6 +217,9 @@ void MainLoop::mainLoopHandler() {
 					})
 
 					applicationOpened = true;
+					// Found again for this application
+					mainLocation = 0;
+					heapLocation = 0;
 
 					// Start the whole main loop
 					// Set the application for the controller
@@ -113,13 +244,16 @@ void MainLoop::mainLoopHandler() {
 			}
 		}
 	}
+}
 
+void MainLoop::handleConnectionState() {
 	if(networkInstance->isConnected()) {
 		if(!internetConnected) {
 #ifdef __SWITCH__
 			LOGD << "Internet connected";
 #endif
 			internetConnected = true;
+			sendHeapUsage();
 		}
 	} else {
 		if(internetConnected) {
@@ -132,28 +266,62 @@ void MainLoop::mainLoopHandler() {
 			reset();
 		}
 	}
+}
 
-	if(applicationOpened) {
-		// handle network updates always, they are stored in the queue regardless of the internet
-		handleNetworkUpdates();
-	}
-
-	// Match first controller inputs as often as possible
+void MainLoop::handleVsync() {
+	// The game only reads inputs once a frame, so they're matched once a frame
 	if(!isPaused) {
 		// TODO handle when running final TAS
 		matchFirstControllerToTASController(0);
 	}
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#ifdef __SWITCH__
+	// Scripts keep running while the game runs normally, once per frame
+	if(!isPaused && applicationOpened && luaScripting->isScriptLoaded()) {
+		luaScripting->runAfterFrame();
+		luaScripting->runBeforeFrame();
+	}
+#endif
+}
+
+#ifdef __SWITCH__
+void MainLoop::logMainLoopStats(uint64_t nowNs) {
+	uint64_t elapsedNs = nowNs - statsStartNs;
+	if(elapsedNs < MAIN_LOOP_STATS_INTERVAL_SECONDS * 1000000000ULL) {
+		return;
+	}
+
+	// Nothing to say while idle, the log is on the SD card
+	if(networkWakeups != 0 || vsyncWakeups != 0) {
+		uint32_t wakeups = networkWakeups + vsyncWakeups + timeoutWakeups;
+		LOGD << "Main loop woke " << wakeups << " times in " << (int)(elapsedNs / 1000000) << " ms, " << networkWakeups << " network, " << vsyncWakeups << " vsync, " << timeoutWakeups << " timeout";
+		if(networkWakeups != 0) {
+			LOGD << "Command latency average " << (int)(totalCommandLatencyNs / networkWakeups / 1000) << " us, max " << (int)(maxCommandLatencyNs / 1000) << " us";
+		}
+		sendHeapUsage();
+	}
+
+	statsStartNs          = nowNs;
+	vsyncWakeups          = 0;
+	networkWakeups        = 0;
+	timeoutWakeups        = 0;
+	totalCommandLatencyNs = 0;
+	maxCommandLatencyNs   = 0;
 }
+#endif
 
 void MainLoop::handleNetworkUpdates() {
 	CHECK_QUEUE(networkInstance, SendFrameData, {
 		if(data.incrementFrame) {
+			frameSequence = data.sequence;
 			runSingleFrame(true, data.includeFramebuffer, false, data.frame, data.savestateHookNum, data.branchIndex, data.playerIndex);
+			frameSequence = 0;
 		} else if(data.isAutoRun) {
+			// Several of these can be queued up, each one is run as soon as the last is captured
+			frameSequence = data.sequence;
 			matchFirstControllerToTASController(data.playerIndex);
 			runSingleFrame(true, data.includeFramebuffer, true, data.frame, data.savestateHookNum, data.branchIndex, data.playerIndex);
+			frameSequence = 0;
 		} else {
 			controllers[data.playerIndex]->setFrame(data.controllerData);
 		}
@@ -203,6 +371,8 @@ void MainLoop::handleNetworkUpdates() {
 			lastNanoseconds = 0;
 		} else if(data.actFlag == SendInfo::STOP_FINAL_TAS) {
 			finalTasShouldRun = false;
+		} else if(data.actFlag == SendInfo::STOP_RUN_TO_FRAME) {
+			runToFrameShouldRun = false;
 		}
 	})
 
@@ -221,7 +391,12 @@ void MainLoop::handleNetworkUpdates() {
 		} else {
 			MemoryRegionInfo info;
 
-			// prepareMemoryRegionMath(info.func, data.pointerDefinition);
+			// Still added so the indexes match the PC, it just never sends anything
+			if(!info.func.compile(data.pointerDefinition)) {
+#ifdef __SWITCH__
+				LOGD << "Invalid pointer definition: " << data.pointerDefinition;
+#endif
+			}
 
 			info.type = data.type;
 			info.u    = data.u;
@@ -230,14 +405,37 @@ void MainLoop::handleNetworkUpdates() {
 		}
 	})
 
+	CHECK_QUEUE(networkInstance, SendMemorySnapshot, {
+		if(data.cancel) {
+			snapshotRegions.clear();
+			snapshotInProgress = false;
+		} else {
+			startMemorySnapshot();
+		}
+	})
+
 	// clang-format off
 	CHECK_QUEUE(networkInstance, SendStartFinalTas, {
 		finalTasShouldRun = true;
-		runFinalTas(data.scriptPaths);
+		runFinalTas(data.scriptPaths, data.numOfStreamedPlayers, data.luaScriptPath, data.precompileLuaScript);
 	})
 	// clang-format on
 
-	// TODO add logic to handle lua scripting
+	CHECK_QUEUE(networkInstance, SendFinalTasChunk, {
+		addFinalTasChunk(data);
+	})
+
+	CHECK_QUEUE(networkInstance, SendRunToFrame, {
+		runToFrame(data);
+	})
+
+	CHECK_QUEUE(networkInstance, SendRunLuaScript, {
+		if(data.path.empty()) {
+			luaScripting->endScript();
+		} else {
+			luaScripting->loadScript(data.path);
+		}
+	})
 }
 
 void MainLoop::sendGameInfo() {
@@ -328,13 +526,60 @@ void MainLoop::setControllerNumber(uint8_t numOfControllers) {
 #endif
 }
 
-void MainLoop::runFinalTas(std::vector<std::string> scriptPaths) {
+void MainLoop::runFinalTas(std::vector<std::string> scriptPaths, uint8_t numOfStreamedPlayers, std::string luaScriptPath, uint8_t precompileLuaScript) {
+	uint8_t streamed = numOfStreamedPlayers != 0;
+
 	std::vector<FILE*> files;
-	for(auto const& path : scriptPaths) {
-		files.push_back(fopen(path.c_str(), "rb"));
+	if(!streamed) {
+		for(auto const& path : scriptPaths) {
+			files.push_back(fopen(path.c_str(), "rb"));
+		}
 	}
 
-	uint8_t filesSize = files.size();
+	// New scripts are one compact file with every player, the old ones have a file per player
+	TasScriptDecoder decoder;
+	std::vector<TasScriptFrame> decodedFrames;
+	uint8_t compact = false;
+	if(files.size() == 1 && files[0] != NULL) {
+		FILE* file = files[0];
+		compact    = decoder.open([file](uint64_t offset, void* data, std::size_t size) {
+			return fseek(file, offset, SEEK_SET) == 0 && fread(data, 1, size, file) == size;
+		});
+	}
+
+	if(!luaScriptPath.empty()) {
+		if(precompileLuaScript) {
+			// Ships with the TAS scripts, later runs can be pointed straight at the bytecode
+			std::string bytecodePath = luaScriptPath + "c";
+			if(luaScripting->compileScript(luaScriptPath, bytecodePath)) {
+				luaScriptPath = bytecodePath;
+			}
+		}
+		luaScripting->loadScript(luaScriptPath);
+	}
+
+	uint8_t numOfPlayers = streamed ? numOfStreamedPlayers : compact ? decoder.getNumOfPlayers() : files.size();
+
+	if(numOfPlayers > controllers.size()) {
+		// Every player needs a controller to play on
+#ifdef __SWITCH__
+		LOGD << "Final TAS has " << (int)numOfPlayers << " players but only " << controllers.size() << " controllers";
+#endif
+		finalTasShouldRun = false;
+	}
+
+	if(streamed) {
+		startFinalTasStream();
+		// Fill the buffer before starting, the PC sends as much as fits right away
+		while(finalTasShouldRun && networkInstance->isConnected() && !streamEnded && streamChunkCount != FINAL_TAS_STREAM_BUFFER_CHUNKS) {
+			handleNetworkUpdates();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		if(!networkInstance->isConnected()) {
+			finalTasShouldRun = false;
+		}
+	}
 
 	// Just in case
 	unpauseApp();
@@ -348,32 +593,387 @@ void MainLoop::runFinalTas(std::vector<std::string> scriptPaths) {
 		for(uint8_t i = 0; i < 30; i++) {
 			// File reading can't slow down at all
 
-			for(uint8_t player = 0; player < filesSize; player++) {
-				// Based on code in project handler without compression
-				uint8_t controllerSize;
-				readFullFileData(files[player], &controllerSize, sizeof(controllerSize));
+			if(streamed) {
+				if(!readStreamedFrame(numOfPlayers)) {
+					if(streamEnded) {
+						// Played everything
+						finalTasShouldRun = false;
+						break;
+					}
+
+					// Ran out, hold the game until more comes in rather than desync
+#ifdef __SWITCH__
+					LOGD << "Final TAS stream underrun at frame " << streamFramesPlayed;
+#endif
+					pauseApp(false, false, false, 0, 0, 0, 0);
+					while(finalTasShouldRun && networkInstance->isConnected() && !streamEnded && streamChunkCount == 0) {
+						handleNetworkUpdates();
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}
+					unpauseApp();
+					lastNanoseconds = 0;
+
+					// The PC is gone, nothing more is coming
+					if(!networkInstance->isConnected() || !readStreamedFrame(numOfPlayers)) {
+						finalTasShouldRun = false;
+						break;
+					}
+				}
+			} else if(compact) {
+				if(!decoder.readFrame(decodedFrames)) {
+					// End of the script
+					finalTasShouldRun = false;
+					break;
+				}
+
+				for(uint8_t player = 0; player < numOfPlayers; player++) {
+					ControllerData data;
+					decodedFrames[player].toControllerData(data);
+					controllers[player]->setFrame(data);
+				}
+			} else {
+				uint8_t endOfScript = false;
+				for(uint8_t player = 0; player < numOfPlayers; player++) {
+					// Based on code in project handler without compression
+					uint8_t controllerSize;
+					if(!readFullFileData(files[player], &controllerSize, sizeof(controllerSize))) {
+						endOfScript = true;
+						break;
+					}
 
-				uint8_t controllerDataBuf[controllerSize];
-				readFullFileData(files[player], controllerDataBuf, sizeof(controllerDataBuf));
+					uint8_t controllerDataBuf[controllerSize];
+					if(!readFullFileData(files[player], controllerDataBuf, sizeof(controllerDataBuf))) {
+						endOfScript = true;
+						break;
+					}
 
-				ControllerData data;
-				serializeProtocol.binaryToData<ControllerData>(data, controllerDataBuf, controllerSize);
+					ControllerData data;
+					serializeProtocol.binaryToData<ControllerData>(data, controllerDataBuf, controllerSize);
 
-				controllers[player]->setFrame(data);
+					controllers[player]->setFrame(data);
+				}
+
+				if(endOfScript) {
+					finalTasShouldRun = false;
+					break;
+				}
 			}
 
+			luaScripting->runBeforeFrame();
 			// Either put this before or after
 			waitForVsync();
+			luaScripting->runAfterFrame();
+		}
+
+		if(streamed) {
+			sendFinalTasProgress(false);
 		}
 
 		handleNetworkUpdates();
 	}
 
 	for(auto const& file : files) {
-		fclose(file);
+		if(file != NULL) {
+			fclose(file);
+		}
+	}
+
+	if(streamed) {
+		sendFinalTasProgress(true);
+		endFinalTasStream();
+	}
+
+	luaScripting->endScript();
+}
+
+void MainLoop::startFinalTasStream() {
+	// Slots are only allocated once, the chunk buffers are reused after that
+	streamChunks.resize(FINAL_TAS_STREAM_BUFFER_CHUNKS);
+	streamChunkHead    = 0;
+	streamChunkCount   = 0;
+	streamReadOffset   = 0;
+	streamFrameInChunk = 0;
+	streamFramesPlayed = 0;
+	streamChunksPlayed = 0;
+	streamActive       = true;
+	streamEnded        = false;
+}
+
+void MainLoop::endFinalTasStream() {
+	// Anything still buffered is dropped, late chunks are ignored by addFinalTasChunk
+	streamChunkCount = 0;
+	streamActive     = false;
+}
+
+void MainLoop::addFinalTasChunk(Protocol::Struct_SendFinalTasChunk& chunk) {
+	// Leftovers from a stopped run
+	if(!streamActive || streamEnded) {
+		return;
+	}
+
+	if(streamChunkCount == FINAL_TAS_STREAM_BUFFER_CHUNKS) {
+		// The PC never sends more than fits, so this means it's out of sync
+#ifdef __SWITCH__
+		LOGD << "Final TAS stream overflow, chunk dropped";
+#endif
+		return;
+	}
+
+	Protocol::Struct_SendFinalTasChunk& slot = streamChunks[(streamChunkHead + streamChunkCount) % FINAL_TAS_STREAM_BUFFER_CHUNKS];
+	// Swap so the slot keeps the old buffer's memory for the next chunk
+	slot.data.swap(chunk.data);
+	slot.numOfFrames = chunk.numOfFrames;
+	slot.isLast      = chunk.isLast;
+	streamChunkCount++;
+
+	if(chunk.isLast) {
+		streamEnded = true;
+	}
+}
+
+void MainLoop::popPlayedStreamChunks() {
+	// Empty chunks are skipped too, the last one can be
+	while(streamChunkCount != 0 && streamFrameInChunk == streamChunks[streamChunkHead].numOfFrames) {
+		streamChunkHead    = (streamChunkHead + 1) % FINAL_TAS_STREAM_BUFFER_CHUNKS;
+		streamReadOffset   = 0;
+		streamFrameInChunk = 0;
+		streamChunkCount--;
+		streamChunksPlayed++;
 	}
 }
 
+bool MainLoop::readStreamedFrame(uint8_t numOfPlayers) {
+	popPlayedStreamChunks();
+
+	if(streamChunkCount == 0) {
+		return false;
+	}
+
+	Protocol::Struct_SendFinalTasChunk& chunk = streamChunks[streamChunkHead];
+
+	// Every record is checked before any controller is touched, a broken chunk ends the stream
+	std::size_t offset = streamReadOffset;
+	for(uint8_t player = 0; player < numOfPlayers; player++) {
+		if(player >= controllers.size() || offset >= chunk.data.size() || chunk.data[offset] > chunk.data.size() - offset - 1) {
+#ifdef __SWITCH__
+			LOGD << "Malformed stream chunk " << streamChunksPlayed << ", ending the stream";
+#endif
+			streamEnded      = true;
+			streamChunkCount = 0;
+			return false;
+		}
+		offset += 1 + chunk.data[offset];
+	}
+
+	for(uint8_t player = 0; player < numOfPlayers; player++) {
+		uint8_t controllerSize = chunk.data[streamReadOffset];
+		streamReadOffset++;
+
+		ControllerData data;
+		serializeProtocol.binaryToData<ControllerData>(data, &chunk.data[streamReadOffset], controllerSize);
+		streamReadOffset += controllerSize;
+
+		controllers[player]->setFrame(data);
+	}
+
+	streamFrameInChunk++;
+	streamFramesPlayed++;
+	return true;
+}
+
+void MainLoop::sendFinalTasProgress(uint8_t finished) {
+	// Finished chunks are freed now so the PC can send more straight away
+	popPlayedStreamChunks();
+
+	ADD_TO_QUEUE(RecieveFinalTasProgress, networkInstance, {
+		data.framesPlayed = streamFramesPlayed;
+		data.chunksPlayed = streamChunksPlayed;
+		data.finished     = finished;
+	})
+}
+
+void MainLoop::runToFrame(Protocol::Struct_SendRunToFrame& info) {
+	std::vector<uint8_t> framebuffer;
+	std::string dhash;
+
+	// Starts from a frame advance pause, and can't start while something else is streaming
+	if(!isPaused || streamActive || info.endFrame <= info.startFrame || info.numOfPlayers > controllers.size()) {
+#ifdef __SWITCH__
+		LOGD << "Run to frame ignored";
+#endif
+		sendRunToFrameProgress(0, true, framebuffer);
+		return;
+	}
+
+	runToFrameShouldRun = true;
+	startFinalTasStream();
+	// Fill the buffer before starting, the PC sends as much as fits right away
+	while(runToFrameShouldRun && networkInstance->isConnected() && !streamEnded && streamChunkCount != FINAL_TAS_STREAM_BUFFER_CHUNKS) {
+		handleNetworkUpdates();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+#ifdef __SWITCH__
+	uint64_t startNanoseconds = armTicksToNs(armGetSystemTick());
+#endif
+
+	uint32_t numOfFrames = info.endFrame - info.startFrame;
+	uint32_t framesRun   = 0;
+	while(runToFrameShouldRun && framesRun != numOfFrames) {
+		if(!readStreamedFrame(info.numOfPlayers)) {
+			// Held on this frame until more comes in, the same as waiting on a frame advance
+#ifdef __SWITCH__
+			LOGD << "Run to frame underrun at frame " << info.startFrame + framesRun;
+#endif
+			haltApp();
+			while(runToFrameShouldRun && networkInstance->isConnected() && !streamEnded && streamChunkCount == 0) {
+				handleNetworkUpdates();
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+
+			if(!readStreamedFrame(info.numOfPlayers)) {
+				break;
+			}
+		}
+
+		luaScripting->runBeforeFrame();
+		if(isPaused) {
+			// Let go on a vsync, like runSingleFrame does
+			waitForVsync();
+			unpauseApp();
+		}
+		waitForVsync();
+		luaScripting->runAfterFrame();
+		framesRun++;
+
+		if(framesRun == numOfFrames) {
+			break;
+		}
+
+		if(info.framebufferInterval != 0 && framesRun % info.framebufferInterval == 0) {
+			// Held while capturing, otherwise the next input would be late
+			haltApp();
+			if(takeCaptureBuffer(framebuffer)) {
+				screenshotHandler.writeFramebuffer(framebuffer, dhash);
+			}
+			sendRunToFrameProgress(framesRun, false, framebuffer);
+			framebuffer.clear();
+			handleNetworkUpdates();
+		} else if(framesRun % RUN_TO_FRAME_PROGRESS_INTERVAL == 0) {
+			sendRunToFrameProgress(framesRun, false, framebuffer);
+			handleNetworkUpdates();
+		}
+	}
+
+	if(framesRun != 0) {
+		if(!isPaused) {
+			// The PC sees the last frame as a normal frame advance
+			pauseApp(true, true, false, info.startFrame + framesRun - 1, info.savestateHookNum, info.branchIndex, info.playerIndex);
+		} else {
+			// Stopped while held, the framebuffer comes with the progress instead
+			if(takeCaptureBuffer(framebuffer)) {
+				screenshotHandler.writeFramebuffer(framebuffer, dhash);
+			}
+		}
+	}
+	lastNanoseconds = 0;
+
+#ifdef __SWITCH__
+	LOGD << "Ran " << framesRun << " of " << numOfFrames << " frames in " << (int)((armTicksToNs(armGetSystemTick()) - startNanoseconds) / 1000000) << " ms";
+#endif
+
+	runToFrameShouldRun = false;
+	sendRunToFrameProgress(framesRun, true, framebuffer);
+	endFinalTasStream();
+}
+
+void MainLoop::sendRunToFrameProgress(uint32_t framesRun, uint8_t finished, std::vector<uint8_t>& framebuffer) {
+	// Finished chunks are freed now so the PC can send more straight away
+	popPlayedStreamChunks();
+
+	ADD_TO_QUEUE(RecieveRunToFrameProgress, networkInstance, {
+		data.framesRun    = framesRun;
+		data.chunksPlayed = streamChunksPlayed;
+		data.finished     = finished;
+		data.buf          = std::move(framebuffer);
+	})
+
+#ifdef __SWITCH__
+	sampleHeapUsage();
+#endif
+}
+
+bool MainLoop::takeCaptureBuffer(std::vector<uint8_t>& buf) {
+	while(!capturePool.take(buf)) {
+		// They only come back once they're sent
+		if(!networkInstance->isConnected()) {
+#ifdef __SWITCH__
+			LOGD << "No capture buffer free, framebuffer skipped";
+#endif
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+#ifdef __SWITCH__
+void MainLoop::sampleHeapUsage() {
+	struct mallinfo info = mallinfo();
+	peakHeapInUse        = std::max<uint32_t>(peakHeapInUse, info.uordblks);
+}
+#endif
+
+void MainLoop::sendHeapUsage() {
+#ifdef __SWITCH__
+	// The emulator doesn't have a heap of its own
+	struct mallinfo info = mallinfo();
+	peakHeapInUse        = std::max<uint32_t>(peakHeapInUse, info.uordblks);
+
+	LOGD << "Heap " << (int)(info.uordblks / 1024) << " KB in use, peak " << (int)(peakHeapInUse / 1024) << " KB, reserved peak " << (int)(info.usmblks / 1024) << " KB";
+
+	ADD_TO_QUEUE(RecieveHeapUsage, networkInstance, {
+		data.heapSize     = nx_inner_heap_size;
+		data.inUse        = info.uordblks;
+		data.peakInUse    = peakHeapInUse;
+		data.peakReserved = info.usmblks;
+	})
+#endif
+}
+
+void MainLoop::findWatchBases() {
+#ifdef __SWITCH__
+	// rtld is loaded first, main comes right after it when there is more than one module
+	std::vector<uint64_t> codeRegions;
+	uint64_t addr = 0;
+	while(true) {
+		MemoryInfo info = { 0 };
+		uint32_t pageinfo;
+		rc = svcQueryDebugProcessMemory(&info, &pageinfo, applicationDebug, addr);
+
+		if(R_FAILED(rc) || info.addr + info.size <= addr) {
+			break;
+		}
+
+		if(info.type == MemType_CodeStatic && info.perm == Perm_Rx) {
+			codeRegions.push_back(info.addr);
+		}
+
+		if(info.type == MemType_Heap && heapLocation == 0) {
+			heapLocation = info.addr;
+		}
+
+		addr = info.addr + info.size;
+	}
+
+	if(!codeRegions.empty()) {
+		mainLocation = codeRegions.size() == 1 ? codeRegions[0] : codeRegions[1];
+	}
+
+	LOGD << "Main at " << mainLocation << ", heap at " << heapLocation;
+#endif
+}
+
 #ifdef __SWITCH__
 GameMemoryInfo MainLoop::getGameMemoryInfo(MemoryInfo memInfo) {
 	GameMemoryInfo info;
@@ -389,15 +989,119 @@ GameMemoryInfo MainLoop::getGameMemoryInfo(MemoryInfo memInfo) {
 }
 #endif
 
+void MainLoop::startMemorySnapshot() {
+	snapshotRegions.clear();
+	snapshotRegionIndex  = 0;
+	snapshotRegionOffset = 0;
+	snapshotInProgress   = false;
+
+	// Memory can only be read while paused
+	if(!isPaused) {
+#ifdef __SWITCH__
+		LOGD << "Memory snapshot refused, not paused";
+#endif
+		abortMemorySnapshot();
+		return;
+	}
+
+	snapshotInProgress = true;
+
+#ifdef __SWITCH__
+	LOGD << "Start memory snapshot";
+	uint64_t addr = 0;
+	while(true) {
+		MemoryInfo info = { 0 };
+		uint32_t pageinfo;
+		rc = svcQueryDebugProcessMemory(&info, &pageinfo, applicationDebug, addr);
+
+		if(R_FAILED(rc) || info.addr + info.size <= addr) {
+			break;
+		}
+
+		// Only writable memory can change
+		if((info.perm & Perm_W) && info.type != MemType_Unmapped && info.type != MemType_Io) {
+			snapshotRegions.push_back(getGameMemoryInfo(info));
+		}
+
+		addr = info.addr + info.size;
+	}
+#endif
+}
+
+void MainLoop::abortMemorySnapshot() {
+	// The PC throws away what it got and keeps its last results
+	ADD_TO_QUEUE(RecieveMemorySnapshotChunk, networkInstance, {
+		data.addr    = 0;
+		data.isLast  = true;
+		data.aborted = true;
+	})
+
+	snapshotRegions.clear();
+	snapshotInProgress = false;
+}
+
+void MainLoop::sendMemorySnapshotChunk() {
+	if(!isPaused || !networkInstance->isConnected()) {
+		// Can't read anymore, a partial snapshot would drop every candidate not sent yet
+#ifdef __SWITCH__
+		LOGD << "Memory snapshot aborted";
+#endif
+		abortMemorySnapshot();
+		return;
+	}
+
+	if(networkInstance->Queue_RecieveMemorySnapshotChunk.size_approx() >= MAX_SNAPSHOT_CHUNKS_QUEUED) {
+		// Wait for the network thread to catch up
+		return;
+	}
+
+	uint64_t addr = 0;
+	std::vector<uint8_t> bytes;
+
+	if(snapshotRegionIndex < snapshotRegions.size()) {
+		GameMemoryInfo& region = snapshotRegions[snapshotRegionIndex];
+		uint64_t size          = std::min((uint64_t)MEMORY_SNAPSHOT_CHUNK_SIZE, region.size - snapshotRegionOffset);
+
+		addr  = region.addr + snapshotRegionOffset;
+		bytes = getMemory(addr, size);
+
+		snapshotRegionOffset += size;
+		if(snapshotRegionOffset == region.size) {
+			snapshotRegionIndex++;
+			snapshotRegionOffset = 0;
+		}
+	}
+
+	uint8_t isLast = snapshotRegionIndex >= snapshotRegions.size();
+
+	ADD_TO_QUEUE(RecieveMemorySnapshotChunk, networkInstance, {
+		data.addr    = addr;
+		data.memory  = std::move(bytes);
+		data.isLast  = isLast;
+		data.aborted = false;
+	})
+
+	if(isLast) {
+#ifdef __SWITCH__
+		LOGD << "Finished memory snapshot";
+#endif
+		snapshotRegions.clear();
+		snapshotInProgress = false;
+	}
+}
+
 void MainLoop::runSingleFrame(uint8_t linkedWithFrameAdvance, uint8_t includeFramebuffer, uint8_t autoAdvance, uint32_t frame, uint16_t savestateHookNum, uint32_t branchIndex, uint8_t playerIndex) {
 	if(isPaused) {
 #ifdef __SWITCH__
 		LOGD << "Running frame";
 #endif
+		// Scripts get the last say on the inputs of this frame
+		luaScripting->runBeforeFrame();
 		waitForVsync();
 		unpauseApp();
 		waitForVsync();
 		pauseApp(linkedWithFrameAdvance, includeFramebuffer, autoAdvance, frame, savestateHookNum, branchIndex, playerIndex);
+		luaScripting->runAfterFrame();
 	}
 }
 
@@ -427,12 +1131,13 @@ void MainLoop::pauseApp(uint8_t linkedWithFrameAdvance, uint8_t includeFramebuff
 			std::vector<uint8_t> jpegBuf;
 			std::string dhash;
 
-			if(includeFramebuffer) {
+			// Comes from the pool and goes back once it's sent
+			if(includeFramebuffer && takeCaptureBuffer(jpegBuf)) {
 				screenshotHandler.writeFramebuffer(jpegBuf, dhash);
 			}
 
 			ADD_TO_QUEUE(RecieveGameFramebuffer, networkInstance, {
-				data.buf = jpegBuf;
+				data.buf = std::move(jpegBuf);
 				// if(includeFramebuffer) {
 				//	data.dhash = dhash;
 				//}
@@ -445,21 +1150,67 @@ void MainLoop::pauseApp(uint8_t linkedWithFrameAdvance, uint8_t includeFramebuff
 				if(autoAdvance) {
 					data.controllerData = *controllers[0]->getControllerData();
 				}
+				data.sequence = frameSequence;
 			})
+#ifdef __SWITCH__
+			sampleHeapUsage();
+#endif
+
+			// Bases are found the first time a watch needs them
+			if(!currentMemoryRegions.empty() && mainLocation == 0) {
+				findWatchBases();
+			}
+
+			auto readPointer = [this](uint64_t addr, uint64_t& pointer) {
+				return readMemory(addr, &pointer, sizeof(pointer));
+			};
 
-			// TODO set main and handle types correctly
-			// Put data into a vector<uint_t> first
 			for(uint16_t i = 0; i < currentMemoryRegions.size(); i++) {
-				uint64_t addr      = 0; // currentMemoryRegions[i].func.Eval();
-				uint8_t isUnsigned = currentMemoryRegions[i].u;
+				uint64_t addr;
+				if(!currentMemoryRegions[i].func.evaluate(mainLocation, heapLocation, readPointer, addr)) {
+					// A pointer along the way is null, nothing is recorded this frame
+					continue;
+				}
 
+				uint8_t isUnsigned     = currentMemoryRegions[i].u;
 				MemoryRegionTypes type = currentMemoryRegions[i].type;
-				std::vector<uint8_t> bytes;
-				std::string stringVersion;
 
+				uint64_t size;
+				switch(type) {
+				case MemoryRegionTypes::Bit8:
+					size = sizeof(uint8_t);
+					break;
+				case MemoryRegionTypes::Bit16:
+					size = sizeof(uint16_t);
+					break;
+				case MemoryRegionTypes::Bit32:
+					size = sizeof(uint32_t);
+					break;
+				case MemoryRegionTypes::Bit64:
+					size = sizeof(uint64_t);
+					break;
+				case MemoryRegionTypes::Float:
+					size = sizeof(float);
+					break;
+				case MemoryRegionTypes::Double:
+					size = sizeof(double);
+					break;
+				case MemoryRegionTypes::Bool:
+					size = sizeof(bool);
+					break;
+				default:
+					size = currentMemoryRegions[i].size;
+					break;
+				}
+
+				std::vector<uint8_t> bytes(size);
+				if(size == 0 || !readMemory(addr, bytes.data(), size)) {
+					continue;
+				}
+
+				std::string stringVersion;
 				switch(type) {
 				case MemoryRegionTypes::Bit8:
-					bytes = getMemory(addr, sizeof(uint8_t));
 					if(isUnsigned) {
 						stringVersion = std::to_string(*(uint8_t*)bytes.data());
 					} else {
@@ -467,7 +1218,6 @@ void MainLoop::pauseApp(uint8_t linkedWithFrameAdvance, uint8_t includeFramebuff
 					}
 					break;
 				case MemoryRegionTypes::Bit16:
-					bytes = getMemory(addr, sizeof(uint16_t));
 					if(isUnsigned) {
 						stringVersion = std::to_string(*(uint16_t*)bytes.data());
 					} else {
@@ -475,7 +1225,6 @@ void MainLoop::pauseApp(uint8_t linkedWithFrameAdvance, uint8_t includeFramebuff
 					}
 					break;
 				case MemoryRegionTypes::Bit32:
-					bytes = getMemory(addr, sizeof(uint32_t));
 					if(isUnsigned) {
 						stringVersion = std::to_string(*(uint32_t*)bytes.data());
 					} else {
@@ -483,7 +1232,6 @@ void MainLoop::pauseApp(uint8_t linkedWithFrameAdvance, uint8_t includeFramebuff
 					}
 					break;
 				case MemoryRegionTypes::Bit64:
-					bytes = getMemory(addr, sizeof(uint64_t));
 					if(isUnsigned) {
 						stringVersion = std::to_string(*(uint64_t*)bytes.data());
 					} else {
@@ -491,32 +1239,29 @@ void MainLoop::pauseApp(uint8_t linkedWithFrameAdvance, uint8_t includeFramebuff
 					}
 					break;
 				case MemoryRegionTypes::Float:
-					bytes         = getMemory(addr, sizeof(float));
 					stringVersion = std::to_string(*(float*)bytes.data());
 					break;
 				case MemoryRegionTypes::Double:
-					bytes         = getMemory(addr, sizeof(double));
 					stringVersion = std::to_string(*(double*)bytes.data());
 					break;
 				case MemoryRegionTypes::Bool:
-					bytes         = getMemory(addr, sizeof(bool));
 					stringVersion = *(bool*)bytes.data() ? "1" : "0";
 					break;
 				case MemoryRegionTypes::CharPointer:
-					bytes         = getMemory(addr, currentMemoryRegions[i].size);
 					stringVersion = std::string((const char*)bytes.data(), bytes.size());
 					break;
-				case MemoryRegionTypes::ByteArray:
-					bytes = getMemory(addr, currentMemoryRegions[i].size);
-					// Unused
-					stringVersion = "";
+				default:
+					// Byte arrays have no string version
 					break;
 				}
 
 				ADD_TO_QUEUE(RecieveMemoryRegion, networkInstance, {
-					data.memory               = bytes;
+					data.memory               = std::move(bytes);
 					data.stringRepresentation = stringVersion;
 					data.index                = i;
+					data.frame                = frame;
+					data.savestateHookNum     = savestateHookNum;
+					data.branchIndex          = branchIndex;
 				})
 			}
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
@@ -8,6 +10,7 @@
 #include <vector>
 
 #ifdef __SWITCH__
+#include <malloc.h>
 #include <plog/Log.h>
 #include <switch.h>
 #endif
@@ -17,13 +20,21 @@
 #include "yuzuSyscalls.hpp"
 #endif
 
+#include "captureBufferPool.hpp"
 #include "controller.hpp"
+#include "pointerExpression.hpp"
 #include "scripting/luaScripting.hpp"
 #include "sharedNetworkCode/networkInterface.hpp"
 #include "sharedNetworkCode/serializeUnserializeData.hpp"
+#include "sharedNetworkCode/tasScriptFormat.hpp"
+
+// Nothing tells a sysmodule when an application opens or closes, so that's checked this often
+#define PROCESS_CHECK_INTERVAL_MS 500
+// How often wakeups and command latency are logged, only when commands came in
+#define MAIN_LOOP_STATS_INTERVAL_SECONDS 10
 
 struct MemoryRegionInfo {
-	// mu::Parser func;
+	PointerExpression func;
 	MemoryRegionTypes type;
 	uint8_t u;
 	uint64_t size;
@@ -56,28 +67,74 @@ private:
 
 #ifdef __SWITCH__
 	Event vsyncEvent;
+	// Signaled by the network threads whenever something is queued or the connection changes
+	UEvent networkEvent;
+	// When the oldest command not handled yet came in, 0 if there isn't one
+	std::atomic<uint64_t> networkSignalTick;
+
+	uint64_t nextProcessCheckNs = 0;
+
+	// Reset every time they're logged
+	uint64_t statsStartNs          = 0;
+	uint32_t vsyncWakeups          = 0;
+	uint32_t networkWakeups        = 0;
+	uint32_t timeoutWakeups        = 0;
+	uint64_t totalCommandLatencyNs = 0;
+	uint64_t maxCommandLatencyNs   = 0;
+
+	// Only while something has to happen every frame, otherwise the loop doesn't wake up for it
+	bool needsVsync() {
+		return !isPaused && (!controllers.empty() || (applicationOpened && luaScripting->isScriptLoaded()));
+	}
+
+	void logMainLoopStats(uint64_t nowNs);
+
+	// Sampled when the heap is likely fullest, after a framebuffer is captured
+	uint32_t peakHeapInUse = 0;
+	void sampleHeapUsage();
 #endif
+	void sendHeapUsage();
 
 	std::vector<std::unique_ptr<ControllerHandler>> controllers;
 	std::shared_ptr<CommunicateWithNetwork> networkInstance;
 
 	ScreenshotHandler screenshotHandler;
+	CaptureBufferPool capturePool;
 	std::shared_ptr<LuaScripting> luaScripting;
 
 	// int memoryRegionCompiler;
 	std::vector<MemoryRegionInfo> currentMemoryRegions;
-	uint64_t mainLocation;
+	// Where watch pointers start from, found the first time they're needed
+	uint64_t mainLocation = 0;
+	uint64_t heapLocation = 0;
+	void findWatchBases();
 
 	uint8_t isPaused = false;
 
-	void readFullFileData(FILE* file, void* bufPtr, int size) {
+	// Of the SendFrameData being run, sent back with its framebuffer so the PC can pipeline auto run
+	uint32_t frameSequence = 0;
+
+	// Writable regions still to be sent for the memory scanner
+	std::vector<GameMemoryInfo> snapshotRegions;
+	uint16_t snapshotRegionIndex  = 0;
+	uint64_t snapshotRegionOffset = 0;
+	uint8_t snapshotInProgress    = false;
+	// Only a few chunks are held in memory, the heap is tiny
+	static constexpr std::size_t MAX_SNAPSHOT_CHUNKS_QUEUED = 4;
+
+	// Returns false at the end of the file
+	bool readFullFileData(FILE* file, void* bufPtr, int size) {
 		int sizeActuallyRead = 0;
 		uint8_t* buf         = (uint8_t*)bufPtr;
 
 		while(sizeActuallyRead != size) {
-			int bytesRead = fread(&buf[sizeActuallyRead], size - sizeActuallyRead, 1, file);
+			int bytesRead = fread(&buf[sizeActuallyRead], 1, size - sizeActuallyRead, file);
+			if(bytesRead == 0) {
+				return false;
+			}
 			sizeActuallyRead += bytesRead;
 		}
+		return true;
 	}
 
 #ifdef __SWITCH__
@@ -94,10 +151,15 @@ private:
 		return str;
 	}
 
+	// Each of these is woken up by its own event
+	void handleProcessState();
+	void handleConnectionState();
+	void handleVsync();
 	void handleNetworkUpdates();
 	void sendGameInfo();
-
-	// void prepareMemoryRegionMath(mu::Parser& parser, std::string func);
+	void startMemorySnapshot();
+	void sendMemorySnapshotChunk();
+	void abortMemorySnapshot();
 
 	std::vector<uint8_t> getMemory(uint64_t addr, uint64_t size) {
 		std::vector<uint8_t> region(size);
@@ -105,6 +167,15 @@ private:
 		return region;
 	}
 
+	// Unlike getMemory, fails on unmapped memory instead of returning zeroes
+	bool readMemory(uint64_t addr, void* buf, uint64_t size) {
+#ifdef __SWITCH__
+		return R_SUCCEEDED(svcReadDebugProcessMemory(buf, applicationDebug, addr, size));
+#else
+		return false;
+#endif
+	}
+
 #ifdef __SWITCH__
 	GameMemoryInfo getGameMemoryInfo(MemoryInfo memInfo);
 #endif
@@ -120,6 +191,16 @@ private:
 #endif
 	}
 
+	// Just attaches the debugger, nothing is sent to the PC
+	void haltApp() {
+		if(!isPaused) {
+#ifdef __SWITCH__
+			rc       = svcDebugActiveProcess(&applicationDebug, applicationProcessId);
+			isPaused = true;
+#endif
+		}
+	}
+
 	void unpauseApp() {
 		if(isPaused) {
 #ifdef __SWITCH__
@@ -151,7 +232,35 @@ private:
 	uint8_t getNumControllers();
 
 	uint8_t finalTasShouldRun;
-	void runFinalTas(std::vector<std::string> scriptPaths);
+	void runFinalTas(std::vector<std::string> scriptPaths, uint8_t numOfStreamedPlayers, std::string luaScriptPath, uint8_t precompileLuaScript);
+
+	// Streamed final TAS chunks, the slots keep their memory between runs
+	std::vector<Protocol::Struct_SendFinalTasChunk> streamChunks;
+	uint8_t streamChunkHead     = 0;
+	uint8_t streamChunkCount    = 0;
+	uint32_t streamReadOffset   = 0;
+	uint32_t streamFrameInChunk = 0;
+	uint32_t streamFramesPlayed = 0;
+	uint32_t streamChunksPlayed = 0;
+	uint8_t streamActive        = false;
+	uint8_t streamEnded         = false;
+
+	void startFinalTasStream();
+	void endFinalTasStream();
+	void addFinalTasChunk(Protocol::Struct_SendFinalTasChunk& chunk);
+	void popPlayedStreamChunks();
+	// Returns false when there is no frame buffered, or the chunk is broken and the stream ended
+	bool readStreamedFrame(uint8_t numOfPlayers);
+	void sendFinalTasProgress(uint8_t finished);
+
+	// Runs from the paused frame to the end of the range without pausing every frame
+	// The inputs are streamed through the same chunk slots as the final TAS
+	uint8_t runToFrameShouldRun = false;
+	void runToFrame(Protocol::Struct_SendRunToFrame& info);
+	void sendRunToFrameProgress(uint32_t framesRun, uint8_t finished, std::vector<uint8_t>& framebuffer);
+
+	// Waits for the network thread to give one back if they're all queued, false if it never will
+	bool takeCaptureBuffer(std::vector<uint8_t>& buf);
 
 	uint8_t checkSleep();
 	uint8_t checkAwaken();
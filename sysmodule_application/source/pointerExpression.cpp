@@ -0,0 +1,127 @@
+#include "pointerExpression.hpp"
+
+void PointerExpression::skipSpaces() {
+	while(position < source.size() && source[position] == ' ') {
+		position++;
+	}
+}
+
+bool PointerExpression::parseSum() {
+	if(!parseTerm()) {
+		return false;
+	}
+
+	while(true) {
+		skipSpaces();
+		if(position == source.size() || (source[position] != '+' && source[position] != '-')) {
+			return true;
+		}
+
+		OpType type = source[position] == '+' ? OpType::ADD : OpType::SUBTRACT;
+		position++;
+
+		if(!parseTerm()) {
+			return false;
+		}
+		ops.push_back({ type, 0 });
+	}
+}
+
+bool PointerExpression::parseTerm() {
+	skipSpaces();
+	if(position == source.size()) {
+		return false;
+	}
+
+	if(source[position] == '[') {
+		position++;
+		if(!parseSum()) {
+			return false;
+		}
+
+		skipSpaces();
+		if(position == source.size() || source[position] != ']') {
+			return false;
+		}
+		position++;
+
+		ops.push_back({ OpType::DEREFERENCE, 0 });
+		return true;
+	}
+
+	if(source.compare(position, 4, "main") == 0) {
+		position += 4;
+		ops.push_back({ OpType::PUSH_MAIN, 0 });
+		return true;
+	}
+
+	if(source.compare(position, 4, "heap") == 0) {
+		position += 4;
+		ops.push_back({ OpType::PUSH_HEAP, 0 });
+		return true;
+	}
+
+	// Base 0 takes both 0x and decimal
+	const char* start = source.c_str() + position;
+	char* end;
+	uint64_t number = strtoull(start, &end, 0);
+	if(end == start) {
+		return false;
+	}
+	position += end - start;
+
+	ops.push_back({ OpType::PUSH_NUMBER, number });
+	return true;
+}
+
+bool PointerExpression::compile(std::string definition) {
+	ops.clear();
+	source   = definition;
+	position = 0;
+
+	bool succeeded = parseSum();
+	skipSpaces();
+	if(!succeeded || position != source.size()) {
+		ops.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool PointerExpression::evaluate(uint64_t mainBase, uint64_t heapBase, std::function<bool(uint64_t, uint64_t&)> readPointer, uint64_t& addr) const {
+	if(ops.empty()) {
+		return false;
+	}
+
+	// Parsing already checked there are always enough values
+	std::vector<uint64_t> stack;
+	for(auto const& op : ops) {
+		switch(op.type) {
+		case OpType::PUSH_NUMBER:
+			stack.push_back(op.number);
+			break;
+		case OpType::PUSH_MAIN:
+			stack.push_back(mainBase);
+			break;
+		case OpType::PUSH_HEAP:
+			stack.push_back(heapBase);
+			break;
+		case OpType::ADD:
+		case OpType::SUBTRACT: {
+			uint64_t right = stack.back();
+			stack.pop_back();
+			stack.back() = op.type == OpType::ADD ? stack.back() + right : stack.back() - right;
+			break;
+		}
+		case OpType::DEREFERENCE:
+			if(!readPointer(stack.back(), stack.back())) {
+				return false;
+			}
+			break;
+		}
+	}
+
+	addr = stack.back();
+	return true;
+}
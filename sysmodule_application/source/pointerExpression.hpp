@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Pointer definitions for memory watches, like Cheat Engine pointers
+// "main" and "heap" are the start of the main executable and the heap
+// Numbers are hex with 0x or decimal, + and - work on addresses
+// Brackets read the 64 bit pointer at that address
+// "[[main+0x4C8A10]+0x18]+0x2C" follows two pointers from main
+// Compiled once when the watch is added, evaluated every time the game pauses
+class PointerExpression {
+public:
+	enum OpType : uint8_t {
+		PUSH_NUMBER,
+		PUSH_MAIN,
+		PUSH_HEAP,
+		ADD,
+		SUBTRACT,
+		DEREFERENCE,
+	};
+
+	struct Op {
+		OpType type;
+		uint64_t number;
+	};
+
+private:
+	// Postfix, so evaluation is a simple stack machine
+	std::vector<Op> ops;
+
+	std::string source;
+	std::size_t position;
+
+	void skipSpaces();
+	bool parseSum();
+	bool parseTerm();
+
+public:
+	// False if the definition doesn't parse, nothing is evaluated then
+	bool compile(std::string definition);
+
+	bool isValid() const {
+		return !ops.empty();
+	}
+
+	// Read returns false if the pointer points nowhere, which makes the whole thing fail
+	bool evaluate(uint64_t mainBase, uint64_t heapBase, std::function<bool(uint64_t, uint64_t&)> readPointer, uint64_t& addr) const;
+};
@@ -3,6 +3,7 @@
 ScreenshotHandler::ScreenshotHandler() {}
 
 void ScreenshotHandler::writeFramebuffer(std::vector<uint8_t>& buf, std::string& dhash) {
+	// Capture buffers come from the pool with this much reserved, so this doesn't allocate
 	buf.resize(JPEG_BUF_SIZE);
 	uint64_t outSize;
 	uint8_t succeeded = true;
@@ -1,6 +1,7 @@
 #include "gui.hpp"
 
-Gui::Gui() {
+Gui::Gui()
+	: renderer(FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT) {
 
 #ifdef __SWITCH__
 	// https://github.com/averne/dvdnx/blob/master/src/screen.cpp
@@ -67,14 +68,8 @@ Gui::Gui() {
 		fatalThrow(rc);
 	}
 
-	// Make Framebuffer linear to make things easier
-	// Imma too dumb to figure out the raw format
-	// 4 bytes per pixel (outstride)
-	rc = framebufferMakeLinear(&framebuf);
-	if(R_FAILED(rc)) {
-		nwindowClose(&window);
-		fatalThrow(rc);
-	}
+	// Not linear, a linear framebuffer is converted in full every frame
+	// Only the dirty parts of the renderer are swizzled in instead, the single buffer keeps the rest
 
 	static PlFontData stdFontData, extFontData;
 
@@ -105,25 +100,36 @@ Gui::Gui() {
 }
 
 void Gui::startFrame() {
-// Dequeue
-#ifdef __SWITCH__
-	currentBuffer = (uint8_t*)framebufferBegin(&framebuf, nullptr);
-#endif
+	renderer.startFrame();
 }
 
 void Gui::endFrame() {
-// Flush
+	std::vector<DirtyRect> dirtyRects = renderer.takeDirtyRects();
+	if(dirtyRects.empty()) {
+		// Nothing changed, nothing to present
+		return;
+	}
+
 #ifdef __SWITCH__
+	// Dequeue
+	currentBuffer = (uint8_t*)framebufferBegin(&framebuf, nullptr);
+
+	for(auto const& rect : dirtyRects) {
+		for(int32_t y = rect.y; y < rect.bottom(); y++) {
+			const Color* row = renderer.getRow(y);
+			for(int32_t x = rect.x; x < rect.right(); x++) {
+				((Color*)currentBuffer)[getPixelOffset(x, y)] = row[x];
+			}
+		}
+	}
+
+	// Flush
 	framebufferEnd(&framebuf);
 #endif
 }
 
 void Gui::setPixel(uint32_t x, uint32_t y, Color color) {
-// Outstride is 4 and bytes per pixel is 4
-#ifdef __SWITCH__
-	uint32_t offset                 = getPixelOffset(x, y);
-	((Color*)currentBuffer)[offset] = color;
-#endif
+	renderer.fillRect(x, y, 1, 1, color);
 }
 
 void Gui::takeScreenshot(std::string path) {
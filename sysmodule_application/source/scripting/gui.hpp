@@ -9,9 +9,8 @@
 #endif
 
 #define JPEG_BUF_SIZE 0x80000
-#define STB_TRUETYPE_IMPLEMENTATION
 
-#include <stb_truetype.h>
+#include "renderer.hpp"
 
 #ifdef __SWITCH__
 extern "C" u64 __nx_vi_layer_id;
@@ -20,13 +19,6 @@ extern "C" u64 __nx_vi_layer_id;
 #define FRAMEBUFFER_WIDTH 1280
 #define FRAMEBUFFER_HEIGHT 720
 
-// Libtesla color
-// RGBA4444
-// Even on yuzu, this is the same
-struct Color {
-	uint16_t r : 4, g : 4, b : 4, a : 4;
-} __attribute__((packed));
-
 class Gui {
 private:
 #ifdef __SWITCH__
@@ -41,6 +33,9 @@ private:
 	uint8_t* savedJpegFramebuffer;
 #endif
 
+	// Everything is drawn here first, only the changed parts are copied to the framebuffer
+	Renderer renderer;
+
 #ifdef __SWITCH__
 	stbtt_fontinfo stdNintendoFont;
 	stbtt_fontinfo extNintendoFont;
@@ -69,6 +64,18 @@ public:
 
 	void setPixel(uint32_t x, uint32_t y, Color color);
 
+	Renderer& getRenderer() {
+		return renderer;
+	}
+
+	const stbtt_fontinfo* getFont() {
+#ifdef __SWITCH__
+		return &stdNintendoFont;
+#else
+		return &stdFont;
+#endif
+	}
+
 	void takeScreenshot(std::string path);
 
 	~Gui();
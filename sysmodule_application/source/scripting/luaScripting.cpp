@@ -1,72 +1,374 @@
 #include "luaScripting.hpp"
 
+static const std::unordered_map<std::string, Btn> luaNameToButton {
+	{ "A", Btn::A },
+	{ "B", Btn::B },
+	{ "X", Btn::X },
+	{ "Y", Btn::Y },
+	{ "L", Btn::L },
+	{ "R", Btn::R },
+	{ "ZL", Btn::ZL },
+	{ "ZR", Btn::ZR },
+	{ "SL", Btn::SL },
+	{ "SR", Btn::SR },
+	{ "DUP", Btn::DUP },
+	{ "DDOWN", Btn::DDOWN },
+	{ "DLEFT", Btn::DLEFT },
+	{ "DRIGHT", Btn::DRIGHT },
+	{ "PLUS", Btn::PLUS },
+	{ "MINUS", Btn::MINUS },
+	{ "HOME", Btn::HOME },
+	{ "CAPT", Btn::CAPT },
+	{ "LS", Btn::LS },
+	{ "RS", Btn::RS },
+};
+
 LuaScripting::LuaScripting() {
 	// http://www.fceux.com/web/help/fceux.html?LuaFunctionsList.html
 	// https://github.com/yuzu-emu/yuzu/wiki/Building-for-Windows
 	// https://sol2.readthedocs.io/en/latest/api/function.html
 	// https://sol2.readthedocs.io/en/latest/tutorial/all-the-things.html
+	setupState();
+}
+
+void LuaScripting::setupState() {
+	// Every script gets a clean state
+	luaState = sol::state();
 	luaState.open_libraries(sol::lib::base, sol::lib::package, sol::lib::coroutine, sol::lib::string, sol::lib::os, sol::lib::math, sol::lib::table, sol::lib::bit32, sol::lib::io, sol::lib::utf8);
+
+	// Threads copy this from the main thread, so the hook can always find this class
+	*(LuaScripting**)lua_getextraspace(luaState.lua_state()) = this;
+	lua_sethook(luaState.lua_state(), &LuaScripting::instructionHook, LUA_MASKCOUNT, INSTRUCTION_HOOK_INTERVAL);
+
+	luaState.set_function("print", [this](sol::variadic_args args) {
+		std::string message;
+		for(auto arg : args) {
+			if(!message.empty()) {
+				message += "\t";
+			}
+			message += luaState["tostring"](arg.get<sol::object>()).get<std::string>();
+		}
+		log(message);
+	});
+
+	sol::table emu = luaState.create_named_table("emu");
+
+	// Only valid inside the script, callbacks can't yield
+	emu["frameadvance"] = luaState["coroutine"]["yield"];
+
+	emu.set_function("framecount", [this]() {
+		return frameCount;
+	});
+
+	emu.set_function("registerbefore", [this](sol::object func) {
+		beforeFrameCallback = func.is<sol::protected_function>() ? func.as<sol::protected_function>() : sol::protected_function();
+	});
+
+	emu.set_function("registerafter", [this](sol::object func) {
+		afterFrameCallback = func.is<sol::protected_function>() ? func.as<sol::protected_function>() : sol::protected_function();
+	});
+
+	setupJoypad();
+}
+
+void LuaScripting::setupJoypad() {
+	sol::table joypad = luaState.create_named_table("joypad");
+
+	// Players start at 1, like FCEUX
+	joypad.set_function("set", [this](uint8_t player, sol::table inputs) {
+		if(controllers == nullptr || player == 0 || player > controllers->size()) {
+			return;
+		}
+
+		ControllerHandler* controller = (*controllers)[player - 1].get();
+		inputs.for_each([&](sol::object key, sol::object value) {
+			std::string name = key.as<std::string>();
+			if(luaNameToButton.count(name)) {
+				controller->setButtonState(luaNameToButton.at(name), value.as<bool>());
+			} else if(name == "LS_X") {
+				controller->setJoystickState(false, false, value.as<int16_t>());
+			} else if(name == "LS_Y") {
+				controller->setJoystickState(false, true, value.as<int16_t>());
+			} else if(name == "RS_X") {
+				controller->setJoystickState(true, false, value.as<int16_t>());
+			} else if(name == "RS_Y") {
+				controller->setJoystickState(true, true, value.as<int16_t>());
+			}
+		});
+
+		controllersChanged = true;
+	});
+
+	joypad.set_function("get", [this](uint8_t player, sol::this_state state) {
+		sol::table inputs = sol::state_view(state).create_table();
+		if(controllers == nullptr || player == 0 || player > controllers->size()) {
+			return inputs;
+		}
+
+		std::shared_ptr<ControllerData> controllerData = (*controllers)[player - 1]->getControllerData();
+		for(auto const& button : luaNameToButton) {
+			inputs[button.first] = (bool)(GET_BIT(controllerData->buttons, button.second));
+		}
+		inputs["LS_X"] = controllerData->LS_X;
+		inputs["LS_Y"] = controllerData->LS_Y;
+		inputs["RS_X"] = controllerData->RS_X;
+		inputs["RS_Y"] = controllerData->RS_Y;
+		return inputs;
+	});
+}
+
+void LuaScripting::instructionHook(lua_State* L, lua_Debug* ar) {
+	LuaScripting* self = *(LuaScripting**)lua_getextraspace(L);
+
+	self->instructionsThisFrame += INSTRUCTION_HOOK_INTERVAL;
+	if(self->instructionsThisFrame > self->instructionBudget) {
+		// Stops the script instead of freezing the main loop
+		luaL_error(L, "Instruction budget of %d per frame exceeded", (int)self->instructionBudget);
+	}
+}
+
+bool LuaScripting::readFile(std::string path, std::string& contents) {
+	FILE* file = fopen(path.c_str(), "rb");
+	if(file == NULL) {
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	contents.resize(size < 0 ? 0 : size);
+	bool succeeded = size >= 0 && fread(contents.data(), 1, contents.size(), file) == contents.size();
+	fclose(file);
+	return succeeded;
+}
+
+bool LuaScripting::writeFile(std::string path, std::string_view contents) {
+	FILE* file = fopen(path.c_str(), "wb");
+	if(file == NULL) {
+		return false;
+	}
+
+	bool succeeded = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+	fclose(file);
+	return succeeded;
+}
+
+uint64_t LuaScripting::hashString(std::string_view data, uint64_t hash) {
+	for(char c : data) {
+		hash ^= (uint8_t)c;
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
+
+std::string LuaScripting::getBytecodeCachePath() {
+	// Only the path, the hash of the source is stored in the entry instead
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long)hashString(luaPath));
+	return std::string(BYTECODE_CACHE_DIR) + "/" + name + ".luac";
+}
+
+sol::protected_function LuaScripting::loadChunk(std::string_view code, sol::load_mode mode, std::string& error) {
+	// The result has to be popped before anything else is loaded
+	sol::load_result result = luaState.load(code, "@" + luaPath, mode);
+	if(!result.valid()) {
+		sol::error err = result;
+		error          = err.what();
+		return sol::protected_function();
+	}
+	return result.get<sol::protected_function>();
+}
+
+sol::protected_function LuaScripting::loadWithCache(std::string_view source, std::string& error, bool& fromBytecode) {
+	fromBytecode = true;
+
+	// Already precompiled
+	if(source.compare(0, sizeof(LUA_SIGNATURE) - 1, LUA_SIGNATURE) == 0) {
+		return loadChunk(source, sol::load_mode::binary, error);
+	}
+
+	// Entries are the hash of the source, then the bytecode
+	std::string cachePath = getBytecodeCachePath();
+	uint64_t sourceHash   = hashString(source);
+	std::string entry;
+	if(readFile(cachePath, entry) && entry.size() > sizeof(sourceHash) && memcmp(entry.data(), &sourceHash, sizeof(sourceHash)) == 0) {
+		sol::protected_function cached = loadChunk(std::string_view(entry).substr(sizeof(sourceHash)), sol::load_mode::binary, error);
+		if(cached.valid()) {
+			return cached;
+		}
+		// Cache from another Lua version or a partial write, just recompile
+	}
+
+	fromBytecode                   = false;
+	sol::protected_function script = loadChunk(source, sol::load_mode::text, error);
+	if(script.valid()) {
+		// Overwrites the entry of the old source
+		entry.assign((const char*)&sourceHash, sizeof(sourceHash));
+		entry += script.dump().as_string_view();
+
+		mkdir(BYTECODE_CACHE_DIR, 0777);
+		if(!writeFile(cachePath, entry)) {
+			remove(cachePath.c_str());
+		}
+	}
+	return script;
 }
 
 void LuaScripting::loadScript(std::string path) {
+	endScript();
+	setupState();
+
 	luaPath = path;
 
-	luaExecutionThread = std::make_unique<std::thread>(&LuaScripting::luaThread, this);
+	auto start = std::chrono::steady_clock::now();
+
+	std::string source;
+	if(!readFile(luaPath, source)) {
+		log("Lua script could not be read: " + luaPath);
+		return;
+	}
+
+	std::string error;
+	bool fromBytecode;
+	sol::protected_function script = loadWithCache(source, error, fromBytecode);
+	if(!script.valid()) {
+		log("Lua script failed to load: " + error);
+		return;
+	}
+
+	uint64_t loadMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	log("Lua script loaded from " + std::string(fromBytecode ? "bytecode" : "source") + " in " + std::to_string(loadMicroseconds) + "us");
+
+	// The script starts running on the next frame
+	scriptThread    = sol::thread::create(luaState.lua_state());
+	scriptCoroutine = sol::coroutine(scriptThread.state(), script);
+
+	frameCount                = 0;
+	totalOverheadMicroseconds = 0;
+	maxOverheadMicroseconds   = 0;
+	overheadFrames            = 0;
+	scriptFinished            = false;
+	scriptLoaded              = true;
+}
+
+bool LuaScripting::compileScript(std::string path, std::string outputPath) {
+	endScript();
+	setupState();
+
+	luaPath = path;
+
+	std::string source;
+	if(!readFile(luaPath, source)) {
+		log("Lua script could not be read: " + luaPath);
+		return false;
+	}
+
+	std::string error;
+	sol::protected_function script = loadChunk(source, sol::load_mode::text, error);
+	if(!script.valid()) {
+		log("Lua script failed to compile: " + error);
+		return false;
+	}
+
+	if(!writeFile(outputPath, script.dump().as_string_view())) {
+		log("Lua bytecode could not be written: " + outputPath);
+		return false;
+	}
+
+	return true;
 }
 
 void LuaScripting::endScript() {
 	scriptLoaded = false;
+
+	// References have to go before the state does
+	beforeFrameCallback = sol::protected_function();
+	afterFrameCallback  = sol::protected_function();
+	scriptCoroutine     = sol::coroutine();
+	scriptThread        = sol::thread();
 }
 
-void LuaScripting::luaThread() {
-	sol::load_result currentScript = luaState.load_file(luaPath);
-	if(!currentScript.valid()) {
-		/*
-		sol::error err = currentScript;
-		std::cerr << "failde to load string-based script in the program" << err.what() << std::endl;
-		*/
-		// TODO handle errors
+bool LuaScripting::checkResult(const sol::protected_function_result& result, std::string where) {
+	if(!result.valid()) {
+		sol::error err = result;
+		log("Lua error in " + where + ": " + err.what());
+		endScript();
+		return false;
 	}
+	return true;
+}
 
-	sol::protected_function_result currentScriptResult = currentScript();
+void LuaScripting::applyControllers() {
+	if(controllersChanged) {
+		for(auto& controller : *controllers) {
+			controller->setInput();
+		}
+		controllersChanged = false;
+	}
 }
 
-void LuaScripting::sendSyscall(std::function<void()> func) {
-	syscallReady = true;
-	std::unique_lock<std::mutex> lk(syscallMutex);
-	syscallCv.wait(lk, [this] { return ready; });
+void LuaScripting::addOverhead(std::chrono::steady_clock::time_point start) {
+	frameOverheadMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
 
-	// Run the syscalls provided by yuzu or otherwise
-	func();
-	processed    = true;
-	syscallReady = false;
+void LuaScripting::runBeforeFrame() {
+	if(!scriptLoaded) {
+		return;
+	}
 
-	lk.unlock();
-	syscallCv.notify_one();
-}
+	auto start            = std::chrono::steady_clock::now();
+	instructionsThisFrame = 0;
 
-void LuaScripting::callMainloop() {
-	// https://en.cppreference.com/w/cpp/thread/condition_variable
-	// 10 syscalls handled a time
-	for(uint8_t i = 0; i < 10; i++) {
-		// Somehow, inform syscall (if a syscall is waiting at the moment) through the condition variabke
-		// Continue if a syscall is avalible at the beginning of this loop and break otherwise
-		// A max of 10 syscalls will be handled at a time
-		if(syscallReady) {
-			{
-				std::lock_guard<std::mutex> lk(syscallMutex);
-				ready = true;
-			}
-			syscallCv.notify_one();
-			// wait for lua to run syscalls
+	if(beforeFrameCallback.valid() && !checkResult(beforeFrameCallback(), "registerbefore")) {
+		return;
+	}
 
-			{
-				// Gain back control
-				std::unique_lock<std::mutex> lk(syscallMutex);
-				syscallCv.wait(lk, [this] { return processed; });
-			}
-		} else {
-			break;
+	if(!scriptFinished) {
+		sol::protected_function_result result = scriptCoroutine();
+		if(!checkResult(result, luaPath)) {
+			return;
+		}
+		if(scriptCoroutine.status() != sol::call_status::yielded) {
+			// Returned, only the callbacks are left
+			scriptFinished = true;
 		}
 	}
-}
\ No newline at end of file
+
+	applyControllers();
+	addOverhead(start);
+
+	if(scriptFinished && !beforeFrameCallback.valid() && !afterFrameCallback.valid()) {
+		log("Lua script finished");
+		endScript();
+	}
+}
+
+void LuaScripting::runAfterFrame() {
+	if(!scriptLoaded) {
+		return;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	if(afterFrameCallback.valid() && !checkResult(afterFrameCallback(), "registerafter")) {
+		return;
+	}
+
+	applyControllers();
+	addOverhead(start);
+
+	frameCount++;
+
+	totalOverheadMicroseconds += frameOverheadMicroseconds;
+	maxOverheadMicroseconds = std::max(maxOverheadMicroseconds, frameOverheadMicroseconds);
+	frameOverheadMicroseconds = 0;
+	overheadFrames++;
+
+	if(overheadFrames == OVERHEAD_REPORT_INTERVAL) {
+		log("Lua overhead per frame: average " + std::to_string(totalOverheadMicroseconds / overheadFrames) + "us, max " + std::to_string(maxOverheadMicroseconds) + "us");
+		totalOverheadMicroseconds = 0;
+		maxOverheadMicroseconds   = 0;
+		overheadFrames            = 0;
+	}
+}
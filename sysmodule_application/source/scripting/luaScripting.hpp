@@ -1,12 +1,17 @@
 #pragma once
 
-#include <atomic>
-#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
-#include <mutex>
+#include <cstdio>
+#include <cstring>
 #include <sol/sol.hpp>
 #include <string>
-#include <thread>
+#include <string_view>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
 
 #ifdef __SWITCH__
 #include <switch.h>
@@ -16,27 +21,79 @@
 #include "../yuzuSyscalls.hpp"
 #endif
 
+#include "../controller.hpp"
+
+// Scripts run on the main loop, with an API modeled after FCEUX
+// emu.registerbefore(func) and emu.registerafter(func) are called around every frame
+// The script itself runs as a coroutine, emu.frameadvance() yields it until the next frame
+// joypad.set(player, { A = true, LS_X = 30000 }) writes straight into the controller state
 class LuaScripting {
 private:
 	sol::state luaState;
-	uint8_t scriptLoaded = false;
-	std::unique_ptr<std::thread> luaExecutionThread;
+	uint8_t scriptLoaded   = false;
+	uint8_t scriptFinished = false;
 
 	std::string luaPath;
 
+	sol::thread scriptThread;
+	sol::coroutine scriptCoroutine;
+
+	sol::protected_function beforeFrameCallback;
+	sol::protected_function afterFrameCallback;
+
+	std::vector<std::unique_ptr<ControllerHandler>>* controllers = nullptr;
+	uint8_t controllersChanged                                   = false;
+
+	std::function<void(std::string)> logCallback;
+
+	uint32_t frameCount = 0;
+
+	// The count hook runs every this many instructions
+	static constexpr int INSTRUCTION_HOOK_INTERVAL = 1000;
+	uint32_t instructionBudget                     = 1000000;
+	uint32_t instructionsThisFrame                 = 0;
+
+	// Time spent in Lua every frame, reported every 10 seconds or so
+	static constexpr uint32_t OVERHEAD_REPORT_INTERVAL = 600;
+	uint64_t frameOverheadMicroseconds                 = 0;
+	uint64_t totalOverheadMicroseconds                 = 0;
+	uint64_t maxOverheadMicroseconds                   = 0;
+	uint32_t overheadFrames                            = 0;
+
 #ifdef YUZU
 	std::shared_ptr<Syscalls> yuzuSyscalls;
 #endif
 
-	std::atomic_bool syscallReady = false;
-	uint8_t ready                 = false;
-	uint8_t processed             = false;
-	std::mutex syscallMutex;
-	std::condition_variable syscallCv;
+	// Scripts are compiled once, later loads of the same source use the cached bytecode
+	// One entry per script path, it's replaced when the source changes so the cache can't grow forever
+	static constexpr const char* BYTECODE_CACHE_DIR = "/SwiTAS_luaCache";
+
+	static void instructionHook(lua_State* L, lua_Debug* ar);
+
+	void setupState();
+
+	bool readFile(std::string path, std::string& contents);
+	bool writeFile(std::string path, std::string_view contents);
+	// FNV-1a
+	static uint64_t hashString(std::string_view data, uint64_t hash = 0xcbf29ce484222325);
+	std::string getBytecodeCachePath();
+
+	// Returns an invalid function and sets the error if loading fails
+	sol::protected_function loadChunk(std::string_view code, sol::load_mode mode, std::string& error);
+	sol::protected_function loadWithCache(std::string_view source, std::string& error, bool& fromBytecode);
+	void setupJoypad();
 
-	void sendSyscall(std::function<void()> func);
+	// Logs the error and stops the script if the call failed
+	bool checkResult(const sol::protected_function_result& result, std::string where);
 
-	void luaThread();
+	void applyControllers();
+	void addOverhead(std::chrono::steady_clock::time_point start);
+
+	void log(std::string message) {
+		if(logCallback) {
+			logCallback(message);
+		}
+	}
 
 public:
 	LuaScripting();
@@ -46,9 +103,31 @@ public:
 		yuzuSyscalls = syscalls;
 	}
 #endif
+
+	void setControllers(std::vector<std::unique_ptr<ControllerHandler>>* controllerHandlers) {
+		controllers = controllerHandlers;
+	}
+
+	void setLogCallback(std::function<void(std::string)> callback) {
+		logCallback = callback;
+	}
+
+	void setInstructionBudget(uint32_t budget) {
+		instructionBudget = budget;
+	}
+
+	uint8_t isScriptLoaded() {
+		return scriptLoaded;
+	}
+
 	void loadScript(std::string path);
 
+	// Bytecode that can be shipped instead of the source, loadScript accepts both
+	bool compileScript(std::string path, std::string outputPath);
+
 	void endScript();
 
-	void callMainloop();
-};
\ No newline at end of file
+	// Called by the main loop right before and right after a frame runs
+	void runBeforeFrame();
+	void runAfterFrame();
+};
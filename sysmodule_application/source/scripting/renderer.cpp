@@ -0,0 +1,349 @@
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "renderer.hpp"
+
+GlyphCache::GlyphCache() {
+	atlas.resize((std::size_t)ATLAS_SIZE * ATLAS_SIZE);
+}
+
+Glyph GlyphCache::getGlyph(const stbtt_fontinfo* font, uint32_t codepoint, uint16_t size) {
+	GlyphKey key { font, codepoint, size };
+	auto cached = glyphs.find(key);
+	if(cached != glyphs.end()) {
+		return cached->second;
+	}
+
+	float scale = stbtt_ScaleForPixelHeight(font, size);
+
+	int advance;
+	int leftSideBearing;
+	stbtt_GetCodepointHMetrics(font, codepoint, &advance, &leftSideBearing);
+
+	int x0, y0, x1, y1;
+	stbtt_GetCodepointBitmapBox(font, codepoint, scale, scale, &x0, &y0, &x1, &y1);
+
+	Glyph glyph = { 0 };
+	glyph.offsetX = x0;
+	glyph.offsetY = y0;
+	glyph.advance = (int16_t)(advance * scale + 0.5f);
+
+	int glyphWidth  = x1 - x0;
+	int glyphHeight = y1 - y0;
+	if(glyphWidth > 0 && glyphHeight > 0 && glyphWidth < ATLAS_SIZE && glyphHeight < ATLAS_SIZE) {
+		if(shelfX + glyphWidth > ATLAS_SIZE) {
+			shelfY += shelfHeight;
+			shelfX      = 0;
+			shelfHeight = 0;
+		}
+
+		if(shelfY + glyphHeight > ATLAS_SIZE) {
+			// Out of room, start over
+			glyphs.clear();
+			shelfX      = 0;
+			shelfY      = 0;
+			shelfHeight = 0;
+		}
+
+		stbtt_MakeCodepointBitmap(font, &atlas[(std::size_t)shelfY * ATLAS_SIZE + shelfX], glyphWidth, glyphHeight, ATLAS_SIZE, scale, scale, codepoint);
+
+		glyph.atlasX = shelfX;
+		glyph.atlasY = shelfY;
+		glyph.width  = glyphWidth;
+		glyph.height = glyphHeight;
+
+		// A pixel of padding between glyphs
+		shelfX += glyphWidth + 1;
+		shelfHeight = std::max<uint16_t>(shelfHeight, glyphHeight + 1);
+	}
+
+	glyphs[key] = glyph;
+	return glyph;
+}
+
+Renderer::Renderer(uint32_t canvasWidth, uint32_t canvasHeight) {
+	width  = canvasWidth;
+	height = canvasHeight;
+	pixels.resize((std::size_t)width * height, Color { 0, 0, 0, 0 });
+}
+
+bool Renderer::clip(DirtyRect& rect) const {
+	int32_t left   = std::max<int32_t>(rect.x, 0);
+	int32_t top    = std::max<int32_t>(rect.y, 0);
+	int32_t right  = std::min<int32_t>(rect.right(), width);
+	int32_t bottom = std::min<int32_t>(rect.bottom(), height);
+
+	rect.x      = left;
+	rect.y      = top;
+	rect.width  = right - left;
+	rect.height = bottom - top;
+	return rect.width > 0 && rect.height > 0;
+}
+
+void Renderer::addDirtyRect(std::vector<DirtyRect>& rects, DirtyRect rect) {
+	// Touching or overlapping rects are merged, flushing a few big ones is cheaper than many small ones
+	std::size_t i = 0;
+	while(i < rects.size()) {
+		DirtyRect& other = rects[i];
+		if(rect.x <= other.right() && other.x <= rect.right() && rect.y <= other.bottom() && other.y <= rect.bottom()) {
+			int32_t left   = std::min(rect.x, other.x);
+			int32_t top    = std::min(rect.y, other.y);
+			int32_t right  = std::max(rect.right(), other.right());
+			int32_t bottom = std::max(rect.bottom(), other.bottom());
+			rect           = DirtyRect { left, top, right - left, bottom - top };
+
+			rects.erase(rects.begin() + i);
+			// The bigger rect might touch ones already checked
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+
+	rects.push_back(rect);
+
+	if(rects.size() > MAX_DIRTY_RECTS) {
+		int32_t left   = width;
+		int32_t top    = height;
+		int32_t right  = 0;
+		int32_t bottom = 0;
+		for(auto const& other : rects) {
+			left   = std::min(left, other.x);
+			top    = std::min(top, other.y);
+			right  = std::max(right, other.right());
+			bottom = std::max(bottom, other.bottom());
+		}
+		rects.clear();
+		rects.push_back(DirtyRect { left, top, right - left, bottom - top });
+	}
+}
+
+void Renderer::markDrawn(DirtyRect rect) {
+	addDirtyRect(dirtyRects, rect);
+	addDirtyRect(frameRects, rect);
+}
+
+void Renderer::fillSpan(Color* row, int32_t length, Color color) {
+	if(color.a == 15) {
+		std::fill(row, row + length, color);
+	} else if(color.a != 0) {
+		// Same as blend, but the source half is only calculated once
+		uint8_t inverse = 15 - color.a;
+		uint16_t r      = color.r * color.a + 7;
+		uint16_t g      = color.g * color.a + 7;
+		uint16_t b      = color.b * color.a + 7;
+		for(int32_t i = 0; i < length; i++) {
+			Color dst = row[i];
+			row[i].r  = (r + dst.r * inverse) / 15;
+			row[i].g  = (g + dst.g * inverse) / 15;
+			row[i].b  = (b + dst.b * inverse) / 15;
+			row[i].a  = color.a + (dst.a * inverse + 7) / 15;
+		}
+	}
+}
+
+void Renderer::startFrame() {
+	for(auto const& rect : frameRects) {
+		for(int32_t y = rect.y; y < rect.bottom(); y++) {
+			Color* row = &pixels[(std::size_t)y * width + rect.x];
+			std::fill(row, row + rect.width, Color { 0, 0, 0, 0 });
+		}
+		addDirtyRect(dirtyRects, rect);
+	}
+	frameRects.clear();
+}
+
+void Renderer::clear() {
+	std::fill(pixels.begin(), pixels.end(), Color { 0, 0, 0, 0 });
+	frameRects.clear();
+	dirtyRects.clear();
+	dirtyRects.push_back(DirtyRect { 0, 0, (int32_t)width, (int32_t)height });
+}
+
+void Renderer::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, Color color) {
+	DirtyRect rect { x, y, w, h };
+	if(!clip(rect)) {
+		return;
+	}
+
+	for(int32_t row = rect.y; row < rect.bottom(); row++) {
+		fillSpan(&pixels[(std::size_t)row * width + rect.x], rect.width, color);
+	}
+
+	markDrawn(rect);
+}
+
+void Renderer::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, Color color) {
+	// Edges don't overlap so translucent corners aren't blended twice
+	fillRect(x, y, w, 1, color);
+	if(h > 1) {
+		fillRect(x, y + h - 1, w, 1, color);
+	}
+	if(h > 2) {
+		fillRect(x, y + 1, 1, h - 2, color);
+		if(w > 1) {
+			fillRect(x + w - 1, y + 1, 1, h - 2, color);
+		}
+	}
+}
+
+void Renderer::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, Color color) {
+	// Straight lines are just spans
+	if(y0 == y1) {
+		fillRect(std::min(x0, x1), y0, std::abs(x1 - x0) + 1, 1, color);
+		return;
+	}
+	if(x0 == x1) {
+		fillRect(x0, std::min(y0, y1), 1, std::abs(y1 - y0) + 1, color);
+		return;
+	}
+
+	DirtyRect rect { std::min(x0, x1), std::min(y0, y1), std::abs(x1 - x0) + 1, std::abs(y1 - y0) + 1 };
+	if(!clip(rect)) {
+		return;
+	}
+
+	// Bresenham
+	int32_t dx    = std::abs(x1 - x0);
+	int32_t dy    = -std::abs(y1 - y0);
+	int32_t stepX = x0 < x1 ? 1 : -1;
+	int32_t stepY = y0 < y1 ? 1 : -1;
+	int32_t error = dx + dy;
+	while(true) {
+		if(x0 >= 0 && y0 >= 0 && x0 < (int32_t)width && y0 < (int32_t)height && color.a != 0) {
+			Color& pixel = pixels[(std::size_t)y0 * width + x0];
+			pixel        = blend(pixel, color, color.a);
+		}
+		if(x0 == x1 && y0 == y1) {
+			break;
+		}
+		int32_t doubleError = error * 2;
+		if(doubleError >= dy) {
+			error += dy;
+			x0 += stepX;
+		}
+		if(doubleError <= dx) {
+			error += dx;
+			y0 += stepY;
+		}
+	}
+
+	markDrawn(rect);
+}
+
+int32_t Renderer::drawText(const stbtt_fontinfo* font, int32_t x, int32_t y, uint16_t size, std::string text, Color color) {
+	int ascent, descent, lineGap;
+	stbtt_GetFontVMetrics(font, &ascent, &descent, &lineGap);
+	float scale        = stbtt_ScaleForPixelHeight(font, size);
+	int32_t baseline   = y + (int32_t)(ascent * scale + 0.5f);
+	int32_t lineHeight = (int32_t)((ascent - descent + lineGap) * scale + 0.5f);
+
+	int32_t penX     = x;
+	int32_t maxWidth = 0;
+	int32_t lines    = 1;
+
+	// Glyphs can hang outside the pen box (italics, negative bearings), so the real ink is tracked too
+	int32_t inkLeft   = x;
+	int32_t inkTop    = y;
+	int32_t inkRight  = x;
+	int32_t inkBottom = y;
+
+	std::size_t i = 0;
+	while(i < text.size()) {
+		// Decode UTF-8
+		uint8_t lead       = text[i];
+		uint32_t codepoint = lead;
+		uint8_t extraBytes = 0;
+		if(lead >= 0xF0) {
+			codepoint  = lead & 0x07;
+			extraBytes = 3;
+		} else if(lead >= 0xE0) {
+			codepoint  = lead & 0x0F;
+			extraBytes = 2;
+		} else if(lead >= 0xC0) {
+			codepoint  = lead & 0x1F;
+			extraBytes = 1;
+		}
+		i++;
+		for(uint8_t extra = 0; extra < extraBytes && i < text.size(); extra++, i++) {
+			codepoint = (codepoint << 6) | (text[i] & 0x3F);
+		}
+
+		if(codepoint == '\n') {
+			maxWidth = std::max(maxWidth, penX - x);
+			penX     = x;
+			baseline += lineHeight;
+			lines++;
+			continue;
+		}
+
+		Glyph glyph = glyphCache.getGlyph(font, codepoint, size);
+
+		DirtyRect glyphRect { penX + glyph.offsetX, baseline + glyph.offsetY, glyph.width, glyph.height };
+		int32_t unclippedX = glyphRect.x;
+		int32_t unclippedY = glyphRect.y;
+		if(glyphRect.width > 0 && glyphRect.height > 0) {
+			inkLeft   = std::min(inkLeft, glyphRect.x);
+			inkTop    = std::min(inkTop, glyphRect.y);
+			inkRight  = std::max(inkRight, glyphRect.right());
+			inkBottom = std::max(inkBottom, glyphRect.bottom());
+		}
+		if(color.a != 0 && clip(glyphRect)) {
+			for(int32_t row = glyphRect.y; row < glyphRect.bottom(); row++) {
+				const uint8_t* coverage = glyphCache.getAtlasRow(glyph.atlasX + (glyphRect.x - unclippedX), glyph.atlasY + (row - unclippedY));
+				Color* pixel            = &pixels[(std::size_t)row * width + glyphRect.x];
+				for(int32_t column = 0; column < glyphRect.width; column++) {
+					if(coverage[column] != 0) {
+						uint8_t alpha = (color.a * coverage[column] + 127) / 255;
+						if(alpha != 0) {
+							pixel[column] = blend(pixel[column], color, alpha);
+						}
+					}
+				}
+			}
+		}
+
+		penX += glyph.advance;
+	}
+
+	maxWidth = std::max(maxWidth, penX - x);
+
+	inkRight  = std::max(inkRight, x + maxWidth);
+	inkBottom = std::max(inkBottom, y + lineHeight * lines);
+
+	DirtyRect textRect { inkLeft, inkTop, inkRight - inkLeft, inkBottom - inkTop };
+	if(clip(textRect)) {
+		markDrawn(textRect);
+	}
+
+	return maxWidth;
+}
+
+std::vector<DirtyRect> Renderer::takeDirtyRects() {
+	std::vector<DirtyRect> rects;
+	rects.swap(dirtyRects);
+	return rects;
+}
+
+bool Renderer::writeToFile(std::string path) const {
+	FILE* file = fopen(path.c_str(), "wb");
+	if(file == NULL) {
+		return false;
+	}
+
+	fprintf(file, "P7\nWIDTH %u\nHEIGHT %u\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", width, height);
+
+	std::vector<uint8_t> row(width * 4);
+	for(uint32_t y = 0; y < height; y++) {
+		const Color* source = getRow(y);
+		for(uint32_t x = 0; x < width; x++) {
+			// 4 bits to 8 bits
+			row[x * 4]     = source[x].r * 17;
+			row[x * 4 + 1] = source[x].g * 17;
+			row[x * 4 + 2] = source[x].b * 17;
+			row[x * 4 + 3] = source[x].a * 17;
+		}
+		fwrite(row.data(), 1, row.size(), file);
+	}
+
+	fclose(file);
+	return true;
+}
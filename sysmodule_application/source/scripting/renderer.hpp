@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <stb_truetype.h>
+
+// Libtesla color
+// RGBA4444
+// Even on yuzu, this is the same
+struct Color {
+	uint16_t r : 4, g : 4, b : 4, a : 4;
+} __attribute__((packed));
+
+struct DirtyRect {
+	int32_t x;
+	int32_t y;
+	int32_t width;
+	int32_t height;
+
+	int32_t right() const {
+		return x + width;
+	}
+
+	int32_t bottom() const {
+		return y + height;
+	}
+
+	int64_t area() const {
+		return (int64_t)width * height;
+	}
+};
+
+struct Glyph {
+	// Where in the atlas, width 0 for glyphs like space
+	uint16_t atlasX;
+	uint16_t atlasY;
+	uint16_t width;
+	uint16_t height;
+	// From the pen position to the top left of the bitmap
+	int16_t offsetX;
+	int16_t offsetY;
+	int16_t advance;
+};
+
+// Every glyph is rasterized once into one 8 bit coverage atlas, packed in shelves
+class GlyphCache {
+private:
+	static constexpr uint16_t ATLAS_SIZE = 1024;
+
+	std::vector<uint8_t> atlas;
+	uint16_t shelfX      = 0;
+	uint16_t shelfY      = 0;
+	uint16_t shelfHeight = 0;
+
+	// Font, codepoint and size in one key
+	struct GlyphKey {
+		const stbtt_fontinfo* font;
+		uint32_t codepoint;
+		uint16_t size;
+
+		bool operator==(const GlyphKey& other) const {
+			return font == other.font && codepoint == other.codepoint && size == other.size;
+		}
+	};
+
+	struct GlyphKeyHash {
+		std::size_t operator()(const GlyphKey& key) const {
+			return std::hash<const void*>()(key.font) ^ ((std::size_t)key.codepoint << 16) ^ key.size;
+		}
+	};
+
+	std::unordered_map<GlyphKey, Glyph, GlyphKeyHash> glyphs;
+
+public:
+	GlyphCache();
+
+	// Full atlases are thrown away and refilled on demand
+	Glyph getGlyph(const stbtt_fontinfo* font, uint32_t codepoint, uint16_t size);
+
+	const uint8_t* getAtlasRow(uint16_t x, uint16_t y) const {
+		return &atlas[(std::size_t)y * ATLAS_SIZE + x];
+	}
+
+	std::size_t getNumGlyphs() const {
+		return glyphs.size();
+	}
+};
+
+// Draws into a linear RGBA4444 framebuffer in memory
+// Only the regions drawn since the last flush are reported, so the real
+// framebuffer only needs those copied, while whatever was drawn last frame
+// is erased automatically when the next frame starts
+// Has no dependencies on libnx, so it can be run on Linux
+class Renderer {
+private:
+	uint32_t width;
+	uint32_t height;
+	std::vector<Color> pixels;
+
+	GlyphCache glyphCache;
+
+	std::vector<DirtyRect> dirtyRects;
+	// Drawn this frame, erased when the next one starts
+	std::vector<DirtyRect> frameRects;
+
+	// Past this many rects they are just merged into one
+	static constexpr std::size_t MAX_DIRTY_RECTS = 32;
+
+	bool clip(DirtyRect& rect) const;
+	void addDirtyRect(std::vector<DirtyRect>& rects, DirtyRect rect);
+	void markDrawn(DirtyRect rect);
+
+	// Source over blending, coverage scales the alpha of the color
+	static inline Color blend(Color dst, Color src, uint8_t alpha) {
+		if(alpha == 15) {
+			return src;
+		}
+		uint8_t inverse = 15 - alpha;
+		Color out;
+		out.r = (src.r * alpha + dst.r * inverse + 7) / 15;
+		out.g = (src.g * alpha + dst.g * inverse + 7) / 15;
+		out.b = (src.b * alpha + dst.b * inverse + 7) / 15;
+		out.a = alpha + (dst.a * inverse + 7) / 15;
+		return out;
+	}
+
+	void fillSpan(Color* row, int32_t length, Color color);
+
+public:
+	Renderer(uint32_t canvasWidth, uint32_t canvasHeight);
+
+	// Erases last frame's drawings
+	void startFrame();
+
+	void clear();
+
+	void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, Color color);
+	void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, Color color);
+	void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, Color color);
+	// UTF-8, returns the width of the text
+	int32_t drawText(const stbtt_fontinfo* font, int32_t x, int32_t y, uint16_t size, std::string text, Color color);
+
+	// Regions that need to be flushed, cleared afterwards
+	std::vector<DirtyRect> takeDirtyRects();
+
+	const Color* getRow(uint32_t y) const {
+		return &pixels[(std::size_t)y * width];
+	}
+
+	uint32_t getWidth() const {
+		return width;
+	}
+
+	uint32_t getHeight() const {
+		return height;
+	}
+
+	std::size_t getNumCachedGlyphs() const {
+		return glyphCache.getNumGlyphs();
+	}
+
+	// RGBA PAM, for comparing renders against known good images
+	bool writeToFile(std::string path) const;
+};
@@ -35,6 +35,14 @@ enum DataFlag : uint8_t {
 	RecieveApplicationConnected,
 	RecieveGameMemoryInfo,
 	RecieveAutoRunControllerData,
+	SendMemorySnapshot,
+	RecieveMemorySnapshotChunk,
+	SendRunLuaScript,
+	SendFinalTasChunk,
+	RecieveFinalTasProgress,
+	SendRunToFrame,
+	RecieveRunToFrameProgress,
+	RecieveHeapUsage,
 	NUM_OF_FLAGS,
 };
 
@@ -60,6 +68,7 @@ enum SendInfo : uint8_t {
 	STOP_FULL_SPEED,
 	PAUSE_FULL_SPEED,
 	STOP_FINAL_TAS,
+	STOP_RUN_TO_FRAME,
 };
 
 // This is used by the switch to determine size, a vector is always send back enyway
@@ -76,6 +85,17 @@ enum MemoryRegionTypes : uint8_t {
 	NUM_OF_TYPES,
 };
 
+// Snapshots for the memory scanner are sent in pieces this big, values never straddle them
+#define MEMORY_SNAPSHOT_CHUNK_SIZE 0x10000
+
+// Streamed final TAS inputs are sent this many frames at a time
+#define FINAL_TAS_STREAM_CHUNK_FRAMES 60
+// Chunks the switch can hold, the PC never sends more than this ahead of playback, 10 seconds
+#define FINAL_TAS_STREAM_BUFFER_CHUNKS 10
+
+// Frames run to frame goes between progress reports, when it isn't sending a framebuffer anyway
+#define RUN_TO_FRAME_PROGRESS_INTERVAL 30
+
 // clang-format off
 namespace Protocol {
 	// Run a single frame and return when done
@@ -90,7 +110,9 @@ namespace Protocol {
 		uint8_t incrementFrame;
 		uint8_t includeFramebuffer;
 		uint8_t isAutoRun;
-	, self.controllerData, self.frame, self.playerIndex, self.incrementFrame, self.branchIndex, self.savestateHookNum, self.includeFramebuffer, self.isAutoRun)
+		// Sent back with the framebuffer, so auto run can have several frames in flight, 0 for none
+		uint32_t sequence;
+	, self.controllerData, self.frame, self.playerIndex, self.incrementFrame, self.branchIndex, self.savestateHookNum, self.includeFramebuffer, self.isAutoRun, self.sequence)
 
 	// Recieve all of the game's framebuffer
 	DEFINE_STRUCT(RecieveGameFramebuffer,
@@ -103,7 +125,9 @@ namespace Protocol {
 		// Set by auto advance
 		uint8_t controllerDataIncluded;
 		ControllerData controllerData;
-	, self.buf, self.fromFrameAdvance, self.frame, self.savestateHookNum, self.branchIndex, self.playerIndex, self.controllerDataIncluded, self.controllerData)
+		// Of the frame that was run
+		uint32_t sequence;
+	, self.buf, self.fromFrameAdvance, self.frame, self.savestateHookNum, self.branchIndex, self.playerIndex, self.controllerDataIncluded, self.controllerData, self.sequence)
 
 	// Recieve a ton of game and user info
 	DEFINE_STRUCT(RecieveGameInfo,
@@ -120,9 +144,59 @@ namespace Protocol {
 	, self.actFlag)
 
 	// Needs to have number of controllers set right, TODO
+	// The Lua script is optional, when precompiled its bytecode is written next to it
+	// When players are streamed the script paths are ignored and the inputs come in SendFinalTasChunk
 	DEFINE_STRUCT(SendStartFinalTas,
 		std::vector<std::string> scriptPaths;
-	, self.scriptPaths)
+		std::string luaScriptPath;
+		uint8_t precompileLuaScript;
+		uint8_t numOfStreamedPlayers;
+	, self.scriptPaths, self.luaScriptPath, self.precompileLuaScript, self.numOfStreamedPlayers)
+
+	// Same records as the script files, every player for one frame, then the next frame
+	DEFINE_STRUCT(SendFinalTasChunk,
+		std::vector<uint8_t> data;
+		uint32_t numOfFrames;
+		uint8_t isLast;
+	, self.data, self.numOfFrames, self.isLast)
+
+	// Sent as playback goes, every chunk played makes room for another
+	DEFINE_STRUCT(RecieveFinalTasProgress,
+		uint32_t framesPlayed;
+		uint32_t chunksPlayed;
+		uint8_t finished;
+	, self.framesPlayed, self.chunksPlayed, self.finished)
+
+	// Lets the paused game run freely through a range of frames, only pausing again at the end
+	// Inputs come in SendFinalTasChunk, the same as a streamed final TAS, starting with startFrame
+	// The last frame is sent back as a normal frame advance framebuffer
+	DEFINE_STRUCT(SendRunToFrame,
+		uint32_t startFrame;
+		uint32_t endFrame;
+		uint16_t savestateHookNum;
+		uint16_t branchIndex;
+		uint8_t playerIndex;
+		uint8_t numOfPlayers;
+		// A framebuffer every this many frames on the way, 0 for none
+		uint32_t framebufferInterval;
+	, self.startFrame, self.endFrame, self.savestateHookNum, self.branchIndex, self.playerIndex, self.numOfPlayers, self.framebufferInterval)
+
+	// Framebuffer is of the last frame run, if it's empty it wasn't sampled
+	DEFINE_STRUCT(RecieveRunToFrameProgress,
+		uint32_t framesRun;
+		uint32_t chunksPlayed;
+		uint8_t finished;
+		std::vector<uint8_t> buf;
+	, self.framesRun, self.chunksPlayed, self.finished, self.buf)
+
+	// Sysmodule heap in bytes, it's tiny and running out is a fatal
+	// Reserved is how far into the heap malloc has ever gone, the in use peak is only sampled
+	DEFINE_STRUCT(RecieveHeapUsage,
+		uint32_t heapSize;
+		uint32_t inUse;
+		uint32_t peakInUse;
+		uint32_t peakReserved;
+	, self.heapSize, self.inUse, self.peakInUse, self.peakReserved)
 
 	DEFINE_STRUCT(SendLogging,
 		std::string log;
@@ -149,7 +223,28 @@ namespace Protocol {
 		std::vector<uint8_t> memory;
 		std::string stringRepresentation;
 		uint16_t index;
-	, self.memory, self.stringRepresentation, self.index)
+		uint32_t frame;
+		uint16_t savestateHookNum;
+		uint16_t branchIndex;
+	, self.memory, self.stringRepresentation, self.index, self.frame, self.savestateHookNum, self.branchIndex)
+
+	// Streams every writable region of the game, one chunk at a time
+	DEFINE_STRUCT(SendMemorySnapshot,
+		uint8_t cancel;
+	, self.cancel)
+
+	// Aborted is only set on the last chunk, when the game was unpaused or the network dropped partway
+	DEFINE_STRUCT(RecieveMemorySnapshotChunk,
+		uint64_t addr;
+		std::vector<uint8_t> memory;
+		uint8_t isLast;
+		uint8_t aborted;
+	, self.addr, self.memory, self.isLast, self.aborted)
+
+	// Path on the SD card, an empty path stops the current script
+	DEFINE_STRUCT(SendRunLuaScript,
+		std::string path;
+	, self.path)
 
 	DEFINE_STRUCT(RecieveLogging,
 		std::string log;
@@ -0,0 +1,227 @@
+#include "doctest.h"
+#include "tasScriptFormat.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Deterministic, so failures can be reproduced
+static uint32_t nextRandom(uint32_t& state) {
+	state = state * 1664525 + 1013904223;
+	return state >> 8;
+}
+
+// Looks like a real TAS, inputs are held for a while and long stretches change nothing
+static std::vector<TasScriptFrame> makeFrames(uint32_t numOfFrames, uint32_t seed) {
+	std::vector<TasScriptFrame> frames(numOfFrames);
+	TasScriptFrame frame;
+	memset(&frame, 0, sizeof(frame));
+
+	uint32_t state = seed;
+	for(uint32_t i = 0; i < numOfFrames; i++) {
+		uint32_t roll = nextRandom(state) % 100;
+		if(roll < 10) {
+			frame.buttons = nextRandom(state) & 0xFFFFF;
+		} else if(roll < 20) {
+			frame.leftJoystick[0] = (int16_t)(nextRandom(state) % 60001) - 30000;
+			frame.leftJoystick[1] = (int16_t)(nextRandom(state) % 60001) - 30000;
+		} else if(roll < 25) {
+			frame.rightJoystick[0] = (int16_t)(nextRandom(state) % 60001) - 30000;
+		} else if(roll < 28) {
+			frame.accel[nextRandom(state) % 3] = (int16_t)nextRandom(state);
+			frame.gyro[nextRandom(state) % 3]  = (int16_t)nextRandom(state);
+		} else if(roll == 99 && i + 600 < numOfFrames) {
+			// More than UINT8_MAX repeats in a row
+			for(uint32_t j = 0; j < 600; j++) {
+				frames[i++] = frame;
+			}
+		}
+		frames[i] = frame;
+	}
+
+	return frames;
+}
+
+static bool sameFrame(const TasScriptFrame& a, const TasScriptFrame& b) {
+	return memcmp(&a, &b, sizeof(TasScriptFrame)) == 0;
+}
+
+static std::vector<uint8_t> encode(const std::vector<std::vector<TasScriptFrame>>& players, uint16_t framesPerBlock) {
+	std::vector<std::vector<std::vector<uint8_t>>> blocks;
+	for(auto const& player : players) {
+		blocks.push_back(TasScriptEncoder::encodePlayer(player, framesPerBlock));
+	}
+	return TasScriptEncoder::assemble(blocks, players[0].size(), framesPerBlock);
+}
+
+static TasScriptDecoder::Reader memoryReader(const std::vector<uint8_t>& file) {
+	return [&file](uint64_t offset, void* data, std::size_t size) {
+		if(offset > file.size() || size > file.size() - offset) {
+			return false;
+		}
+		memcpy(data, file.data() + offset, size);
+		return true;
+	};
+}
+
+SCENARIO("Compact TAS script round trip") {
+	GIVEN("several players with a partial last block") {
+		std::vector<std::vector<TasScriptFrame>> players;
+		for(uint32_t player = 0; player < 4; player++) {
+			players.push_back(makeFrames(5000, player + 1));
+		}
+		std::vector<uint8_t> file = encode(players, 600);
+
+		WHEN("it is decoded from the start") {
+			TasScriptDecoder decoder;
+			REQUIRE(TasScriptDecoder::isCompactScript(file.data(), file.size()));
+			REQUIRE(decoder.open(memoryReader(file)));
+			CHECK(decoder.getNumOfPlayers() == 4);
+			CHECK(decoder.getNumOfFrames() == 5000);
+
+			std::vector<TasScriptFrame> frames;
+			uint32_t mismatches = 0;
+			for(uint32_t frame = 0; frame < 5000; frame++) {
+				REQUIRE(decoder.readFrame(frames));
+				for(uint32_t player = 0; player < 4; player++) {
+					mismatches += !sameFrame(frames[player], players[player][frame]);
+				}
+			}
+			CHECK(mismatches == 0);
+			CHECK_FALSE(decoder.readFrame(frames));
+		}
+
+		WHEN("frames go through ControllerData") {
+			ControllerData data;
+			data.frameState = 3;
+			players[2][1234].toControllerData(data);
+			CHECK(sameFrame(TasScriptFrame::fromControllerData(data), players[2][1234]));
+			// Editor only state is left alone
+			CHECK(data.frameState == 3);
+		}
+	}
+
+	GIVEN("a script shorter than one block") {
+		std::vector<std::vector<TasScriptFrame>> players { makeFrames(10, 7) };
+		std::vector<uint8_t> file = encode(players, 600);
+
+		TasScriptDecoder decoder;
+		REQUIRE(decoder.open(memoryReader(file)));
+		std::vector<TasScriptFrame> frames;
+		for(uint32_t frame = 0; frame < 10; frame++) {
+			REQUIRE(decoder.readFrame(frames));
+			CHECK(sameFrame(frames[0], players[0][frame]));
+		}
+		CHECK_FALSE(decoder.readFrame(frames));
+	}
+
+	GIVEN("a file that isn't a compact script") {
+		std::vector<uint8_t> file(64, 0);
+		TasScriptDecoder decoder;
+		CHECK_FALSE(TasScriptDecoder::isCompactScript(file.data(), file.size()));
+		CHECK_FALSE(decoder.open(memoryReader(file)));
+	}
+
+	GIVEN("a truncated script") {
+		std::vector<std::vector<TasScriptFrame>> players { makeFrames(2000, 3), makeFrames(2000, 4) };
+		std::vector<uint8_t> file = encode(players, 600);
+		file.resize(file.size() - 100);
+
+		WHEN("it is read to the end") {
+			TasScriptDecoder decoder;
+			REQUIRE(decoder.open(memoryReader(file)));
+
+			// Has to stop instead of reading past the buffer
+			std::vector<TasScriptFrame> frames;
+			uint32_t framesRead = 0;
+			while(decoder.readFrame(frames)) {
+				framesRead++;
+			}
+			CHECK(framesRead < 2000);
+		}
+
+		WHEN("the last block header is cut off too") {
+			file.resize(TasScriptEncoder::writeHeader(2, 2000, 600).size() + 2);
+			TasScriptDecoder decoder;
+			CHECK_FALSE(decoder.open(memoryReader(file)));
+		}
+	}
+}
+
+SCENARIO("Compact TAS script written block by block") {
+	std::vector<std::vector<TasScriptFrame>> players { makeFrames(1500, 30), makeFrames(1500, 31), makeFrames(1500, 32) };
+
+	// How the PC app sends it, each block as soon as every player has it
+	std::vector<uint8_t> file = TasScriptEncoder::writeHeader(players.size(), 1500, 600);
+	for(uint32_t start = 0; start < 1500; start += 600) {
+		std::vector<std::vector<uint8_t>> playerBlocks;
+		for(auto const& player : players) {
+			playerBlocks.push_back(TasScriptEncoder::encodeBlock(&player[start], std::min<uint32_t>(600, 1500 - start)));
+		}
+		std::vector<uint8_t> block = TasScriptEncoder::writeBlock(playerBlocks);
+		file.insert(file.end(), block.begin(), block.end());
+	}
+
+	CHECK(file == encode(players, 600));
+}
+
+SCENARIO("Compact TAS script seeking") {
+	std::vector<std::vector<TasScriptFrame>> players { makeFrames(3000, 11), makeFrames(3000, 12) };
+	std::vector<uint8_t> file = encode(players, 600);
+
+	TasScriptDecoder decoder;
+	REQUIRE(decoder.open(memoryReader(file)));
+
+	WHEN("seeking to block boundaries and into blocks, forwards and backwards") {
+		std::vector<TasScriptFrame> frames;
+		for(uint32_t target : { 0u, 599u, 600u, 601u, 2999u, 1200u, 1799u, 5u, 2400u }) {
+			REQUIRE(decoder.seek(target));
+			CHECK(decoder.getCurrentFrame() == target);
+			REQUIRE(decoder.readFrame(frames));
+			CHECK(sameFrame(frames[0], players[0][target]));
+			CHECK(sameFrame(frames[1], players[1][target]));
+		}
+	}
+
+	WHEN("seeking to the end") {
+		std::vector<TasScriptFrame> frames;
+		REQUIRE(decoder.seek(3000));
+		CHECK_FALSE(decoder.readFrame(frames));
+		CHECK_FALSE(decoder.seek(3001));
+	}
+}
+
+SCENARIO("Compact TAS script throughput") {
+	// An hour at 60 FPS with 4 players
+	const uint32_t numOfFrames = 60 * 60 * 60;
+	std::vector<std::vector<TasScriptFrame>> players;
+	for(uint32_t player = 0; player < 4; player++) {
+		players.push_back(makeFrames(numOfFrames, player + 20));
+	}
+
+	auto encodeStart          = std::chrono::steady_clock::now();
+	std::vector<uint8_t> file = encode(players, TAS_SCRIPT_FRAMES_PER_BLOCK);
+	double encodeSeconds      = std::chrono::duration<double>(std::chrono::steady_clock::now() - encodeStart).count();
+
+	TasScriptDecoder decoder;
+	REQUIRE(decoder.open(memoryReader(file)));
+
+	auto decodeStart = std::chrono::steady_clock::now();
+	std::vector<TasScriptFrame> frames;
+	uint32_t framesRead = 0;
+	while(decoder.readFrame(frames)) {
+		framesRead++;
+	}
+	double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
+
+	CHECK(framesRead == numOfFrames);
+	CHECK(sameFrame(frames[3], players[3][numOfFrames - 1]));
+
+	double rawSize = (double)numOfFrames * players.size() * sizeof(TasScriptFrame);
+	MESSAGE("Encoded " << numOfFrames << " frames in " << encodeSeconds << "s, decoded in " << decodeSeconds << "s, " << file.size() << " bytes, " << rawSize / file.size() << "x smaller than raw");
+
+	// Has to stay far ahead of playback even on the switch, this host gets a lot of headroom for debug builds
+	CHECK(framesRead / decodeSeconds > 60 * 100);
+	CHECK(file.size() < rawSize);
+}